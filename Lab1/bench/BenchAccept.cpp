@@ -0,0 +1,67 @@
+// ===================== 基准测试：连接接入速率 =====================
+// 多个线程并发地 connect -> JOIN -> 等待欢迎帧 -> EXIT -> close，
+// 统计服务器每秒能完成多少次完整的接入握手。
+// 用法：BenchAccept.exe [线程数=8] [每线程连接数=500] [端口=8888]
+// 对比：分别用 Server.exe -r 1 与 Server.exe -r <核数> 启动服务器后运行。
+// ==========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+
+static std::atomic<long> okCount{0};
+static std::atomic<long> failCount{0};
+
+static bool oneConnection(unsigned short port, const std::string& name) {
+    SOCKET s = connectTcp(port);
+    if (s == INVALID_SOCKET) return false;
+    bool ok = sendFrame(s, buildMessage(Message{"JOIN", name, "", ""}));
+    // 等待服务器的欢迎帧，确认连接已被某个 reactor 接管并处理
+    FrameDecoder decoder;
+    std::string payload;
+    char buf[4096];
+    while (ok && !decoder.next(payload)) {
+        int n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) ok = false;
+        else decoder.feed(buf, (size_t)n);
+    }
+    if (ok) sendFrame(s, buildMessage(Message{"EXIT", name, "", ""}));
+    closeSocket(s);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc > 1 ? std::atoi(argv[1]) : 8;
+    int perThread = argc > 2 ? std::atoi(argv[2]) : 500;
+    unsigned short port = (unsigned short)(argc > 3 ? std::atoi(argv[3]) : 8888);
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t, perThread, port]() {
+            for (int i = 0; i < perThread; i++) {
+                std::string name = "acc_" + std::to_string(t) + "_" + std::to_string(i);
+                if (oneConnection(port, name)) okCount++;
+                else failCount++;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "[BenchAccept] threads=" << threads << " connections=" << okCount.load()
+              << " failed=" << failCount.load() << " elapsed=" << secs << "s"
+              << " rate=" << (long)(okCount.load() / secs) << " conn/s" << std::endl;
+    netCleanup();
+    return 0;
+}
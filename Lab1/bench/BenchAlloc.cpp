@@ -0,0 +1,137 @@
+// ===================== 基准测试：热路径堆分配次数 =====================
+// 在进程内模拟服务器处理一条广播消息的完整热路径：
+//   拆帧 -> 解析 -> 构造转发帧 -> 扇出到 K 个连接的发送队列 -> 写出后释放
+// 分别用旧写法（substr 拆字段、字符串拼接、shared_ptr<string> 帧）和
+// 现在的写法（就地解析、对象池 Message、池化帧缓冲）跑同样的稳定负载，
+// 先预热一轮，再统计每条消息平均的 operator new 次数。
+// 用法：BenchAlloc.exe [消息数=200000] [每条消息的接收者数=16] [内容字节数=64]
+// ==========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "../include/Common.h"
+#include "../include/FramePool.h"
+#include "../include/ObjectPool.h"
+
+static std::atomic<long long> allocCount{0};
+
+void* operator new(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// ---- 旧写法（与改动前的 parseMessage/buildMessage/makeFrame 一致） ----
+static Message legacyParse(const std::string& strMsg) {
+    Message m;
+    size_t start = 0, pos;
+    std::vector<std::string> parts;
+    while ((pos = strMsg.find('|', start)) != std::string::npos) {
+        parts.push_back(strMsg.substr(start, pos - start));
+        start = pos + 1;
+    }
+    parts.push_back(strMsg.substr(start));
+    if (parts.size() > 0) m.type = parts[0];
+    if (parts.size() > 1) m.sender = parts[1];
+    if (parts.size() > 2) m.accepter = parts[2];
+    if (parts.size() > 3) m.content = parts[3];
+    m.timestamp = parts.size() > 4 ? std::strtoll(parts[4].c_str(), nullptr, 10) : 0;
+    return m;
+}
+
+static std::string legacyBuild(const Message& m) {
+    return m.type + "|" + m.sender + "|" + m.accepter + "|" + m.content + "|" + std::to_string(m.timestamp);
+}
+
+// 把 N 条消息编码成连续字节流，按 16KB 一块喂给解帧器（模拟 recv）
+static std::string makeStream(int messages, int contentBytes) {
+    std::string stream;
+    for (int i = 0; i < messages; i++) {
+        Message m{"MSG", "user" + std::to_string(i % 1000), "ALL", std::string((size_t)contentBytes, 'x')};
+        stream += encodeFrame(buildMessage(m));
+    }
+    return stream;
+}
+
+template <typename Frame, typename Handler>
+static void runPath(const std::string& stream, std::vector<std::vector<Frame>>& outq, Handler handle) {
+    FrameDecoder decoder;
+    const size_t CHUNK = 16384;
+    for (size_t off = 0; off < stream.size(); off += CHUNK) {
+        size_t n = stream.size() - off < CHUNK ? stream.size() - off : CHUNK;
+        decoder.feed(stream.data() + off, n);
+        handle(decoder);
+        // 一轮事件循环结束：发送队列写出，帧引用释放
+        for (auto& q : outq) q.clear();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int messages = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int fanout = argc > 2 ? std::atoi(argv[2]) : 16;
+    int contentBytes = argc > 3 ? std::atoi(argv[3]) : 64;
+    std::string stream = makeStream(messages, contentBytes);
+
+    std::cout << "[BenchAlloc] messages=" << messages << " fanout=" << fanout
+              << " content=" << contentBytes << "B" << std::endl;
+
+    // 旧写法
+    std::vector<std::vector<std::shared_ptr<const std::string>>> legacyQ((size_t)fanout);
+    auto legacy = [&](FrameDecoder& d) {
+        std::string payload;
+        while (d.next(payload)) {
+            Message m = legacyParse(payload);
+            auto frame = std::make_shared<const std::string>(encodeFrame(legacyBuild(m)));
+            std::vector<int> targets;
+            for (int k = 0; k < fanout; k++) targets.push_back(k);
+            for (int k : targets) legacyQ[(size_t)k].push_back(frame);
+        }
+    };
+
+    // 现在的写法
+    std::vector<std::vector<FramePtr>> pooledQ((size_t)fanout);
+    std::vector<int> targets;
+    auto pooled = [&](FrameDecoder& d) {
+        const char* payload;
+        size_t len;
+        while (d.next(payload, len)) {
+            Message* m = ObjectPool<Message>::acquire();
+            parseMessageInto(payload, len, *m);
+            FramePtr frame = makeMessageFrame(*m);
+            targets.clear();
+            for (int k = 0; k < fanout; k++) targets.push_back(k);
+            for (int k : targets) pooledQ[(size_t)k].push_back(frame);
+            ObjectPool<Message>::release(m);
+        }
+    };
+
+    for (int round = 0; round < 2; round++) {
+        bool warmup = (round == 0);
+        long long a0 = allocCount.load();
+        auto t0 = std::chrono::steady_clock::now();
+        runPath(stream, legacyQ, legacy);
+        auto t1 = std::chrono::steady_clock::now();
+        long long a1 = allocCount.load();
+        runPath(stream, pooledQ, pooled);
+        auto t2 = std::chrono::steady_clock::now();
+        long long a2 = allocCount.load();
+        if (warmup) continue;   // 第一轮只为填满对象池和各容器的容量
+        double l = std::chrono::duration<double>(t1 - t0).count();
+        double p = std::chrono::duration<double>(t2 - t1).count();
+        std::cout << "  legacy : " << (double)(a1 - a0) / messages << " allocs/msg, "
+                  << (long long)(messages / l) << " msg/s" << std::endl;
+        std::cout << "  pooled : " << (double)(a2 - a1) / messages << " allocs/msg, "
+                  << (long long)(messages / p) << " msg/s" << std::endl;
+    }
+    return 0;
+}
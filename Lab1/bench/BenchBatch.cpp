@@ -0,0 +1,159 @@
+// ===================== 基准测试：批量消息 =====================
+// 同一组客户端先后按两种方式发送同样多的消息，对比吞吐：
+//   single : 每条消息一帧 MSG（服务器每条做一次成员检查、一次扇出）
+//   batch  : 每 B 条合成一帧 BATCH（发送者与会话只写一次，服务器每帧检查、扇出一次）
+// 每轮新建一个群，N 个客户端加入，其中前 S 个各发 M 条，统计全部送达所需的时间、
+// 接收端收到的帧数与字节数。legacy 个接收者不声明批量能力，服务器为它们拆回逐条 MSG。
+// 用法：BenchBatch.exe [客户端数=16] [发送者数=4] [每发送者消息数=20000] [每帧条数=64] [legacy 接收者数=0] [端口=8888]
+// ==========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "BenchUtil.h"
+
+static std::atomic<long long> delivered{0};
+static std::atomic<long long> framesIn{0};
+static std::atomic<long long> bytesIn{0};
+
+// 接收线程：MSG 计一条，BATCH 按其中的条数计（与客户端一样逐条拆开）
+static void recvLoop(SOCKET s) {
+    Message m;
+    std::vector<std::pair<size_t, size_t>> items;
+    recvFrames(s, [&](const std::string& payload) {
+        if (payload.compare(0, 4, "MSG|") == 0) {
+            delivered++;
+            framesIn++;
+        } else if (payload.compare(0, 6, "BATCH|") == 0) {
+            int64_t ts;
+            parseMessageInto(payload.data(), payload.size(), m);
+            if (parseBatch(m.content, ts, items)) delivered += (long long)items.size();
+            framesIn++;
+        }
+    }, &bytesIn);
+}
+
+struct Result {
+    double sendSecs = 0;
+    double secs = 0;
+    long long delivered = 0;
+    long long expected = 0;
+    long long frames = 0;
+    long long bytes = 0;
+};
+
+static bool runRound(const std::string& tag, int clients, int senders, int msgs, int perFrame, int legacy,
+                     unsigned short port, Result& r) {
+    delivered = 0;
+    framesIn = 0;
+    bytesIn = 0;
+    std::vector<SOCKET> socks;
+    std::vector<std::string> names;
+    std::vector<std::thread> receivers;
+    for (int i = 0; i < clients; i++) {
+        SOCKET s = connectTcp(port);
+        if (s == INVALID_SOCKET) {
+            std::cout << "Connect to Server failed" << std::endl;
+            return false;
+        }
+        names.push_back("batch-" + tag + std::to_string(i));
+        socks.push_back(s);
+        // 最后 legacy 个接收者不声明批量能力
+        bool batchOk = i < clients - legacy;
+        sendFrame(s, buildMessage(Message{"JOIN", names[i], "", batchOk ? BATCH_FEATURE : ""}));
+        receivers.emplace_back(recvLoop, s);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    std::string group = "bench-batch-" + tag;
+    sendFrame(socks[0], buildMessage(Message{"CREATE_GROUP", names[0], group, ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    for (int i = 1; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"JOIN_SESSION", names[i], group, ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    delivered = 0;   // 加入会话时的提示不计
+    framesIn = 0;
+    bytesIn = 0;
+
+    r.expected = (long long)senders * msgs * clients;
+    std::string body(32, 'x');
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < senders; i++) {
+        threads.emplace_back([&, i]() {
+            std::string payload;
+            for (int k = 0; k < msgs; k += perFrame) {
+                int n = msgs - k < perFrame ? msgs - k : perFrame;
+                if (perFrame == 1) {
+                    sendFrame(socks[i], buildMessage(Message{"MSG", names[i], group, body}));
+                    continue;
+                }
+                payload.clear();
+                appendBatchHeader(payload, names[i], group, (int64_t)std::time(nullptr));
+                for (int j = 0; j < n; j++) appendBatchItem(payload, body.data(), body.size());
+                sendFrame(socks[i], payload);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    r.sendSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // 等待全部投递完成（最多 60 秒）
+    while (delivered.load() < r.expected && std::chrono::steady_clock::now() - begin < std::chrono::seconds(60)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    r.secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    r.delivered = delivered.load();
+    r.frames = framesIn.load();
+    r.bytes = bytesIn.load();
+
+    for (int i = 0; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"EXIT", names[i], "", ""}));
+    closeAfterJoin(socks, receivers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    return true;
+}
+
+static void report(const char* mode, long long sent, const Result& r) {
+    std::cout << "  " << mode << " sent " << sent << " in " << r.sendSecs << "s -> " << (long long)(sent / r.sendSecs)
+              << " msg/s, delivered " << r.delivered << "/" << r.expected << " in " << r.secs << "s -> "
+              << (long long)(r.delivered / r.secs) << " msg/s, " << r.frames << " frames, " << r.bytes << " B" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int clients = argc > 1 ? std::atoi(argv[1]) : 16;
+    int senders = argc > 2 ? std::atoi(argv[2]) : 4;
+    int msgs = argc > 3 ? std::atoi(argv[3]) : 20000;
+    int perFrame = argc > 4 ? std::atoi(argv[4]) : 64;
+    int legacy = argc > 5 ? std::atoi(argv[5]) : 0;
+    unsigned short port = (unsigned short)(argc > 6 ? std::atoi(argv[6]) : 8888);
+    if (senders > clients) senders = clients;
+    if (legacy > clients) legacy = clients;
+    if (perFrame < 1) perFrame = 1;
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+
+    // 每轮用不同的名字与群，互不干扰
+    std::string run = std::to_string(std::time(nullptr) % 100000) + "-";
+    Result single, batch;
+    if (!runRound(run + "s", clients, senders, msgs, 1, legacy, port, single)) return 1;
+    if (!runRound(run + "b", clients, senders, msgs, perFrame, legacy, port, batch)) return 1;
+
+    long long sent = (long long)senders * msgs;
+    std::cout << "[BenchBatch] clients=" << clients << " senders=" << senders << " msgs/sender=" << msgs
+              << " per-frame=" << perFrame << " legacy=" << legacy << std::endl;
+    report("single", sent, single);
+    report("batch ", sent, batch);
+    std::cout << "  throughput x" << (single.secs / batch.secs) << ", frames x"
+              << (double)single.frames / (double)(batch.frames > 0 ? batch.frames : 1) << " fewer, bytes x"
+              << (double)single.bytes / (double)(batch.bytes > 0 ? batch.bytes : 1) << " fewer" << std::endl;
+
+    netCleanup();
+    return 0;
+}
@@ -0,0 +1,111 @@
+// ===================== 基准测试：多节点群聊扇出 =====================
+// 客户端轮流连到各个节点，分成 G 个群（群名不同，按一致性哈希分散到各归属节点），
+// 每个客户端向自己的群连续发送 M 条消息，统计每秒投递给客户端的帧数。
+// 成员分布在所有节点上，所以大部分请求和投递都要经过节点间链路；
+// 用同样的参数分别对 1、2、3 个节点运行，即可比较扇出吞吐随节点数的变化。
+// 用法：BenchCluster [节点端口列表=8888] [客户端数=24] [每客户端消息数=2000] [群数=6]
+//   节点端口列表用逗号分隔，例如 8881,8882,8883（各节点以 --cluster ... --node i 启动）
+// =================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "BenchUtil.h"
+
+static std::atomic<long long> delivered{0};
+
+// 接收线程：只统计 MSG 帧
+static void recvLoop(SOCKET s) {
+    recvFrames(s, [](const std::string& payload) {
+        if (payload.compare(0, 4, "MSG|") == 0) delivered++;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<unsigned short> ports;
+    std::stringstream list(argc > 1 ? argv[1] : "8888");
+    std::string item;
+    while (std::getline(list, item, ',')) ports.push_back((unsigned short)std::atoi(item.c_str()));
+    int clients = argc > 2 ? std::atoi(argv[2]) : 24;
+    int msgs = argc > 3 ? std::atoi(argv[3]) : 2000;
+    int groups = argc > 4 ? std::atoi(argv[4]) : 6;
+    if (ports.empty() || groups <= 0 || clients < groups) {
+        std::cout << "usage: BenchCluster [ports=8888] [clients=24] [msgs/client=2000] [groups=6]" << std::endl;
+        return 1;
+    }
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+
+    std::string suffix = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1000000007);
+    std::vector<SOCKET> socks;
+    std::vector<std::string> names;
+    std::vector<std::string> targets;
+    std::vector<std::thread> receivers;
+    for (int i = 0; i < clients; i++) {
+        SOCKET s = connectTcp(ports[i % ports.size()]);
+        if (s == INVALID_SOCKET) {
+            std::cout << "Connect to node " << ports[i % ports.size()] << " failed" << std::endl;
+            return 1;
+        }
+        names.push_back("cb" + std::to_string(i) + "_" + suffix);
+        targets.push_back("cg" + std::to_string(i % groups) + "_" + suffix);
+        socks.push_back(s);
+        sendFrame(s, buildMessage(Message{"JOIN", names[i], "", ""}));
+        receivers.emplace_back(recvLoop, s);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // 每个群的第一个客户端建群，其余的加入
+    for (int i = 0; i < groups; i++) sendFrame(socks[i], buildMessage(Message{"CREATE_GROUP", names[i], targets[i], ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    for (int i = groups; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"JOIN_SESSION", names[i], targets[i], ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // 每条消息投递给所在群的全部成员（含发送者回显）
+    long long expected = 0;
+    for (int g = 0; g < groups; g++) {
+        long long members = clients / groups + (g < clients % groups ? 1 : 0);
+        expected += members * members * msgs;
+    }
+    std::string body(32, 'x');
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> senders;
+    for (int i = 0; i < clients; i++) {
+        senders.emplace_back([&, i]() {
+            for (int k = 0; k < msgs; k++) {
+                sendFrame(socks[i], buildMessage(Message{"MSG", names[i], targets[i], body}));
+            }
+        });
+    }
+    for (auto& t : senders) t.join();
+    double sendSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // 等待全部投递完成（最多 60 秒）
+    while (delivered.load() < expected &&
+           std::chrono::steady_clock::now() - begin < std::chrono::seconds(60)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    long long sent = (long long)clients * msgs;
+    std::cout << "[BenchCluster] nodes=" << ports.size() << " clients=" << clients << " groups=" << groups
+              << " msgs/client=" << msgs << std::endl;
+    std::cout << "  sent      " << sent << " in " << sendSecs << "s -> " << (long long)(sent / sendSecs) << " msg/s" << std::endl;
+    std::cout << "  delivered " << delivered.load() << "/" << expected << " in " << secs << "s -> "
+              << (long long)(delivered.load() / secs) << " frames/s" << std::endl;
+
+    for (int i = 0; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"EXIT", names[i], "", ""}));
+    closeAfterJoin(socks, receivers);
+    netCleanup();
+    return 0;
+}
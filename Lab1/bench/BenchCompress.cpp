@@ -0,0 +1,266 @@
+// ===================== 基准测试：连接级压缩 =====================
+// 1. 进程内（不需要服务器）：对两种语料比较几种做法的压缩率与 CPU 开销
+//      每帧单独压缩 / 每批单独压缩 / 按批流式压缩（每批约为服务器的默认阈值），各自带与不带内置聊天字典；
+//    语料为模拟的群聊帧（多人、常用词、递增的时间戳）和内容为随机字节的帧（压缩不了的最坏情况）。
+// 2. 端到端（给出端口时）：一个发送者向群里连发 N 条消息，两个接收者先不读（接收缓冲设得很小，积压留在服务器），
+//    一个协商了压缩、一个没有，之后读完全部消息，比较两者在线路上收到的字节数与解压耗时。
+//    服务器一侧的压缩耗时用管理命令 compress 查看。
+// 用法：BenchCompress [端口（不给则只跑进程内部分）] [消息数=20000] [积压的毫秒数=300]
+// =================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "../include/Compress.h"
+#include "BenchUtil.h"
+
+static const size_t BATCH_BYTES = 2048;   // 流式压缩每批的原文字节（与服务器的 --compress-min 默认值相同）
+
+static const char* const WORDS[] = {
+    "hello", "ok", "thanks", "see", "you", "tomorrow", "meeting", "at", "the", "office", "lunch", "today", "how",
+    "about", "this", "is", "done", "please", "check", "review", "merged", "build", "failed", "again", "lol", "yes",
+    "no", "maybe", "later", "call", "me", "when", "free", "good", "morning", "night", "deploy", "server", "is", "down",
+    "back", "up", "我", "好的", "收到", "明天", "见", "谢谢", "哈哈", "在吗", "开会", "了"};
+
+static long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string randomText(std::mt19937& rng) {
+    std::string text;
+    int n = 2 + (int)(rng() % 10);
+    for (int i = 0; i < n; i++) {
+        if (i > 0) text += ' ';
+        text += WORDS[rng() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+    }
+    return text;
+}
+
+// 模拟群聊：20 个人在一个群里说话，时间戳每几条前进一秒
+static std::vector<std::string> chatFrames(size_t count) {
+    std::mt19937 rng(7);
+    std::vector<std::string> frames;
+    int64_t ts = 1763119000;
+    for (size_t i = 0; i < count; i++) {
+        if (rng() % 4 == 0) ts++;
+        Message m{"MSG", "user" + std::to_string(rng() % 20), "ALL", randomText(rng)};
+        m.timestamp = ts;
+        frames.push_back(encodeFrame(buildMessage(m)));
+    }
+    return frames;
+}
+
+// 内容为随机字节（压缩不了）
+static std::vector<std::string> randomFrames(size_t count) {
+    std::mt19937 rng(11);
+    std::vector<std::string> frames;
+    for (size_t i = 0; i < count; i++) {
+        std::string content(40 + rng() % 60, '\0');
+        for (char& c : content) c = (char)('!' + rng() % 90);
+        frames.push_back(encodeFrame("MSG|u|ALL|" + content + "|1763119000"));
+    }
+    return frames;
+}
+
+// 把帧按 batchBytes 分批（batchBytes 为 0 表示每帧一批），每批压缩后解压核对
+static void measure(const char* corpus, const char* mode, const std::vector<std::string>& frames, size_t batchBytes,
+                    bool streaming, const std::string& dict) {
+    std::vector<std::string> batches;
+    std::string cur;
+    for (const std::string& f : frames) {
+        cur += f;
+        if (cur.size() >= batchBytes) {
+            batches.push_back(cur);
+            cur.clear();
+        }
+    }
+    if (!cur.empty()) batches.push_back(cur);
+
+    size_t in = 0, out = 0;
+    std::vector<std::string> packed(batches.size());
+    ZipEncoder enc(dict);
+    long long t0 = nowNs();
+    for (size_t i = 0; i < batches.size(); i++) {
+        if (!streaming) enc = ZipEncoder(dict);
+        enc.compress(batches[i].data(), batches[i].size(), packed[i]);
+        in += batches[i].size();
+        out += packed[i].size() + FRAME_HEADER_SIZE + strlen(ZIP_TYPE) + 1;   // 算上 ZIP 帧自身的开销
+    }
+    long long t1 = nowNs();
+    ZipDecoder dec(dict);
+    bool ok = true;
+    std::string plain;
+    for (size_t i = 0; i < batches.size(); i++) {
+        if (!streaming) dec = ZipDecoder(dict);
+        plain.clear();
+        if (!dec.decompress(packed[i].data(), packed[i].size(), plain) || plain != batches[i]) ok = false;
+    }
+    long long t2 = nowNs();
+    printf("  %-7s %-22s %9zu -> %9zu B  ratio %5.2f  saved %5.1f%%  compress %6.1f ns/B (%5.0f MB/s)  decompress %5.1f ns/B%s\n",
+           corpus, mode, in, out, (double)in / (double)out, 100.0 * (1.0 - (double)out / (double)in),
+           (double)(t1 - t0) / (double)in, (double)in / 1e6 / ((double)(t1 - t0) / 1e9), (double)(t2 - t1) / (double)in,
+           ok ? "" : "  ROUND TRIP FAILED");
+}
+
+static void inProcess() {
+    std::vector<std::string> chat = chatFrames(50000);
+    std::vector<std::string> noise = randomFrames(50000);
+    const std::string none;
+    const std::string& dict = chatDictionary();
+    std::cout << "[BenchCompress] in-process, dictionary " << chatDictionaryId() << " (" << dict.size() << " B), batch "
+              << BATCH_BYTES << " B" << std::endl;
+    for (int c = 0; c < 2; c++) {
+        const char* name = c == 0 ? "chat" : "random";
+        const std::vector<std::string>& frames = c == 0 ? chat : noise;
+        measure(name, "per-frame", frames, 0, false, none);
+        measure(name, "per-frame + dict", frames, 0, false, dict);
+        measure(name, "per-batch", frames, BATCH_BYTES, false, none);
+        measure(name, "per-batch + dict", frames, BATCH_BYTES, false, dict);
+        measure(name, "streaming", frames, BATCH_BYTES, true, none);
+        measure(name, "streaming + dict", frames, BATCH_BYTES, true, dict);
+    }
+}
+
+// ========== 端到端 ==========
+
+struct Receiver {
+    SOCKET sock = INVALID_SOCKET;
+    std::string name;
+    bool compressed = false;
+    std::atomic<long long> wireBytes{0};
+    std::atomic<long long> msgs{0};
+    std::atomic<long long> zipFrames{0};
+    std::atomic<long long> inflateNs{0};
+    std::atomic<bool> reading{false};
+    std::atomic<bool> failed{false};
+};
+
+static void recvLoop(Receiver* r) {
+    while (!r->reading.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    FrameDecoder inner;
+    ZipDecoder zip(chatDictionary());
+    std::string plain, frame;
+    recvFrames(r->sock, [&](const std::string& payload) {
+        if (payload.compare(0, 4, "MSG|") == 0) {
+            r->msgs++;
+        } else if (payload.compare(0, 4, "ZIP|") == 0) {
+            r->zipFrames++;
+            plain.clear();
+            long long t0 = nowNs();
+            if (!zip.decompress(payload.data() + 4, payload.size() - 4, plain)) r->failed = true;
+            r->inflateNs += nowNs() - t0;
+            inner.feed(plain.data(), plain.size());
+            while (inner.next(frame)) {
+                if (frame.compare(0, 4, "MSG|") == 0) r->msgs++;
+            }
+        }
+    }, &r->wireBytes);
+}
+
+static void drainLoop(SOCKET s) {
+    char buf[65536];
+    while (recv(s, buf, sizeof(buf), 0) > 0) {
+    }
+}
+
+static int endToEnd(unsigned short port, int count, int backlogMs) {
+    std::string suffix = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1000000007);
+    std::string group = "cz_" + suffix;
+    std::string senderName = "czs_" + suffix;
+    SOCKET sender = connectTcp(port);
+    Receiver plainRx, zipRx;
+    plainRx.name = "czp_" + suffix;
+    zipRx.name = "czz_" + suffix;
+    zipRx.compressed = true;
+    // 接收端的窗口设小：积压留在服务器的发送通道里
+    plainRx.sock = connectTcp(port, 16384);
+    zipRx.sock = connectTcp(port, 16384);
+    if (sender == INVALID_SOCKET || plainRx.sock == INVALID_SOCKET || zipRx.sock == INVALID_SOCKET) {
+        std::cout << "Connect failed" << std::endl;
+        return 1;
+    }
+    sendFrame(sender, buildMessage(Message{"JOIN", senderName, "", ""}));
+    sendFrame(sender, buildMessage(Message{"EVENTS", senderName, "", "off"}));
+    sendFrame(sender, buildMessage(Message{"CREATE_GROUP", senderName, group, ""}));
+    std::vector<std::thread> threads;
+    threads.emplace_back(drainLoop, sender);
+    for (Receiver* r : {&plainRx, &zipRx}) {
+        sendFrame(r->sock, buildMessage(Message{"JOIN", r->name, "", ""}));
+        sendFrame(r->sock, buildMessage(Message{"EVENTS", r->name, "", "off"}));
+        if (r->compressed) sendFrame(r->sock, buildMessage(Message{"COMPRESS", r->name, "", chatDictionaryId()}));
+        sendFrame(r->sock, buildMessage(Message{"JOIN_SESSION", r->name, group, ""}));
+        threads.emplace_back(recvLoop, r);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    // 登录阶段的回复不计入
+    for (Receiver* r : {&plainRx, &zipRx}) {
+        char buf[65536];
+        while (true) {
+            fd_set set;
+            FD_ZERO(&set);
+            FD_SET(r->sock, &set);
+            timeval tv{0, 0};
+            if (select((int)r->sock + 1, &set, nullptr, nullptr, &tv) <= 0) break;
+            if (recv(r->sock, buf, sizeof(buf), 0) <= 0) break;
+        }
+    }
+
+    std::mt19937 rng(3);
+    long long t0 = nowNs();
+    for (int i = 0; i < count; i++) sendFrame(sender, buildMessage(Message{"MSG", senderName, group, randomText(rng)}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(backlogMs));
+    plainRx.reading = true;
+    zipRx.reading = true;
+    auto begin = std::chrono::steady_clock::now();
+    while ((plainRx.msgs.load() < count || zipRx.msgs.load() < count) &&
+           std::chrono::steady_clock::now() - begin < std::chrono::seconds(20)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    double secs = (double)(nowNs() - t0) / 1e9;
+
+    std::cout << "[BenchCompress] end-to-end: " << count << " messages to a backlogged group member, " << secs << "s"
+              << std::endl;
+    for (Receiver* r : {&plainRx, &zipRx}) {
+        printf("  %-11s %6lld msgs  %9lld B on the wire  %6.1f B/msg", r->compressed ? "compressed" : "plain",
+               r->msgs.load(), r->wireBytes.load(), (double)r->wireBytes.load() / (double)(r->msgs.load() > 0 ? r->msgs.load() : 1));
+        if (r->compressed) {
+            printf("  %lld ZIP frames  inflate %.1f ns/B%s", r->zipFrames.load(),
+                   (double)r->inflateNs.load() / (double)(r->wireBytes.load() > 0 ? r->wireBytes.load() : 1),
+                   r->failed.load() ? "  INFLATE FAILED" : "");
+        }
+        printf("\n");
+    }
+    if (plainRx.wireBytes.load() > 0) {
+        printf("  bandwidth saved %.1f%%\n", 100.0 * (1.0 - (double)zipRx.wireBytes.load() / (double)plainRx.wireBytes.load()));
+    }
+
+    closeAfterJoin({sender, plainRx.sock, zipRx.sock}, threads);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    inProcess();
+    if (argc < 2) return 0;
+    unsigned short port = (unsigned short)std::atoi(argv[1]);
+    int count = argc > 2 ? std::atoi(argv[2]) : 20000;
+    int backlogMs = argc > 3 ? std::atoi(argv[3]) : 300;
+    if (count <= 0) {
+        std::cout << "usage: BenchCompress [port] [messages=20000] [backlog ms=300]" << std::endl;
+        return 1;
+    }
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+    int rc = endToEnd(port, count, backlogMs);
+    netCleanup();
+    return rc;
+}
@@ -0,0 +1,134 @@
+// ===================== 基准测试：会话事件的合并 =====================
+// N 个客户端登录后：
+//   1. 登录潮：除建群者外所有人几乎同时加入同一个群，统计成员们收到的事件帧数与事件数；
+//   2. 正在输入：每个成员每 20ms 发一次 TYPING（相当于连续打字），持续 S 秒，统计每个成员每秒收到的事件帧数；
+// 其中 K 个客户端登录后发 EVENTS off 关闭事件推送，它们应当一帧 EVENTS 都收不到。
+// 分别对 --event-tick-ms 0（每个事件立即发出，相当于原来的逐条通知）和默认周期的服务器运行即可对比。
+// 用法：BenchEvents [端口=8888] [客户端数=200] [打字秒数=3] [关闭推送的客户端数=0]
+// =================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "BenchUtil.h"
+
+static std::atomic<long long> eventFrames{0};     // 收到的 EVENTS 帧
+static std::atomic<long long> eventCount{0};      // 其中的事件条数
+static std::atomic<long long> eventBytes{0};
+static std::atomic<long long> optOutFrames{0};    // 关闭了推送的客户端收到的 EVENTS 帧（应为 0）
+static std::atomic<long long> lastFrameUs{0};
+
+static long long nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void recvLoop(SOCKET s, bool optedOut) {
+    recvFrames(s, [optedOut](const std::string& payload) {
+        lastFrameUs = nowUs();
+        if (payload.compare(0, 7, "EVENTS|") != 0) return;
+        if (optedOut) optOutFrames++;
+        eventFrames++;
+        eventBytes += (long long)payload.size();
+        Message m = parseMessage(payload);
+        long long k = m.content.empty() ? 0 : 1;
+        for (char c : m.content) k += c == ',' ? 1 : 0;
+        eventCount += k;
+    });
+}
+
+// 先等 quietMs，再等到 quietMs 内没有任何帧到达（最多 10 秒）
+static void waitQuiet(int quietMs) {
+    auto begin = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(quietMs));
+    while (nowUs() - lastFrameUs.load() < quietMs * 1000LL &&
+           std::chrono::steady_clock::now() - begin < std::chrono::seconds(10)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned short port = (unsigned short)(argc > 1 ? std::atoi(argv[1]) : 8888);
+    int clients = argc > 2 ? std::atoi(argv[2]) : 200;
+    int typingSecs = argc > 3 ? std::atoi(argv[3]) : 3;
+    int optOut = argc > 4 ? std::atoi(argv[4]) : 0;
+    if (clients < 2 || optOut < 0 || optOut >= clients) {
+        std::cout << "usage: BenchEvents [port=8888] [clients=200] [typing seconds=3] [opted-out clients=0]" << std::endl;
+        return 1;
+    }
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+    std::string suffix = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1000000007);
+    std::string group = "eg_" + suffix;
+    std::vector<SOCKET> socks;
+    std::vector<std::string> names;
+    std::vector<std::thread> receivers;
+    for (int i = 0; i < clients; i++) {
+        SOCKET s = connectTcp(port);
+        if (s == INVALID_SOCKET) {
+            std::cout << "Connect failed" << std::endl;
+            return 1;
+        }
+        // 最后 optOut 个客户端关闭事件推送
+        bool optedOut = i >= clients - optOut;
+        names.push_back("ev" + std::to_string(i) + "_" + suffix);
+        socks.push_back(s);
+        sendFrame(s, buildMessage(Message{"JOIN", names[i], "", ""}));
+        if (optedOut) sendFrame(s, buildMessage(Message{"EVENTS", names[i], "", "off"}));
+        receivers.emplace_back(recvLoop, s, optedOut);
+    }
+    sendFrame(socks[0], buildMessage(Message{"CREATE_GROUP", names[0], group, ""}));
+    waitQuiet(300);
+
+    // 1. 登录潮
+    long long frames0 = eventFrames.load(), events0 = eventCount.load(), bytes0 = eventBytes.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 1; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"JOIN_SESSION", names[i], group, ""}));
+    waitQuiet(300);
+    double waveSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() - 0.3;
+    long long waveFrames = eventFrames.load() - frames0;
+    long long waveEvents = eventCount.load() - events0;
+    long long waveBytes = eventBytes.load() - bytes0;
+
+    // 2. 正在输入：每 20ms 每人一次
+    frames0 = eventFrames.load();
+    events0 = eventCount.load();
+    bytes0 = eventBytes.load();
+    long long typingSent = 0;
+    begin = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - begin < std::chrono::seconds(typingSecs)) {
+        auto round = std::chrono::steady_clock::now();
+        for (int i = 0; i < clients; i++) {
+            sendFrame(socks[i], buildMessage(Message{"TYPING", names[i], group, ""}));
+            typingSent++;
+        }
+        std::this_thread::sleep_until(round + std::chrono::milliseconds(20));
+    }
+    waitQuiet(300);
+    double typeSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() - 0.3;
+    long long typeFrames = eventFrames.load() - frames0;
+    long long typeEvents = eventCount.load() - events0;
+    long long typeBytes = eventBytes.load() - bytes0;
+
+    long long members = clients - optOut;   // 收事件的成员
+    std::cout << "[BenchEvents] clients=" << clients << " opted out=" << optOut << std::endl;
+    std::cout << "  join wave  " << (clients - 1) << " joins in " << waveSecs << "s -> " << waveFrames << " EVENTS frames ("
+              << waveEvents << " events, " << waveBytes << " B), " << (double)waveFrames / members << " frames/member"
+              << std::endl;
+    std::cout << "  typing     " << typingSent << " TYPING in " << typeSecs << "s -> " << typeFrames << " EVENTS frames ("
+              << typeEvents << " events, " << typeBytes << " B), " << (long long)(typeFrames / typeSecs / members)
+              << " frames/s per member" << std::endl;
+    std::cout << "  opted out  " << optOutFrames.load() << " EVENTS frames received (expected 0)" << std::endl;
+
+    for (int i = 0; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"EXIT", names[i], "", ""}));
+    closeAfterJoin(socks, receivers);
+    netCleanup();
+    return 0;
+}
@@ -0,0 +1,265 @@
+// ===================== 基准测试：大文件传输 =====================
+// 需以 --blob-dir 启动服务器。一个进程内完成：
+//   1. 上传：生成 M MB 随机内容，FILE_PUT 声明后逐块上传，统计吞吐；
+//   2. 去重：同一内容再声明一次，应立即确认已存好，不再传输；
+//   3. 续传：另一份内容只传一半就断开，重连后再声明，服务器应回复已有一半，从那里传完；
+//   4. 下载：从头下载并核对摘要，统计吞吐；
+//   5. 下载时的聊天延迟：同一群里一人每 2ms 发一条消息，另一人（下载者）统计收到的延迟，
+//      先空闲时测一次，再在下载者连续下载时测一次。文件块走连接的文件通道，聊天帧应能在块之间插队。
+// 分别对 --io epoll（sendfile 零拷贝）和 --io uring（读成普通帧）的服务器运行即可对比。
+// 用法：BenchFiles [端口=8888] [文件 MB=64] [测延迟的秒数=2]
+// ================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "BenchUtil.h"
+#include "../include/Sha256.h"
+
+static long long nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 一条连接上收到的东西
+struct Peer {
+    SOCKET sock = INVALID_SOCKET;
+    std::string name;
+    std::thread receiver;
+    std::atomic<long long> acks{0};           // 收到的 FILE_ACK 数
+    std::atomic<long long> lastAck{-1};       // 最近一次 FILE_ACK 的字节数
+    std::atomic<long long> fileBytes{0};      // 收到的文件块字节
+    std::atomic<long long> infos{0};          // 收到的 FILE_INFO 数
+    std::atomic<long long> sysErrors{0};
+    Sha256 sha;                               // 第一次下载的内容摘要
+    std::atomic<bool> hashing{false};
+    std::vector<long long> chatLatencyUs;     // 收到的聊天消息延迟（只由接收线程写）
+    std::atomic<bool> recordChat{false};
+};
+
+static void recvLoop(Peer* p) {
+    // 文件块较大，接收缓冲放大到 256 KB
+    recvFrames(p->sock, [p](const std::string& payload) {
+        Message m = parseMessage(payload);
+        if (m.type == FILE_DATA_TYPE) {
+            size_t bar = m.content.find('|');
+            if (bar == std::string::npos) return;
+            if (p->hashing) p->sha.update(m.content.data() + bar + 1, m.content.size() - bar - 1);
+            p->fileBytes += (long long)(m.content.size() - bar - 1);
+        } else if (m.type == "FILE_ACK") {
+            p->lastAck = std::atoll(m.content.c_str());
+            p->acks++;
+        } else if (m.type == "FILE_INFO") {
+            p->infos++;
+        } else if (m.type == "SYS" && m.content.find("文件") != std::string::npos) {
+            std::cout << "  [SYS] " << m.content << std::endl;
+            p->sysErrors++;
+        } else if (m.type == "MSG" && p->recordChat) {
+            p->chatLatencyUs.push_back(nowUs() - std::atoll(m.content.c_str()));
+        }
+    }, nullptr, 256 * 1024);
+}
+
+static bool openPeer(Peer& p, unsigned short port, const std::string& name) {
+    p.sock = connectTcp(port);
+    if (p.sock == INVALID_SOCKET) return false;
+    p.name = name;
+    sendFrame(p.sock, buildMessage(Message{"JOIN", name, "", ""}));
+    p.receiver = std::thread(recvLoop, &p);
+    return true;
+}
+
+static void closePeer(Peer& p, bool sayExit) {
+    if (sayExit) sendFrame(p.sock, buildMessage(Message{"EXIT", p.name, "", ""}));
+    shutdown(p.sock, SD_BOTH);
+    if (p.receiver.joinable()) p.receiver.join();
+    closeSocket(p.sock);
+}
+
+// 等 cond 成立，最多 timeoutMs
+template <typename Cond>
+static bool waitFor(Cond cond, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+// 声明上传并等待回复，返回服务器已有的字节数（超时返回 -1）
+static long long putFile(Peer& p, const std::string& hash, size_t size) {
+    long long before = p.acks.load();
+    sendFrame(p.sock, buildMessage(Message{"FILE_PUT", p.name, hash, std::to_string(size)}));
+    if (!waitFor([&] { return p.acks.load() > before; }, 5000)) return -1;
+    return p.lastAck.load();
+}
+
+// 从 offset 发到 end
+static void sendChunks(Peer& p, const std::string& hash, const std::string& data, size_t offset, size_t end) {
+    std::string payload;
+    while (offset < end) {
+        size_t n = std::min(FILE_CHUNK_SIZE, end - offset);
+        payload.clear();
+        appendFileChunkHeader(payload, p.name, hash, offset);
+        payload.append(data, offset, n);
+        sendFrame(p.sock, payload);
+        offset += n;
+    }
+}
+
+static std::string randomData(size_t size, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::string data(size, '\0');
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t v = rng();
+        memcpy(&data[i], &v, 8);
+    }
+    return data;
+}
+
+static std::string hashOf(const std::string& data) {
+    Sha256 sha;
+    sha.update(data.data(), data.size());
+    return sha.hexDigest();
+}
+
+// 聊天延迟：pinger 每 2ms 向群发一条带发送时刻的消息，receiver 统计；返回 p50 / p99 / max
+static void measureChat(Peer& pinger, Peer& receiver, const std::string& group, int seconds, long long out[3]) {
+    receiver.chatLatencyUs.clear();
+    receiver.recordChat = true;
+    auto begin = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - begin < std::chrono::seconds(seconds)) {
+        sendFrame(pinger.sock, buildMessage(Message{"MSG", pinger.name, group, std::to_string(nowUs())}));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    receiver.recordChat = false;
+    std::vector<long long> v = receiver.chatLatencyUs;
+    std::sort(v.begin(), v.end());
+    if (v.empty()) v.push_back(-1);
+    out[0] = v[v.size() / 2];
+    out[1] = v[std::min(v.size() - 1, v.size() * 99 / 100)];
+    out[2] = v.back();
+}
+
+int main(int argc, char* argv[]) {
+    unsigned short port = (unsigned short)(argc > 1 ? std::atoi(argv[1]) : 8888);
+    int mb = argc > 2 ? std::atoi(argv[2]) : 64;
+    int chatSecs = argc > 3 ? std::atoi(argv[3]) : 2;
+    if (mb <= 0 || chatSecs <= 0) {
+        std::cout << "usage: BenchFiles [port=8888] [file MB=64] [chat seconds=2]" << std::endl;
+        return 1;
+    }
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+    size_t size = (size_t)mb * 1024 * 1024;
+    unsigned seed = (unsigned)std::chrono::steady_clock::now().time_since_epoch().count();
+    std::string suffix = std::to_string(seed % 1000000007);
+    std::string data = randomData(size, seed);
+    std::string hash = hashOf(data);
+
+    Peer up, down, pinger;
+    if (!openPeer(up, port, "fu_" + suffix) || !openPeer(down, port, "fd_" + suffix) ||
+        !openPeer(pinger, port, "fp_" + suffix)) {
+        std::cout << "Connect failed" << std::endl;
+        return 1;
+    }
+    std::string group = "fg_" + suffix;
+    sendFrame(pinger.sock, buildMessage(Message{"CREATE_GROUP", pinger.name, group, ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sendFrame(down.sock, buildMessage(Message{"JOIN_SESSION", down.name, group, ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // 1. 上传
+    long long t0 = nowUs();
+    long long have = putFile(up, hash, size);
+    if (have != 0) {
+        std::cout << "FILE_PUT failed (got " << have << "), is the server started with --blob-dir?" << std::endl;
+        return 1;
+    }
+    long long acks = up.acks.load();
+    sendChunks(up, hash, data, 0, size);
+    bool stored = waitFor([&] { return up.acks.load() > acks; }, 60000) && up.lastAck.load() == (long long)size;
+    double upSecs = (nowUs() - t0) / 1e6;
+
+    // 2. 去重
+    t0 = nowUs();
+    long long dedup = putFile(up, hash, size);
+    long long dedupUs = nowUs() - t0;
+
+    // 3. 续传：传一半后断开，重连再声明
+    std::string data2 = randomData(size, seed + 1);
+    std::string hash2 = hashOf(data2);
+    Peer up2;
+    openPeer(up2, port, "fr_" + suffix);
+    putFile(up2, hash2, size);
+    sendChunks(up2, hash2, data2, 0, size / 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    closePeer(up2, false);
+    Peer up3;
+    openPeer(up3, port, "fr_" + suffix);
+    long long resumedAt = putFile(up3, hash2, size);
+    bool resumed = false;
+    if (resumedAt >= 0 && resumedAt < (long long)size) {
+        acks = up3.acks.load();
+        sendChunks(up3, hash2, data2, (size_t)resumedAt, size);
+        resumed = waitFor([&] { return up3.acks.load() > acks; }, 60000) && up3.lastAck.load() == (long long)size;
+    }
+    closePeer(up3, true);
+
+    // 4. 下载（第一次核对摘要）
+    down.hashing = true;
+    t0 = nowUs();
+    sendFrame(down.sock, buildMessage(Message{"FILE_GET", down.name, hash, "0"}));
+    bool downloaded = waitFor([&] { return down.fileBytes.load() >= (long long)size; }, 60000);
+    double downSecs = (nowUs() - t0) / 1e6;
+    down.hashing = false;
+    bool intact = downloaded && down.sha.hexDigest() == hash;
+
+    // 5. 聊天延迟：空闲时与连续下载时
+    long long idle[3], busy[3];
+    measureChat(pinger, down, group, chatSecs, idle);
+    std::atomic<bool> downloading{true};
+    std::atomic<int> downloads{0};
+    std::thread loader([&] {
+        while (downloading) {
+            long long target = down.fileBytes.load() + (long long)size;
+            sendFrame(down.sock, buildMessage(Message{"FILE_GET", down.name, hash, "0"}));
+            if (!waitFor([&] { return down.fileBytes.load() >= target; }, 60000)) break;
+            downloads++;
+        }
+    });
+    measureChat(pinger, down, group, chatSecs, busy);
+    downloading = false;
+    loader.join();
+
+    std::cout << "[BenchFiles] file " << mb << " MB, chunk " << FILE_CHUNK_SIZE / 1024 << " KB" << std::endl;
+    std::cout << "  upload     " << (stored ? "stored" : "FAILED") << " in " << upSecs << "s -> " << mb / upSecs << " MB/s"
+              << std::endl;
+    std::cout << "  dedup      re-upload acked " << dedup << " B in " << dedupUs << " us"
+              << (dedup == (long long)size ? " (no transfer)" : " (UNEXPECTED)") << std::endl;
+    std::cout << "  resume     reconnect resumed at " << resumedAt << " B of " << size << " -> "
+              << (resumed ? "stored" : "FAILED") << std::endl;
+    std::cout << "  download   " << (intact ? "hash ok" : "FAILED") << " in " << downSecs << "s -> " << mb / downSecs
+              << " MB/s" << std::endl;
+    std::cout << "  chat idle          p50 " << idle[0] << " us, p99 " << idle[1] << " us, max " << idle[2] << " us"
+              << std::endl;
+    std::cout << "  chat downloading   p50 " << busy[0] << " us, p99 " << busy[1] << " us, max " << busy[2] << " us ("
+              << downloads.load() << " downloads, " << mb * downloads.load() / (double)chatSecs << " MB/s)" << std::endl;
+
+    closePeer(up, true);
+    closePeer(down, true);
+    closePeer(pinger, true);
+    netCleanup();
+    return 0;
+}
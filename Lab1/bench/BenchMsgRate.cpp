@@ -0,0 +1,98 @@
+// ===================== 基准测试：消息吞吐 =====================
+// N 个客户端登录后加入会话，每个客户端连续发送 M 条消息，
+// 统计服务器每秒接收的消息数与每秒投递给客户端的帧数。
+// 用法：BenchMsgRate.exe [客户端数=16] [每客户端消息数=2000] [all|private] [端口=8888]
+//   all     : 所有客户端加入 ALL，每条消息扇出给全部 N 个成员
+//   private : 客户端两两私聊，每条消息投递给 2 个成员（含发送者回显）
+// ==========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "BenchUtil.h"
+
+static std::atomic<long long> delivered{0};
+
+// 接收线程：只统计 MSG 帧
+static void recvLoop(SOCKET s) {
+    recvFrames(s, [](const std::string& payload) {
+        if (payload.compare(0, 4, "MSG|") == 0) delivered++;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    int clients = argc > 1 ? std::atoi(argv[1]) : 16;
+    int msgs = argc > 2 ? std::atoi(argv[2]) : 2000;
+    std::string mode = argc > 3 ? argv[3] : "all";
+    unsigned short port = (unsigned short)(argc > 4 ? std::atoi(argv[4]) : 8888);
+    bool privateMode = (mode == "private");
+    if (privateMode && clients % 2 != 0) clients++;
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+
+    std::vector<SOCKET> socks;
+    std::vector<std::string> names;
+    std::vector<std::thread> receivers;
+    for (int i = 0; i < clients; i++) {
+        SOCKET s = connectTcp(port);
+        if (s == INVALID_SOCKET) {
+            std::cout << "Connect to Server failed" << std::endl;
+            return 1;
+        }
+        names.push_back("bench" + std::to_string(i));
+        socks.push_back(s);
+        sendFrame(s, buildMessage(Message{"JOIN", names[i], "", ""}));
+        receivers.emplace_back(recvLoop, s);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // 加入会话：all 模式加入 ALL，private 模式 i 与 i^1 互为私聊对象
+    std::vector<std::string> targets;
+    for (int i = 0; i < clients; i++) {
+        targets.push_back(privateMode ? names[i ^ 1] : "ALL");
+        sendFrame(socks[i], buildMessage(Message{"JOIN_SESSION", names[i], targets[i], ""}));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    long long fanout = privateMode ? 2 : clients;
+    long long expected = (long long)clients * msgs * fanout;
+    std::string body(32, 'x');
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> senders;
+    for (int i = 0; i < clients; i++) {
+        senders.emplace_back([&, i]() {
+            for (int k = 0; k < msgs; k++) {
+                sendFrame(socks[i], buildMessage(Message{"MSG", names[i], targets[i], body}));
+            }
+        });
+    }
+    for (auto& t : senders) t.join();
+    double sendSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // 等待全部投递完成（最多 60 秒）
+    while (delivered.load() < expected &&
+           std::chrono::steady_clock::now() - begin < std::chrono::seconds(60)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    long long sent = (long long)clients * msgs;
+    std::cout << "[BenchMsgRate] mode=" << mode << " clients=" << clients << " msgs/client=" << msgs << std::endl;
+    std::cout << "  sent      " << sent << " in " << sendSecs << "s -> " << (long long)(sent / sendSecs) << " msg/s" << std::endl;
+    std::cout << "  delivered " << delivered.load() << "/" << expected << " in " << secs << "s -> "
+              << (long long)(delivered.load() / secs) << " frames/s" << std::endl;
+
+    for (int i = 0; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"EXIT", names[i], "", ""}));
+    closeAfterJoin(socks, receivers);
+    netCleanup();
+    return 0;
+}
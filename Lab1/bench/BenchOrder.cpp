@@ -0,0 +1,138 @@
+// ===================== 基准测试：私聊两个方向的先后顺序 =====================
+// alice 与 bob 私聊，一问一答交替 N 轮：bob 收到 a<i> 后才回 b<i>，收到自己 b<i> 的回显后 alice 才发下一条。
+// alice 的接收缓冲很小且在此期间不读，两人的消息（alice 自己的回显与 bob 的回复）都积压在服务器为 alice
+// 排队的发送通道里。最后 alice 一次读完，检查写出的顺序是否仍是 a0 b0 a1 b1 ...：
+// 同一私聊的两个方向必须在同一个发送流里，否则按会话轮转时会把一个方向的消息整批排到另一个方向前面。
+// 总量要超过内核的收发缓冲（回环上约 3MB）才会在通道里积压，又不能超过连接的积压上限 4MB。
+// 不符合时打印第一个错位的位置并返回 1。
+// 用法：BenchOrder [轮数=3000] [消息字节数=512] [端口=8888]
+// ==========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "BenchUtil.h"
+
+static std::atomic<int> bobSawA{-1};      // bob 收到的 alice 最新一条的序号
+static std::atomic<int> bobSawEcho{-1};   // bob 收到的自己回显的最新序号
+
+// 消息内容是 "a<序号> " 或 "b<序号> " 加填充，取出方向与序号
+static bool tagOf(const Message& m, char& dir, int& seq) {
+    if (m.content.size() < 2 || (m.content[0] != 'a' && m.content[0] != 'b')) return false;
+    dir = m.content[0];
+    seq = std::atoi(m.content.c_str() + 1);
+    return true;
+}
+
+static bool waitFor(const std::atomic<int>& v, int want) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (v.load() < want) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 3000;
+    int bodyBytes = argc > 2 ? std::atoi(argv[2]) : 512;
+    unsigned short port = (unsigned short)(argc > 3 ? std::atoi(argv[3]) : 8888);
+    if (rounds < 1) rounds = 1;
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+
+    std::string run = std::to_string(std::time(nullptr) % 100000);
+    std::string alice = "order-a" + run, bob = "order-b" + run;
+    SOCKET sa = connectTcp(port, 4096);   // 接收缓冲尽量小，服务器很快就写不进去
+    SOCKET sb = connectTcp(port);
+    if (sa == INVALID_SOCKET || sb == INVALID_SOCKET) {
+        std::cout << "Connect to Server failed" << std::endl;
+        return 1;
+    }
+    sendFrame(sa, buildMessage(Message{"JOIN", alice, "", ""}));
+    sendFrame(sb, buildMessage(Message{"JOIN", bob, "", ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    sendFrame(sa, buildMessage(Message{"JOIN_SESSION", alice, bob, ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([&]() {
+        Message m;
+        recvFrames(sb, [&](const std::string& payload) {
+            if (payload.compare(0, 4, "MSG|") != 0) return;
+            parseMessageInto(payload.data(), payload.size(), m);
+            char dir;
+            int seq;
+            if (!tagOf(m, dir, seq)) return;
+            if (dir == 'a') bobSawA = seq;
+            else bobSawEcho = seq;
+        });
+    });
+
+    std::string pad(bodyBytes > 16 ? bodyBytes - 16 : 0, 'x');
+    auto begin = std::chrono::steady_clock::now();
+    int done = 0;
+    for (; done < rounds; done++) {
+        sendFrame(sa, buildMessage(Message{"MSG", alice, bob, "a" + std::to_string(done) + " " + pad}));
+        if (!waitFor(bobSawA, done)) break;
+        sendFrame(sb, buildMessage(Message{"MSG", bob, alice, "b" + std::to_string(done) + " " + pad}));
+        if (!waitFor(bobSawEcho, done)) break;
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (done < rounds) std::cout << "[BenchOrder] round " << done << " timed out" << std::endl;
+
+    // alice 现在才开始读，按写出的顺序逐条核对
+    std::vector<std::pair<char, int>> seen;
+    std::atomic<size_t> seenCount{0};
+    std::atomic<long long> bytes{0};
+    threads.emplace_back([&]() {
+        Message m;
+        recvFrames(sa, [&](const std::string& payload) {
+            if (payload.compare(0, 4, "MSG|") != 0) return;
+            parseMessageInto(payload.data(), payload.size(), m);
+            char dir;
+            int seq;
+            if (!tagOf(m, dir, seq)) return;
+            seen.emplace_back(dir, seq);
+            seenCount++;
+        }, &bytes);
+    });
+    size_t expected = (size_t)done * 2;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (seenCount.load() < expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    sendFrame(sa, buildMessage(Message{"EXIT", alice, "", ""}));
+    sendFrame(sb, buildMessage(Message{"EXIT", bob, "", ""}));
+    closeAfterJoin({sa, sb}, threads);
+
+    size_t wrong = 0, firstWrong = seen.size();
+    for (size_t i = 0; i < seen.size() && i < expected; i++) {
+        std::pair<char, int> want(i % 2 == 0 ? 'a' : 'b', (int)(i / 2));
+        if (seen[i] != want) {
+            if (firstWrong == seen.size()) firstWrong = i;
+            wrong++;
+        }
+    }
+    std::cout << "[BenchOrder] rounds=" << done << " in " << secs << "s, alice read " << seen.size() << "/" << expected
+              << " messages (" << bytes.load() << " B), " << wrong << " out of place" << std::endl;
+    bool ok = done == rounds && seen.size() == expected && wrong == 0;
+    if (firstWrong < seen.size()) {
+        std::cout << "  first mismatch at #" << firstWrong << ": got " << seen[firstWrong].first << seen[firstWrong].second
+                  << ", want " << (firstWrong % 2 == 0 ? 'a' : 'b') << firstWrong / 2 << std::endl;
+    }
+    std::cout << (ok ? "  OK" : "  FAILED") << std::endl;
+
+    netCleanup();
+    return ok ? 0 : 1;
+}
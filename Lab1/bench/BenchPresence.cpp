@@ -0,0 +1,191 @@
+// ===================== 基准测试：集群在线目录的收敛与带宽 =====================
+// 两个节点 A、B（同一集群，分别以 --admin-port 启动时可统计 gossip 流量）：
+//   1. 抖动：C 个客户端反复连到 A、登录、停留 5~30ms、退出、断开，每轮产生一次上线和一次下线；
+//   2. 收敛：同时每 200ms 有一个新用户登录 A，B 上的观察者不断对它发起私聊（/join 用户名），
+//      从登录到 B 上私聊成功的时间就是目录的收敛时间，报告 p50 / p99 / 最大值；
+//   3. 带宽：压测前后各读一次两个节点管理端口上 cluster 命令里的 gossip 字节数，
+//      报告总字节数、每次上下线平均的字节数，以及实际发出的记录数与本地变化数之比（同一用户在一轮内的多次变化只发最后一次）。
+// 用法：BenchPresence [A 端口=8881] [B 端口=8882] [抖动客户端数=32] [秒数=5] [A 管理端口=0] [B 管理端口=0]
+// 服务器：Server -p 8881 --admin-port 9101 --cluster 127.0.0.1:9001,127.0.0.1:9002 --node 0（B 同理，--node 1）
+// =================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+
+struct GossipStats {
+    unsigned long long bytes = 0;
+    unsigned long long entries = 0;
+    unsigned long long changes = 0;
+};
+
+// 在管理端口上执行 cluster，取出在线目录那一行的计数
+static bool readGossip(unsigned short adminPort, GossipStats& st) {
+    SOCKET s = connectTcp(adminPort);
+    if (s == INVALID_SOCKET) return false;
+    std::string text;
+    char buf[4096];
+    const char* cmd = "cluster\n";
+    send(s, cmd, (int)strlen(cmd), 0);
+    // 欢迎语和命令输出各以一个提示符结尾
+    while (true) {
+        size_t first = text.find("> ");
+        if (first != std::string::npos && text.find("> ", first + 2) != std::string::npos) break;
+        int n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        text.append(buf, (size_t)n);
+    }
+    closeSocket(s);
+    size_t at = text.find("local changes ");
+    if (at == std::string::npos) return false;
+    unsigned long long msgs = 0;
+    return sscanf(text.c_str() + at, "local changes %llu, gossip out %llu msgs / %llu entries / %llu B", &st.changes, &msgs,
+                  &st.entries, &st.bytes) == 4;
+}
+
+// 读到以 prefix 开头的帧为止（超时返回 false）
+static bool waitFor(SOCKET s, FrameDecoder& decoder, const std::string& prefix, int timeoutMs) {
+    std::string payload;
+    char buf[8192];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        while (decoder.next(payload)) {
+            if (payload.compare(0, prefix.size(), prefix) == 0) return true;
+        }
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        int n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        decoder.feed(buf, (size_t)n);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned short portA = (unsigned short)(argc > 1 ? std::atoi(argv[1]) : 8881);
+    unsigned short portB = (unsigned short)(argc > 2 ? std::atoi(argv[2]) : 8882);
+    int churners = argc > 3 ? std::atoi(argv[3]) : 32;
+    int seconds = argc > 4 ? std::atoi(argv[4]) : 5;
+    unsigned short adminA = (unsigned short)(argc > 5 ? std::atoi(argv[5]) : 0);
+    unsigned short adminB = (unsigned short)(argc > 6 ? std::atoi(argv[6]) : 0);
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+    std::string suffix = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1000000007);
+
+    GossipStats beforeA, beforeB;
+    bool haveA = adminA != 0 && readGossip(adminA, beforeA);
+    bool haveB = adminB != 0 && readGossip(adminB, beforeB);
+
+    // B 上的观察者
+    SOCKET watcher = connectTcp(portB);
+    if (watcher == INVALID_SOCKET) {
+        std::cout << "Connect to node B failed" << std::endl;
+        return 1;
+    }
+    std::string watchName = "watch_" + suffix;
+    FrameDecoder watchDecoder;
+    sendFrame(watcher, buildMessage(Message{"JOIN", watchName, "", ""}));
+    waitFor(watcher, watchDecoder, "SYS|", 1000);
+#ifdef _WIN32
+    DWORD tv = 5;
+#else
+    timeval tv{0, 5000};
+#endif
+    setsockopt(watcher, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+
+    std::atomic<bool> stop{false};
+    std::atomic<long long> cycles{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < churners; i++) {
+        threads.emplace_back([&, i]() {
+            std::mt19937 rng((unsigned)i * 7919u + 1);
+            std::string name = "churn" + std::to_string(i) + "_" + suffix;
+            while (!stop.load()) {
+                SOCKET s = connectTcp(portA);
+                if (s == INVALID_SOCKET) break;
+                sendFrame(s, buildMessage(Message{"JOIN", name, "", ""}));
+                std::this_thread::sleep_for(std::chrono::milliseconds(5 + rng() % 26));
+                sendFrame(s, buildMessage(Message{"EXIT", name, "", ""}));
+                shutdown(s, SD_BOTH);
+                closeSocket(s);
+                cycles++;
+            }
+        });
+    }
+
+    // 收敛：新用户登录 A，观察者在 B 上反复 /join 它，直到私聊建立
+    std::vector<double> converge;
+    int missed = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int k = 0; std::chrono::steady_clock::now() - begin < std::chrono::seconds(seconds); k++) {
+        std::string probe = "probe" + std::to_string(k) + "_" + suffix;
+        SOCKET p = connectTcp(portA);
+        if (p == INVALID_SOCKET) break;
+        FrameDecoder probeDecoder;
+        sendFrame(p, buildMessage(Message{"JOIN", probe, "", ""}));
+        waitFor(p, probeDecoder, "SYS|", 1000);   // A 已处理登录
+        auto t0 = std::chrono::steady_clock::now();
+        std::string ok = "SYS|Server|" + watchName + "|已加入会话 " + probe;
+        bool joined = false;
+        while (!joined && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(3)) {
+            sendFrame(watcher, buildMessage(Message{"JOIN_SESSION", watchName, probe, ""}));
+            joined = waitFor(watcher, watchDecoder, ok, 5);
+        }
+        if (joined) {
+            converge.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+            sendFrame(watcher, buildMessage(Message{"LEAVE_SESSION", watchName, probe, ""}));
+        } else {
+            missed++;
+        }
+        sendFrame(p, buildMessage(Message{"EXIT", probe, "", ""}));
+        shutdown(p, SD_BOTH);
+        closeSocket(p);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    stop.store(true);
+    for (auto& t : threads) t.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));   // 最后一轮 gossip 与确认
+
+    long long events = cycles.load() * 2;
+    std::cout << "[BenchPresence] churn clients=" << churners << " seconds=" << secs << std::endl;
+    std::cout << "  churn     " << events << " online/offline events -> " << (long long)(events / secs) << " /s" << std::endl;
+    std::sort(converge.begin(), converge.end());
+    if (!converge.empty()) {
+        auto pct = [&](double p) { return converge[std::min(converge.size() - 1, (size_t)(p * converge.size()))]; };
+        std::cout << "  converge  " << converge.size() << " probes (" << missed << " missed), ms p50 " << pct(0.5) << " p99 "
+                  << pct(0.99) << " max " << converge.back() << std::endl;
+    }
+    GossipStats afterA, afterB;
+    unsigned long long bytes = 0, entries = 0, changes = 0;
+    if (haveA && readGossip(adminA, afterA)) {
+        bytes += afterA.bytes - beforeA.bytes;
+        entries += afterA.entries - beforeA.entries;
+        changes += afterA.changes - beforeA.changes;
+    }
+    if (haveB && readGossip(adminB, afterB)) {
+        bytes += afterB.bytes - beforeB.bytes;
+        entries += afterB.entries - beforeB.entries;
+        changes += afterB.changes - beforeB.changes;
+    }
+    if (haveA || haveB) {
+        std::cout << "  gossip    " << bytes << " B (" << (long long)(bytes / secs) << " B/s, "
+                  << (changes > 0 ? (double)bytes / changes : 0.0) << " B per local change), " << entries
+                  << " entries sent for " << changes << " local changes" << std::endl;
+    }
+
+    sendFrame(watcher, buildMessage(Message{"EXIT", watchName, "", ""}));
+    closeSocket(watcher);
+    netCleanup();
+    return 0;
+}
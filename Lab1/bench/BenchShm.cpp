@@ -0,0 +1,177 @@
+// ===================== 基准测试：共享内存环传输 =====================
+// 服务器以 --shm 启动（需要 epoll 或 uring 后端），本程序作为同机机器人进程连上去：
+//   1. 入队开销：一个客户端在自己的群里连发消息，只统计 send() 本身的耗时（写入共享内存环），
+//      每发一批再把回显读空，报告每条消息的平均纳秒数和最快一批的纳秒数（单核机器上平均值会混进
+//      服务器抢占的时间，最快一批更接近写环本身的开销）；
+//   2. 吞吐：N 个客户端加入同一个群，每个连续发送 M 条消息，统计每秒投递给客户端的帧数；
+// 两项都报告写 eventfd 的次数：服务器忙时双方都不睡，稳定负载下应远小于消息数。
+// 用法：BenchShm [控制套接字路径=/tmp/chat.shm] [入队消息数=200000] [客户端数=8] [每客户端消息数=5000]
+// 服务器：Server -q --shm /tmp/chat.shm
+// =================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "../include/ShmRing.h"
+
+static std::string uniqueSuffix() {
+    return std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1000000007);
+}
+
+// 把已到达的字节读空（timeoutMs 为 0 时不等待），返回收到的 MSG 帧数；连接断开返回 -1
+static long drain(ShmClient& c, FrameDecoder& decoder, int timeoutMs) {
+    static thread_local char buf[65536];
+    std::string payload;
+    long msgs = 0;
+    while (true) {
+        long n = c.recv(buf, sizeof(buf), timeoutMs);
+        if (n < 0) return -1;
+        if (n == 0) return msgs;
+        decoder.feed(buf, (size_t)n);
+        while (decoder.next(payload)) {
+            if (payload.compare(0, 4, "MSG|") == 0) msgs++;
+        }
+        timeoutMs = 0;
+    }
+}
+
+// 等到收到以 prefix 开头的帧（握手阶段的 SYS 回复）
+static bool waitFor(ShmClient& c, FrameDecoder& decoder, const char* prefix) {
+    char buf[65536];
+    std::string payload;
+    size_t len = strlen(prefix);
+    for (int tries = 0; tries < 50; tries++) {
+        while (decoder.next(payload)) {
+            if (payload.compare(0, len, prefix) == 0) return true;
+        }
+        long n = c.recv(buf, sizeof(buf), 100);
+        if (n < 0) return false;
+        decoder.feed(buf, (size_t)n);
+    }
+    return false;
+}
+
+static bool runEnqueue(const std::string& path, int total) {
+    ShmClient c;
+    if (!c.connect(path)) {
+        std::cout << "  connect " << path << " failed" << std::endl;
+        return false;
+    }
+    FrameDecoder decoder;
+    std::string name = "shm_enq" + uniqueSuffix();
+    std::string group = "g" + name;
+    c.send(buildMessage(Message{"JOIN", name, "", ""}));
+    waitFor(c, decoder, "SYS|");
+    c.send(buildMessage(Message{"CREATE_GROUP", name, group, ""}));
+    waitFor(c, decoder, "SYS|");
+
+    // 提前编好帧，计时只包含写入共享内存环
+    std::string payload = buildMessage(Message{"MSG", name, group, std::string(32, 'x')});
+    const int batch = 1000;
+    long long sendNs = 0;
+    long long bestNs = -1;
+    long received = 0;
+    uint64_t wakeBefore = c.wakeups();
+    for (int sent = 0; sent < total; sent += batch) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < batch; i++) c.send(payload);
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        sendNs += ns;
+        if (bestNs < 0 || ns < bestNs) bestNs = ns;
+        long n = drain(c, decoder, 0);
+        if (n < 0) return false;
+        received += n;
+    }
+    int sentTotal = (total + batch - 1) / batch * batch;
+    while (received < sentTotal) {
+        long n = drain(c, decoder, 1000);
+        if (n <= 0) break;
+        received += n;
+    }
+    std::cout << "  [enqueue] " << sentTotal << " msgs, " << (double)sendNs / sentTotal << " ns/msg in send() (best batch "
+              << (double)bestNs / batch << "), echoes "
+              << received << "/" << sentTotal << ", eventfd writes " << c.wakeups() - wakeBefore << std::endl;
+    c.send(buildMessage(Message{"EXIT", name, "", ""}));
+    return received == sentTotal;
+}
+
+// 每个客户端一个线程：交替发送和读空（send 与 recv 共用一个 eventfd，须在同一线程调用）
+static bool runThroughput(const std::string& path, int clients, int msgs) {
+    std::vector<std::unique_ptr<ShmClient>> conns;
+    std::vector<std::string> names;
+    std::vector<FrameDecoder> decoders(clients);
+    std::string suffix = uniqueSuffix();
+    std::string group = "shm_tp" + suffix;
+    for (int i = 0; i < clients; i++) {
+        conns.emplace_back(new ShmClient());
+        if (!conns.back()->connect(path)) {
+            std::cout << "  connect " << path << " failed" << std::endl;
+            return false;
+        }
+        names.push_back("shm" + std::to_string(i) + "_" + suffix);
+        conns[i]->send(buildMessage(Message{"JOIN", names[i], "", ""}));
+        waitFor(*conns[i], decoders[i], "SYS|");
+    }
+    conns[0]->send(buildMessage(Message{"CREATE_GROUP", names[0], group, ""}));
+    waitFor(*conns[0], decoders[0], "SYS|");
+    for (int i = 1; i < clients; i++) {
+        conns[i]->send(buildMessage(Message{"JOIN_SESSION", names[i], group, ""}));
+        waitFor(*conns[i], decoders[i], "SYS|");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    std::atomic<long long> delivered{0};
+    std::atomic<uint64_t> wakeups{0};
+    long long expected = (long long)clients * msgs * clients;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; i++) {
+        threads.emplace_back([&, i]() {
+            ShmClient& c = *conns[i];
+            FrameDecoder& decoder = decoders[i];
+            std::string payload = buildMessage(Message{"MSG", names[i], group, std::string(32, 'x')});
+            uint64_t wakeBefore = c.wakeups();
+            long long mine = 0;
+            for (int k = 0; k < msgs; k++) {
+                c.send(payload);
+                if ((k & 63) == 63) mine += std::max<long>(0, drain(c, decoder, 0));
+            }
+            while (mine < (long long)msgs * clients &&
+                   std::chrono::steady_clock::now() - begin < std::chrono::seconds(60)) {
+                long n = drain(c, decoder, 100);
+                if (n < 0) break;
+                mine += n;
+            }
+            delivered += mine;
+            wakeups += c.wakeups() - wakeBefore;
+        });
+    }
+    for (auto& th : threads) th.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "  [throughput] delivered " << delivered.load() << "/" << expected << " in " << secs << "s -> "
+              << (long long)(delivered.load() / secs) << " frames/s, eventfd writes " << wakeups.load() << " for "
+              << (long long)clients * msgs << " msgs sent" << std::endl;
+    for (int i = 0; i < clients; i++) conns[i]->send(buildMessage(Message{"EXIT", names[i], "", ""}));
+    return delivered.load() == expected;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "/tmp/chat.shm";
+    int total = argc > 2 ? std::atoi(argv[2]) : 200000;
+    int clients = argc > 3 ? std::atoi(argv[3]) : 8;
+    int msgs = argc > 4 ? std::atoi(argv[4]) : 5000;
+
+    std::cout << "[BenchShm] path=" << path << " enqueue=" << total << " clients=" << clients << " msgs/client=" << msgs
+              << std::endl;
+    runEnqueue(path, total);
+    runThroughput(path, clients, msgs);
+    return 0;
+}
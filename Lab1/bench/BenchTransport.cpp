@@ -0,0 +1,171 @@
+// ===================== 基准测试：TCP 回环与 Unix 域套接字 =====================
+// 服务器同时开启 TCP 与 --unix 监听，对两种传输各跑一遍：
+//   1. 延迟：一个客户端建群后逐条往返（发出 MSG，等到自己的回显再发下一条），统计往返延迟分位数；
+//   2. 吞吐：N 个客户端加入同一个群，每个连续发送 M 条消息，统计每秒投递给客户端的帧数。
+// 两种传输走的是服务器里同一套 reactor、会话表和扇出路径，差别只在内核里的传输层。
+// 用法：BenchTransport.exe [套接字路径=/tmp/chat.sock] [端口=8888] [往返次数=20000] [客户端数=8] [每客户端消息数=5000]
+// 服务器：Server -q --unix /tmp/chat.sock
+// ==========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "../include/Histogram.h"
+#include "BenchUtil.h"
+
+struct Transport {
+    std::string name;           // tcp / unix
+    std::string path;           // 非空表示 Unix 域套接字
+    unsigned short port = 8888;
+};
+
+static SOCKET connectTo(const Transport& t) {
+    if (!t.path.empty()) return connectUnix(t.path);
+    SOCKET s = connectTcp(t.port);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    setNoDelay(s);
+    return s;
+}
+
+// 阻塞读取，直到收到一个以 prefix 开头的帧
+static bool waitFor(SOCKET s, FrameDecoder& decoder, const char* prefix) {
+    std::string payload;
+    char buf[65536];
+    size_t len = strlen(prefix);
+    while (true) {
+        while (decoder.next(payload)) {
+            if (payload.compare(0, len, prefix) == 0) return true;
+        }
+        int n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        decoder.feed(buf, (size_t)n);
+    }
+}
+
+static std::string uniqueSuffix() {
+    return std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1000000007);
+}
+
+// 往返延迟（纳秒记录，微秒输出）
+static bool runLatency(const Transport& t, int rounds) {
+    SOCKET s = connectTo(t);
+    if (s == INVALID_SOCKET) {
+        std::cout << "  [" << t.name << "] connect failed" << std::endl;
+        return false;
+    }
+    FrameDecoder decoder;
+    std::string name = "lat_" + t.name + uniqueSuffix();
+    std::string group = "g" + name;
+    sendFrame(s, buildMessage(Message{"JOIN", name, "", ""}));
+    waitFor(s, decoder, "SYS|");
+    sendFrame(s, buildMessage(Message{"CREATE_GROUP", name, group, ""}));
+    waitFor(s, decoder, "SYS|");
+
+    LatencyHistogram hist;
+    std::string body(32, 'x');
+    std::string prefix = "MSG|" + name + "|";
+    bool ok = true;
+    for (int i = 0; i < rounds && ok; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        sendFrame(s, buildMessage(Message{"MSG", name, group, body}));
+        ok = waitFor(s, decoder, prefix.c_str());
+        hist.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+    }
+    std::cout << "  [" << t.name << "] rtt us: p50=" << hist.percentile(50) / 1000.0
+              << " p99=" << hist.percentile(99) / 1000.0 << " p99.9=" << hist.percentile(99.9) / 1000.0
+              << " max=" << hist.max() / 1000.0 << " (" << hist.count() << " rounds)" << std::endl;
+    sendFrame(s, buildMessage(Message{"EXIT", name, "", ""}));
+    closeSocket(s);
+    return ok;
+}
+
+// 吞吐：与 BenchMsgRate 的 all 模式相同，但在独立的群里进行
+static bool runThroughput(const Transport& t, int clients, int msgs) {
+    std::atomic<long long> delivered{0};
+    std::vector<SOCKET> socks;
+    std::vector<std::string> names;
+    std::vector<std::thread> receivers;
+    std::string suffix = uniqueSuffix();
+    std::string group = "tp_" + t.name + suffix;
+    for (int i = 0; i < clients; i++) {
+        SOCKET s = connectTo(t);
+        if (s == INVALID_SOCKET) {
+            std::cout << "  [" << t.name << "] connect failed" << std::endl;
+            return false;
+        }
+        names.push_back("tp" + std::to_string(i) + "_" + t.name + suffix);
+        socks.push_back(s);
+        sendFrame(s, buildMessage(Message{"JOIN", names[i], "", ""}));
+        receivers.emplace_back([s, &delivered]() {
+            recvFrames(s, [&delivered](const std::string& payload) {
+                if (payload.compare(0, 4, "MSG|") == 0) delivered++;
+            });
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    sendFrame(socks[0], buildMessage(Message{"CREATE_GROUP", names[0], group, ""}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (int i = 1; i < clients; i++) {
+        sendFrame(socks[i], buildMessage(Message{"JOIN_SESSION", names[i], group, ""}));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    long long expected = (long long)clients * msgs * clients;
+    std::string body(32, 'x');
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> senders;
+    for (int i = 0; i < clients; i++) {
+        senders.emplace_back([&, i]() {
+            for (int k = 0; k < msgs; k++) {
+                sendFrame(socks[i], buildMessage(Message{"MSG", names[i], group, body}));
+            }
+        });
+    }
+    for (auto& th : senders) th.join();
+    while (delivered.load() < expected &&
+           std::chrono::steady_clock::now() - begin < std::chrono::seconds(60)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "  [" << t.name << "] delivered " << delivered.load() << "/" << expected << " in " << secs << "s -> "
+              << (long long)(delivered.load() / secs) << " frames/s" << std::endl;
+
+    for (int i = 0; i < clients; i++) sendFrame(socks[i], buildMessage(Message{"EXIT", names[i], "", ""}));
+    closeAfterJoin(socks, receivers);
+    return delivered.load() == expected;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "/tmp/chat.sock";
+    unsigned short port = (unsigned short)(argc > 2 ? std::atoi(argv[2]) : 8888);
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 20000;
+    int clients = argc > 4 ? std::atoi(argv[4]) : 8;
+    int msgs = argc > 5 ? std::atoi(argv[5]) : 5000;
+
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+
+    Transport transports[2];
+    transports[0].name = "tcp";
+    transports[0].port = port;
+    transports[1].name = "unix";
+    transports[1].path = path;
+
+    std::cout << "[BenchTransport] rounds=" << rounds << " clients=" << clients << " msgs/client=" << msgs << std::endl;
+    for (const Transport& t : transports) {
+        runLatency(t, rounds);
+    }
+    for (const Transport& t : transports) {
+        runThroughput(t, clients, msgs);
+    }
+    netCleanup();
+    return 0;
+}
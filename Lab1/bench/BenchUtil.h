@@ -0,0 +1,39 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+// ===================== 基准测试的公共部分 =====================
+// 各个 Bench*.cpp 共用的接收线程循环与收尾。连接用 Platform.h 的 connectTcp。
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+
+// 接收线程：读到连接关闭（或被 shutdown）为止，拆出的每一帧交给 onFrame(payload)。
+// wireBytes 非空时累加收到的原始字节数
+template <typename OnFrame>
+void recvFrames(SOCKET s, OnFrame onFrame, std::atomic<long long>* wireBytes = nullptr, size_t bufSize = 65536) {
+    FrameDecoder decoder;
+    std::string payload;
+    std::vector<char> buf(bufSize);
+    while (true) {
+        int n = recv(s, buf.data(), (int)buf.size(), 0);
+        if (n <= 0) break;
+        if (wireBytes != nullptr) *wireBytes += n;
+        decoder.feed(buf.data(), (size_t)n);
+        while (decoder.next(payload)) onFrame(payload);
+    }
+}
+
+// 收尾：先 shutdown 让接收线程从 recv 返回，等它们全部退出后才关闭套接字，
+// 否则句柄可能在别的线程还在读时被关闭、复用
+inline void closeAfterJoin(const std::vector<SOCKET>& socks, std::vector<std::thread>& threads) {
+    for (SOCKET s : socks) shutdown(s, SD_BOTH);
+    for (auto& t : threads) {
+        if (t.joinable()) t.join();
+    }
+    for (SOCKET s : socks) closeSocket(s);
+}
+
+#endif // BENCH_UTIL_H
@@ -0,0 +1,19 @@
+#ifndef ADMIN_H
+#define ADMIN_H
+
+#include <string>
+
+// ========== 管理控制台 ==========
+// 同一套命令既可以在服务器控制台（stdin）输入，也可以连到本机管理端口（--admin-port）输入，
+// 每行一条命令，返回可直接打印的文本。
+//
+// 命令只读快照：用户表、会话表分小批拷贝（每批持锁很短），连接统计由各 reactor 在自己的线程里填写，
+// 所以在高负载时排查问题也不会长时间占用 clientMutex。
+
+// 执行一条命令，返回输出文本（以换行结尾）；quit 为 true 表示调用方输出后应停止服务器
+std::string runAdminCommand(const std::string& line, bool& quit);
+
+// 在 127.0.0.1:port 上启动管理端口，失败返回 false
+bool startAdminServer(unsigned short port);
+
+#endif // ADMIN_H
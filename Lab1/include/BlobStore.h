@@ -0,0 +1,58 @@
+#ifndef BLOB_STORE_H
+#define BLOB_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// ========== 大文件：按内容寻址的存储（分块上传、去重、续传） ==========
+// 目录 dir 下每个文件以其 SHA-256 摘要（64 位十六进制）命名；正在上传的文件是 <摘要>.part，
+// 它的长度就是已收到的字节数，断线、重启后从这里续传。同一内容只存一份：上传前先声明摘要，
+// 已经存在时直接确认，不再传输。收齐后核对摘要，一致才改名为正式文件，否则丢弃重传。
+// 上传时边收边算摘要，收齐时不必再读一遍文件（重启后续传的 .part 在续传开始时补算一次已有部分）。
+// 存储只在本节点：集群中各节点的文件互不相通，客户端需从上传所在的节点下载。
+//
+// 协议（内容字段）：
+//   客户端 FILE_PUT|名字|摘要|大小        服务器 FILE_ACK|Server|摘要|已有字节数（等于大小表示已存好）
+//   客户端 FILE_DATA|名字|摘要|偏移|<原始字节>   偏移与已有字节数不符、或收齐时，服务器回 FILE_ACK
+//   客户端 FILE_GET|名字|摘要|偏移        服务器 FILE_INFO|Server|摘要|大小，随后是 FILE_DATA 块（零拷贝发送）
+
+const uint64_t MAX_BLOB_SIZE = 1ULL << 30;   // 单个文件的上限（1GB）
+// 每个进行中的上传占一个打开的 .part 文件：限制总数与每个连接的个数，连接断开或闲置超时即关闭
+// （.part 的长度就是续传位置，关闭不丢数据，重新 FILE_PUT 即可接着传）
+const size_t MAX_OPEN_UPLOADS = 256;
+const size_t MAX_UPLOADS_PER_CONN = 4;
+const int UPLOAD_IDLE_SECONDS = 60;
+
+enum BlobWrite {
+    BLOB_OK,          // 已写入，还没收齐
+    BLOB_DONE,        // 收齐且摘要一致，已存好
+    BLOB_MISMATCH,    // 偏移与已有字节数不符（重复或乱序的块），回复已有字节数让客户端从那里续传
+    BLOB_BAD_HASH,    // 收齐但摘要不符，已丢弃
+    BLOB_ERROR        // 没有先声明上传、超出声明的大小或写盘失败
+};
+
+// 创建目录并开启存储；不调用时所有 FILE_* 请求都回复未开启
+bool startBlobStore(const std::string& dir);
+bool blobStoreEnabled();
+
+// 声明上传：返回已有的字节数（已存好时等于 size），失败返回 -1 并填写原因。
+// owner 是声明上传的连接（同一摘要被另一个连接重新声明时归它所有）
+int64_t blobPut(const std::string& hash, uint64_t size, uint64_t owner, std::string& error);
+
+// 写入一块；have 为写入后（或不符时现有）的字节数
+BlobWrite blobWrite(const std::string& hash, uint64_t offset, const char* data, size_t len, uint64_t& have);
+
+// 连接断开：关闭它名下未完成的上传
+void blobConnClosed(uint64_t owner);
+
+// 已存好的文件：返回大小并填写路径，不存在返回 -1
+int64_t blobFind(const std::string& hash, std::string& path);
+
+// 记录一次下载发出的字节数（统计用）
+void blobServed(uint64_t bytes);
+
+void describeBlobs(std::ostream& os);
+
+#endif // BLOB_STORE_H
@@ -3,7 +3,7 @@
 
 #include<iostream>
 #include<string>
-#include<winsock2.h>
+#include "Platform.h"
 #include<vector>
 #include<map>
 #include "Common.h" //包含公共头文件
@@ -22,11 +22,14 @@ extern std::string currSessionId;
 
 extern std::string currUserName; //用于存储当前用户名的全局变量
 
-//发送消息线程函数声明
-void sendThread(SOCKET clientSocket, const std::string& userName);
+//发送消息线程函数声明（使用当前连接，服务器排空重连后自动换用新连接）
+void sendThread(const std::string& userName);
 
 //接收消息线程函数声明
-void recvThread(SOCKET clientSocket);
+void recvThread();
+
+//处理服务器发来的一条完整消息（由 recvThread 解帧后调用）
+void handleServerMessage(const Message &m);
 
 // ========== 时间戳格式化工具函数 ==========
 
@@ -0,0 +1,61 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Common.h"
+#include "FramePool.h"
+#include "Reactor.h"
+
+// ========== 多节点集群：按会话归属路由 ==========
+// 启动时用 --cluster 列出所有节点的节点间地址（host:port，逗号分隔，各节点顺序一致），--node 指明自己是第几个。
+// 群聊会话（含 ALL）按一致性哈希分给唯一的归属节点，成员表、加入/离开、消息的校验和扇出都只在归属节点上做；
+// 客户端可以连任意节点，发往不归本节点的会话的请求经节点间长连接转给归属节点。
+// 归属节点把其它节点上的用户记为“远端连接”（见 makeRemoteConn），回复和扇出照常调用 sendTo / fanOut，
+// 发给远端连接的帧按节点攒批，由每条节点链路的发送线程一次写出。
+// 群消息按节点发布/订阅：归属节点把某节点上的成员名单作为订阅发一次，之后每条消息每个节点只转一份，
+// 由该节点按名单在本地扇出，跨节点流量从 O(成员数) 降到 O(节点数)；名单变化时才重新订阅。
+// ALL 的语义是“所有在线用户”，所以发往 ALL 的帧每个节点只转一份，由各节点广播给本地用户。
+// 私聊按两人的名字选归属节点，对方连在哪个节点从集群在线目录（Presence.h）查，本机内存即可回答。
+
+const int MAX_CLUSTER_NODES = 128;
+
+// 其它节点上的连接：最高位置 1，接着 7 位是节点编号，低 56 位是该连接在它所在节点上的 ConnId
+const ConnId REMOTE_CONN_FLAG = 1ULL << 63;
+const ConnId LOCAL_CONN_MASK = (1ULL << 56) - 1;
+
+inline bool isRemoteConn(ConnId conn) { return (conn & REMOTE_CONN_FLAG) != 0; }
+inline ConnId makeRemoteConn(int node, ConnId local) {
+    return REMOTE_CONN_FLAG | ((ConnId)node << 56) | (local & LOCAL_CONN_MASK);
+}
+inline int nodeOfConn(ConnId conn) { return (int)((conn >> 56) & 0x7F); }
+inline ConnId localConnOf(ConnId conn) { return conn & LOCAL_CONN_MASK; }
+
+// 解析节点列表、建哈希环、开始监听节点端口并连接其它节点。nodes 为空时不启用集群
+bool startCluster(const std::string& nodes, int self);
+bool clusterEnabled();
+int clusterSelf();
+int clusterSize();
+
+// 会话的归属节点（一致性哈希，每个节点 128 个虚拟点）；未启用集群时总是本节点
+int ownerOf(const std::string& sessionId);
+
+// 两人私聊的归属节点（与谁先发起无关）
+int privateOwnerOf(const std::string& user1, const std::string& user2);
+
+// 在处理客户端消息之前调用：需要由其它节点处理时转发过去并返回 true
+bool clusterRoute(const Message& m, ConnId clientConn);
+
+// ---- 供 Reactor / Server 调用 ----
+void clusterSend(ConnId remote, const FramePtr& frame);                          // 发给一个远端连接
+void clusterDeliver(std::vector<ConnId>& remotes, const FramePtr& frame);        // 发给一组远端连接（会被排序）
+// 发布一条会话消息：remotes 为该会话在其它节点上的全部在线成员（会被排序），excludeConn 不收这一条
+void clusterPublish(const std::string& sessionId, std::vector<ConnId>& remotes, ConnId excludeConn, const FramePtr& frame);
+void clusterBroadcast(const std::string& payload, ConnId excludeConn = INVALID_CONN);   // 每个节点广播给本地所有用户
+void clusterUserGone(const std::string& name, ConnId conn);                      // 本地用户退出或断开
+
+// 管理命令 cluster：各节点链路的状态与收发统计
+void describeCluster(std::ostream& os);
+
+#endif // CLUSTER_H
@@ -7,7 +7,7 @@
 #include <vector>
 #include <thread>
 #include <algorithm>
-#include <winsock2.h>
+#include "Platform.h"
 #include <ctime>
 
 struct Message {
@@ -16,6 +16,9 @@ struct Message {
     std::string accepter;
     std::string content;
     int64_t timestamp;  // 消息时间戳（秒级Unix时间）
+    std::string trace;  // 可选的分段跟踪时刻（见 Trace.h），为空时不编码
+    int64_t recvUs = 0;  // 服务器本地：收到、解析完该消息的时刻（仅跟踪时填写，不参与编码）
+    int64_t parseUs = 0;
     
     // 默认构造函数
     Message() : timestamp(0) {}
@@ -27,9 +30,64 @@ struct Message {
 
 //构造消息
 std::string buildMessage(const Message& m) ;
+//把消息追加到 out 末尾（复用 out 已有的容量，服务器热路径用）
+void appendMessage(std::string& out, const Message& m);
 
 //解析消息
 Message parseMessage(const std::string& strMsg) ;
+//就地解析到已有的 Message，复用其中字符串的容量，稳定负载下不分配内存
+void parseMessageInto(const char* data, size_t len, Message& out);
+
+// ========== 文件块 ==========
+// FILE_DATA|发送者|摘要|偏移|<原始字节到帧尾>：内容不是文本，可以含 '|'，也没有时间戳字段，
+// parseMessageInto 把第四个 '|' 之后的全部字节作为 content（偏移在 content 开头，以 '|' 结束）。
+const char* const FILE_DATA_TYPE = "FILE_DATA";
+const size_t FILE_CHUNK_SIZE = 32 * 1024;   // 每块的字节数：远小于 MAX_FRAME_SIZE，一块写完即可让聊天帧插队
+//追加文件块的前缀（不含长度头），之后紧跟 len 字节文件内容即是一帧的负载
+void appendFileChunkHeader(std::string& out, const std::string& sender, const std::string& hash, uint64_t offset);
+
+// ========== 批量消息 ==========
+// BATCH|发送者|会话|时间戳|<长度>:<内容><长度>:<内容>...：同一发送者发往同一会话的多条消息合成一帧，
+// 共同的字段只写一次。与 FILE_DATA 一样，parseMessageInto 把第三个 '|' 之后的全部字节作为 content
+// （时间戳在 content 开头），buildMessage 也不再追加时间戳，解析与封装互为逆操作。
+// 客户端在 JOIN 的内容里写 batch 表示能解析批量帧；没有声明的连接由服务器拆回逐条 MSG 下发。
+const char* const BATCH_TYPE = "BATCH";
+const char* const BATCH_FEATURE = "batch";
+const size_t BATCH_MAX_BYTES = 32 * 1024;   // 客户端每个批量帧装入的消息字节上限（远小于 MAX_FRAME_SIZE）
+//追加批量帧的前缀（不含长度头），之后用 appendBatchItem 逐条追加
+void appendBatchHeader(std::string& out, const std::string& sender, const std::string& session, int64_t timestamp);
+void appendBatchItem(std::string& out, const char* text, size_t len);
+//解析批量帧的 content：items 依次收到每条消息在 content 中的（起点, 长度）；格式错误或一条都没有时返回 false
+bool parseBatch(const std::string& content, int64_t& timestamp, std::vector<std::pair<size_t, size_t>>& items);
+
+//站在 self 的角度，消息属于哪个会话：私聊是对方的用户名，群聊是群名。
+//服务器用两人编号的有序对（PairKey）识别私聊；客户端只看得到自己参与的私聊，对方的用户名即是唯一的键
+const std::string& conversationOf(const Message& m, const std::string& self);
+
+// ========== 帧格式（解决 TCP 粘包/拆包） ==========
+// 每一帧 = 4 字节大端长度 + 负载（即 buildMessage 的结果）
+const size_t FRAME_HEADER_SIZE = 4;
+const size_t MAX_FRAME_SIZE = 64 * 1024;
+
+//为负载加上长度头
+std::string encodeFrame(const std::string& payload);
+
+//阻塞发送一个完整帧（循环直到全部写出），失败返回 false
+bool sendFrame(SOCKET s, const std::string& payload);
+
+//流式解帧器：把 recv 得到的字节喂进来，再逐个取出完整帧
+class FrameDecoder {
+public:
+    void feed(const char* data, size_t len);
+    bool next(std::string& payload);   // 取出一个完整帧的负载，没有则返回 false
+    bool next(const char*& data, size_t& len);   // 同上但不拷贝，指针在下次 feed 前有效
+    bool error() const { return bad; } // 出现超长帧，连接应当关闭
+    size_t buffered() const { return buf.size() - pos; }   // 已收到、尚未取出的字节数
+private:
+    std::string buf;
+    size_t pos = 0;
+    bool bad = false;
+};
 
 //修改枚举类型
 enum MessageType{
@@ -39,9 +97,27 @@ enum MessageType{
     MT_EXIT,          // 退出
     MT_JOIN_SESSION,  // 加入会话
     MT_LEAVE_SESSION, // 离开会话
-    MT_NOTIFY         // 通知消息（如新私聊）
+    MT_NOTIFY,        // 通知消息（如新私聊）
+    MT_CREATE_GROUP,  // 创建命名群聊
+    MT_TYPING,        // 正在输入（客户端 -> 服务器）
+    MT_EVENTS,        // 合并后的会话事件；客户端发 on / off 开关事件推送
+    MT_FILE_PUT,      // 上传开始 / 续传：声明摘要与大小
+    MT_FILE_ACK,      // 服务器已有的字节数（等于大小表示已存好）
+    MT_FILE_GET,      // 下载：从某个偏移开始
+    MT_FILE_INFO,     // 下载的文件大小，随后是文件块
+    MT_FILE_DATA,     // 文件块（内容为原始字节）
+    MT_COMPRESS,      // 协商压缩：客户端报字典标识，服务器回复是否启用（见 Compress.h）
+    MT_ZIP,           // 压缩后的若干帧（内容为压缩字节）
+    MT_BATCH,         // 同一发送者发往同一会话的多条消息
+    MT_OTHER,         // 无法识别的类型（仅用于统计）
+    MT_TYPE_COUNT
 };
 
+//TYPE 字段 -> 枚举（按类型分类统计帧数用）
+MessageType messageTypeOf(const char* type, size_t len);
+//枚举 -> 协议中的 TYPE 字符串
+const char* messageTypeName(int type);
+
 enum SessionType{ST_GROUP, ST_PRIVATE, ST_SYSTEM};
 
 #endif // COMMON_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ========== 连接级流式压缩（LZ77，带预置字典） ==========
+// 聊天帧很短、彼此高度相似（同样的 TYPE|SENDER|ACCEPTER 前缀、相近的时间戳），单帧压缩几乎没有收益；
+// 这里在一条连接的整个生命周期里保留最近 ZIP_WINDOW 字节的历史，后面的块可以引用前面块里的内容，
+// 历史的开头预置一份按聊天记录训练出的字典（ChatDict.cpp，由 TrainDict 生成），第一块就能命中常见片段。
+//
+// 块格式（与 LZ4 的序列相同）：若干个 [令牌][字面量][2 字节小端偏移][匹配长度扩展]，
+// 令牌高 4 位是字面量长度、低 4 位是匹配长度减 MIN_MATCH，等于 15 时后面跟 255 累加的扩展字节；
+// 每块以一个只有字面量、没有偏移的序列结束。编码器与解码器按相同的规则裁剪历史，两端始终一致，
+// 所以块必须按编码顺序逐个解码，丢一块之后的数据都无法还原（连接断开后两端都从字典重新开始）。
+//
+// 协议：客户端登录后发 COMPRESS|名字||<字典标识>，服务器字典相同且开启了压缩时回 COMPRESS|Server||<字典标识>，
+// 否则回 none；之后服务器可能把积压的多帧聊天消息合并成一帧 ZIP|<压缩字节>，解压后是原样的若干帧（含长度头）。
+
+const size_t ZIP_WINDOW = 32 * 1024;      // 匹配最远回看的字节数
+const size_t ZIP_MAX_INPUT = 32 * 1024;   // 每块原文的上限（压缩后仍远小于 MAX_FRAME_SIZE）
+const char* const ZIP_TYPE = "ZIP";
+
+class ZipEncoder {
+public:
+    explicit ZipEncoder(const std::string& dict);
+    // 压缩 in[0, len) 追加到 out 末尾，len 不超过 ZIP_MAX_INPUT
+    void compress(const char* in, size_t len, std::string& out);
+
+private:
+    void trim();
+
+    std::string hist;              // 字典 + 已压缩的原文（最多保留两个窗口）
+    std::vector<uint32_t> table;   // 4 字节前缀的哈希 -> 在 hist 中的位置 + 1（0 为空）
+};
+
+class ZipDecoder {
+public:
+    explicit ZipDecoder(const std::string& dict);
+    // 解压一块追加到 out 末尾；数据损坏或还原后超过 maxOut 字节时返回 false（之后的块也不可再用）
+    bool decompress(const char* in, size_t len, std::string& out, size_t maxOut = ZIP_MAX_INPUT);
+
+private:
+    std::string hist;
+};
+
+// 内置的聊天字典及其标识（"lz-" + 字典 SHA-256 的前 8 位），两端标识相同才启用压缩
+const std::string& chatDictionary();
+const std::string& chatDictionaryId();
+
+// ChatDict.cpp（TrainDict 生成）
+extern const char CHAT_DICT[];
+extern const size_t CHAT_DICT_SIZE;
+
+#endif // COMPRESS_H
@@ -0,0 +1,55 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <atomic>
+#include <string>
+#include "Common.h"
+
+// 编码好的帧（长度头 + 负载），广播时所有接收者共享同一份。
+// 缓冲来自对象池：最后一个持有者释放后连同容量回到池里，下一帧直接复用，
+// 不再像 shared_ptr<string> 那样每帧两次堆分配。
+struct FrameBuf {
+    std::string bytes;
+    std::atomic<int> refs{0};
+    int64_t traceUs = 0;    // 带跟踪的消息：服务器路由完成的时刻，用于统计入队/写出两段
+    int type = MT_OTHER;    // 消息类型（MessageType），按类型统计发出的帧数
+    uint32_t flow = 0;      // 发送通道：0 为控制帧（优先），否则是聊天消息所属会话的哈希
+    bool pair = false;      // 私聊帧：flow 按两人的用户名计，与方向无关
+    int weight = 1;         // 聊天消息在会话间轮转时的权重
+};
+
+class FramePtr {
+public:
+    FramePtr() {}
+    explicit FramePtr(FrameBuf* buf) : p(buf) { if (p) p->refs.fetch_add(1, std::memory_order_relaxed); }
+    FramePtr(const FramePtr& o) : p(o.p) { if (p) p->refs.fetch_add(1, std::memory_order_relaxed); }
+    FramePtr(FramePtr&& o) noexcept : p(o.p) { o.p = nullptr; }
+    ~FramePtr() { reset(); }
+
+    FramePtr& operator=(FramePtr o) noexcept {
+        std::swap(p, o.p);
+        return *this;
+    }
+
+    void reset();
+    const std::string& operator*() const { return p->bytes; }
+    const std::string* operator->() const { return &p->bytes; }
+    explicit operator bool() const { return p != nullptr; }
+    int64_t traceUs() const { return p->traceUs; }
+    int type() const { return p->type; }
+    uint32_t flow() const { return p->flow; }
+    bool isPrivate() const { return p->pair; }
+    int weight() const { return p->weight; }
+
+private:
+    FrameBuf* p = nullptr;
+};
+
+// 把协议字符串封帧（缓冲取自池）；traceUs 非 0 表示这是一条被跟踪的消息
+FramePtr makeFrame(const std::string& payload, int64_t traceUs = 0);
+// 私聊的帧：MSG / BATCH 按排好序的两个用户名分流，两个方向的消息在同一个接收连接里先后不变
+FramePtr makePrivateFrame(const std::string& payload, int64_t traceUs = 0);
+// 直接把消息编码成帧，省去中间的协议字符串；isPrivate 同 makePrivateFrame
+FramePtr makeMessageFrame(const Message& m, bool isPrivate = false);
+
+#endif // FRAME_POOL_H
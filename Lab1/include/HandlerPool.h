@@ -0,0 +1,107 @@
+#ifndef HANDLER_POOL_H
+#define HANDLER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 消息处理线程池：reactor 只负责收发和拆帧，handleMessage 交给这里执行
+//
+// 1. 串行队列（strand）：同一个 key（通常是会话名）的任务严格按提交顺序串行执行，
+//    但可以由任意工作线程执行；不同 key 之间完全并行；
+// 2. 工作窃取：每个工作线程有自己的就绪队列，空闲时从其它线程的队列尾部偷一个 strand；
+// 3. 一个 strand 每次最多连续执行 STRAND_BATCH 个任务就让出，热点会话不会长期霸占线程。
+
+typedef std::function<void()> Job;
+
+// 单个连接的顺序约束：同一连接发出的消息也必须按序处理。
+// 连接的任务还在某个 strand 里没做完时，发往另一个 strand 的任务先挂在 deferred，
+// 等前面的任务全部完成后再放行。
+struct ConnOrder {
+    std::mutex lock;
+    int running = 0;                                   // 已投递、尚未完成的任务数
+    std::string lastKey;                               // 这些任务所在的 strand
+    std::deque<std::pair<std::string, Job>> deferred;
+};
+
+class HandlerPool {
+public:
+    explicit HandlerPool(int workers);
+    ~HandlerPool();
+
+    // 提交任务：key 为空表示“跟随连接”（沿用该连接上一个任务的 strand）
+    void submit(const std::shared_ptr<ConnOrder>& order, const std::string& key, Job job);
+    // 同 submit，但该连接积压超过 MAX_CONN_JOBS 或目标 strand 积压超过 MAX_STRAND_JOBS 时不接收，
+    // 返回 false 且 job 保持不变（reactor 据此暂停处理该连接，客户端的数据留在内核和 decoder 里）
+    bool trySubmit(const std::shared_ptr<ConnOrder>& order, const std::string& key, Job& job);
+
+    // 停止：不再等新任务，已提交的任务（包括各连接挂起的）全部执行完后工作线程退出
+    void stop();
+    int workerCount() const { return (int)workers.size(); }
+    size_t queuedJobs() const { return queued.load(std::memory_order_relaxed); }
+
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> steals{0};
+
+private:
+    struct Task {
+        Job job;
+        std::shared_ptr<ConnOrder> order;   // 完成后据此放行该连接挂起的任务
+    };
+
+    struct Strand {
+        std::string key;
+        std::deque<Task> jobs;      // 受所在分片的锁保护
+        bool scheduled = false;     // 是否已在某个就绪队列中或正在执行
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<std::string, std::shared_ptr<Strand>> strands;
+    };
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<std::shared_ptr<Strand>> ready;
+        std::thread thread;
+    };
+
+    static const int SHARD_COUNT = 16;
+    static const int STRAND_BATCH = 64;
+    static const size_t MAX_IDLE_STRANDS = 256;   // 每个分片保留的空闲 strand 数，避免反复创建
+    static const size_t MAX_CONN_JOBS = 256;      // 单个连接最多积压的任务数（含挂起的）
+    static const size_t MAX_STRAND_JOBS = 4096;   // 单个 strand 最多积压的任务数
+
+    bool submitJob(const std::shared_ptr<ConnOrder>& order, const std::string& key, Job& job, bool bounded);
+
+    bool enqueue(const std::string& key, Task& task, size_t limit);
+    void schedule(const std::shared_ptr<Strand>& s);
+    bool takeWork(int self, std::shared_ptr<Strand>& out);
+    void runStrand(const std::shared_ptr<Strand>& s);
+    void workerLoop(int self);
+    Shard& shardOf(const std::string& key);
+    void finished(const std::shared_ptr<ConnOrder>& order);
+
+    Shard shards[SHARD_COUNT];
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<unsigned> nextWorker{0};
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> outstanding{0};   // 已提交、尚未执行完的任务（含挂起在 deferred 中的）
+    std::atomic<int> readyCount{0};
+    std::atomic<bool> running{true};
+    std::mutex idleLock;
+    std::condition_variable idle;
+};
+
+// 全局处理池：workers <= 0 时不创建，消息在 reactor 线程内直接处理（旧行为）
+void startHandlerPool(int workers);
+HandlerPool* getHandlerPool();
+
+#endif // HANDLER_POOL_H
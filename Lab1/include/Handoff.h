@@ -0,0 +1,22 @@
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <string>
+#include <vector>
+#include "Platform.h"
+
+// ========== 热重启：监听套接字与会话状态交接 ==========
+// 旧进程在 Unix 域套接字 path 上等待接班者；新进程以同一个 --handoff path 启动时先连过去：
+//   1. 旧进程用 SCM_RIGHTS 把所有监听套接字传给新进程（同一个内核套接字，排队中的连接不丢）；
+//   2. 再把会话表（会话名、类型、成员）按协议帧逐条发过去；
+//   3. 新进程开始接入后，旧进程停止接入并进入排空：通知在线客户端在随机延迟后重连。
+// 客户端因此分散地重连到新进程，升级时不会出现重连风暴。
+// 只在支持 SCM_RIGHTS 的平台（Linux 等）可用，Windows 下两个函数都直接返回 false。
+
+// 新进程：连接旧进程并接管监听套接字与会话表（写入全局 sessions）。没有旧进程在运行时返回 false
+bool takeOverFrom(const std::string& path, std::vector<SOCKET>& listeners);
+
+// 旧进程：在 path 上等待接班者，交接完成后调用 drainServer 排空
+bool startHandoffListener(const std::string& path);
+
+#endif // HANDOFF_H
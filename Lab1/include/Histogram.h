@@ -0,0 +1,34 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+// HDR 风格的延迟直方图：按 2 的幂分段，每段再等分 16 个子桶（约 6% 精度），
+// 桶数固定、不随样本增长，记录只是一次原子加，可由多个线程同时写入。
+// 单位由调用方决定（服务器与客户端的分段统计用微秒，LoadGen 用纳秒）。
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(int64_t value);                 // 小于 1 的值（如时钟回拨）按 1 计
+    void merge(const LatencyHistogram& o);
+    void reset();
+
+    int64_t percentile(double p) const;         // 第 p 百分位，取所在桶的中点
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    int64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+
+private:
+    static const int SUB_BITS = 4;
+    static const int SUB = 1 << SUB_BITS;
+    static const int BUCKETS = 64 * SUB;
+
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> total{0};
+    std::atomic<int64_t> maxValue{0};
+};
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,66 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <atomic>
+#include <string>
+#include "Reactor.h"
+
+// I/O 后端：Reactor 决定“收到什么、发给谁”，后端决定“怎么收、怎么发”
+// 所有方法（除 wake 外）都只在所属 reactor 线程内调用
+class IoBackend {
+public:
+    virtual ~IoBackend() {}
+
+    virtual const char* name() const = 0;
+    virtual bool init() = 0;
+
+    virtual void addListener(SOCKET listener) = 0;
+    virtual void removeListener(SOCKET listener) = 0;
+    virtual void addConn(Connection& c) = 0;
+    // 该套接字能否交给本后端监听（select 在 POSIX 上只能放 FD_SETSIZE 以下的描述符）
+    virtual bool canWatch(SOCKET) const { return true; }
+    virtual void removeConn(Connection& c) = 0;   // 之后由 reactor 关闭套接字
+
+    // 把 c.lanes 中排队的帧按优先级合并写出（每轮每个连接最多调用一次）
+    virtual void flush(Connection& c) = 0;
+    // flush 是否也负责 c.files（零拷贝写文件块）；为 false 时由 reactor 把文件块读成普通帧排进 lanes
+    virtual bool sendsFiles() const { return false; }
+
+    virtual void wake() = 0;                      // 任意线程调用，打断 poll 的等待
+    virtual int wakeHandle() const { return -1; } // 唤醒用的 eventfd（epoll/uring），供共享内存客户端直接写
+    virtual void poll(int64_t timeoutUs) = 0;     // 跑一轮：提交、等待并回调 reactor
+
+    // 本后端发起的系统调用次数（用于对比不同后端），writes 为其中的发送调用
+    std::atomic<uint64_t> syscalls{0};
+    std::atomic<uint64_t> writes{0};
+
+protected:
+    explicit IoBackend(Reactor& owner) : reactor(owner) {}
+    void countSyscall(uint64_t n = 1) { syscalls.fetch_add(n, std::memory_order_relaxed); }
+    void countWrite() {
+        countSyscall();
+        writes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Reactor& reactor;
+};
+
+// 单个连接允许积压的最大字节数，超过视为慢消费者直接断开
+const size_t MAX_PENDING_BYTES = 4 * 1024 * 1024;
+
+// 正在下载文件的连接在内核里最多积压的未发出字节（setSendLowWater）
+const int FILE_LOW_WATER = 128 * 1024;
+
+// 按名字创建后端：select（全平台）、epoll（Linux）、uring（Linux io_uring）
+// 请求的后端不可用时回退：uring -> epoll -> select
+IoBackend* createIoBackend(const std::string& name, Reactor& owner);
+
+// 平台默认后端名
+const char* defaultIoBackend();
+
+#ifdef __linux__
+// 由 UringBackend.cpp 提供；内核不支持 io_uring 时返回 nullptr
+IoBackend* createUringBackend(Reactor& owner);
+#endif
+
+#endif // IO_BACKEND_H
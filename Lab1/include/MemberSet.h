@@ -0,0 +1,117 @@
+#ifndef MEMBER_SET_H
+#define MEMBER_SET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Reactor.h"
+
+// 用户编号：用户名第一次出现时分配，进程内不变（不回收）。
+// 会话成员只存编号，几万人的群每个成员只占 4 字节，扇出时按编号直接查在线连接。
+typedef uint32_t UserId;
+static const UserId NO_USER = 0xFFFFFFFFu;
+
+// 会话成员集合：升序的用户编号数组。
+// 查找是二分，遍历是连续内存；插入、删除要搬移后面的元素，但成员变动远少于消息扇出。
+class MemberSet {
+public:
+    typedef std::vector<UserId>::const_iterator const_iterator;
+
+    bool insert(UserId id) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        if (it != ids.end() && *it == id) return false;
+        ids.insert(it, id);
+        return true;
+    }
+
+    bool erase(UserId id) {
+        auto it = std::lower_bound(ids.begin(), ids.end(), id);
+        if (it == ids.end() || *it != id) return false;
+        ids.erase(it);
+        return true;
+    }
+
+    bool contains(UserId id) const {
+        return std::binary_search(ids.begin(), ids.end(), id);
+    }
+
+    // 批量设置（加载快照时用）：排序去重一次，避免逐个插入的平方开销
+    void assign(std::vector<UserId>&& list) {
+        ids = std::move(list);
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    void clear() { ids.clear(); }
+    const_iterator begin() const { return ids.begin(); }
+    const_iterator end() const { return ids.end(); }
+
+private:
+    std::vector<UserId> ids;
+};
+
+// 私聊会话键：两个用户编号按大小排好后拼成 64 位。
+// 谁先发起、消息往哪个方向发都得到同一个键，不同的两人组合也不会像拼接用户名那样撞到一起
+struct PairKey {
+    uint64_t v = 0;
+
+    PairKey() = default;
+    PairKey(UserId a, UserId b) : v(a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a) {}
+
+    UserId lo() const { return (UserId)(v >> 32); }
+    UserId hi() const { return (UserId)v; }
+    // 会话中的另一方
+    UserId other(UserId self) const { return self == lo() ? hi() : lo(); }
+
+    bool operator==(const PairKey& o) const { return v == o.v; }
+    bool operator<(const PairKey& o) const { return v < o.v; }
+};
+
+// 编号是连续分配的，直接取模会让相邻的键挤在一起，先打散一次
+struct PairKeyHash {
+    size_t operator()(const PairKey& k) const {
+        uint64_t x = k.v;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return (size_t)x;
+    }
+};
+
+// 用户名 <-> 编号，以及每个编号当前的在线连接。所有操作都要持有 clientMutex
+class UserDirectory {
+public:
+    // 查找编号，没有则分配
+    UserId intern(const std::string& name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        UserId id = (UserId)names.size();
+        ids.emplace(name, id);
+        names.push_back(name);
+        conns.push_back(INVALID_CONN);
+        return id;
+    }
+
+    // 只查找，没有返回 NO_USER
+    UserId find(const std::string& name) const {
+        auto it = ids.find(name);
+        return it != ids.end() ? it->second : NO_USER;
+    }
+
+    const std::string& name(UserId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+    ConnId connOf(UserId id) const { return id < conns.size() ? conns[id] : INVALID_CONN; }
+    void setConn(UserId id, ConnId conn) { conns[id] = conn; }
+
+private:
+    std::unordered_map<std::string, UserId> ids;
+    std::vector<std::string> names;
+    std::vector<ConnId> conns;     // INVALID_CONN 表示不在线
+};
+
+#endif // MEMBER_SET_H
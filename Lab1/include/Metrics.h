@@ -0,0 +1,84 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "Common.h"
+
+// ========== 服务器指标 ==========
+// 计数器按线程分片：每个线程固定写自己的分片（独占一条缓存行），只在抓取时求和，
+// 热路径上只是一次无竞争的原子加。通过独立的本地 HTTP 端口以 Prometheus 文本格式导出。
+
+const int COUNTER_SHARDS = 16;
+
+// 当前线程使用的分片编号（首次调用时轮流分配）
+inline int counterShard() {
+    static std::atomic<int> next{0};
+    thread_local int shard = next.fetch_add(1, std::memory_order_relaxed) % COUNTER_SHARDS;
+    return shard;
+}
+
+class ShardedCounter {
+public:
+    void add(uint64_t n = 1) { slots[counterShard()].v.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const {
+        uint64_t sum = 0;
+        for (const auto& s : slots) sum += s.v.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> v{0};
+    };
+    Slot slots[COUNTER_SHARDS];
+};
+
+struct ServerMetrics {
+    ShardedCounter framesIn[MT_TYPE_COUNT];    // 按消息类型
+    ShardedCounter framesOut[MT_TYPE_COUNT];
+    ShardedCounter bytesIn;
+    ShardedCounter bytesOut;
+    ShardedCounter connOpened;
+    ShardedCounter connClosed;
+    ShardedCounter sendErrors;                 // 发送失败导致的断开
+    ShardedCounter slowConsumers;              // 积压超限被断开的连接
+    ShardedCounter throttledUser;              // 超过用户限额的消息
+    ShardedCounter throttledSession;           // 超过会话限额的消息
+    ShardedCounter throttleDropped;            // 因限流丢弃（warn / drop）
+    ShardedCounter throttleDelayed;            // 因限流暂缓处理（delay）
+    ShardedCounter floodDisconnects;           // 暂缓期间积压超限被断开的连接
+    ShardedCounter poolPaused;                 // 处理池积压过多而暂缓处理的消息
+    ShardedCounter compressConns;              // 协商启用了压缩的连接
+    ShardedCounter compressFrames;             // 被合并压缩的聊天帧
+    ShardedCounter compressBlocks;             // 压缩后发出的 ZIP 帧
+    ShardedCounter compressBytesIn;            // 压缩前的字节（含长度头）
+    ShardedCounter compressBytesOut;           // 压缩后的 ZIP 帧字节
+    ShardedCounter compressNs;                 // 压缩花费的时间
+    ShardedCounter batchIn;                    // 收到并转发的 BATCH 帧
+    ShardedCounter batchItems;                 // 其中的消息条数
+    ShardedCounter batchExpanded;              // 为不支持批量帧的连接拆回逐条 MSG 的 BATCH 帧
+    ShardedCounter lockAcquires;               // clientMutex
+    ShardedCounter lockContended;
+    ShardedCounter lockWaitNs;
+};
+
+ServerMetrics& metrics();
+
+// clientMutex 的计量锁：先 try_lock，拿不到时才计时等待，无竞争时不读时钟
+class MeteredLock {
+public:
+    explicit MeteredLock(std::mutex& m);
+    ~MeteredLock() { mu.unlock(); }
+    MeteredLock(const MeteredLock&) = delete;
+    MeteredLock& operator=(const MeteredLock&) = delete;
+
+private:
+    std::mutex& mu;
+};
+
+// 在 127.0.0.1:port 上启动指标服务线程（GET /metrics），失败返回 false
+bool startMetricsServer(unsigned short port);
+
+#endif // METRICS_H
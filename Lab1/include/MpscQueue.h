@@ -0,0 +1,59 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+#include "ObjectPool.h"
+
+// 无锁多生产者单消费者队列（Vyukov 链表算法）
+// 任意线程都可以 push，只有所属的 reactor 线程 pop。
+// push 只有一次原子 exchange，不会因为消费者忙而阻塞生产者。
+// 节点取自对象池，稳定负载下投递任务不再分配内存。
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() {
+        Node* stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue() {
+        T tmp;
+        while (pop(tmp)) {}
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // 生产者：任意线程
+    void push(T value) {
+        Node* node = ObjectPool<Node>::acquire();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->value = std::move(value);
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 消费者：仅限单个线程；队列为空（或生产者尚未链接完成）时返回 false
+    bool pop(T& out) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) return false;
+        out = std::move(next->value);
+        ObjectPool<Node>::release(tail);
+        tail = next;   // next 成为新的哨兵节点
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    std::atomic<Node*> head;   // 生产者端
+    Node* tail;                // 消费者端（哨兵）
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,78 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <mutex>
+#include <vector>
+
+// 对象池：用过的对象连同其内部已分配的容量（如 std::string 的缓冲）一起回收复用，
+// 稳定负载下不再向堆申请内存。
+// 每个线程先用自己的本地缓存；本地缓存满了或空了，再整批和全局池交换，
+// 所以“在 reactor 线程申请、在工作线程释放”这种跨线程用法也只偶尔加锁。
+template <typename T>
+class ObjectPool {
+public:
+    static T* acquire() {
+        Local& l = local();
+        if (l.items.empty()) refill(l);
+        if (l.items.empty()) return new T();
+        T* obj = l.items.back();
+        l.items.pop_back();
+        return obj;
+    }
+
+    static void release(T* obj) {
+        if (obj == nullptr) return;
+        Local& l = local();
+        l.items.push_back(obj);
+        if (l.items.size() >= LOCAL_MAX) spill(l);
+    }
+
+private:
+    static const size_t LOCAL_MAX = 256;      // 本地缓存上限
+    static const size_t BATCH = 64;           // 与全局池一次交换的个数
+    static const size_t GLOBAL_MAX = 16384;   // 全局池上限，超出的直接释放
+
+    struct Global {
+        std::mutex lock;
+        std::vector<T*> items;
+    };
+
+    struct Local {
+        std::vector<T*> items;
+        ~Local() {
+            // 线程退出：缓存还给全局池
+            while (!items.empty()) spill(*this);
+        }
+    };
+
+    static Global& global() {
+        static Global g;
+        return g;
+    }
+
+    static Local& local() {
+        static thread_local Local l;
+        return l;
+    }
+
+    static void refill(Local& l) {
+        Global& g = global();
+        std::lock_guard<std::mutex> lk(g.lock);
+        for (size_t i = 0; i < BATCH && !g.items.empty(); i++) {
+            l.items.push_back(g.items.back());
+            g.items.pop_back();
+        }
+    }
+
+    static void spill(Local& l) {
+        Global& g = global();
+        std::lock_guard<std::mutex> lk(g.lock);
+        for (size_t i = 0; i < BATCH && !l.items.empty(); i++) {
+            if (g.items.size() < GLOBAL_MAX) g.items.push_back(l.items.back());
+            else delete l.items.back();
+            l.items.pop_back();
+        }
+    }
+};
+
+#endif // OBJECT_POOL_H
@@ -0,0 +1,76 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// ========== 平台层：套接字、错误码、控制台 ==========
+// Windows 下是 Winsock，Linux 等平台是 BSD 套接字。其余代码只包含这个头文件，
+// 统一使用 SOCKET / INVALID_SOCKET / SOCKET_ERROR / SD_BOTH 以及下面的函数，
+// 不再直接调用 WSAStartup、closesocket、ioctlsocket 之类的 Winsock 接口。
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define SD_RECEIVE SHUT_RD
+#define SD_SEND SHUT_WR
+#define SD_BOTH SHUT_RDWR
+#endif
+
+// 进程启动时调用一次：Windows 初始化 Winsock；其它平台忽略 SIGPIPE，
+// 对端已关闭时 send 返回错误而不是直接结束进程
+bool netStartup();
+void netCleanup();
+
+void closeSocket(SOCKET s);
+void setNonBlocking(SOCKET s);
+void setNoDelay(SOCKET s);
+// 限制内核里尚未发出的字节数（Linux 的 TCP_NOTSENT_LOWAT）：大块数据不会在发送缓冲里堆积，
+// 后写的小帧不必排在几 MB 数据之后。其它平台不做任何事
+void setSendLowWater(SOCKET s, int bytes);
+int socketError();                 // 上一次套接字调用的错误码（WSAGetLastError / errno）
+bool socketWouldBlock();           // 上一次套接字调用是否只是“暂时无法完成”
+
+// 连到本机 127.0.0.1:port（压测与同机工具用），失败返回 INVALID_SOCKET。
+// rcvBuf > 0 时在 connect 之前设置接收缓冲，握手时通告的窗口才会跟着变小
+SOCKET connectTcp(unsigned short port, int rcvBuf = 0);
+
+// Unix 域套接字（同机的机器人、网关进程不经过 TCP 协议栈）。仅 POSIX 平台，其它平台返回 INVALID_SOCKET。
+// listenUnix 先删除 path 上残留的文件再绑定
+SOCKET listenUnix(const std::string& path, int backlog);
+SOCKET connectUnix(const std::string& path);
+
+// 文件传输用的只读文件句柄（POSIX 文件描述符 / Windows CRT 句柄），失败返回 -1
+int openFileRead(const std::string& path);
+void closeFile(int fd);
+// stdio 文件定位到 offset。Windows 的 long 只有 32 位，fseek 超过 2 GB 会回绕，
+// 所以这里走 _fseeki64 / fseeko
+bool seekFile(FILE* f, uint64_t offset);
+// 从 offset 处读至多 len 字节，返回读到的字节数，出错返回 -1
+long readFileAt(int fd, char* buf, size_t len, uint64_t offset);
+// 零拷贝：把文件 offset 处的 len 字节直接从页缓存写进套接字（Linux sendfile），返回写出的字节数，出错返回 -1。
+// 其它平台不支持（sendFileSupported 为 false），调用方改为 readFileAt 后再 send
+bool sendFileSupported();
+long sendFileAt(SOCKET s, int fd, uint64_t offset, size_t len);
+
+// 控制台按 UTF-8 输入输出（Windows 切换代码页，其它平台终端本来就是 UTF-8）
+void setupConsole();
+
+#endif // PLATFORM_H
@@ -0,0 +1,42 @@
+#ifndef PRESENCE_H
+#define PRESENCE_H
+
+#include <ostream>
+#include <string>
+#include "Common.h"
+#include "Reactor.h"
+
+// ========== 集群在线目录：增量 gossip + 版本向量 ==========
+// 每个节点只对连在自己身上的用户负责：用户上线、下线时本节点的版本号加一，记录“用户名 -> (连接, 是否在线, 版本号)”。
+// 每个来源节点的记录按版本号排好，同一用户只保留最新一条，所以短时间内反复上下线只会发出最后的状态。
+// 各节点每隔 GOSSIP_INTERVAL_MS 把对方还没有的记录（按对方上次报来的版本向量算增量）攒成一条消息发出，
+// 同时附上自己的版本向量。从其它节点收到的记录在几轮之后对方仍未确认时才转发，
+// 直连链路正常时不重复发送，某条链路断开时目录仍能经第三个节点收敛。
+// 查询只读本机内存（presenceFind），不产生网络往返。
+// 每个节点启动时取一个纪元（启动时刻），重启后纪元变大，其它节点据此清掉它上一次运行留下的记录。
+// 下线的记录作为墓碑保留（每个用户名一条），目录大小以出现过的用户数为上限。
+
+const int GOSSIP_INTERVAL_MS = 100;
+
+// 由 startCluster 调用
+void startPresence(int nodes, int self);
+bool presenceEnabled();
+
+// 本节点的用户上线 / 下线（调用方持有 clientMutex，保证与 userSocket 的修改顺序一致）
+void presenceLocal(const std::string& name, ConnId conn, bool online);
+
+// 查询用户：目录里没有返回 false；有记录时 conn 为它当前的连接（其它节点上的用户是远端连接），不在线为 INVALID_CONN
+bool presenceFind(const std::string& name, ConnId& conn);
+
+// ---- 供 Cluster 的 gossip 线程与接收线程调用 ----
+// 每轮 gossip 开始时调用一次（推进转发的时间线）
+void presenceTick();
+// 生成发给 peer 的 gossip；没有新内容且 force 为 false 时返回 false
+bool buildGossip(int peer, std::string& out, bool force);
+void applyGossip(int from, const char* data, size_t len);
+// 到 peer 的链路（重新）建立：已发出但可能丢失的增量从对方确认过的版本重发
+void presenceLinkUp(int peer);
+
+void describePresence(std::ostream& os);
+
+#endif // PRESENCE_H
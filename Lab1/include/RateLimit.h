@@ -0,0 +1,64 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ========== 入口限流：按用户、按会话的令牌桶 ==========
+// 令牌桶用 GCRA 实现：每个桶只有一个时间戳 tat（按当前速率，桶重新装满的时刻），
+// 检查就是一次加法和比较。按用户、按会话的桶都是定长表中的原子量，用 CAS 更新：
+// 用户按编号取槽位（同一用户的多个连接、断线重连都共用一个桶），会话按会话键取槽位
+// （私聊是两人的编号对，群是群名，见 privateRateKey / groupRateKey）。
+// 登录前的连接还没有用户编号，用连接自己的桶。整个检查不加锁、不分配内存，
+// 在拆帧之后、进入处理池（加锁、扇出）之前完成；未开启限流时入口只多一次分支判断。
+
+// 超过限额时的处理方式
+enum ThrottleAction {
+    THROTTLE_WARN,    // 丢弃，并回复 SYS 提示（每个连接每秒最多提示一次）
+    THROTTLE_DROP,    // 静默丢弃
+    THROTTLE_DELAY,   // 暂停处理该连接后面的消息，等令牌补足后继续（不丢消息）
+};
+
+struct RateLimitConfig {
+    double userRate = 0;        // 每个用户每秒的消息数，0 表示不限
+    int userBurst = 20;         // 允许的突发条数（桶容量）
+    double sessionRate = 0;     // 每个会话每秒的 MSG 数，0 表示不限
+    int sessionBurst = 200;
+    ThrottleAction action = THROTTLE_WARN;
+};
+
+// 连接自己的令牌桶：只在登录前使用
+struct TokenBucket {
+    int64_t tat = 0;
+};
+
+// 尚未登录（没有用户编号）
+const uint32_t RATE_ANON = 0xFFFFFFFFu;
+
+// 会话键：两类键分开编码，私聊与同名的群不会共用限额；0 表示不计会话限额
+uint64_t groupRateKey(const std::string& group);
+uint64_t privateRateKey(uint64_t pair);     // pair 为 PairKey::v
+
+// 启动时配置一次，之后只读
+void configureRateLimit(const RateLimitConfig& cfg);
+const RateLimitConfig& rateLimitConfig();
+
+extern bool rateLimitActive;
+inline bool rateLimitEnabled() { return rateLimitActive; }
+
+// 限流使用的单调时钟（微秒）
+inline int64_t rateNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 检查一条消息：放行时扣除令牌并返回 0，否则返回还要等待的微秒数（不扣令牌）。
+// user 是发送者的用户编号，RATE_ANON 时改用 conn；session 为 0 表示不计会话限额；
+// bySession 返回是否因会话限额被拦下。cost 是这一帧算作的消息条数（BATCH 帧按条计）
+int64_t rateLimitCheck(TokenBucket& conn, uint32_t user, uint64_t session, int64_t nowUs, bool& bySession, int cost = 1);
+
+bool parseThrottleAction(const std::string& name, ThrottleAction& out);
+const char* throttleActionName(ThrottleAction action);
+
+#endif // RATE_LIMIT_H
@@ -0,0 +1,217 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Platform.h"
+#include "Common.h"
+#include "FramePool.h"
+#include "HandlerPool.h"
+#include "MpscQueue.h"
+#include "RateLimit.h"
+#include "SendLanes.h"
+#include "Compress.h"
+
+// 连接标识：低 8 位是所属 reactor 的编号，高位是该 reactor 内的自增序号
+// 这样任何线程拿到 ConnId 都能直接算出该把数据投递给哪个 reactor
+typedef uint64_t ConnId;
+const ConnId INVALID_CONN = 0;
+const int MAX_REACTORS = 256;
+
+inline int reactorOf(ConnId conn) { return (int)(conn & 0xFF); }
+
+struct ShmLink;
+
+// 一个客户端连接，取代原来每个客户端一个 handleClient 线程
+// 只由所属 reactor 线程访问，因此不需要加锁；具体怎么收发由 IoBackend 决定
+struct Connection {
+    ConnId id = INVALID_CONN;
+    SOCKET sock = INVALID_SOCKET;
+    FrameDecoder decoder;
+    SendLanes lanes;            // 排队的帧：控制帧优先，聊天消息按会话轮转；一轮结束时合并成一次 writev/sendmsg 写出
+    bool queued = false;        // 是否已在 reactor 的待写列表中
+    bool writeBlocked = false;  // 内核发送缓冲已满，正在等可写（就绪式后端）
+    std::vector<int64_t> tracedAt;  // 排队中被跟踪的帧的入队时刻（写出时统计排队耗时）
+    std::string pending;        // 写了一半的帧的剩余字节（就绪式后端等可写时先写它）
+    std::string inflight;       // 已提交给内核、尚未完成的发送（仅完成式后端使用）
+    bool closing = false;
+    std::shared_ptr<ConnOrder> order;   // 启用处理池时，保证该连接的消息按序处理
+    uint64_t msgsIn = 0;        // 收到的消息数与字节数（管理命令 top 使用）
+    uint64_t bytesIn = 0;
+    TokenBucket bucket;         // 登录前按连接限流；登录后改用 rateUser 的共享桶
+    uint32_t rateUser = RATE_ANON;  // 登录用户的编号（限流用）
+    std::unordered_map<std::string, uint64_t> rateKeys;   // 目标 → 会话键的缓存（私聊建立或删除时清空）
+    Message* held = nullptr;    // 暂缓处理的消息（限流 delay 模式或处理池积压，取自对象池），之后的帧留在 decoder 里
+    bool heldByPool = false;    // held 是因处理池积压而暂缓（已计过限额，重试时不再检查）
+    int64_t resumeAtUs = 0;     // held 可以再次尝试的时刻（rateNowUs）
+    int64_t warnedAtUs = 0;     // 上次发送限流提示的时刻
+    std::shared_ptr<ShmLink> shm;   // 共享内存连接：收发走共享内存环，sock 只是用来感知断开的控制套接字
+    bool eventsOff = false;     // 客户端关闭了会话事件推送：EVENTS 帧不再入队
+    FileLane files;             // 下载中的文件：聊天帧写完后才按块发送
+    bool compress = false;      // 客户端协商了压缩：积压的聊天帧合并压缩成 ZIP 帧
+    std::unique_ptr<ZipEncoder> zip;   // 压缩的流式状态（第一次压缩时创建，跟随连接的整个生命周期）
+    bool batchOk = false;       // 客户端能解析 BATCH 帧；否则发给它的批量帧拆回逐条 MSG
+};
+
+// 单个连接的统计快照（由所属 reactor 在自己的线程内填写）
+struct ConnStat {
+    ConnId id = INVALID_CONN;
+    uint64_t msgsIn = 0;
+    uint64_t bytesIn = 0;
+    size_t queuedBytes = 0;     // 尚未写出的字节：排队帧 + 上次没写完的 + 已提交未完成的
+    size_t queuedFrames = 0;
+};
+
+// 其它线程投递给 reactor 的任务（经无锁邮箱传递）
+struct ReactorTask {
+    enum Kind { TASK_NONE, TASK_ADOPT, TASK_SEND, TASK_FANOUT, TASK_CLOSE, TASK_STOP_LISTEN, TASK_CALL };
+    Kind kind = TASK_NONE;
+    ConnId conn = INVALID_CONN;         // TASK_SEND / TASK_CLOSE 的目标
+    SOCKET sock = INVALID_SOCKET;       // TASK_ADOPT：由共享监听线程接入的新连接
+    std::shared_ptr<ShmLink> shm;       // TASK_ADOPT：共享内存连接（已完成握手）
+    FramePtr frame;
+    std::vector<ConnId> targets;        // TASK_FANOUT：本 reactor 内的一组接收者
+    std::function<void()> call;         // TASK_CALL：在 reactor 线程内执行（管理命令读取连接状态）
+};
+
+class IoBackend;
+
+// 反应堆线程：独立的监听套接字、独立的 I/O 后端（epoll/select/io_uring）、独立的连接集合
+class Reactor {
+public:
+    explicit Reactor(int index);
+    ~Reactor();
+
+    bool init(const std::string& ioBackend);     // 创建 I/O 后端，不可用时自动回退
+    bool listenOn(SOCKET listener);              // 接管一个（SO_REUSEPORT）监听套接字
+    void start();
+    void stop();
+    void join();
+
+    void post(ReactorTask task);                 // 任意线程调用
+    void sendLocal(ConnId conn, const FramePtr& frame);  // 仅本线程调用
+    void sendFileLocal(ConnId conn, int fd, const std::string& hash, uint64_t offset, uint64_t end);  // 仅本线程调用
+    int index() const { return idx; }
+    const char* backendName() const;
+    uint64_t syscallCount() const;
+    uint64_t writeCount() const;
+    int wakeHandle() const;                      // 唤醒本 reactor 的 eventfd（共享内存客户端直接写它），没有时返回 -1
+
+    // ---- 供 IoBackend 回调（均在本 reactor 线程内） ----
+    void onAccept(SOCKET sock, std::shared_ptr<ShmLink> shm = nullptr);
+    void onData(Connection& c, const char* data, size_t len);
+    void markClosing(Connection& c);
+    Connection* findConn(ConnId conn);
+    void collectConnStats(std::vector<ConnStat>& out) const;   // 仅本线程调用
+
+    // 统计（供基准测试与日志使用）
+    std::atomic<uint64_t> acceptedCount{0};
+    std::atomic<uint64_t> framesIn{0};
+    std::atomic<uint64_t> framesOut{0};
+    std::atomic<uint64_t> mailboxPosted{0};     // 两者之差为邮箱中待处理的任务数
+    std::atomic<uint64_t> mailboxDrained{0};
+
+private:
+    void run();
+    void drainMailbox();
+    void flushOutput();
+    int64_t pollTimeoutUs() const;
+    void closeMarked();
+    void processInput(Connection& c, int64_t recvUs);   // 从 decoder 中取帧、解析并处理
+    void dispatch(Connection& c, Message* m);           // 把解析好的消息交给处理池（或直接处理）
+    bool throttle(Connection& c, Message* m);           // 超过限额时按配置处理并返回 true
+    void hold(Connection& c, Message* m, int64_t resumeAtUs, bool byPool);   // 暂缓 m，到 resumeAtUs 再试
+    void resumeThrottled();                              // 重新尝试到期的暂缓消息
+    void pumpFiles();                                    // 有下载的连接：空闲时发下一块（或交给后端零拷贝写出）
+    void queueFlush(Connection& c);                      // 把连接加入本轮待写列表
+    bool armShm();                                       // 准备阻塞：登记各共享内存环的等待标志，已有数据时返回 false
+    void pollShm();                                      // 读各共享内存环，并重试之前写满的连接
+    void flushShm(Connection& c);                        // 把排队的帧写进共享内存环
+    void compressBulk(Connection& c);                    // 把积压的聊天帧合并压缩成 ZIP 帧，放进控制通道
+    void expandBatch(ConnId conn, const FramePtr& frame); // BATCH 帧拆成逐条 MSG 入队
+
+    int idx;
+    uint64_t nextSeq = 1;
+    std::atomic<bool> running{false};
+    std::atomic<bool> wakePending{false};
+    SOCKET listenSock = INVALID_SOCKET;
+    std::unique_ptr<IoBackend> backend;
+    std::unordered_map<ConnId, Connection> conns;
+    std::vector<ConnId> toClose;
+    std::vector<ConnId> throttled;               // 有暂缓消息的连接（限流 delay 模式或处理池积压）
+    int64_t nextResumeUs = 0;                    // 其中最早可以重试的时刻
+    Message scratch;                             // 在本线程内直接处理消息时复用的解析结果
+    std::vector<ConnId> toFlush;                 // 本轮有帧排队的连接
+    std::vector<ConnId> shmConns;                // 共享内存连接（每轮都要检查它们的环）
+    std::vector<ConnId> fileConns;               // 文件通道里有待发文件的连接
+    std::chrono::steady_clock::time_point corkStart;   // 本轮第一帧排队的时间
+    MpscQueue<ReactorTask> mailbox;
+    std::thread worker;
+};
+
+// ========== reactor 组 ==========
+
+// 启动 count 个 reactor（count <= 0 时取 CPU 核数），监听 port
+// ioBackend 为 select / epoll / uring，不可用时回退到平台默认后端
+// inherited 为从旧进程接管的监听套接字（热重启），优先使用，不足的部分再新建
+bool startReactors(int count, unsigned short port, const std::string& ioBackend,
+                   const std::vector<SOCKET>& inherited = std::vector<SOCKET>());
+void stopReactors();
+void joinReactors();
+int getReactorCount();
+Reactor* getReactor(int index);
+
+// 额外在 Unix 域套接字 path 上接受连接（仅 POSIX），协议与 TCP 连接完全相同。
+// 由一个接入线程轮流分给各 reactor；热重启时不交接，由新进程重新绑定同一路径
+bool startUnixListener(const std::string& path);
+
+// 在 Unix 域套接字 path 上接受共享内存连接（仅 Linux，需要 epoll 或 uring 后端）：
+// 握手后收发都走共享内存环，帧格式与 TCP 相同；同样不参与热重启交接
+bool startShmListener(const std::string& path);
+
+// 启动时创建或接管的 TCP 监听套接字（交接给新进程用）
+std::vector<SOCKET> getListeners();
+
+// 关闭所有监听套接字，包括 Unix 域套接字和共享内存控制套接字（不再接受新连接）
+void closeListeners();
+
+// 把协议字符串封帧后投递给某个连接（线程安全）
+void sendTo(ConnId conn, const std::string& payload);
+void sendFrameTo(ConnId conn, const FramePtr& frame);
+
+// 把同一帧扇出给一组连接：按 reactor 分组，每个 reactor 只投递一次邮箱
+void fanOut(const std::vector<ConnId>& targets, const FramePtr& frame);
+
+// 请求关闭连接（线程安全）
+void closeConnection(ConnId conn);
+
+// 把文件 fd 的 [offset, end) 排进连接的文件通道（线程安全，fd 随后归文件通道所有并负责关闭）。
+// 在这之前用 sendTo 投递给该连接的帧先写出
+void sendFileTo(ConnId conn, int fd, const std::string& hash, uint64_t offset, uint64_t end);
+
+// 打开 / 关闭某个连接的会话事件推送（线程安全，之后投递给该连接的 EVENTS 帧按新设置处理）
+void setConnEvents(ConnId conn, bool wanted);
+
+// 标记某个连接能解析 BATCH 帧（线程安全，JOIN 声明了 batch 时调用；在此之前发给它的批量帧拆成逐条 MSG）
+void setConnBatch(ConnId conn);
+
+// 为某个连接开启压缩（线程安全，客户端协商成功后调用；之后积压的聊天帧按 compressMinBytes 合并压缩）
+void setConnCompress(ConnId conn);
+
+// 告诉连接它的登录用户编号（线程安全，JOIN 时调用；之后该连接按用户共享的桶限流）
+void setConnUser(ConnId conn, uint32_t user);
+
+// 清空连接缓存的限流会话键（线程安全，私聊建立或删除时调用，调用方可持有 clientMutex）
+void resetConnRateKey(ConnId conn);
+
+// 向每个 reactor 投递一次统计任务，汇总所有连接的快照（最多等待 timeoutMs，超时的 reactor 跳过）
+// 会阻塞等待，不能在 reactor 线程内调用
+std::vector<ConnStat> snapshotConnections(int timeoutMs = 1000);
+
+#endif // REACTOR_H
@@ -0,0 +1,110 @@
+#ifndef SEND_LANES_H
+#define SEND_LANES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "FramePool.h"
+
+// 连接上尚未写出的帧：vector + 队头下标，取空后复用容量，稳定负载下不分配内存
+class FrameQueue {
+public:
+    bool empty() const { return head == items.size(); }
+    size_t size() const { return items.size() - head; }
+    const FramePtr& front() const { return items[head]; }
+    void push_back(const FramePtr& f) { items.push_back(f); }
+    FramePtr pop_front();
+    void push_front(FramePtr f);
+    void clear();
+
+private:
+    std::vector<FramePtr> items;
+    size_t head = 0;
+};
+
+// ========== 每个连接的发送通道 ==========
+// 控制帧（SYS 回复、加入/退出通知、RECONNECT……）走优先通道，总是排在聊天消息前面写出；
+// 聊天消息按会话分流，各流之间按权重做差额轮转（DRR），刷屏的会话不会饿死其它会话。
+// 同一通道、同一会话内保持先后顺序。只由连接所属的 reactor 线程访问。
+class SendLanes {
+public:
+    void push(const FramePtr& f);
+    // 取出下一帧（先控制通道，再按轮转），为空时返回空指针
+    FramePtr pop();
+    // 只从聊天消息的各会话流里按轮转取（压缩积压时用），没有时返回空指针
+    FramePtr popBulk();
+    // 写不下的帧放回原通道的队头，按 pop 的相反顺序调用
+    void unpop(FramePtr f);
+    void clear();
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    size_t bytes() const { return queuedBytes; }
+    size_t bulkBytes() const { return bulkQueued; }   // 各会话流中的字节数
+
+private:
+    struct Flow {
+        uint32_t key = 0;
+        int weight = 1;
+        long long deficit = 0;   // DRR 本轮剩余的可发送字节数
+        FrameQueue q;
+    };
+    Flow& flowOf(uint32_t key, int weight);
+
+    FrameQueue control;
+    std::vector<Flow> flows;
+    size_t cursor = 0;           // 轮转当前所在的流
+    size_t bulkCount = 0;        // 各会话流中的帧数
+    size_t bulkQueued = 0;       // 各会话流中的字节数
+    size_t count = 0;
+    size_t queuedBytes = 0;
+};
+
+// ========== 每个连接的文件通道 ==========
+// 下载的文件不进 SendLanes，也不计入积压上限：只有聊天帧（含控制帧）全部写完时才发下一块，
+// 一块就是一帧 FILE_DATA（FILE_CHUNK_SIZE 字节）。写到一半的块必须先写完，块与块之间新到的聊天帧先走，
+// 所以几 MB 的下载最多让聊天帧多等一块。支持 sendfile 的后端由 startChunk 取出帧头后
+// 把文件内容从页缓存直接写进套接字（零拷贝）；其它后端用 readChunk 读成一帧再按普通帧写出。
+// 只由连接所属的 reactor 线程访问。
+class FileLane {
+public:
+    FileLane() {}
+    FileLane(const FileLane&) = delete;
+    FileLane& operator=(const FileLane&) = delete;
+    ~FileLane() { clear(); }
+
+    // 排入一个文件的 [offset, end)；fd 由文件通道负责关闭
+    void push(int fd, const std::string& hash, uint64_t offset, uint64_t end);
+    bool empty() const { return files.empty() && !midChunk(); }
+    bool midChunk() const { return headSent < head.size() || bodyLeft > 0; }
+    uint64_t bytes() const;     // 还没写出的文件字节
+    void clear();
+
+    // 零拷贝：开始下一块，填好帧头 head（长度头 + FILE_DATA 前缀）与文件内容的位置；没有文件时返回 false
+    bool startChunk();
+    std::string head;
+    size_t headSent = 0;
+    int bodyFd = -1;
+    uint64_t bodyOffset = 0;
+    size_t bodyLeft = 0;
+
+    // 其它后端：读出下一块作为一帧；读失败时丢掉该文件并返回空
+    FramePtr readChunk();
+
+private:
+    struct FileSend {
+        int fd;
+        std::string hash;
+        uint64_t offset;
+        uint64_t end;
+    };
+    size_t chunkOf(FileSend& f);   // 丢掉已发完的文件，返回下一块的长度（没有时为 0）
+    void closeDone();
+
+    std::deque<FileSend> files;
+    int doneFd = -1;            // 最后一块正在写出的文件，写完（开始下一块）时关闭
+};
+
+#endif // SEND_LANES_H
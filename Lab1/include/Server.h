@@ -6,10 +6,15 @@
 #include <vector>
 #include <thread>
 #include <algorithm>
-#include<winsock2.h>
 #include"Common.h"
+#include"Reactor.h"
+#include"Metrics.h"
+#include"MemberSet.h"
+#include"RateLimit.h"
+#include"SessionEvents.h"
 #include <mutex>
 #include<set>
+#include <unordered_set>
 
 
 //定义接口和用户名之间的映射
@@ -17,34 +22,107 @@
 class ServerSession {
 public:
     std::string id;
-    SessionType type;
-    std::set<std::string> members;  // 在线成员
+    SessionType type = ST_GROUP;
+    MemberSet members;  // 成员的用户编号（见 users）
 };
-std:: map<SOCKET,std::string> socketUser;
-std::map<std::string, SOCKET> userSocket;
-std::mutex clientMutex;//保护映射表的互斥锁,用于枷锁保护的参数
-std::map<std::string, ServerSession> sessions;//用于管理所有的会话
+//连接由 reactor 统一管理，这里用 ConnId 标识客户端连接
+extern std::map<ConnId,std::string> socketUser;
+extern std::map<std::string, ConnId> userSocket;
+extern std::mutex clientMutex;//保护映射表的互斥锁,用于枷锁保护的参数
+extern std::map<std::string, ServerSession> sessions;//用于管理所有的会话
+extern UserDirectory users;//用户名与编号、在线连接的对应（由 clientMutex 保护）
+extern std::unordered_set<PairKey, PairKeyHash> privateSessions;//私聊会话：两人的编号对（由 clientMutex 保护）
+
+//分批遍历会话表等全局 map 时每批处理的条目数：每批单独加锁，批与批之间让出 clientMutex
+static const size_t SCAN_CHUNK = 256;
+
+//分批遍历 std::map：每批持锁访问至多 SCAN_CHUNK 项，下一批从上一批最后一个键之后继续。
+//两批之间表可能被修改，因此结果是近似快照（诊断、写快照时配合变更日志使用）。
+template <typename K, typename V, typename F>
+void scanInChunks(const std::map<K, V>& table, F visit) {
+    K last{};
+    bool started = false;
+    while (true) {
+        MeteredLock lock(clientMutex);
+        auto it = started ? table.upper_bound(last) : table.begin();
+        for (size_t n = 0; it != table.end() && n < SCAN_CHUNK; ++it, ++n) {
+            visit(it->first, it->second);
+            last = it->first;
+            started = true;
+        }
+        if (it == table.end()) return;
+    }
+}
+
+//拷贝全部私聊会话键：哈希表在两批之间可能重排，不能像 std::map 那样从上一个键续扫，
+//只好一次持锁拷出（每个键 8 字节）；查用户名等较慢的工作由调用方在锁外或分批完成
+std::vector<PairKey> privateSessionKeys();
+
+//服务器启动参数
+struct ServerConfig {
+    unsigned short port = 8888;
+    int reactors = 0;       // reactor 线程数，0 表示取 CPU 核数
+    bool verbose = true;    // 是否逐条打印收发日志（压测时用 --quiet 关闭）
+    std::string ioBackend;  // I/O 后端：select / epoll / uring，空表示平台默认
+    bool stats = false;     // 每秒打印一次吞吐与系统调用统计
+    int corkUs = 0;         // 发送合并窗口（微秒）：0 表示每轮事件循环结束立即写出
+    int workers = -1;       // 消息处理线程数：-1 取 CPU 核数，0 表示在 reactor 线程内直接处理
+    unsigned short metricsPort = 0;   // Prometheus 指标端口（仅本机），0 表示不开启
+    unsigned short adminPort = 0;     // 管理命令端口（仅本机），0 表示只用 stdin
+    std::string handoffPath;          // 热重启交接用的 Unix 域套接字路径，空表示不启用
+    std::string unixPath;             // 同机客户端连接用的 Unix 域套接字路径，空表示只监听 TCP
+    std::string shmPath;              // 共享内存连接的控制套接字路径（仅 Linux），空表示不启用
+    std::string clusterNodes;         // 集群所有节点的节点间地址（host:port,...），空表示单机
+    int nodeIndex = -1;               // 本节点在 clusterNodes 中的序号
+    int eventTickMs = EVENT_TICK_MS;  // 会话事件的合并周期（毫秒），0 表示每个事件立即发出
+    std::string blobDir;              // 大文件存储目录，空表示不支持文件传输
+    int compressMinBytes = 2048;      // 积压的聊天帧达到这么多字节才压缩（仅协商过的连接），0 表示不压缩
+    int drainSeconds = 10;            // 排空时客户端重连的随机延迟窗口（秒）
+    std::string stateDir;             // 会话快照与变更日志目录，空表示不持久化
+    int snapshotSeconds = 60;         // 写快照的间隔（秒）
+    RateLimitConfig rateLimit;        // 入口限流（按用户、按会话），默认不限
+};
+extern ServerConfig serverConfig;
 
 
 //主要函数声明
-void handleClient(SOCKET clientSocket); //处理客户端请求
-void onJoin(const Message& m, SOCKET clientSocket);
-void onJoinSession(const Message& m, SOCKET clientSocket);  // 新增：加入会话
-void onLeaveSession(const Message& m, SOCKET clientSocket); // 新增：离开会话
-void onMsg(const Message& m, SOCKET clientSocket);
-void onExit(const Message& m, SOCKET clientSocket);
+void onJoin(const Message& m, ConnId clientConn);
+void onJoinSession(const Message& m, ConnId clientConn);  // 新增：加入会话
+void onLeaveSession(const Message& m, ConnId clientConn); // 新增：离开会话
+void onMsg(const Message& m, ConnId clientConn);
+void onExit(const Message& m, ConnId clientConn);
+void onCreateGroup(const Message& m, ConnId clientConn);   // 创建命名群聊
+void onTyping(const Message& m, ConnId clientConn);        // 正在输入
+void onEvents(const Message& m, ConnId clientConn);        // 开关会话事件推送
+void onFilePut(const Message& m, ConnId clientConn);       // 声明上传（去重、续传）
+void onFileData(const Message& m, ConnId clientConn);      // 上传的文件块
+void onFileGet(const Message& m, ConnId clientConn);       // 下载
+void onCompress(const Message& m, ConnId clientConn);      // 协商压缩
+void onDisconnect(ConnId clientConn);                     // 连接断开（reactor 关闭连接时调用）
 //处理消息
-void handleMessage(const Message &m, SOCKET clientSocket);
+void handleMessage(const Message &m, ConnId clientConn);
+//消息在处理池中的串行键：同一会话的消息串行，空串表示跟随所在连接
+const std::string& messageOrderKey(const Message &m);
+//限流的会话键：user 与 target 之间有私聊时按两人的编号对，否则按群名（reactor 在连接的缓存未命中时调用）
+uint64_t rateSessionKey(uint32_t user, const std::string &target);
 // 通用广播
-void broadcast(const std::string& data, SOCKET excludeSocket = INVALID_SOCKET);
+void broadcast(const std::string& data, ConnId excludeConn = INVALID_CONN);
+// 只广播给连在本节点上的用户（集群中其它节点转来的广播用它，避免再转回去）
+void broadcastLocal(const std::string& data, ConnId excludeConn = INVALID_CONN);
+//排空：停止接入新连接，通知在线客户端在 [0, windowMs) 内的随机时刻重连，连接全部断开（或超时）后退出
+void drainServer(int windowMs);
+void shutdownServer();
 
 
 //在服务器端增加会话管理函数
-void createGroupSession(const std::string &groupName);
-void createPrivateSession(const std::string &user1, const std::string &user2);
+//创建群聊并把创建者加入，群已存在（或与会话重名）时返回 false
+bool createGroupSession(const std::string &groupName, const std::string &creator);
+//建立 / 删除两人之间的私聊会话，返回是否有变化（调用方持有 clientMutex）
+bool createPrivateSession(const std::string &user1, const std::string &user2);
+bool dropPrivateSession(const std::string &user1, const std::string &user2);
 void addUserToSession(const std::string &sessionid ,const std::string & uerName);
 void removeUserFromSession(const std::string &sessionId, const std::string & userName);
-void broadcastToSession(const std::string & sessionId, const std::string & msg, SOCKET excludeSocket);
+//traceUs 非 0 表示转发的是被跟踪的消息（路由完成时刻），reactor 据此统计入队与写出耗时
+void broadcastToSession(const std::string & sessionId, const std::string & msg, ConnId excludeConn, int64_t traceUs = 0);
 
 #endif // SERVER_H
-
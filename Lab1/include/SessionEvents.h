@@ -0,0 +1,40 @@
+#ifndef SESSION_EVENTS_H
+#define SESSION_EVENTS_H
+
+#include <ostream>
+#include <string>
+#include "Common.h"
+#include "Reactor.h"
+
+// ========== 会话事件：加入 / 离开 / 下线 / 正在输入，按周期合并后发出 ==========
+// 事件发生时不立即广播，先记进该会话本轮的待发表；每隔 tick（默认 100ms）把一个会话在这一轮里的
+// 全部变化合成一帧发给当时的成员：
+//   EVENTS|Server|<会话>|j:alice,l:bob,o:carol,t:dave|时间戳
+// j 加入、l 离开、o 下线（会话 ALL）、t 正在输入。同一用户在一轮里只留最后的状态，
+// 加入后又离开（或离开后又加入）互相抵消，正在输入一轮只发一次。
+// 一个会话在一轮里有 k 个人加入，原来是 k 次广播，现在每个成员每轮只收一帧。
+// 私聊的正在输入直接发给对方，帧里的会话是发送者的名字（对方眼里的会话名）。
+// 客户端发 EVENTS|名字||off 关闭事件推送（on 重新打开）：由连接所在的 reactor 在入队时丢掉 EVENTS 帧，
+// 集群中其它节点转来的也一样过滤。
+
+enum SessionEventKind {
+    EV_JOIN = 'j',
+    EV_LEAVE = 'l',
+    EV_OFFLINE = 'o',
+    EV_TYPING = 't'
+};
+
+const int EVENT_TICK_MS = 100;
+
+// 启动合并线程；tickMs 为 0 时不合并，每个事件立即单独发出
+void startSessionEvents(int tickMs);
+
+// 记录群聊（含 ALL）里的一个事件，下一轮发给该会话的全部成员
+void postSessionEvent(const std::string& sessionId, const std::string& user, SessionEventKind kind);
+
+// 私聊中 from 正在输入：下一轮发给对方的连接 peerConn（可以是其它节点上的连接）
+void postPrivateTyping(ConnId peerConn, const std::string& from);
+
+void describeSessionEvents(std::ostream& os);
+
+#endif // SESSION_EVENTS_H
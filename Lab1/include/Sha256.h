@@ -0,0 +1,31 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SHA-256（FIPS 180-4），文件传输按内容寻址用：服务器以摘要的十六进制串为文件名去重，
+// 客户端上传前、下载后各算一次校验。分块调用 update，最后 hexDigest 取结果（之后不能再 update）
+class Sha256 {
+public:
+    Sha256();
+    void update(const void* data, size_t len);
+    std::string hexDigest();
+
+private:
+    void block(const unsigned char* p);
+
+    uint32_t h[8];
+    unsigned char buf[64];
+    size_t used = 0;
+    uint64_t total = 0;
+};
+
+// 整个文件的摘要，打不开时返回空串
+std::string sha256File(const std::string& path);
+
+// 是否是 64 位小写十六进制的摘要（也保证能安全地用作文件名）
+bool isSha256Hex(const std::string& s);
+
+#endif // SHA256_H
@@ -0,0 +1,192 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "Platform.h"
+
+// ========== 共享内存环：同机机器人进程的传输（仅 Linux） ==========
+// 客户端先连服务器的 --shm 控制套接字（Unix 域），服务器建一块共享内存（memfd），里面是两条
+// 单生产者单消费者的字节环：up（客户端 -> 服务器）与 down（服务器 -> 客户端），
+// 再用 SCM_RIGHTS 把 memfd 和两个 eventfd 交给客户端。环里的字节与 TCP 字节流完全相同
+// （4 字节长度头 + 负载），两端照旧用 FrameDecoder 拆帧。
+// 生产者只在放得下整帧时写入，写完再推进 head；稳定负载下收发只是内存拷贝和原子读写，不进内核。
+// 只有对端事先登记了“我要睡了”（waiting 标志），生产者才写一次 eventfd 叫醒它。
+// 控制套接字一直保持到断开，任意一方退出时另一方都能感知。
+
+const uint32_t SHM_MAGIC = 0x53484d31;      // "SHM1"
+const size_t SHM_RING_BYTES = 1 << 20;      // 每个方向的环大小（2 的幂）
+
+// 一条环的控制字段，生产者与消费者各占一个缓存行，避免互相伪共享
+struct ShmRingHeader {
+    alignas(64) std::atomic<uint64_t> head;             // 生产者累计写入的字节数
+    alignas(64) std::atomic<uint64_t> tail;             // 消费者累计读出的字节数
+    alignas(64) std::atomic<uint32_t> consumerWaiting;  // 消费者即将阻塞，等新数据
+    std::atomic<uint32_t> producerWaiting;              // 生产者因环满在等空间
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory ring needs lock-free 64-bit atomics");
+
+// 共享内存的布局：头部之后依次是 up、down 两段数据区，各 ringBytes 字节
+struct ShmRegion {
+    uint32_t magic;
+    uint32_t ringBytes;
+    ShmRingHeader up;
+    ShmRingHeader down;
+};
+
+// 环的一端（生产者或消费者）。每个进程只用它那一端的方法
+class ShmRing {
+public:
+    ShmRing() {}
+    ShmRing(ShmRingHeader* header, char* data, size_t bytes)
+        : h(header), buf(data), mask(bytes - 1), localHead(header->head.load(std::memory_order_relaxed)) {}
+
+    // ---- 生产者 ----
+    size_t freeBytes() const { return mask + 1 - (size_t)(localHead - h->tail.load(std::memory_order_acquire)); }
+
+    // 追加 len 字节但不发布；放不下时什么也不写，返回 false
+    bool append(const char* data, size_t len) {
+        if (freeBytes() < len) return false;
+        copyIn(data, len);
+        return true;
+    }
+
+    // 追加一帧（长度头 + 负载），不发布
+    bool appendFrame(const char* payload, size_t len) {
+        if (freeBytes() < 4 + len) return false;
+        unsigned char hdr[4] = {(unsigned char)(len >> 24), (unsigned char)(len >> 16), (unsigned char)(len >> 8), (unsigned char)len};
+        copyIn((const char*)hdr, 4);
+        copyIn(payload, len);
+        return true;
+    }
+
+    // 把已追加的字节交给消费者；返回消费者是否在睡、需要写 eventfd 叫醒
+    bool publish() {
+        h->head.store(localHead, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return takeFlag(h->consumerWaiting);
+    }
+
+    // 环满、准备阻塞等空间：登记标志后再看一次，sinceTail 之后消费者已读走数据则不必睡
+    bool prepareWaitSpace(uint64_t sinceTail) {
+        h->producerWaiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (h->tail.load(std::memory_order_acquire) != sinceTail) {
+            h->producerWaiting.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    void endWaitSpace() { h->producerWaiting.store(0, std::memory_order_relaxed); }
+    uint64_t consumed() const { return h->tail.load(std::memory_order_acquire); }
+
+    // ---- 消费者 ----
+    // 可读的字节最多分成两段（环尾一段、环头一段），读完后调用 consume
+    size_t peek(const char*& p1, size_t& n1, const char*& p2, size_t& n2) const {
+        uint64_t tail = h->tail.load(std::memory_order_relaxed);
+        size_t avail = (size_t)(h->head.load(std::memory_order_acquire) - tail);
+        size_t off = (size_t)tail & mask;
+        n1 = avail < mask + 1 - off ? avail : mask + 1 - off;
+        p1 = buf + off;
+        n2 = avail - n1;
+        p2 = buf;
+        return avail;
+    }
+
+    // 释放 n 字节的空间；返回生产者是否在等空间、需要写 eventfd 叫醒
+    bool consume(size_t n) {
+        h->tail.store(h->tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return takeFlag(h->producerWaiting);
+    }
+
+    // 准备阻塞等数据：登记标志后再看一次，已有数据则不必睡
+    bool prepareWait() {
+        h->consumerWaiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (h->head.load(std::memory_order_acquire) != h->tail.load(std::memory_order_relaxed)) {
+            h->consumerWaiting.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    void endWait() { h->consumerWaiting.store(0, std::memory_order_relaxed); }
+
+private:
+    void copyIn(const char* data, size_t len) {
+        size_t off = (size_t)localHead & mask;
+        size_t first = len < mask + 1 - off ? len : mask + 1 - off;
+        memcpy(buf + off, data, first);
+        memcpy(buf, data + first, len - first);
+        localHead += len;
+    }
+
+    static bool takeFlag(std::atomic<uint32_t>& flag) {
+        return flag.load(std::memory_order_relaxed) != 0 && flag.exchange(0, std::memory_order_acq_rel) != 0;
+    }
+
+    ShmRingHeader* h = nullptr;
+    char* buf = nullptr;
+    size_t mask = 0;
+    uint64_t localHead = 0;     // 生产者已追加、可能尚未发布的位置
+};
+
+// 写一次 eventfd（叫醒对端）
+void notifyEvent(int fd);
+
+// ========== 服务器端：一个共享内存连接 ==========
+struct ShmLink {
+    ShmRegion* region = nullptr;
+    size_t regionSize = 0;
+    ShmRing up;                 // 服务器是消费者
+    ShmRing down;               // 服务器是生产者
+    int clientEvent = -1;       // 叫醒客户端（有新数据，或环有了空间）
+    uint64_t blockedTail = 0;   // down 环满时消费者的位置，之后有进展才重试
+    ~ShmLink();
+};
+
+// 在控制套接字 ctl 上完成握手：建共享内存和客户端 eventfd，连同 serverWake（所属 reactor 的唤醒 eventfd）
+// 一起发给客户端。失败返回空
+std::shared_ptr<ShmLink> acceptShmLink(SOCKET ctl, int serverWake);
+
+// ========== 客户端 ==========
+// send 与 recv 阻塞时等的是同一个 eventfd，应在同一线程里调用（交替发送和读取）
+class ShmClient {
+public:
+    ShmClient() {}
+    ~ShmClient();
+    ShmClient(const ShmClient&) = delete;
+    ShmClient& operator=(const ShmClient&) = delete;
+
+    bool connect(const std::string& path);
+    void close();
+
+    // 发送一帧；环满时阻塞等服务器读走。连接已断开返回 false
+    bool send(const char* payload, size_t len);
+    bool send(const std::string& payload) { return send(payload.data(), payload.size()); }
+
+    // 读出服务器发来的字节（交给 FrameDecoder）。没有数据时最多等 timeoutMs 毫秒；
+    // 返回字节数，0 表示超时，-1 表示连接已断开
+    long recv(char* out, size_t cap, int timeoutMs);
+
+    uint64_t wakeups() const { return notifies; }   // 写 eventfd 的次数（稳定负载下应远小于消息数）
+
+private:
+    bool waitEvent(int timeoutMs);   // 阻塞到 eventfd 可读；控制套接字断开时返回 false
+
+    int ctl = -1;
+    int event = -1;             // 服务器叫醒本客户端
+    int serverWake = -1;        // 叫醒服务器的 reactor
+    ShmRegion* region = nullptr;
+    size_t regionSize = 0;
+    ShmRing up;                 // 客户端是生产者
+    ShmRing down;               // 客户端是消费者
+    uint64_t notifies = 0;
+};
+
+#endif // SHM_RING_H
@@ -0,0 +1,37 @@
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <string>
+#include "Common.h"
+
+// ========== 会话状态持久化：快照 + 变更日志 ==========
+// 目录 dir 下有两类文件：
+//   sessions.snap    会话表与私聊表的紧凑二进制快照，头部记录代号 G
+//   journal.<代号>   快照之后的变更记录（建会话、删会话、加成员、删成员、建私聊、删私聊），按代号递增
+// 启动时读入快照，再按顺序重放代号 >= G 的日志，即可恢复重启前的会话与成员关系。
+//
+// 写快照时先切换到新一代日志，再分批拷贝会话表（每批持锁很短，不阻塞消息路由），
+// 编码和写文件都在锁外完成；快照落盘后删除已被它覆盖的旧日志。
+// 拷贝期间发生的变更同时出现在新一代日志里，重放是幂等的集合操作，所以结果一致。
+
+// 启动时加载 dir 中的状态到全局 sessions 与 privateSessions，sessionCount 为加载的会话数（含私聊）；目录中没有状态时返回 false
+bool loadServerState(const std::string& dir, size_t& sessionCount);
+
+// 开始写日志，并每 intervalSec 秒写一次快照（启动后先写一次）
+bool startStatePersistence(const std::string& dir, int intervalSec);
+
+// 停止写日志和快照（热重启交接后由新进程接着写）
+void stopStatePersistence();
+
+// 立即写一次快照，返回是否成功（管理命令 snapshot）
+bool writeSnapshotNow();
+
+// 变更日志：调用方持有 clientMutex，保证日志顺序与内存中的修改顺序一致。未开启持久化时什么都不做
+void journalSessionCreate(const std::string& id, SessionType type);
+void journalSessionDrop(const std::string& id);
+void journalMemberAdd(const std::string& id, const std::string& user);
+void journalMemberDel(const std::string& id, const std::string& user);
+void journalPrivateCreate(const std::string& user1, const std::string& user2);
+void journalPrivateDrop(const std::string& user1, const std::string& user2);
+
+#endif // STATE_STORE_H
@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include "Histogram.h"
+
+// ========== 逐条消息的分段延迟跟踪 ==========
+// 客户端开启跟踪后，在消息的第 6 个字段 TRACE 填入发送时刻；服务器转发时依次追加
+// 收到、解析完、路由时刻，接收方据此算出各段耗时：
+//   TRACE = 客户端发送[,服务器收到,解析完成,路由完成]   （墙钟微秒，逗号分隔）
+// 入队、写出两段只在服务器内部统计，不写进消息。
+// 跨进程的分段（客户端->服务器、服务器->客户端、端到端）依赖双方时钟同步，本机测试时最准确。
+
+enum TraceStage {
+    // 服务器统计
+    STAGE_NET_IN,       // 客户端发送 -> 服务器收到
+    STAGE_PARSE,        // 收到 -> 解析完成
+    STAGE_HANDLE,       // 解析完成 -> 路由完成（含处理池排队）
+    STAGE_FANOUT,       // 路由完成 -> 进入接收者发送队列（含邮箱投递）
+    STAGE_FLUSH,        // 进入发送队列 -> 写出
+    // 客户端统计
+    STAGE_NET_OUT,      // 服务器路由完成 -> 接收方收到
+    STAGE_DISPLAY,      // 接收方收到 -> 显示完成
+    STAGE_END_TO_END,   // 发送方发送 -> 接收方显示完成
+    STAGE_COUNT
+};
+
+// 下标 TRACE_SEND.. 对应 TRACE 字段中各时刻的位置
+enum TraceStamp { TRACE_SEND, TRACE_RECV, TRACE_PARSE, TRACE_ROUTE, TRACE_STAMPS };
+
+const char* traceStageName(int stage);
+
+// 墙钟微秒（跨进程比较需要同一时间基准）
+int64_t traceNowUs();
+
+// 在 out 末尾追加 ",<us>"
+void appendTraceStamp(std::string& out, int64_t us);
+
+// 解析 TRACE 字段，返回解析出的时刻个数（最多 TRACE_STAMPS 个）
+int parseTraceStamps(const std::string& trace, int64_t stamps[TRACE_STAMPS]);
+
+// 一组分段直方图（微秒）
+struct TraceStats {
+    LatencyHistogram stages[STAGE_COUNT];
+
+    void record(int stage, int64_t us) { stages[stage].record(us); }
+    void reset();
+    // 打印 [first, last) 区间内有样本的分段：次数、p50/p99/p999、最大值
+    void print(std::ostream& os, int first, int last) const;
+};
+
+// 服务器端的全局统计（reactor 与处理池线程并发写入）
+TraceStats& serverTraceStats();
+
+#endif // TRACE_H
@@ -0,0 +1,232 @@
+#include "../include/Admin.h"
+#include "../include/BlobStore.h"
+#include "../include/Cluster.h"
+#include "../include/Compress.h"
+#include "../include/Metrics.h"
+#include "../include/Server.h"
+#include "../include/StateStore.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+// 为少量连接查用户名（一次短暂持锁）
+static std::vector<std::string> namesOf(const std::vector<ConnStat>& stats) {
+    std::vector<std::string> names;
+    names.reserve(stats.size());
+    MeteredLock lock(clientMutex);
+    for (const auto& st : stats) {
+        auto it = socketUser.find(st.id);
+        names.push_back(it != socketUser.end() ? it->second : "-");
+    }
+    return names;
+}
+
+static void cmdSessions(std::ostringstream& os, size_t limit) {
+    std::vector<std::pair<size_t, std::string>> rows;
+    scanInChunks(sessions, [&rows](const std::string& id, const ServerSession& s) {
+        rows.emplace_back(s.members.size(), id);
+    });
+    size_t shown = rows.size() < limit ? rows.size() : limit;
+    std::partial_sort(rows.begin(), rows.begin() + shown, rows.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+    size_t pairs;
+    {
+        MeteredLock lock(clientMutex);
+        pairs = privateSessions.size();
+    }
+    os << "sessions: " << rows.size() << " groups, " << pairs << " private, top " << shown << " groups by members\n";
+    for (size_t i = 0; i < shown; i++) {
+        os << "  " << std::left << std::setw(24) << rows[i].second << std::right << std::setw(8) << rows[i].first << "\n";
+    }
+}
+
+// top：收到消息最多的连接；queues：发送积压最多的连接
+static void cmdConnections(std::ostringstream& os, size_t limit, bool byQueue) {
+    std::vector<ConnStat> stats = snapshotConnections();
+    size_t shown = stats.size() < limit ? stats.size() : limit;
+    std::partial_sort(stats.begin(), stats.begin() + shown, stats.end(), [byQueue](const ConnStat& a, const ConnStat& b) {
+        return byQueue ? a.queuedBytes > b.queuedBytes : a.msgsIn > b.msgsIn;
+    });
+    stats.resize(shown);
+    std::vector<std::string> names = namesOf(stats);
+    os << (byQueue ? "queue depth" : "top talkers") << " (" << shown << " connections)\n";
+    os << "  " << std::left << std::setw(20) << "user" << std::right << std::setw(12) << "conn"
+       << std::setw(10) << "msgs" << std::setw(12) << "bytes_in" << std::setw(12) << "queued_B"
+       << std::setw(8) << "frames" << "\n";
+    for (size_t i = 0; i < shown; i++) {
+        const ConnStat& st = stats[i];
+        os << "  " << std::left << std::setw(20) << names[i] << std::right << std::setw(12) << st.id
+           << std::setw(10) << st.msgsIn << std::setw(12) << st.bytesIn << std::setw(12) << st.queuedBytes
+           << std::setw(8) << st.queuedFrames << "\n";
+    }
+}
+
+static void cmdKick(std::ostringstream& os, const std::string& user) {
+    ConnId conn = INVALID_CONN;
+    {
+        MeteredLock lock(clientMutex);
+        auto it = userSocket.find(user);
+        if (it != userSocket.end()) conn = it->second;
+    }
+    if (conn == INVALID_CONN) {
+        os << "user " << user << " not online\n";
+        return;
+    }
+    // 先发通知再关闭：两者进入同一个 reactor 邮箱，关闭前会先写出已排队的帧
+    Message notice{"SYS", "Server", user, "你已被管理员移出服务器"};
+    sendTo(conn, buildMessage(notice));
+    closeConnection(conn);
+    os << "kicked " << user << " (conn " << conn << ")\n";
+}
+
+static void cmdCompress(std::ostringstream& os) {
+    ServerMetrics& mt = metrics();
+    uint64_t in = mt.compressBytesIn.value();
+    uint64_t out = mt.compressBytesOut.value();
+    os << "compress: dictionary " << chatDictionaryId() << " (" << chatDictionary().size() << " B), ";
+    if (serverConfig.compressMinBytes <= 0) os << "disabled (--compress-min 0)\n";
+    else os << "backlog threshold " << serverConfig.compressMinBytes << " B\n";
+    os << "  connections " << mt.compressConns.value() << ", frames " << mt.compressFrames.value() << " -> "
+       << mt.compressBlocks.value() << " ZIP frames\n";
+    os << "  bytes " << in << " -> " << out;
+    if (in > 0) {
+        os << std::fixed << std::setprecision(2) << " (ratio " << (double)in / (double)(out > 0 ? out : 1) << ", saved "
+           << (in > out ? in - out : 0) << " B, " << (double)mt.compressNs.value() / (double)in << " ns/B)";
+    }
+    os << "\n";
+}
+
+static void cmdHelp(std::ostringstream& os) {
+    os << "commands:\n"
+       << "  sessions [N]     sessions with the most members\n"
+       << "  top [N]          connections that sent the most messages\n"
+       << "  queues [N]       connections with the largest send backlog\n"
+       << "  kick <user>      disconnect a user\n"
+       << "  latency          per-stage latency of traced messages\n"
+       << "  latency-reset    clear latency histograms\n"
+       << "  snapshot         write a session snapshot now\n"
+       << "  cluster          peer links and forwarding counters\n"
+       << "  events           coalesced join/leave/offline/typing events\n"
+       << "  blobs            file store: stored, deduplicated, uploading, served\n"
+       << "  compress         per-connection compression: bytes saved and CPU cost\n"
+       << "  drain [S]        stop accepting, ask clients to reconnect within S seconds, then exit\n"
+       << "  shutdown | exit  stop the server\n";
+}
+
+std::string runAdminCommand(const std::string& line, bool& quit) {
+    std::istringstream in(line);
+    std::string cmd, arg;
+    in >> cmd >> arg;
+    size_t limit = 20;
+    if (!arg.empty() && std::isdigit((unsigned char)arg[0])) limit = (size_t)std::strtoul(arg.c_str(), nullptr, 10);
+
+    std::ostringstream os;
+    quit = false;
+    if (cmd.empty()) {
+        return "";
+    } else if (cmd == "help") {
+        cmdHelp(os);
+    } else if (cmd == "sessions") {
+        cmdSessions(os, limit);
+    } else if (cmd == "top") {
+        cmdConnections(os, limit, false);
+    } else if (cmd == "queues") {
+        cmdConnections(os, limit, true);
+    } else if (cmd == "kick") {
+        if (arg.empty()) os << "usage: kick <user>\n";
+        else cmdKick(os, arg);
+    } else if (cmd == "latency") {
+        //各处理阶段的延迟分位数（只统计客户端开启跟踪的消息）
+        os << "[LATENCY] traced messages, microseconds\n";
+        serverTraceStats().print(os, STAGE_NET_IN, STAGE_NET_OUT);
+    } else if (cmd == "latency-reset") {
+        serverTraceStats().reset();
+        os << "[LATENCY] reset\n";
+    } else if (cmd == "snapshot") {
+        os << (writeSnapshotNow() ? "snapshot written\n" : "snapshot failed (is --state-dir set?)\n");
+    } else if (cmd == "cluster") {
+        describeCluster(os);
+    } else if (cmd == "events") {
+        describeSessionEvents(os);
+    } else if (cmd == "blobs") {
+        describeBlobs(os);
+    } else if (cmd == "compress") {
+        cmdCompress(os);
+    } else if (cmd == "drain") {
+        int seconds = arg.empty() ? serverConfig.drainSeconds : std::atoi(arg.c_str());
+        drainServer(seconds * 1000);
+        os << "draining: listeners closed, clients reconnect within " << seconds << "s, then the server exits\n";
+    } else if (cmd == "shutdown" || cmd == "exit") {
+        os << "shutting down\n";
+        quit = true;
+    } else {
+        os << "unknown command: " << cmd << " (try help)\n";
+    }
+    return os.str();
+}
+
+// ========== 管理端口 ==========
+
+static bool sendText(SOCKET s, const std::string& text) {
+    size_t sent = 0;
+    while (sent < text.size()) {
+        int n = send(s, text.data() + sent, (int)(text.size() - sent), 0);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// 每个管理连接一个线程：按行读命令，逐条回复
+static void adminSession(SOCKET s) {
+    std::string buf;
+    char chunk[512];
+    bool quit = false;
+    bool alive = sendText(s, "chat server admin, type help\n> ");
+    while (alive && !quit) {
+        int n = recv(s, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buf.append(chunk, (size_t)n);
+        size_t nl;
+        while (alive && !quit && (nl = buf.find('\n')) != std::string::npos) {
+            std::string line = buf.substr(0, nl);
+            buf.erase(0, nl + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            std::string out = runAdminCommand(line, quit);
+            alive = sendText(s, out + (quit ? "" : "> "));
+        }
+        if (buf.size() > 4096) break;   // 不是正常的命令行
+    }
+    closeSocket(s);
+    if (quit) shutdownServer();
+}
+
+static void adminLoop(SOCKET listener) {
+    while (true) {
+        SOCKET s = accept(listener, nullptr, nullptr);
+        if (s == INVALID_SOCKET) continue;
+        std::thread(adminSession, s).detach();
+    }
+}
+
+bool startAdminServer(unsigned short port) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return false;
+#ifndef _WIN32
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+#endif
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   // 管理命令可以踢人、停服，只对本机开放
+    addr.sin_port = htons(port);
+    if (bind(s, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(s, 4) == SOCKET_ERROR) {
+        closeSocket(s);
+        return false;
+    }
+    std::thread(adminLoop, s).detach();
+    return true;
+}
@@ -0,0 +1,270 @@
+#include "../include/BlobStore.h"
+#include "../include/Sha256.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// 一个正在进行的上传：文件保持打开，边写边算摘要
+struct Upload {
+    std::mutex lock;
+    FILE* file = nullptr;
+    uint64_t size = 0;
+    uint64_t have = 0;
+    Sha256 sha;
+    bool finished = false;
+    bool closed = false;                  // 因断开或闲置被关闭，已从 uploads 中移除
+    std::atomic<uint64_t> owner{0};       // 最近声明它的连接
+    std::atomic<int64_t> lastUs{0};       // 最近一次声明或写入的时刻
+};
+
+static std::string blobDir;
+static std::mutex uploadsLock;
+static std::unordered_map<std::string, std::shared_ptr<Upload>> uploads;
+
+static std::atomic<uint64_t> blobsStored{0};
+static std::atomic<uint64_t> dedupHits{0};
+static std::atomic<uint64_t> badHashes{0};
+static std::atomic<uint64_t> bytesReceived{0};
+static std::atomic<uint64_t> bytesServed{0};
+
+static int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string blobPath(const std::string& hash) {
+    return (fs::path(blobDir) / hash).string();
+}
+
+static int64_t storedSize(const std::string& hash) {
+    std::error_code ec;
+    uint64_t n = fs::file_size(blobPath(hash), ec);
+    return ec ? -1 : (int64_t)n;
+}
+
+bool startBlobStore(const std::string& dir) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (!fs::is_directory(dir, ec)) return false;
+    blobDir = dir;
+    return true;
+}
+
+bool blobStoreEnabled() {
+    return !blobDir.empty();
+}
+
+// 收齐：核对摘要后改名为正式文件（调用方持有 u.lock）
+static BlobWrite finishUpload(const std::string& hash, Upload& u) {
+    fclose(u.file);
+    u.file = nullptr;
+    u.finished = true;
+    std::string part = blobPath(hash) + ".part";
+    std::error_code ec;
+    BlobWrite result = BLOB_DONE;
+    if (u.sha.hexDigest() != hash) {
+        fs::remove(part, ec);
+        badHashes.fetch_add(1, std::memory_order_relaxed);
+        result = BLOB_BAD_HASH;
+    } else {
+        fs::rename(part, blobPath(hash), ec);
+        if (ec) result = BLOB_ERROR;
+        else blobsStored.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lk(uploadsLock);
+    auto it = uploads.find(hash);
+    if (it != uploads.end() && it->second.get() == &u) uploads.erase(it);
+    return result;
+}
+
+// 关闭一个未完成的上传：先在 u.lock 内关文件、置 closed，再从表中移除（与 finishUpload 的加锁顺序相同）
+static void closeUpload(const std::string& hash, const std::shared_ptr<Upload>& u) {
+    std::lock_guard<std::mutex> lk(u->lock);
+    if (u->finished || u->closed) return;
+    if (u->file != nullptr) fclose(u->file);
+    u->file = nullptr;
+    u->closed = true;
+    std::lock_guard<std::mutex> mk(uploadsLock);
+    auto it = uploads.find(hash);
+    if (it != uploads.end() && it->second == u) uploads.erase(it);
+}
+
+// 关闭闲置超时的上传（调用方不持有任何锁）
+static void closeIdleUploads() {
+    int64_t cutoff = nowUs() - (int64_t)UPLOAD_IDLE_SECONDS * 1000000;
+    std::vector<std::pair<std::string, std::shared_ptr<Upload>>> idle;
+    {
+        std::lock_guard<std::mutex> lk(uploadsLock);
+        for (auto& [hash, u] : uploads) {
+            if (u->lastUs.load(std::memory_order_relaxed) < cutoff) idle.emplace_back(hash, u);
+        }
+    }
+    for (auto& [hash, u] : idle) closeUpload(hash, u);
+}
+
+void blobConnClosed(uint64_t owner) {
+    std::vector<std::pair<std::string, std::shared_ptr<Upload>>> owned;
+    {
+        std::lock_guard<std::mutex> lk(uploadsLock);
+        for (auto& [hash, u] : uploads) {
+            if (u->owner.load(std::memory_order_relaxed) == owner) owned.emplace_back(hash, u);
+        }
+    }
+    for (auto& [hash, u] : owned) closeUpload(hash, u);
+}
+
+int64_t blobPut(const std::string& hash, uint64_t size, uint64_t owner, std::string& error) {
+    if (!blobStoreEnabled()) {
+        error = "服务器未开启文件存储";
+        return -1;
+    }
+    if (!isSha256Hex(hash) || size == 0 || size > MAX_BLOB_SIZE) {
+        error = "文件摘要或大小无效";
+        return -1;
+    }
+    int64_t stored = storedSize(hash);
+    if (stored >= 0) {
+        dedupHits.fetch_add(1, std::memory_order_relaxed);
+        return stored;
+    }
+    std::shared_ptr<Upload> u;
+    bool full = false;
+    closeIdleUploads();
+    {
+        std::lock_guard<std::mutex> lk(uploadsLock);
+        auto it = uploads.find(hash);
+        if (it != uploads.end()) {
+            u = it->second;
+        } else {
+            size_t mine = 0;
+            for (auto& entry : uploads) mine += entry.second->owner.load(std::memory_order_relaxed) == owner ? 1 : 0;
+            full = uploads.size() >= MAX_OPEN_UPLOADS || mine >= MAX_UPLOADS_PER_CONN;
+            if (!full) {
+                u = std::make_shared<Upload>();
+                uploads[hash] = u;
+            }
+        }
+        if (u) {
+            u->owner.store(owner, std::memory_order_relaxed);
+            u->lastUs.store(nowUs(), std::memory_order_relaxed);
+        }
+    }
+    if (full) {
+        error = "同时进行的上传过多，请稍后再试";
+        return -1;
+    }
+    std::unique_lock<std::mutex> lk(u->lock);
+    if (u->closed) {
+        // 刚被关闭（已从表中移除）：按新的上传重新声明
+        lk.unlock();
+        return blobPut(hash, size, owner, error);
+    }
+    if (u->finished) {
+        // 刚被另一个连接传完
+        stored = storedSize(hash);
+        if (stored >= 0) return stored;
+        error = "文件校验失败，请重新上传";
+        return -1;
+    }
+    if (u->file != nullptr) {
+        if (u->size != size) {
+            error = "同一摘要的文件正在以不同大小上传";
+            return -1;
+        }
+        return (int64_t)u->have;
+    }
+    // 第一次声明：接着磁盘上的 .part 续传，先把已有部分算进摘要
+    std::string part = blobPath(hash) + ".part";
+    u->size = size;
+    u->have = 0;
+    if (FILE* old = fopen(part.c_str(), "rb")) {
+        char buf[65536];
+        size_t n;
+        while (u->have < size && (n = fread(buf, 1, sizeof(buf), old)) > 0) {
+            if (n > size - u->have) n = (size_t)(size - u->have);
+            u->sha.update(buf, n);
+            u->have += n;
+        }
+        fclose(old);
+        std::error_code ec;
+        if (fs::file_size(part, ec) != u->have) fs::resize_file(part, u->have, ec);
+    }
+    u->file = fopen(part.c_str(), u->have > 0 ? "ab" : "wb");
+    if (u->file == nullptr) {
+        std::lock_guard<std::mutex> mk(uploadsLock);
+        auto it = uploads.find(hash);
+        if (it != uploads.end() && it->second == u) uploads.erase(it);
+        u->closed = true;
+        error = "无法写入文件存储";
+        return -1;
+    }
+    if (u->have == size) {
+        BlobWrite r = finishUpload(hash, *u);
+        if (r == BLOB_DONE) return (int64_t)size;
+        error = "文件校验失败，请重新上传";
+        return -1;
+    }
+    return (int64_t)u->have;
+}
+
+BlobWrite blobWrite(const std::string& hash, uint64_t offset, const char* data, size_t len, uint64_t& have) {
+    // 摘要来自客户端，拼进路径之前必须是 64 位十六进制（不能含 / 或 ..）
+    if (!blobStoreEnabled() || !isSha256Hex(hash)) return BLOB_ERROR;
+    std::shared_ptr<Upload> u;
+    {
+        std::lock_guard<std::mutex> lk(uploadsLock);
+        auto it = uploads.find(hash);
+        if (it != uploads.end()) u = it->second;
+    }
+    if (!u) {
+        // 已被（别的连接）传完：当作重复的块，回复完整大小
+        int64_t stored = storedSize(hash);
+        if (stored < 0) return BLOB_ERROR;
+        have = (uint64_t)stored;
+        return BLOB_MISMATCH;
+    }
+    std::lock_guard<std::mutex> lk(u->lock);
+    if (u->finished || u->closed || u->file == nullptr) return BLOB_ERROR;
+    u->lastUs.store(nowUs(), std::memory_order_relaxed);
+    have = u->have;
+    if (offset != u->have) return BLOB_MISMATCH;
+    if (len == 0 || len > u->size - u->have) return BLOB_ERROR;
+    if (fwrite(data, 1, len, u->file) != len) return BLOB_ERROR;
+    u->sha.update(data, len);
+    u->have += len;
+    have = u->have;
+    bytesReceived.fetch_add(len, std::memory_order_relaxed);
+    if (u->have < u->size) return BLOB_OK;
+    return finishUpload(hash, *u);
+}
+
+int64_t blobFind(const std::string& hash, std::string& path) {
+    if (!blobStoreEnabled() || !isSha256Hex(hash)) return -1;
+    path = blobPath(hash);
+    return storedSize(hash);
+}
+
+void blobServed(uint64_t bytes) {
+    bytesServed.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void describeBlobs(std::ostream& os) {
+    if (!blobStoreEnabled()) {
+        os << "blobs: disabled (start with --blob-dir)\n";
+        return;
+    }
+    size_t active;
+    {
+        std::lock_guard<std::mutex> lk(uploadsLock);
+        active = uploads.size();
+    }
+    os << "blobs: dir " << blobDir << ", stored " << blobsStored.load() << " (dedup hits " << dedupHits.load()
+       << ", bad hash " << badHashes.load() << "), uploads in progress " << active << ", received " << bytesReceived.load()
+       << " B, served " << bytesServed.load() << " B\n";
+}
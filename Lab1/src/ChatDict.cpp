@@ -0,0 +1,22 @@
+// 由 TrainDict 根据 4 个聊天记录数据库（86 条消息）生成，请勿手工修改；重新生成：make dict
+#include "../include/Compress.h"
+
+const char CHAT_DICT[] =
+    "09692\000\000\000jqx|1763109234\000\000\000J|adf|1"
+    "76311818141\000\000\000\000\000\000/MSG089\000\000\000F|J|Q"
+    "|hello\000\000\000\033MSG|J im J|1763118907 "
+    "im Q|176311891419013\000\000\00019105\000\000\000|"
+    "Q|J|im Q|1763109187\000\000\000 im JQX|17"
+    "63118898\000\000\000J|asdf|1763118200\000\000\000\000"
+    "\000\000\032MSG|J|ALL|hello|1763119183 im"
+    " X|1763118966\000\000\000174\000\000\000\027MSG|J|Q|i"
+    "m J|1763109181\000\000\000\027MSG|MSG|Q|J|he"
+    "llo|1763109162\000\000\000\030MSG|MSG|X|ALL|"
+    "J|hello im jqx|1763109217\000\000\000ALL|"
+    "khello|1763119168\000\000\000\035\000\000\000\037MSG|MSG"
+    "|J|JQX|hello |Q|J|hello ,it is t"
+    "he second chaMSG|JQX||ALL|\344\275\240\345\245\275"
+    "|1763119|ALL|hello|17631        "
+    "                  ";
+
+const size_t CHAT_DICT_SIZE = sizeof(CHAT_DICT) - 1;
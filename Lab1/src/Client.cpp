@@ -1,6 +1,6 @@
 // ===================== 实验：多线程协议化聊天室客户端 =====================
 // 功能说明：
-// 1. 使用原生 Winsock 完成与服务器的 TCP 通信。
+// 1. 使用原生套接字（Windows 下为 Winsock）完成与服务器的 TCP 通信。
 // 2. 实现 “TYPE|SENDER|ACCEPTER|MESSAGE” 自定义协议。
 // 3. 使用两个线程实现全双工通信（同时发送与接收）。
 // 4. 支持系统消息、群聊消息、正常退出。
@@ -8,18 +8,43 @@
 
 #include <iostream>
 #include <string>
+#include <atomic>
 #include <thread>
 #include <ctime>
-#include <winsock2.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
 #include "../include/Client.h"     // （预留接口）客户端类或辅助定义
+#include "../include/Compress.h"   // 批量下发的聊天帧解压
+#include "../include/Sha256.h"     // 文件传输的摘要
 #include "../include/Storage.h"    // Storage 数据库类
-#pragma comment(lib, "ws2_32.lib")
+#include "../include/Trace.h"      // 分段延迟跟踪
 
 // 全局变量定义
 std::map<std::string, ClientSession> sessions;
 std::string currSessionId;
 std::string currUserName;
 Storage* storage = nullptr;  // 全局数据库对象
+static std::atomic<bool> traceEnabled{false};  // /trace on 后发出的消息带跟踪字段
+static std::atomic<bool> eventsEnabled{true};  // /events off 后服务器不再推送加入、离开、正在输入等事件
+static bool compressWanted = true;             // 登录后向服务器申请压缩积压的消息（--no-compress 关闭）
+static TraceStats clientTrace;                 // 收到的被跟踪消息的分段延迟（微秒）
+static sockaddr_in serverAddr{};                         // 服务器地址（重连时复用）
+static std::string unixPath;                             // 非空时改走同机的 Unix 域套接字（--unix）
+static std::atomic<SOCKET> serverSocket{INVALID_SOCKET}; // 当前连接，重连时整体替换
+static const int RECONNECT_ATTEMPTS = 30;                // 重连失败时的最大尝试次数
+static std::mutex sendLock;                              // 输入线程与上传线程共用连接，每帧整体写出
+
+// 发往当前连接（线程安全：上传的文件块与聊天消息逐帧交错，不会互相截断）
+static bool sendServer(const std::string& payload) {
+    std::lock_guard<std::mutex> lk(sendLock);
+    return sendFrame(serverSocket.load(), payload);
+}
 
 // ========== 时间戳格式化工具函数实现 ==========
 
@@ -75,17 +100,259 @@ bool shouldShowTimestamp(int64_t currentTime, int64_t lastTime, int threshold) {
     return (diff >= threshold);
 }
 
+// ========== 文件传输 ==========
+// 上传：先算摘要，发 FILE_PUT 声明，服务器回复已有的字节数（已存过同样内容时直接完成），
+// 由上传线程从那里开始逐块发 FILE_DATA；收齐后服务器再回复一次，这时向当前会话发一条带摘要的消息。
+// 下载：文件先写到 <路径>.part，断线重连（或重新 /get）时从它的长度续传，收齐后核对摘要再改名。
+namespace fs = std::filesystem;
+
+struct UploadJob {
+    std::string path;
+    std::string name;        // 发到会话里的文件名
+    std::string sessionId;   // 上传完成后通知的会话
+    uint64_t size = 0;
+    uint64_t gen = 0;        // 每次（重新）开始发送加一，旧的上传线程看到后停止
+};
+
+struct DownloadJob {
+    std::string path;
+    FILE* file = nullptr;    // <路径>.part，追加写
+    uint64_t have = 0;
+    uint64_t size = 0;       // FILE_INFO 到达前为 0
+};
+
+static std::mutex filesLock;
+static std::map<std::string, UploadJob> uploads;       // 按摘要
+static std::map<std::string, DownloadJob> downloads;
+
+// 上传线程：从 offset 开始逐块发出，直到发完或被新一轮发送取代
+static void streamUpload(std::string hash, uint64_t gen, uint64_t offset) {
+    std::string path;
+    uint64_t size;
+    {
+        std::lock_guard<std::mutex> lk(filesLock);
+        auto it = uploads.find(hash);
+        if (it == uploads.end() || it->second.gen != gen) return;
+        path = it->second.path;
+        size = it->second.size;
+    }
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr || !seekFile(f, offset)) {
+        std::cout << "\n[文件] 无法读取 " << path << std::endl;
+        if (f != nullptr) fclose(f);
+        return;
+    }
+    std::vector<char> buf(FILE_CHUNK_SIZE);
+    std::string payload;
+    while (offset < size) {
+        {
+            std::lock_guard<std::mutex> lk(filesLock);
+            auto it = uploads.find(hash);
+            if (it == uploads.end() || it->second.gen != gen) break;
+        }
+        size_t n = (size_t)(size - offset < FILE_CHUNK_SIZE ? size - offset : FILE_CHUNK_SIZE);
+        if (fread(buf.data(), 1, n, f) != n) {
+            std::cout << "\n[文件] 读取 " << path << " 失败（文件在上传中被修改？）" << std::endl;
+            break;
+        }
+        payload.clear();
+        appendFileChunkHeader(payload, currUserName, hash, offset);
+        payload.append(buf.data(), n);
+        if (!sendServer(payload)) break;   // 断线：重连后重新声明，从服务器已有的位置续传
+        offset += n;
+    }
+    fclose(f);
+}
+
+static void startUpload(const std::string& path, const std::string& userName) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (ec || size == 0) {
+        std::cout << "[错误] 无法读取文件或文件为空: " << path << std::endl;
+        return;
+    }
+    std::string hash = sha256File(path);
+    std::string name = fs::path(path).filename().string();
+    for (char& c : name) {
+        if (c == '|') c = '_';   // 文件名会出现在协议消息里
+    }
+    {
+        std::lock_guard<std::mutex> lk(filesLock);
+        UploadJob& job = uploads[hash];
+        job.path = path;
+        job.name = name;
+        job.sessionId = currSessionId;
+        job.size = size;
+        job.gen++;
+    }
+    std::cout << "[文件] 正在上传 " << name << "（" << size << " 字节，摘要 " << hash.substr(0, 12) << "…）" << std::endl;
+    sendServer(buildMessage(Message{"FILE_PUT", userName, hash, std::to_string(size)}));
+}
+
+static void startDownload(const std::string& hash, std::string path, const std::string& userName) {
+    if (!isSha256Hex(hash)) {
+        std::cout << "[错误] 文件摘要应为 64 位小写十六进制" << std::endl;
+        return;
+    }
+    if (path.empty()) path = "download_" + hash.substr(0, 12);
+    uint64_t have = 0;
+    {
+        std::lock_guard<std::mutex> lk(filesLock);
+        if (downloads.count(hash) != 0) {
+            std::cout << "[文件] 该文件正在下载" << std::endl;
+            return;
+        }
+        std::error_code ec;
+        std::string part = path + ".part";
+        have = fs::file_size(part, ec);
+        if (ec) have = 0;
+        FILE* f = fopen(part.c_str(), have > 0 ? "ab" : "wb");
+        if (f == nullptr) {
+            std::cout << "[错误] 无法写入 " << part << std::endl;
+            return;
+        }
+        downloads[hash] = DownloadJob{path, f, have, 0};
+    }
+    if (have > 0) std::cout << "[文件] 从第 " << have << " 字节续传" << std::endl;
+    sendServer(buildMessage(Message{"FILE_GET", userName, hash, std::to_string(have)}));
+}
+
+// 服务器已有 have 字节：收齐则完成并通知会话，否则从 have 开始（重新）发送
+static void onFileAck(const Message& m) {
+    uint64_t have = std::strtoull(m.content.c_str(), nullptr, 10);
+    UploadJob done;
+    {
+        std::lock_guard<std::mutex> lk(filesLock);
+        auto it = uploads.find(m.accepter);
+        if (it == uploads.end()) return;
+        if (have < it->second.size) {
+            uint64_t gen = ++it->second.gen;
+            std::thread(streamUpload, m.accepter, gen, have).detach();
+            return;
+        }
+        done = it->second;
+        uploads.erase(it);
+    }
+    std::cout << "\n[文件] " << done.name << " 上传完成，摘要 " << m.accepter << std::endl;
+    if (!done.sessionId.empty()) {
+        Message notice{"MSG", currUserName, done.sessionId,
+                       "[文件] " + done.name + "（" + std::to_string(done.size) + " 字节）/get " + m.accepter};
+        sendServer(buildMessage(notice));
+    }
+}
+
+// 收齐：核对摘要后改名（调用方持有 filesLock，之后删除该下载）
+static void finishDownload(const std::string& hash, DownloadJob& job) {
+    fclose(job.file);
+    job.file = nullptr;
+    std::string part = job.path + ".part";
+    std::error_code ec;
+    if (sha256File(part) != hash) {
+        fs::remove(part, ec);
+        std::cout << "\n[文件] 校验失败，已删除，请重新下载" << std::endl;
+        return;
+    }
+    fs::rename(part, job.path, ec);
+    if (ec) std::cout << "\n[文件] 无法保存为 " << job.path << "，内容在 " << part << std::endl;
+    else std::cout << "\n[文件] 下载完成: " << job.path << "（" << job.size << " 字节）" << std::endl;
+}
+
+static void onFileInfo(const Message& m) {
+    std::lock_guard<std::mutex> lk(filesLock);
+    auto it = downloads.find(m.accepter);
+    if (it == downloads.end()) return;
+    it->second.size = std::strtoull(m.content.c_str(), nullptr, 10);
+    if (it->second.have >= it->second.size) {
+        finishDownload(it->first, it->second);
+        downloads.erase(it);
+    }
+}
+
+// 文件块：内容为 偏移|原始字节，只接受紧接在已收部分之后的块
+static void onFileData(const Message& m) {
+    size_t bar = m.content.find('|');
+    if (bar == std::string::npos) return;
+    uint64_t offset = std::strtoull(m.content.c_str(), nullptr, 10);
+    size_t n = m.content.size() - bar - 1;
+    std::lock_guard<std::mutex> lk(filesLock);
+    auto it = downloads.find(m.accepter);
+    if (it == downloads.end() || offset != it->second.have) return;
+    DownloadJob& job = it->second;
+    if (fwrite(m.content.data() + bar + 1, 1, n, job.file) != n) {
+        std::cout << "\n[文件] 写入 " << job.path << ".part 失败" << std::endl;
+        fclose(job.file);
+        downloads.erase(it);
+        return;
+    }
+    job.have += n;
+    if (job.size > 0 && job.have >= job.size) {
+        finishDownload(it->first, job);
+        downloads.erase(it);
+    }
+}
+
+// 重连后：未完成的上传重新声明（从服务器已有的位置续传），下载从已收的位置重新请求
+static void resumeTransfers() {
+    std::lock_guard<std::mutex> lk(filesLock);
+    for (auto& [hash, job] : uploads) {
+        job.gen++;
+        sendServer(buildMessage(Message{"FILE_PUT", currUserName, hash, std::to_string(job.size)}));
+    }
+    for (auto& [hash, job] : downloads) {
+        fflush(job.file);
+        sendServer(buildMessage(Message{"FILE_GET", currUserName, hash, std::to_string(job.have)}));
+    }
+}
+
+// 把文本文件的每一行作为一条消息发到当前会话：按 BATCH_MAX_BYTES 装成批量帧，
+// 发送者与会话每帧只写一次，服务器也只做一次成员检查、一次扇出
+static void pasteFile(const std::string& path, const std::string& userName) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "[错误] 无法读取文件: " << path << std::endl;
+        return;
+    }
+    ClientSession& session = sessions[currSessionId];
+    std::string payload;
+    std::string line;
+    int lines = 0;
+    int frames = 0;
+    int64_t now = std::time(nullptr);
+    auto flush = [&]() {
+        if (payload.empty()) return;
+        sendServer(payload);
+        payload.clear();
+        frames++;
+    };
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        if (line.size() > BATCH_MAX_BYTES) line.resize(BATCH_MAX_BYTES);
+        if (!payload.empty() && payload.size() + line.size() + 8 > BATCH_MAX_BYTES) flush();
+        if (payload.empty()) appendBatchHeader(payload, userName, currSessionId, now);
+        appendBatchItem(payload, line.data(), line.size());
+        Message msg{"MSG", userName, currSessionId, line};
+        msg.timestamp = now;
+        if (storage) storage->saveMessage(msg, currSessionId, session.type);
+        session.history.push_back(msg);
+        lines++;
+    }
+    flush();
+    std::cout << "[Client] 已发送 " << lines << " 条消息（" << frames << " 个批量帧）" << std::endl;
+}
+
 // ==========================================================================
 // 线程函数：发送线程
 // 职责：负责读取用户输入、封装协议消息并发送至服务器。
 // ==========================================================================
-void sendThread(SOCKET clientSocket, const std::string &userName) {
+void sendThread(const std::string &userName) {
 
     // --------------------- 1. 用户登录阶段 ---------------------
     // 首次连接后，发送 "JOIN" 协议消息，仅注册用户名（不加入任何session）
-    Message joinMsg{"JOIN", userName, "", ""};       // accepter 为空
+    Message joinMsg{"JOIN", userName, "", BATCH_FEATURE};   // accepter 为空，内容声明能解析批量帧
     std::string data = buildMessage(joinMsg);
-    send(clientSocket, data.c_str(), (int)data.size(), 0);
+    sendServer(data);
+    if (compressWanted) sendServer(buildMessage(Message{"COMPRESS", userName, "", chatDictionaryId()}));
     
     std::cout << "\n[提示] 请使用 /join <会话名> 加入会话" << std::endl;
     std::cout << "[提示] 例如：/join ALL 加入聊天室\n" << std::endl;
@@ -113,7 +380,7 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
                 // 组装 EXIT 协议包并发送
                 Message exitMsg{"EXIT", userName, "", ""};
                 std::string exitData = buildMessage(exitMsg);
-                send(clientSocket, exitData.c_str(), (int)exitData.size(), 0);
+                sendServer(exitData);
                 std::cout << "[Client] Exiting...\n";
                 break;
             }
@@ -137,7 +404,7 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
                 
                 Message joinSessionMsg{"JOIN_SESSION", userName, targetSession, ""};
                 std::string joinData = buildMessage(joinSessionMsg);
-                send(clientSocket, joinData.c_str(), (int)joinData.size(), 0);
+                sendServer(joinData);
                 
                 // 本地创建 session（如果不存在）
                 if (sessions.find(targetSession) == sessions.end()) {
@@ -152,6 +419,33 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
                 std::cout << "[Client] 正在加入会话: " << targetSession << std::endl;
                 continue;
             }
+            else if (command.substr(0, 6) == "create") {
+                // 创建命名群聊（创建者自动加入），其他人用 /join <群名> 加入
+                size_t spacePos = command.find(' ');
+                if (spacePos == std::string::npos || spacePos + 1 >= command.length()) {
+                    std::cout << "[错误] 用法: /create <群名>" << std::endl;
+                    continue;
+                }
+                std::string groupName = command.substr(spacePos + 1);
+                size_t nameStart = groupName.find_first_not_of(" \t");
+                size_t nameEnd = groupName.find_last_not_of(" \t");
+                if (nameStart != std::string::npos) {
+                    groupName = groupName.substr(nameStart, nameEnd - nameStart + 1);
+                }
+
+                Message createMsg{"CREATE_GROUP", userName, groupName, ""};
+                sendServer(buildMessage(createMsg));
+
+                ClientSession &group = sessions[groupName];
+                group.id = groupName;
+                group.type = ST_GROUP;
+                if (storage) {
+                    storage->saveSession(groupName, ST_GROUP);
+                }
+                currSessionId = groupName;
+                std::cout << "[Client] 正在创建群聊: " << groupName << std::endl;
+                continue;
+            }
             else if (command.substr(0, 5) == "leave") {
                 // 离开会话
                 size_t spacePos = command.find(' ');
@@ -169,7 +463,7 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
                 
                 Message leaveSessionMsg{"LEAVE_SESSION", userName, targetSession, ""};
                 std::string leaveData = buildMessage(leaveSessionMsg);
-                send(clientSocket, leaveData.c_str(), (int)leaveData.size(), 0);
+                sendServer(leaveData);
                 
                 // 如果离开的是当前会话，清空 currSessionId
                 if (currSessionId == targetSession) {
@@ -225,6 +519,66 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
                 
                 continue;
             }
+            else if (command == "trace on" || command == "trace off") {
+                traceEnabled = (command == "trace on");
+                std::cout << "[Client] 延迟跟踪已" << (traceEnabled ? "开启" : "关闭") << std::endl;
+                continue;
+            }
+            else if (command == "events on" || command == "events off") {
+                // 开关会话事件推送，服务器回复确认
+                eventsEnabled = (command == "events on");
+                sendServer(buildMessage(Message{"EVENTS", userName, "", eventsEnabled ? "on" : "off"}));
+                continue;
+            }
+            else if (command.substr(0, 5) == "send ") {
+                // 上传文件：同样的内容服务器只存一份，已存过时立即完成
+                size_t pathStart = command.find_first_not_of(" \t", 5);
+                if (pathStart == std::string::npos) {
+                    std::cout << "[错误] 用法: /send <文件路径>" << std::endl;
+                    continue;
+                }
+                startUpload(command.substr(pathStart), userName);
+                continue;
+            }
+            else if (command.substr(0, 4) == "get ") {
+                // 下载文件：/get <摘要> [保存路径]，中断后再次 /get 从断点续传
+                std::string rest = command.substr(4);
+                size_t hashStart = rest.find_first_not_of(" \t");
+                if (hashStart == std::string::npos) {
+                    std::cout << "[错误] 用法: /get <摘要> [保存路径]" << std::endl;
+                    continue;
+                }
+                size_t hashEnd = rest.find_first_of(" \t", hashStart);
+                std::string hash = rest.substr(hashStart, hashEnd == std::string::npos ? std::string::npos : hashEnd - hashStart);
+                std::string path;
+                if (hashEnd != std::string::npos) {
+                    size_t pathStart = rest.find_first_not_of(" \t", hashEnd);
+                    if (pathStart != std::string::npos) path = rest.substr(pathStart);
+                }
+                startDownload(hash, path, userName);
+                continue;
+            }
+            else if (command.substr(0, 6) == "paste ") {
+                // 批量发送：文件的每一行是一条消息
+                size_t pathStart = command.find_first_not_of(" \t", 6);
+                if (pathStart == std::string::npos) {
+                    std::cout << "[错误] 用法: /paste <文件路径>" << std::endl;
+                    continue;
+                }
+                if (currSessionId.empty()) {
+                    std::cout << "[错误] 请先加入一个会话，例如：/join ALL" << std::endl;
+                    continue;
+                }
+                pasteFile(command.substr(pathStart), userName);
+                continue;
+            }
+            else if (command == "latency") {
+                // 本客户端收到的被跟踪消息：服务器->本机、显示耗时、端到端
+                std::cout << "\n=== 延迟统计（微秒）===" << std::endl;
+                clientTrace.print(std::cout, STAGE_NET_OUT, STAGE_COUNT);
+                std::cout << "[提示] 服务器各阶段的统计请在服务器控制台输入 latency" << std::endl;
+                continue;
+            }
             else if (command == "sessions") {
                 // 显示所有会话
                 std::cout << "\n=== 我的会话列表 ===" << std::endl;
@@ -280,10 +634,17 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
             else {
                 std::cout << "[错误] 未知命令。可用命令：" << std::endl;
                 std::cout << "  /join <会话名>   - 加入会话" << std::endl;
+                std::cout << "  /create <群名>   - 创建群聊" << std::endl;
                 std::cout << "  /leave <会话名>  - 离开会话" << std::endl;
                 std::cout << "  /switch <会话名> - 切换会话" << std::endl;
                 std::cout << "  /sessions        - 显示所有会话" << std::endl;
                 std::cout << "  /history         - 查看当前会话历史" << std::endl;
+                std::cout << "  /trace on|off    - 开启/关闭消息延迟跟踪" << std::endl;
+                std::cout << "  /events on|off   - 开启/关闭加入、离开、正在输入等事件" << std::endl;
+                std::cout << "  /send <路径>     - 上传文件并发到当前会话" << std::endl;
+                std::cout << "  /get <摘要> [路径] - 下载文件（支持断点续传）" << std::endl;
+                std::cout << "  /paste <路径>    - 把文本文件的每一行发到当前会话（批量发送）" << std::endl;
+                std::cout << "  /latency         - 查看收到消息的延迟分布" << std::endl;
                 std::cout << "  /exit            - 退出程序" << std::endl;
                 continue;
             }
@@ -297,8 +658,9 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
         
         // 发送消息到当前 session
         Message msg{"MSG", userName, currSessionId, input};
+        if (traceEnabled) msg.trace = std::to_string(traceNowUs());
         std::string sendData = buildMessage(msg);
-        send(clientSocket, sendData.c_str(), (int)sendData.size(), 0);
+        sendServer(sendData);
         
         //  保存到数据库
         if (storage) {
@@ -316,153 +678,272 @@ void sendThread(SOCKET clientSocket, const std::string &userName) {
     // --------------------- 3. 退出资源阶段 ---------------------
 }
 
+// 建立一条到服务器的 TCP 连接，失败返回 INVALID_SOCKET
+static SOCKET connectServer() {
+    if (!unixPath.empty()) return connectUnix(unixPath);
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    if (connect(s, (sockaddr *)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
+        closeSocket(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+// 服务器排空（升级重启）时发来 RECONNECT，内容是建议的延迟毫秒数。
+// 各客户端的延迟由服务器随机分配，按延迟等待后连到新进程，重新登录并回到当前会话。
+static bool reconnectAfter(int delayMs) {
+    std::cout << "\n[系统] 服务器正在重启，" << delayMs << " 毫秒后自动重连" << std::endl;
+    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    int backoffMs = 200;
+    for (int attempt = 0; attempt < RECONNECT_ATTEMPTS; attempt++) {
+        SOCKET s = connectServer();
+        if (s != INVALID_SOCKET) {
+            SOCKET old = serverSocket.exchange(s);
+            closeSocket(old);   // 旧进程在所有连接断开后退出
+            sendServer(buildMessage(Message{"JOIN", currUserName, "", BATCH_FEATURE}));
+            if (compressWanted) sendServer(buildMessage(Message{"COMPRESS", currUserName, "", chatDictionaryId()}));
+            if (!eventsEnabled) sendServer(buildMessage(Message{"EVENTS", currUserName, "", "off"}));
+            if (!currSessionId.empty()) {
+                sendServer(buildMessage(Message{"JOIN_SESSION", currUserName, currSessionId, ""}));
+            }
+            resumeTransfers();
+            std::cout << "[系统] 已重新连接" << std::endl;
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+        if (backoffMs < 2000) backoffMs *= 2;
+    }
+    return false;
+}
+
 // ==========================================================================
 // 线程函数：接收线程
 // 职责：持续监听服务器的消息回传，并在本地解析、输出。
 // ==========================================================================
-void recvThread(SOCKET clientSocket) {
-    char buffer[4096];
+// 显示一条消息，并统计被跟踪消息的分段延迟（TRACE 中带有发送方与服务器的时刻）
+static void deliverMessage(const Message &m, int64_t recvUs) {
+    if (m.type == BATCH_TYPE) {
+        // 批量帧：拆回逐条 MSG，发送者、会话、时间戳是共同的
+        std::vector<std::pair<size_t, size_t>> items;
+        Message one{"MSG", m.sender, m.accepter, ""};
+        if (!parseBatch(m.content, one.timestamp, items)) return;
+        for (const auto& item : items) {
+            one.content.assign(m.content, item.first, item.second);
+            handleServerMessage(one);
+        }
+        return;
+    }
+    handleServerMessage(m);
+    int64_t stamps[TRACE_STAMPS];
+    if (m.trace.empty() || parseTraceStamps(m.trace, stamps) < TRACE_STAMPS) return;
+    int64_t shownUs = traceNowUs();
+    clientTrace.record(STAGE_NET_OUT, recvUs - stamps[TRACE_ROUTE]);
+    clientTrace.record(STAGE_DISPLAY, shownUs - recvUs);
+    clientTrace.record(STAGE_END_TO_END, shownUs - stamps[TRACE_SEND]);
+}
+
+// ZIP 帧：按到达顺序解压（压缩状态跨帧延续），还原出的是带长度头的若干原始帧。失败返回 false
+static bool deliverZipped(const std::string &payload, ZipDecoder &zip, int64_t recvUs) {
+    std::string inflated;
+    size_t head = strlen(ZIP_TYPE) + 1;
+    if (!zip.decompress(payload.data() + head, payload.size() - head, inflated)) return false;
+    FrameDecoder frames;
+    frames.feed(inflated.data(), inflated.size());
+    std::string inner;
+    while (frames.next(inner)) deliverMessage(parseMessage(inner), recvUs);
+    return !frames.error() && frames.buffered() == 0;
+}
+
+void recvThread() {
+    char buffer[65536];   // 下载时一帧有 32KB 的文件块
+    FrameDecoder decoder;
+    ZipDecoder zip(chatDictionary());
+    std::string payload;
     while (true) {
-        int bytes = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
+        int bytes = recv(serverSocket.load(), buffer, sizeof(buffer), 0);
         if (bytes <= 0) {
             std::cout << "\n[Client] 连接已断开" << std::endl;
             break;
         }
+        int64_t recvUs = traceNowUs();
 
-        buffer[bytes] = '\0';
-        Message m = parseMessage(std::string(buffer));
-
-        // 根据消息类型进行分类处理
-        if (m.type == "SYS") {
-            // 系统消息（总是显示）
-            std::cout << "\n[系统] " << m.content << std::endl;
+        // 一次 recv 可能包含多帧，也可能只有半帧，交给解帧器切分
+        decoder.feed(buffer, (size_t)bytes);
+        bool switched = false;
+        bool broken = false;
+        while (!switched && !broken && decoder.next(payload)) {
+            if (payload.compare(0, strlen(ZIP_TYPE) + 1, std::string(ZIP_TYPE) + "|") == 0) {
+                broken = !deliverZipped(payload, zip, recvUs);
+                continue;
+            }
+            Message m = parseMessage(payload);
+            if (m.type == "RECONNECT") {
+                if (!reconnectAfter(std::atoi(m.content.c_str()))) {
+                    std::cout << "\n[Client] 重连失败" << std::endl;
+                    return;
+                }
+                // 旧连接上剩余的数据不再处理，新连接从头解帧、从字典重新开始解压
+                decoder = FrameDecoder();
+                zip = ZipDecoder(chatDictionary());
+                switched = true;
+                continue;
+            }
+            deliverMessage(m, recvUs);
+        }
+        if (broken) {
+            std::cout << "\n[Client] 收到无法解压的数据帧，断开连接" << std::endl;
+            break;
         }
-        else if (m.type == "NOTIFY") {
-            // 通知消息（如新私聊）
-            std::cout << "\n[通知] " << m.content << std::endl;
+        if (decoder.error()) {
+            std::cout << "\n[Client] 收到非法数据帧，断开连接" << std::endl;
+            break;
         }
-        else if (m.type == "MSG") {
-            // 普通消息
-            std::string msgSessionId;
-            
-            // 判断消息属于哪个 session
-            if (m.accepter == "ALL") {
-                msgSessionId = "ALL";
-            } else if (m.sender == currUserName) {
-                // 我发的消息（回显）
-                msgSessionId = m.accepter;
-            } else {
-                // 别人发给我的消息
-                msgSessionId = m.sender;
+    }
+}
+
+// 处理服务器发来的一条完整消息
+void handleServerMessage(const Message &m) {
+    // 根据消息类型进行分类处理
+    if (m.type == "SYS") {
+        // 系统消息（总是显示）
+        std::cout << "\n[系统] " << m.content << std::endl;
+    }
+    else if (m.type == "EVENTS") {
+        // 合并后的会话事件：j 加入、l 离开、o 下线、t 正在输入，逗号分隔
+        std::string line;
+        size_t pos = 0;
+        while (pos < m.content.size()) {
+            size_t end = m.content.find(',', pos);
+            if (end == std::string::npos) end = m.content.size();
+            if (end - pos > 2 && m.content[pos + 1] == ':') {
+                std::string who = m.content.substr(pos + 2, end - pos - 2);
+                const char* what = m.content[pos] == 'j' ? " 加入了会话" : m.content[pos] == 'l' ? " 离开了会话"
+                                 : m.content[pos] == 'o' ? " 已下线" : " 正在输入...";
+                if (who != currUserName) line += (line.empty() ? "" : "，") + who + what;
             }
+            pos = end + 1;
+        }
+        if (!line.empty()) std::cout << "\n[" << m.accepter << "] " << line << std::endl;
+    }
+    else if (m.type == FILE_DATA_TYPE) onFileData(m);
+    else if (m.type == "FILE_ACK") onFileAck(m);
+    else if (m.type == "FILE_INFO") onFileInfo(m);
+    else if (m.type == "NOTIFY") {
+        // 通知消息（如新私聊）
+        std::cout << "\n[通知] " << m.content << std::endl;
+    }
+    else if (m.type == "MSG") {
+        // 普通消息
+        // 判断消息属于哪个 session（与服务器的私聊键一一对应）
+        const std::string &msgSessionId = conversationOf(m, currUserName);
+        
+        // 保存到对应 session
+        if (sessions.find(msgSessionId) == sessions.end()) {
+            // 自动创建 session
+            ClientSession newSession;
+            newSession.id = msgSessionId;
+            newSession.type = (msgSessionId == m.accepter) ? ST_GROUP : ST_PRIVATE;
+            newSession.lastReadTime = 0;
+            sessions[msgSessionId] = newSession;
             
-            // 保存到对应 session
-            if (sessions.find(msgSessionId) == sessions.end()) {
-                // 自动创建 session
-                ClientSession newSession;
-                newSession.id = msgSessionId;
-                newSession.type = (msgSessionId == "ALL") ? ST_GROUP : ST_PRIVATE;
-                newSession.lastReadTime = 0;
-                sessions[msgSessionId] = newSession;
-                
-                // 保存会话到数据库
-                if (storage) {
-                    storage->saveSession(msgSessionId, newSession.type);
-                }
+            // 保存会话到数据库
+            if (storage) {
+                storage->saveSession(msgSessionId, newSession.type);
             }
+        }
+        
+        // 保存到内存
+        sessions[msgSessionId].history.push_back(m);
+        
+        // 保存到数据库
+        if (storage) {
+            SessionType type = sessions[msgSessionId].type;
+            storage->saveMessage(m, msgSessionId, type);
             
-            // 保存到内存
-            sessions[msgSessionId].history.push_back(m);
+            // 如果是当前会话，更新已读时间
+            if (msgSessionId == currSessionId) {
+                sessions[msgSessionId].lastReadTime = time(nullptr);
+                storage->updateLastSyncTime(msgSessionId, time(nullptr));
+            }
+        }
+        
+        // 只显示当前 session 的消息
+        if (msgSessionId == currSessionId) {
+            // 智能显示时间戳
+            int64_t lastMsgTime = 0;
             
-            // 保存到数据库
-            if (storage) {
-                SessionType type = sessions[msgSessionId].type;
-                storage->saveMessage(m, msgSessionId, type);
-                
-                // 如果是当前会话，更新已读时间
-                if (msgSessionId == currSessionId) {
-                    sessions[msgSessionId].lastReadTime = time(nullptr);
-                    storage->updateLastSyncTime(msgSessionId, time(nullptr));
-                }
+            // 获取上一条消息的时间戳
+            auto &history = sessions[msgSessionId].history;
+            if (history.size() > 1) {
+                // history 最后一个是刚刚添加的当前消息，倒数第二个是上一条
+                lastMsgTime = history[history.size() - 2].timestamp;
             }
             
-            // 只显示当前 session 的消息
-            if (msgSessionId == currSessionId) {
-                // 智能显示时间戳
-                int64_t lastMsgTime = 0;
-                
-                // 获取上一条消息的时间戳
-                auto &history = sessions[msgSessionId].history;
-                if (history.size() > 1) {
-                    // history 最后一个是刚刚添加的当前消息，倒数第二个是上一条
-                    lastMsgTime = history[history.size() - 2].timestamp;
-                }
-                
-                // 判断是否需要显示时间戳（默认阈值：5分钟 = 300秒）
-                if (shouldShowTimestamp(m.timestamp, lastMsgTime, 300)) {
-                    std::string timeStr = formatTimestamp(m.timestamp);
-                    std::cout << "\n--- " << timeStr << " ---" << std::endl;
-                }
-                
-                std::cout << "[" << m.sender << "] " << m.content << std::endl;
-            } else {
-                // 其他 session 有新消息，提示
-                std::cout << "\n[新消息 @" << msgSessionId << "] " 
-                          << m.sender << ": " << m.content << std::endl;
+            // 判断是否需要显示时间戳（默认阈值：5分钟 = 300秒）
+            if (shouldShowTimestamp(m.timestamp, lastMsgTime, 300)) {
+                std::string timeStr = formatTimestamp(m.timestamp);
+                std::cout << "\n--- " << timeStr << " ---" << std::endl;
             }
+            
+            std::cout << "[" << m.sender << "] " << m.content << std::endl;
+        } else {
+            // 其他 session 有新消息，提示
+            std::cout << "\n[新消息 @" << msgSessionId << "] " 
+                      << m.sender << ": " << m.content << std::endl;
         }
-
-        std::flush(std::cout);
     }
+
+    std::flush(std::cout);
 }
 
 // ==========================================================================
 // 函数：main()
 // 职责：负责客户端主逻辑，创建 socket、连接服务器、
 //       启动发送与接收线程，实现全双工通信。
+// 用法：Client.exe [-p 端口] [--unix 路径] [--no-compress]
 // ==========================================================================
-int main() {
+int main(int argc, char* argv[]) {
     //设置控制台支持中文
-    SetConsoleOutputCP(65001); // 设置控制台输出为 UTF-8 编码
-    SetConsoleCP(65001);
-
-    // --------------------- 第一阶段：初始化 Winsock ---------------------
-    // 初始化阶段属于 Socket API 的系统级准备，相当于在用户空间注册本进程的网络会话句柄。
-    WSADATA wsaData;
-    int res = WSAStartup(MAKEWORD(2, 2), &wsaData);
-    if (res != 0) {
-        std::cout << "Load WSA failed" << std::endl;
-        return 0;
-    }
+    setupConsole(); // 控制台输入输出使用 UTF-8 编码
 
-    // --------------------- 第二阶段：创建套接字 ---------------------
-    SOCKET clientSocket = socket(AF_INET, SOCK_STREAM, 0);
-    // AF_INET 指定使用 IPv4 地址族, SOCK_STREAM 表示使用 TCP 流式套接字
-    if (clientSocket == INVALID_SOCKET) {
-        std::cout << "Create Socket failed" << std::endl;
-        WSACleanup();
+    // --------------------- 第一阶段：初始化网络库 ---------------------
+    // 初始化阶段属于 Socket API 的系统级准备，相当于在用户空间注册本进程的网络会话句柄（Windows 下为 Winsock）。
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
         return 0;
     }
 
-    // --------------------- 第三阶段：配置目标服务器地址信息 ---------------------
-    sockaddr_in serverAddr{};
+    // --------------------- 第二阶段：配置目标服务器地址信息 ---------------------
     serverAddr.sin_family = AF_INET;                // 地址簇为 IPV4
     serverAddr.sin_port = htons(8888);              // 端口号需转换为网络字节序
     serverAddr.sin_addr.s_addr = inet_addr("127.0.0.1"); // 本地回环地址
     /* 该结构体属于“IPv4 套接字编址结构”，定义客户端目标的传输层标识符四元组中的远端信息：
        (目的IP，目的Port)。*/
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
+            serverAddr.sin_port = htons((unsigned short)std::atoi(argv[++i]));
+        } else if (arg == "--unix" && i + 1 < argc) {
+            unixPath = argv[++i];   // 与服务器在同一台机器上时不经过 TCP 协议栈
+        } else if (arg == "--no-compress") {
+            compressWanted = false;
+        }
+    }
 
-    // --------------------- 第四阶段：尝试主动建立与服务器的连接 ---------------------
-    if (connect(clientSocket, (sockaddr *)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
+    // --------------------- 第三阶段：创建套接字并主动建立与服务器的连接 ---------------------
+    // AF_INET 指定使用 IPv4 地址族, SOCK_STREAM 表示使用 TCP 流式套接字
+    SOCKET clientSocket = connectServer();
+    if (clientSocket == INVALID_SOCKET) {
         std::cout << "Connect to Server failed" << std::endl;
-        closesocket(clientSocket);
-        WSACleanup();
+        netCleanup();
         return 0;
     }
+    serverSocket = clientSocket;
     /* connect() 在内核态为该 socket 发起主动连接请求；
        调用成功标志 TCP 状态机由 CLOSED → SYN_SENT → ESTABLISHED 转换。*/
 
-    // --------------------- 第五阶段：启动通信线程 ---------------------
+    // --------------------- 第四阶段：启动通信线程 ---------------------
     std::string username;
     std::cout << "请输入昵称(Please enter your username): ";
     std::getline(std::cin, username);
@@ -474,8 +955,8 @@ int main() {
         std::cout << "[ERROR] 数据库初始化失败！" << std::endl;
         delete storage;
         storage = nullptr;
-        closesocket(clientSocket);
-        WSACleanup();
+        closeSocket(serverSocket.load());
+        netCleanup();
         return 0;
     }
     
@@ -512,14 +993,14 @@ int main() {
     currSessionId = "";  // 空字符串表示未加入任何 session
 
     // 使用两个独立线程同时发送和接收数据，实现双向通信
-    std::thread sender(sendThread, clientSocket, username);   // 处理键盘输入与发送
-    std::thread receiver(recvThread, clientSocket);       // 处理服务器广播接收
+    std::thread sender(sendThread, username);   // 处理键盘输入与发送
+    std::thread receiver(recvThread);           // 处理服务器广播接收
 
-    // --------------------- 第六阶段：等待线程自然结束 ---------------------
+    // --------------------- 第五阶段：等待线程自然结束 ---------------------
     // 主线程等待子线程执行完毕，防止程序过早退出
     sender.join();
-    shutdown(clientSocket, SD_BOTH); // 通知服务器结束发送接收
-    closesocket(clientSocket);      // 真正关闭
+    shutdown(serverSocket.load(), SD_BOTH); // 通知服务器结束发送接收
+    closeSocket(serverSocket.load());      // 真正关闭
     receiver.join();
 
     // 清理数据库资源
@@ -529,9 +1010,9 @@ int main() {
         storage = nullptr;
     }
 
-    // --------------------- 第七阶段：释放网络资源 ---------------------
-    // 所有通信结束后，通过 WSACleanup() 释放 Winsock 资源。
-    WSACleanup();
+    // --------------------- 第六阶段：释放网络资源 ---------------------
+    // 所有通信结束后，通过 netCleanup() 释放网络库资源（Windows 下为 WSACleanup）。
+    netCleanup();
 
     return 0;   // 程序正常结束
 }
\ No newline at end of file
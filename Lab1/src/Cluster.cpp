@@ -0,0 +1,641 @@
+#include "../include/Cluster.h"
+#include "../include/HandlerPool.h"
+#include "../include/ObjectPool.h"
+#include "../include/Presence.h"
+#include "../include/Server.h"
+#include "../include/StateStore.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+// 节点间链路上的帧：4 字节大端长度 + 若干条记录；每条记录 = 1 字节类型 + 8 字节 ConnId + 4 字节长度 + 负载
+// 负载是客户端协议的字符串（不带长度头），接收方直接交给 handleMessage 或封帧发给本地连接
+enum PeerRecord {
+    R_HELLO = 1,        // 链路建立后的第一条：conn 为发送方的节点编号
+    R_REQUEST = 2,      // 客户端请求转给归属节点：conn 为该客户端在发送方节点上的 ConnId
+    R_DELIVER = 3,      // 归属节点发给某个用户：conn 为该用户在接收方节点上的 ConnId
+    R_BROADCAST = 4,    // 发给接收方节点的全部在线用户（ALL）：conn 为要排除的本地连接
+    R_USER_GONE = 5,    // 用户退出或断开：conn 为它在发送方节点上的 ConnId，负载是用户名
+    R_SUBSCRIBE = 6,    // 会话在接收方节点上的订阅者：conn 为会话名长度，负载 = 会话名 + 若干个 8 字节本地 ConnId
+    R_PUBLISH = 7,      // 会话消息，每个订阅节点一份：conn 为会话名长度，负载 = 8 字节排除的本地连接 + 会话名 + 协议字符串
+    R_GOSSIP = 8,       // 在线目录的增量与版本向量（见 Presence.h）
+    R_FORWARD = 9,      // 转来的请求再转一次：conn 为客户端的完整 ConnId（可能在第三个节点上），接收方不再转发
+};
+
+static const size_t RECORD_HEADER = 13;
+static const size_t PEER_FRAME_BYTES = 256 * 1024;           // 一帧最多攒这么多记录再写出
+static const size_t PEER_MAX_FRAME = 4 * 1024 * 1024;        // 接收方拒绝更大的帧（视为协议错误）
+static const size_t PEER_MAX_PENDING = 64 * 1024 * 1024;     // 对端连不上时最多积压这么多，超过的记录丢弃
+static const int VNODES = 128;                               // 每个节点在哈希环上的虚拟点数
+static const int RECONNECT_MS = 500;
+
+struct NodeAddr {
+    std::string host;
+    unsigned short port = 0;
+};
+
+// 到另一个节点的发送链路：任意线程把记录追加到 pending，发送线程整批取走写出
+struct PeerLink {
+    int node = -1;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::string pending;
+    std::atomic<bool> connected{false};
+    std::atomic<uint64_t> recordsOut{0};
+    std::atomic<uint64_t> framesOut{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> recordsIn{0};     // 从该节点收到的记录（由接收线程累计）
+    // 已告诉该节点的各会话订阅者（本地 ConnId，升序），由 lock 保护；重连后清空，下次发布时重新订阅
+    std::unordered_map<std::string, std::vector<ConnId>> subscribed;
+    std::atomic<uint64_t> publishes{0};     // 发出的 R_PUBLISH 数
+    std::atomic<uint64_t> publishTargets{0};   // 这些发布覆盖的成员数（逐个转发时的记录数）
+    std::atomic<uint64_t> subscribes{0};    // 订阅者变化时发出的 R_SUBSCRIBE 数
+};
+
+static std::vector<NodeAddr> nodeAddrs;
+static std::atomic<int> selfNode{-1};   // reactor 已在运行，链路全部建好后才置位
+static std::vector<std::pair<uint64_t, int>> ring;      // 按哈希值排序的虚拟点
+// 按节点编号，本节点为空。链路与发送线程一样活到进程结束：exit() 时不析构，
+// 否则销毁发送线程正在等待的条件变量会卡住退出
+static std::vector<PeerLink*> links;
+
+// FNV-1a 之后再打散一次，相近的会话名也能均匀落到环上
+static uint64_t hashKey(const char* data, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static void putU32(std::string& out, uint32_t v) {
+    char b[4] = {(char)(v >> 24), (char)(v >> 16), (char)(v >> 8), (char)v};
+    out.append(b, 4);
+}
+
+static uint32_t getU32(const char* p) {
+    const unsigned char* u = (const unsigned char*)p;
+    return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | (uint32_t)u[3];
+}
+
+static void putU64(std::string& out, uint64_t v) {
+    putU32(out, (uint32_t)(v >> 32));
+    putU32(out, (uint32_t)v);
+}
+
+static uint64_t getU64(const char* p) {
+    return ((uint64_t)getU32(p) << 32) | getU32(p + 4);
+}
+
+static void appendHeader(std::string& out, PeerRecord kind, uint64_t conn, size_t len) {
+    out.push_back((char)kind);
+    putU64(out, conn);
+    putU32(out, (uint32_t)len);
+}
+
+static void appendRecord(std::string& out, PeerRecord kind, uint64_t conn, const char* data, size_t len) {
+    appendHeader(out, kind, conn, len);
+    out.append(data, len);
+}
+
+// 追加一条记录到发往 node 的链路
+static void enqueue(int node, PeerRecord kind, uint64_t conn, const char* data, size_t len) {
+    PeerLink* l = links[node];
+    if (l == nullptr) return;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lk(l->lock);
+        if (l->pending.size() > PEER_MAX_PENDING) {
+            l->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wake = l->pending.empty();
+        appendRecord(l->pending, kind, conn, data, len);
+    }
+    l->recordsOut.fetch_add(1, std::memory_order_relaxed);
+    if (wake) l->ready.notify_one();
+}
+
+// ========== 发送线程 ==========
+
+static SOCKET connectNode(const NodeAddr& a) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(a.port);
+    addr.sin_addr.s_addr = inet_addr(a.host.c_str());
+    if (connect(s, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        closeSocket(s);
+        return INVALID_SOCKET;
+    }
+    setNoDelay(s);
+    return s;
+}
+
+static bool writeAll(SOCKET s, const char* data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        int n = send(s, data + sent, (int)(len - sent), 0);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// 从 pos 开始取若干条完整记录（至少一条），总长不超过 PEER_FRAME_BYTES，返回结束位置
+static size_t cutFrame(const std::string& batch, size_t pos) {
+    size_t end = pos;
+    while (end < batch.size()) {
+        size_t len = RECORD_HEADER + getU32(batch.data() + end + 9);
+        if (end > pos && end - pos + len > PEER_FRAME_BYTES) break;
+        end += len;
+    }
+    return end;
+}
+
+static void senderLoop(PeerLink* l) {
+    SOCKET s = INVALID_SOCKET;
+    std::string batch;
+    std::string frame;
+    bool warned = false;
+    while (true) {
+        if (s == INVALID_SOCKET) {
+            s = connectNode(nodeAddrs[l->node]);
+            if (s == INVALID_SOCKET) {
+                if (!warned) std::cout << "[CLUSTER] Node " << l->node << " unreachable, retrying" << std::endl;
+                warned = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(RECONNECT_MS));
+                continue;
+            }
+            frame.clear();
+            putU32(frame, (uint32_t)RECORD_HEADER);
+            appendRecord(frame, R_HELLO, (uint64_t)selfNode, "", 0);
+            if (!writeAll(s, frame.data(), frame.size())) {
+                closeSocket(s);
+                s = INVALID_SOCKET;
+                continue;
+            }
+            warned = false;
+            {
+                // 新连接上的接收方没有任何订阅，之后的发布先重新订阅
+                std::lock_guard<std::mutex> lk(l->lock);
+                l->subscribed.clear();
+            }
+            presenceLinkUp(l->node);
+            l->connected.store(true);
+            std::cout << "[CLUSTER] Linked to node " << l->node << " (" << nodeAddrs[l->node].host << ":"
+                      << nodeAddrs[l->node].port << ")" << std::endl;
+        }
+        if (batch.empty()) {
+            std::unique_lock<std::mutex> lk(l->lock);
+            l->ready.wait(lk, [l]() { return !l->pending.empty(); });
+            batch.swap(l->pending);
+        }
+        // 等待期间攒下的记录一起写出：每帧一次 send，帧内记录数就是批大小
+        size_t pos = 0;
+        while (pos < batch.size()) {
+            size_t end = cutFrame(batch, pos);
+            frame.clear();
+            putU32(frame, (uint32_t)(end - pos));
+            frame.append(batch, pos, end - pos);
+            if (!writeAll(s, frame.data(), frame.size())) break;
+            l->framesOut.fetch_add(1, std::memory_order_relaxed);
+            l->bytesOut.fetch_add(frame.size(), std::memory_order_relaxed);
+            pos = end;
+        }
+        if (pos < batch.size()) {
+            // 写失败：没写出的记录留到重连之后（已经写进内核的那部分随连接一起丢失）
+            std::cout << "[CLUSTER] Link to node " << l->node << " lost" << std::endl;
+            l->connected.store(false);
+            closeSocket(s);
+            s = INVALID_SOCKET;
+            batch.erase(0, pos);
+            continue;
+        }
+        batch.clear();
+    }
+}
+
+// ========== 接收线程 ==========
+
+static bool readAll(SOCKET s, char* data, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        int n = recv(s, data + got, (int)(len - got), 0);
+        if (n <= 0) return false;
+        got += (size_t)n;
+    }
+    return true;
+}
+
+// 正在处理的请求已经转过两次，不再转发（两个节点的在线目录暂时不一致时避免来回转）
+static thread_local bool finalHop = false;
+
+// 其它节点转来的客户端请求：在本节点上以远端连接的身份处理。
+// 请求方节点的在线目录还不认识私聊对象时会按群名转过来，这里可以按私聊再转一次（R_FORWARD）
+static void handleRequest(int from, ConnId origin, bool forwarded, const char* data, size_t len,
+                          std::unordered_map<ConnId, std::shared_ptr<ConnOrder>>& orders) {
+    ConnId conn;
+    if (!forwarded) conn = makeRemoteConn(from, origin);
+    else conn = nodeOfConn(origin) == selfNode ? localConnOf(origin) : origin;
+    Message* m = ObjectPool<Message>::acquire();
+    parseMessageInto(data, len, *m);
+    {
+        MeteredLock lock(clientMutex);
+        // 记下该用户在哪个节点：本节点的成员表只存编号，扇出时按编号取到远端连接
+        UserId id = users.intern(m->sender);
+        ConnId cur = users.connOf(id);
+        if (cur == INVALID_CONN || isRemoteConn(cur)) users.setConn(id, conn);
+        // ALL 平时由本地用户的 JOIN 创建；归属节点上可能还没有本地用户
+        if (m->accepter == "ALL" && sessions.find("ALL") == sessions.end()) {
+            ServerSession allSession;
+            allSession.id = "ALL";
+            allSession.type = ST_GROUP;
+            sessions["ALL"] = allSession;
+            journalSessionCreate("ALL", ST_GROUP);
+        }
+    }
+    HandlerPool* pool = getHandlerPool();
+    if (pool == nullptr) {
+        finalHop = forwarded;
+        handleMessage(*m, conn);
+        finalHop = false;
+        ObjectPool<Message>::release(m);
+        return;
+    }
+    // 同一个远端连接的请求按序处理，与本地连接的约束相同
+    std::shared_ptr<ConnOrder>& order = orders[conn];
+    if (!order) {
+        order = std::make_shared<ConnOrder>();
+        order->lastKey = "#" + std::to_string(conn);
+    }
+    pool->submit(order, messageOrderKey(*m), [m, conn, forwarded]() {
+        finalHop = forwarded;
+        handleMessage(*m, conn);
+        finalHop = false;
+        ObjectPool<Message>::release(m);
+    });
+}
+
+static void receiverLoop(SOCKET s) {
+    std::string body;
+    std::string payload;
+    std::unordered_map<ConnId, std::shared_ptr<ConnOrder>> orders;
+    std::unordered_map<std::string, std::vector<ConnId>> subs;   // 对端归属的会话在本节点上的订阅者
+    std::vector<ConnId> targets;
+    int from = -1;
+    char hdr[4];
+    while (readAll(s, hdr, 4)) {
+        size_t len = getU32(hdr);
+        if (len > PEER_MAX_FRAME) break;
+        body.resize(len);
+        if (!readAll(s, &body[0], len)) break;
+        size_t pos = 0;
+        while (pos + RECORD_HEADER <= len) {
+            int kind = (unsigned char)body[pos];
+            uint64_t conn = getU64(body.data() + pos + 1);
+            size_t n = getU32(body.data() + pos + 9);
+            const char* data = body.data() + pos + RECORD_HEADER;
+            if (pos + RECORD_HEADER + n > len) break;
+            pos += RECORD_HEADER + n;
+            if (kind == R_HELLO) {
+                from = (int)conn;
+                if (from < 0 || from >= (int)nodeAddrs.size() || from == selfNode) {
+                    std::cout << "[CLUSTER] Bad hello from node " << from << std::endl;
+                    closeSocket(s);
+                    return;
+                }
+                continue;
+            }
+            if (from < 0) break;   // 没有先自报节点编号
+            links[from]->recordsIn.fetch_add(1, std::memory_order_relaxed);
+            switch (kind) {
+            case R_REQUEST:
+            case R_FORWARD:
+                handleRequest(from, conn, kind == R_FORWARD, data, n, orders);
+                break;
+            case R_DELIVER:
+                // 发给个别用户的聊天消息只有私聊（群聊走 R_PUBLISH），按私聊分流，与本节点的回显同流
+                payload.assign(data, n);
+                sendFrameTo(conn, makePrivateFrame(payload));
+                break;
+            case R_BROADCAST:
+                payload.assign(data, n);
+                broadcastLocal(payload, conn);
+                break;
+            case R_SUBSCRIBE: {
+                if (conn > n || (n - conn) % 8 != 0) break;
+                std::vector<ConnId>& list = subs[std::string(data, conn)];
+                list.clear();
+                for (size_t k = conn; k < n; k += 8) list.push_back(getU64(data + k));
+                if (list.empty()) subs.erase(std::string(data, conn));
+                break;
+            }
+            case R_PUBLISH: {
+                if (n < 8 || conn > n - 8) break;
+                ConnId exclude = getU64(data);
+                auto it = subs.find(std::string(data + 8, conn));
+                if (it == subs.end()) break;
+                // 只转来一份，在本节点按订阅者扇出
+                targets.clear();
+                for (ConnId c : it->second) {
+                    if (c != exclude) targets.push_back(c);
+                }
+                payload.assign(data + 8 + conn, n - 8 - conn);
+                fanOut(targets, makeFrame(payload));
+                break;
+            }
+            case R_GOSSIP:
+                applyGossip(from, data, n);
+                break;
+            case R_USER_GONE: {
+                ConnId remote = makeRemoteConn(from, conn);
+                std::string name(data, n);
+                {
+                    MeteredLock lock(clientMutex);
+                    UserId id = users.find(name);
+                    if (id != NO_USER && users.connOf(id) == remote) users.setConn(id, INVALID_CONN);
+                }
+                orders.erase(remote);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+    if (from >= 0) std::cout << "[CLUSTER] Node " << from << " disconnected" << std::endl;
+    closeSocket(s);
+}
+
+// 每 GOSSIP_INTERVAL_MS 给每个连通的节点发一次在线目录的增量；没有变化时每秒只发一次版本向量
+static void gossipLoop() {
+    std::vector<std::chrono::steady_clock::time_point> lastSent(links.size());
+    std::string payload;
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(GOSSIP_INTERVAL_MS));
+        presenceTick();
+        auto now = std::chrono::steady_clock::now();
+        for (int n = 0; n < (int)links.size(); n++) {
+            if (links[n] == nullptr || !links[n]->connected.load()) continue;
+            bool force = now - lastSent[n] >= std::chrono::seconds(1);
+            if (!buildGossip(n, payload, force)) continue;
+            enqueue(n, R_GOSSIP, 0, payload.data(), payload.size());
+            lastSent[n] = now;
+        }
+    }
+}
+
+static void peerAcceptLoop(SOCKET listener) {
+    while (true) {
+        SOCKET s = accept(listener, nullptr, nullptr);
+        if (s == INVALID_SOCKET) break;
+        setNoDelay(s);
+        std::thread(receiverLoop, s).detach();
+    }
+}
+
+// ========== 启动与路由 ==========
+
+static bool parseNodes(const std::string& list, std::vector<NodeAddr>& out) {
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        size_t colon = item.rfind(':');
+        if (colon == std::string::npos) return false;
+        NodeAddr a;
+        a.host = item.substr(0, colon);
+        a.port = (unsigned short)std::atoi(item.c_str() + colon + 1);
+        if (a.host.empty() || a.port == 0) return false;
+        out.push_back(a);
+    }
+    return !out.empty() && out.size() <= (size_t)MAX_CLUSTER_NODES;
+}
+
+bool startCluster(const std::string& nodes, int self) {
+    std::vector<NodeAddr> addrs;
+    if (!parseNodes(nodes, addrs) || self < 0 || self >= (int)addrs.size()) {
+        std::cout << "[ERROR] Bad cluster spec (want --cluster host:port,... --node index)" << std::endl;
+        return false;
+    }
+    nodeAddrs = addrs;
+    for (int n = 0; n < (int)nodeAddrs.size(); n++) {
+        for (int v = 0; v < VNODES; v++) {
+            std::string point = nodeAddrs[n].host + ":" + std::to_string(nodeAddrs[n].port) + "#" + std::to_string(v);
+            ring.emplace_back(hashKey(point.data(), point.size()), n);
+        }
+    }
+    std::sort(ring.begin(), ring.end());
+
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+#ifndef _WIN32
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+#endif
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(nodeAddrs[self].port);
+    addr.sin_addr.s_addr = inet_addr(nodeAddrs[self].host.c_str());
+    if (bind(listener, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(listener, SOMAXCONN) == SOCKET_ERROR) {
+        std::cout << "[ERROR] Cluster port " << nodeAddrs[self].port << " unavailable" << std::endl;
+        closeSocket(listener);
+        return false;
+    }
+    links.assign(nodeAddrs.size(), nullptr);
+    for (int n = 0; n < (int)nodeAddrs.size(); n++) {
+        if (n == self) continue;
+        links[n] = new PeerLink();
+        links[n]->node = n;
+    }
+    startPresence((int)nodeAddrs.size(), self);
+    selfNode.store(self);
+    std::thread(peerAcceptLoop, listener).detach();
+    std::thread(gossipLoop).detach();
+    for (auto& l : links) {
+        if (l) std::thread(senderLoop, l).detach();
+    }
+    return true;
+}
+
+bool clusterEnabled() {
+    return selfNode >= 0;
+}
+
+int clusterSelf() {
+    return selfNode;
+}
+
+int clusterSize() {
+    return (int)nodeAddrs.size();
+}
+
+int ownerOf(const std::string& sessionId) {
+    if (selfNode < 0) return 0;
+    uint64_t h = hashKey(sessionId.data(), sessionId.size());
+    auto it = std::lower_bound(ring.begin(), ring.end(), std::make_pair(h, 0));
+    if (it == ring.end()) it = ring.begin();
+    return it->second;
+}
+
+// 私聊：两人发给对方的请求要落在同一个节点上，按排好序的两个名字选归属（'|' 不会出现在名字里）
+int privateOwnerOf(const std::string& user1, const std::string& user2) {
+    return user1 < user2 ? ownerOf(user1 + "|" + user2) : ownerOf(user2 + "|" + user1);
+}
+
+// 名字是否是用户（在线目录里有记录，或本节点见过），否则按群名处理
+static bool isUserName(const std::string& name) {
+    ConnId conn;
+    if (presenceFind(name, conn)) return true;
+    MeteredLock lock(clientMutex);
+    return users.find(name) != NO_USER;
+}
+
+bool clusterRoute(const Message& m, ConnId clientConn) {
+    if (selfNode < 0 || m.accepter.empty() || finalHop) return false;
+    if (m.type != "MSG" && m.type != BATCH_TYPE && m.type != "JOIN_SESSION" && m.type != "LEAVE_SESSION" &&
+        m.type != "CREATE_GROUP" && m.type != "TYPING") return false;
+    int owner;
+    if (m.type != "CREATE_GROUP" && m.accepter != "ALL" && isUserName(m.accepter)) {
+        owner = privateOwnerOf(m.sender, m.accepter);
+    } else {
+        owner = ownerOf(m.accepter);
+    }
+    if (owner == selfNode) return false;
+    std::string payload = buildMessage(m);
+    if (isRemoteConn(clientConn)) enqueue(owner, R_FORWARD, clientConn, payload.data(), payload.size());
+    else enqueue(owner, R_REQUEST, clientConn, payload.data(), payload.size());
+    return true;
+}
+
+void clusterSend(ConnId remote, const FramePtr& frame) {
+    int node = nodeOfConn(remote);
+    if (node >= (int)links.size()) return;
+    enqueue(node, R_DELIVER, localConnOf(remote), frame->data() + FRAME_HEADER_SIZE, frame->size() - FRAME_HEADER_SIZE);
+}
+
+void clusterDeliver(std::vector<ConnId>& remotes, const FramePtr& frame) {
+    // 按节点排好，每个节点的链路只加一次锁
+    std::sort(remotes.begin(), remotes.end());
+    const char* data = frame->data() + FRAME_HEADER_SIZE;
+    size_t len = frame->size() - FRAME_HEADER_SIZE;
+    size_t i = 0;
+    while (i < remotes.size()) {
+        int node = nodeOfConn(remotes[i]);
+        size_t j = i;
+        while (j < remotes.size() && nodeOfConn(remotes[j]) == node) j++;
+        PeerLink* l = node < (int)links.size() ? links[node] : nullptr;
+        if (l != nullptr) {
+            bool wake;
+            {
+                std::lock_guard<std::mutex> lk(l->lock);
+                wake = l->pending.empty();
+                if (l->pending.size() > PEER_MAX_PENDING) {
+                    l->dropped.fetch_add(j - i, std::memory_order_relaxed);
+                } else {
+                    for (size_t k = i; k < j; k++) appendRecord(l->pending, R_DELIVER, localConnOf(remotes[k]), data, len);
+                    l->recordsOut.fetch_add(j - i, std::memory_order_relaxed);
+                }
+            }
+            if (wake) l->ready.notify_one();
+        }
+        i = j;
+    }
+}
+
+void clusterPublish(const std::string& sessionId, std::vector<ConnId>& remotes, ConnId excludeConn, const FramePtr& frame) {
+    std::sort(remotes.begin(), remotes.end());
+    const char* data = frame->data() + FRAME_HEADER_SIZE;
+    size_t len = frame->size() - FRAME_HEADER_SIZE;
+    thread_local std::vector<ConnId> ids;
+    size_t i = 0;
+    while (i < remotes.size()) {
+        int node = nodeOfConn(remotes[i]);
+        ids.clear();
+        for (; i < remotes.size() && nodeOfConn(remotes[i]) == node; i++) ids.push_back(localConnOf(remotes[i]));
+        PeerLink* l = node < (int)links.size() ? links[node] : nullptr;
+        if (l == nullptr) continue;
+        ConnId exclude = (isRemoteConn(excludeConn) && nodeOfConn(excludeConn) == node) ? localConnOf(excludeConn) : INVALID_CONN;
+        bool wake;
+        bool resubscribed = false;
+        {
+            std::lock_guard<std::mutex> lk(l->lock);
+            if (l->pending.size() > PEER_MAX_PENDING) {
+                l->dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            wake = l->pending.empty();
+            // 订阅者有变化（有人加入、离开、换了连接）才重发名单；稳定时每条消息每个节点只有一条记录
+            std::vector<ConnId>& known = l->subscribed[sessionId];
+            if (known != ids) {
+                known = ids;
+                appendHeader(l->pending, R_SUBSCRIBE, sessionId.size(), sessionId.size() + ids.size() * 8);
+                l->pending += sessionId;
+                for (ConnId id : ids) putU64(l->pending, id);
+                resubscribed = true;
+            }
+            appendHeader(l->pending, R_PUBLISH, sessionId.size(), 8 + sessionId.size() + len);
+            putU64(l->pending, exclude);
+            l->pending += sessionId;
+            l->pending.append(data, len);
+        }
+        if (wake) l->ready.notify_one();
+        l->recordsOut.fetch_add(resubscribed ? 2 : 1, std::memory_order_relaxed);
+        l->publishes.fetch_add(1, std::memory_order_relaxed);
+        l->publishTargets.fetch_add(ids.size(), std::memory_order_relaxed);
+        if (resubscribed) l->subscribes.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void clusterBroadcast(const std::string& payload, ConnId excludeConn) {
+    if (selfNode < 0) return;
+    for (int n = 0; n < (int)links.size(); n++) {
+        if (!links[n]) continue;
+        ConnId exclude = (isRemoteConn(excludeConn) && nodeOfConn(excludeConn) == n) ? localConnOf(excludeConn) : INVALID_CONN;
+        enqueue(n, R_BROADCAST, exclude, payload.data(), payload.size());
+    }
+}
+
+void clusterUserGone(const std::string& name, ConnId conn) {
+    if (selfNode < 0) return;
+    for (int n = 0; n < (int)links.size(); n++) {
+        if (links[n]) enqueue(n, R_USER_GONE, conn, name.data(), name.size());
+    }
+}
+
+void describeCluster(std::ostream& os) {
+    if (selfNode < 0) {
+        os << "cluster mode is off (start with --cluster host:port,... --node index)\n";
+        return;
+    }
+    os << "cluster: node " << selfNode << " of " << nodeAddrs.size() << "\n";
+    for (int n = 0; n < (int)links.size(); n++) {
+        if (!links[n]) continue;
+        PeerLink* l = links[n];
+        size_t pending;
+        {
+            std::lock_guard<std::mutex> lk(l->lock);
+            pending = l->pending.size();
+        }
+        uint64_t frames = l->framesOut.load();
+        os << "  node " << n << " " << nodeAddrs[n].host << ":" << nodeAddrs[n].port
+           << (l->connected.load() ? " up" : " down") << "  out " << l->recordsOut.load() << " records / " << frames
+           << " frames (" << (frames > 0 ? (double)l->recordsOut.load() / frames : 0.0) << " per frame), "
+           << l->bytesOut.load() << " B, pending " << pending << " B, dropped " << l->dropped.load()
+           << "  in " << l->recordsIn.load() << " records\n"
+           << "    pub/sub: " << l->publishes.load() << " publishes for " << l->publishTargets.load() << " members, "
+           << l->subscribes.load() << " subscription updates\n";
+    }
+    describePresence(os);
+}
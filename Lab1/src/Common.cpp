@@ -1,41 +1,203 @@
 #include "../include/Common.h"
 #include <sstream>
 #include <ctime>
+#include <cstdlib>
 #include <iomanip>
+#include <cstdio>
+#include <cstring>
 #include<vector>
 
 //定义解封装函数
 Message parseMessage(const std::string &strMsg){
         Message m;
-        size_t start=0;
-        size_t pos;
-        //拆分解析消息
-        std::vector<std::string> parts;
-        while((pos=strMsg.find('|',start))!=std::string::npos){
-            parts.push_back(strMsg.substr(start,pos-start));
-            start=pos+1;
+        parseMessageInto(strMsg.data(), strMsg.size(), m);
+        return m;
+}
+
+const std::string& conversationOf(const Message& m, const std::string& self){
+        //发给我的是对方的私聊；其余（群聊、我自己发出的回显）都以 ACCEPTER 为会话
+        return m.accepter == self ? m.sender : m.accepter;
+}
+
+//按 | 拆分字段，直接 assign 到 out 的各个字符串（不产生临时 vector/substr）
+void parseMessageInto(const char* data, size_t len, Message& out){
+        std::string* fields[4] = {&out.type, &out.sender, &out.accepter, &out.content};
+        const char* end = data + len;
+        const char* start = data;
+        int index = 0;
+        const char* tsStart = nullptr;
+        const char* tsEnd = nullptr;
+        while (true) {
+            const char* bar = (const char*)memchr(start, '|', (size_t)(end - start));
+            //文件块的内容是原始字节，一直取到帧尾（没有时间戳字段）
+            if (index == 3 && (out.type == FILE_DATA_TYPE || out.type == BATCH_TYPE)) bar = nullptr;
+            const char* fieldEnd = bar != nullptr ? bar : end;
+            if (index < 4) fields[index]->assign(start, (size_t)(fieldEnd - start));
+            else if (index == 4) { tsStart = start; tsEnd = fieldEnd; }
+            else if (index == 5) out.trace.assign(start, (size_t)(fieldEnd - start));
+            index++;
+            if (bar == nullptr) break;
+            start = bar + 1;
         }
-        // 添加最后一个字段（从最后一个 | 之后到字符串末尾）
-        parts.push_back(strMsg.substr(start));
-
-        //判断后填结构体
-        if(parts.size()>0) m.type=parts[0];
-        if(parts.size()>1) m.sender=parts[1];
-        if(parts.size()>2) m.accepter=parts[2];       
-        if(parts.size()>3) m.content=parts[3];
-        
+        //缺少的字段置空
+        for (int i = index; i < 4; i++) fields[i]->clear();
+        if (index <= 5) out.trace.clear();
+
         // 解析时间戳（如果存在）
-        if(parts.size()>4 && !parts[4].empty()) {
-            m.timestamp = std::stoll(parts[4]);
+        if (tsStart != nullptr && tsStart != tsEnd) {
+            char buf[32];
+            size_t n = (size_t)(tsEnd - tsStart) < sizeof(buf) - 1 ? (size_t)(tsEnd - tsStart) : sizeof(buf) - 1;
+            memcpy(buf, tsStart, n);
+            buf[n] = '\0';
+            out.timestamp = std::strtoll(buf, nullptr, 10); // 非法输入得到 0，不抛异常
         } else {
-            m.timestamp = std::time(nullptr); // 默认当前时间
+            out.timestamp = std::time(nullptr); // 默认当前时间
         }
+}
+void appendFileChunkHeader(std::string& out, const std::string& sender, const std::string& hash, uint64_t offset){
+    char off[24];
+    int n = snprintf(off, sizeof(off), "%llu", (unsigned long long)offset);
+    out.append(FILE_DATA_TYPE).append(1, '|')
+       .append(sender).append(1, '|')
+       .append(hash).append(1, '|')
+       .append(off, (size_t)n).append(1, '|');
+}
 
-        return m;
+void appendBatchHeader(std::string& out, const std::string& sender, const std::string& session, int64_t timestamp){
+    char ts[24];
+    int n = snprintf(ts, sizeof(ts), "%lld", (long long)timestamp);
+    out.append(BATCH_TYPE).append(1, '|')
+       .append(sender).append(1, '|')
+       .append(session).append(1, '|')
+       .append(ts, (size_t)n).append(1, '|');
 }
+
+void appendBatchItem(std::string& out, const char* text, size_t len){
+    char head[24];
+    int n = snprintf(head, sizeof(head), "%zu:", len);
+    out.append(head, (size_t)n).append(text, len);
+}
+
+bool parseBatch(const std::string& content, int64_t& timestamp, std::vector<std::pair<size_t, size_t>>& items){
+    items.clear();
+    size_t bar = content.find('|');
+    if (bar == std::string::npos || bar == 0 || bar > 20) return false;
+    timestamp = std::strtoll(content.c_str(), nullptr, 10);
+    size_t pos = bar + 1;
+    while (pos < content.size()) {
+        //长度是不超过帧长的十进制数，后跟 ':'
+        size_t len = 0;
+        size_t digits = 0;
+        while (pos < content.size() && content[pos] >= '0' && content[pos] <= '9' && digits < 6) {
+            len = len * 10 + (size_t)(content[pos] - '0');
+            pos++;
+            digits++;
+        }
+        if (digits == 0 || pos >= content.size() || content[pos] != ':') return false;
+        pos++;
+        if (len > content.size() - pos) return false;
+        items.emplace_back(pos, len);
+        pos += len;
+    }
+    return !items.empty();
+}
+
 //定义封装函数
 std::string buildMessage(const Message& m) {
-    // 协议格式: TYPE|SENDER|ACCEPTER|CONTENT|TIMESTAMP
-    return m.type + "|" + m.sender + "|" + m.accepter + "|" + m.content + "|" + std::to_string(m.timestamp);
+    // 协议格式: TYPE|SENDER|ACCEPTER|CONTENT|TIMESTAMP[|TRACE]
+    std::string out;
+    out.reserve(m.type.size() + m.sender.size() + m.accepter.size() + m.content.size() + m.trace.size() + 25);
+    appendMessage(out, m);
+    return out;
+}
+
+void appendMessage(std::string& out, const Message& m) {
+    char ts[24];
+    int n = snprintf(ts, sizeof(ts), "%lld", (long long)m.timestamp);
+    out.append(m.type).append(1, '|')
+       .append(m.sender).append(1, '|')
+       .append(m.accepter).append(1, '|')
+       .append(m.content);
+    if (m.type == BATCH_TYPE) return;   // 内容一直到帧尾，时间戳已在内容开头
+    out.append(1, '|').append(ts, (size_t)n);
+    if (!m.trace.empty()) out.append(1, '|').append(m.trace);
 }
 
+
+
+static const char* typeNames[MT_TYPE_COUNT] = {
+    "SYS", "JOIN", "MSG", "EXIT", "JOIN_SESSION", "LEAVE_SESSION", "NOTIFY", "CREATE_GROUP",
+    "TYPING", "EVENTS", "FILE_PUT", "FILE_ACK", "FILE_GET", "FILE_INFO", "FILE_DATA", "COMPRESS", "ZIP", "BATCH", "OTHER"};
+
+MessageType messageTypeOf(const char* type, size_t len) {
+    for (int i = 0; i < MT_OTHER; i++) {
+        if (strlen(typeNames[i]) == len && memcmp(typeNames[i], type, len) == 0) return (MessageType)i;
+    }
+    return MT_OTHER;
+}
+
+const char* messageTypeName(int type) {
+    return (type >= 0 && type < MT_TYPE_COUNT) ? typeNames[type] : "OTHER";
+}
+
+//定义封帧函数
+std::string encodeFrame(const std::string& payload) {
+    uint32_t len = (uint32_t)payload.size();
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    frame.push_back((char)((len >> 24) & 0xFF));
+    frame.push_back((char)((len >> 16) & 0xFF));
+    frame.push_back((char)((len >> 8) & 0xFF));
+    frame.push_back((char)(len & 0xFF));
+    frame += payload;
+    return frame;
+}
+
+bool sendFrame(SOCKET s, const std::string& payload) {
+    std::string frame = encodeFrame(payload);
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        int n = send(s, frame.data() + sent, (int)(frame.size() - sent), 0);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+void FrameDecoder::feed(const char* data, size_t len) {
+    // 已消费的前缀过大时再整理，避免每次都搬移内存
+    if (pos > 0 && pos >= buf.size() / 2) {
+        buf.erase(0, pos);
+        pos = 0;
+    }
+    buf.append(data, len);
+}
+
+bool FrameDecoder::next(std::string& payload) {
+    if (bad || buf.size() - pos < FRAME_HEADER_SIZE) return false;
+    const unsigned char* p = (const unsigned char*)buf.data() + pos;
+    size_t len = ((size_t)p[0] << 24) | ((size_t)p[1] << 16) | ((size_t)p[2] << 8) | (size_t)p[3];
+    if (len > MAX_FRAME_SIZE) {
+        bad = true;
+        return false;
+    }
+    if (buf.size() - pos < FRAME_HEADER_SIZE + len) return false;
+    payload.assign(buf, pos + FRAME_HEADER_SIZE, len);
+    pos += FRAME_HEADER_SIZE + len;
+    return true;
+}
+
+bool FrameDecoder::next(const char*& data, size_t& len) {
+    if (bad || buf.size() - pos < FRAME_HEADER_SIZE) return false;
+    const unsigned char* p = (const unsigned char*)buf.data() + pos;
+    size_t n = ((size_t)p[0] << 24) | ((size_t)p[1] << 16) | ((size_t)p[2] << 8) | (size_t)p[3];
+    if (n > MAX_FRAME_SIZE) {
+        bad = true;
+        return false;
+    }
+    if (buf.size() - pos < FRAME_HEADER_SIZE + n) return false;
+    data = buf.data() + pos + FRAME_HEADER_SIZE;
+    len = n;
+    pos += FRAME_HEADER_SIZE + n;
+    return true;
+}
@@ -0,0 +1,141 @@
+#include "../include/Compress.h"
+#include "../include/Sha256.h"
+#include <cstring>
+
+static const size_t MIN_MATCH = 4;
+static const int HASH_BITS = 12;
+static const size_t MAX_OFFSET = 65535;   // 偏移用 2 字节编码
+
+static inline uint32_t read32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t hash4(const char* p) {
+    return (read32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void putLength(std::string& out, size_t v) {
+    for (; v >= 255; v -= 255) out.push_back((char)255);
+    out.push_back((char)v);
+}
+
+static void putSequence(std::string& out, const char* lit, size_t litLen, size_t offset, size_t matchLen) {
+    size_t m = matchLen >= MIN_MATCH ? matchLen - MIN_MATCH : 0;
+    unsigned char token = (unsigned char)((litLen < 15 ? litLen : 15) << 4);
+    if (offset != 0) token |= (unsigned char)(m < 15 ? m : 15);
+    out.push_back((char)token);
+    if (litLen >= 15) putLength(out, litLen - 15);
+    out.append(lit, litLen);
+    if (offset == 0) return;
+    out.push_back((char)(offset & 0xFF));
+    out.push_back((char)(offset >> 8));
+    if (m >= 15) putLength(out, m - 15);
+}
+
+// 两端相同的裁剪规则：历史超过两个窗口时只留最近一个窗口（按块摊还，不是每块都搬移）
+static size_t trimHistory(std::string& hist) {
+    if (hist.size() <= 2 * ZIP_WINDOW) return 0;
+    size_t shift = hist.size() - ZIP_WINDOW;
+    hist.erase(0, shift);
+    return shift;
+}
+
+// ========== 编码 ==========
+
+ZipEncoder::ZipEncoder(const std::string& dict) : hist(dict), table((size_t)1 << HASH_BITS, 0) {
+    for (size_t i = 0; i + MIN_MATCH <= hist.size(); i++) table[hash4(hist.data() + i)] = (uint32_t)(i + 1);
+}
+
+void ZipEncoder::trim() {
+    size_t shift = trimHistory(hist);
+    if (shift == 0) return;
+    for (uint32_t& e : table) e = e > shift ? e - (uint32_t)shift : 0;
+}
+
+void ZipEncoder::compress(const char* in, size_t len, std::string& out) {
+    trim();
+    size_t start = hist.size();
+    hist.append(in, len);
+    const char* base = hist.data();
+    size_t end = hist.size();
+    size_t anchor = start;
+    size_t i = start;
+    while (i + MIN_MATCH <= end) {
+        uint32_t h = hash4(base + i);
+        size_t cand = table[h];
+        table[h] = (uint32_t)(i + 1);
+        if (cand == 0 || i - (cand - 1) > MAX_OFFSET || read32(base + cand - 1) != read32(base + i)) {
+            i++;
+            continue;
+        }
+        size_t from = cand - 1;
+        size_t n = MIN_MATCH;
+        while (i + n < end && base[from + n] == base[i + n]) n++;
+        putSequence(out, base + anchor, i - anchor, i - from, n);
+        // 匹配内部的位置也登记进表，后面的相似片段能接上
+        for (size_t k = i + 1; k < i + n && k + MIN_MATCH <= end; k++) table[hash4(base + k)] = (uint32_t)(k + 1);
+        i += n;
+        anchor = i;
+    }
+    putSequence(out, base + anchor, end - anchor, 0, 0);
+}
+
+// ========== 解码 ==========
+
+ZipDecoder::ZipDecoder(const std::string& dict) : hist(dict) {}
+
+static bool getLength(const unsigned char*& p, const unsigned char* end, size_t& v) {
+    while (true) {
+        if (p == end) return false;
+        unsigned char b = *p++;
+        v += b;
+        if (b != 255) return true;
+    }
+}
+
+bool ZipDecoder::decompress(const char* in, size_t len, std::string& out, size_t maxOut) {
+    trimHistory(hist);
+    size_t start = hist.size();
+    const unsigned char* p = (const unsigned char*)in;
+    const unsigned char* end = p + len;
+    while (true) {
+        if (p == end) return false;
+        unsigned char token = *p++;
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !getLength(p, end, litLen)) return false;
+        if ((size_t)(end - p) < litLen || hist.size() - start + litLen > maxOut) return false;
+        hist.append((const char*)p, litLen);
+        p += litLen;
+        if (p == end) break;   // 最后一个序列只有字面量
+        if (end - p < 2) return false;
+        size_t offset = (size_t)p[0] | ((size_t)p[1] << 8);
+        p += 2;
+        size_t matchLen = token & 15;
+        if (matchLen == 15 && !getLength(p, end, matchLen)) return false;
+        matchLen += MIN_MATCH;
+        if (offset == 0 || offset > hist.size() || hist.size() - start + matchLen > maxOut) return false;
+        // 可能与正在写出的部分重叠（重复片段），逐字节复制
+        size_t from = hist.size() - offset;
+        for (size_t k = 0; k < matchLen; k++) hist.push_back(hist[from + k]);
+    }
+    out.append(hist, start, std::string::npos);
+    return true;
+}
+
+// ========== 内置字典 ==========
+
+const std::string& chatDictionary() {
+    static const std::string dict(CHAT_DICT, CHAT_DICT_SIZE);
+    return dict;
+}
+
+const std::string& chatDictionaryId() {
+    static const std::string id = [] {
+        Sha256 sha;
+        sha.update(chatDictionary().data(), chatDictionary().size());
+        return "lz-" + sha.hexDigest().substr(0, 8);
+    }();
+    return id;
+}
@@ -0,0 +1,105 @@
+#include "../include/FramePool.h"
+#include "../include/ObjectPool.h"
+#include <cstring>
+#include <utility>
+
+// 超过这个容量的缓冲不回池（偶发的大帧不应长期占住内存）
+static const size_t MAX_POOLED_FRAME = 16 * 1024;
+
+void FramePtr::reset() {
+    if (p == nullptr) return;
+    if (p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (p->bytes.capacity() > MAX_POOLED_FRAME) {
+            delete p;
+        } else {
+            p->bytes.clear();
+            ObjectPool<FrameBuf>::release(p);
+        }
+    }
+    p = nullptr;
+}
+
+static void putLength(std::string& out, size_t at, uint32_t len) {
+    out[at] = (char)((len >> 24) & 0xFF);
+    out[at + 1] = (char)((len >> 16) & 0xFF);
+    out[at + 2] = (char)((len >> 8) & 0xFF);
+    out[at + 3] = (char)(len & 0xFF);
+}
+
+static uint32_t fnv(uint32_t h, const char* p, const char* end) {
+    for (; p < end; p++) {
+        h ^= (unsigned char)*p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 发送通道：群聊的 MSG 与 BATCH 按会话（ACCEPTER 字段）分流（同一会话的两种帧在同一流里，先后不变），
+// 私聊按 SENDER 与 ACCEPTER 排好序后的组合分流：alice→bob 与 bob→alice 落在同一流里，
+// 否则同一连接收到的回显与对方的回复会在轮转时互相越过。其余（SYS、加入/退出通知、RECONNECT 等）都走控制通道。
+// 广播会话 ALL 的权重低于具体的群聊与私聊，刷屏时其它会话的消息不会被它淹没。
+// 文件块（不能零拷贝的后端才会走到这里）按摘要分流，权重与 ALL 相同，不会挡住聊天消息
+static void classify(FrameBuf* b, const char* payload, size_t len, bool isPrivate) {
+    b->flow = 0;
+    b->weight = 1;
+    b->pair = false;
+    if (b->type != MT_MSG && b->type != MT_BATCH && b->type != MT_FILE_DATA) return;
+    const char* end = payload + len;
+    const char* p = (const char*)memchr(payload, '|', len);                            // TYPE 之后
+    const char* sender = p != nullptr ? p + 1 : nullptr;
+    if (p != nullptr) p = (const char*)memchr(p + 1, '|', (size_t)(end - p - 1));      // SENDER 之后
+    if (p == nullptr) return;
+    const char* acc = p + 1;
+    const char* accEnd = (const char*)memchr(acc, '|', (size_t)(end - acc));
+    if (accEnd == nullptr) accEnd = end;
+    uint32_t h = 2166136261u;   // FNV-1a
+    if (isPrivate && b->type != MT_FILE_DATA) {
+        b->pair = true;
+        const char* senderEnd = p;
+        size_t sl = (size_t)(senderEnd - sender), al = (size_t)(accEnd - acc);
+        int cmp = memcmp(sender, acc, sl < al ? sl : al);
+        if (cmp > 0 || (cmp == 0 && sl > al)) {
+            std::swap(sender, acc);
+            std::swap(senderEnd, accEnd);
+        }
+        static const char sep = '|';
+        h = fnv(h, sender, senderEnd);
+        h = fnv(h, &sep, &sep + 1);
+        h = fnv(h, acc, accEnd);
+    } else {
+        h = fnv(h, acc, accEnd);
+    }
+    b->flow = h != 0 ? h : 1;
+    b->weight = b->type == MT_FILE_DATA || (!b->pair && accEnd - acc == 3 && memcmp(acc, "ALL", 3) == 0) ? 1 : 2;
+}
+
+static FramePtr encodeFrame(const std::string& payload, int64_t traceUs, bool isPrivate) {
+    FrameBuf* b = ObjectPool<FrameBuf>::acquire();
+    b->traceUs = traceUs;
+    const char* bar = (const char*)memchr(payload.data(), '|', payload.size());
+    b->type = messageTypeOf(payload.data(), bar != nullptr ? (size_t)(bar - payload.data()) : payload.size());
+    b->bytes.resize(FRAME_HEADER_SIZE);
+    putLength(b->bytes, 0, (uint32_t)payload.size());
+    b->bytes += payload;
+    classify(b, payload.data(), payload.size(), isPrivate);
+    return FramePtr(b);
+}
+
+FramePtr makeFrame(const std::string& payload, int64_t traceUs) {
+    return encodeFrame(payload, traceUs, false);
+}
+
+FramePtr makePrivateFrame(const std::string& payload, int64_t traceUs) {
+    return encodeFrame(payload, traceUs, true);
+}
+
+FramePtr makeMessageFrame(const Message& m, bool isPrivate) {
+    FrameBuf* b = ObjectPool<FrameBuf>::acquire();
+    b->traceUs = 0;
+    b->type = messageTypeOf(m.type.data(), m.type.size());
+    b->bytes.resize(FRAME_HEADER_SIZE);
+    appendMessage(b->bytes, m);
+    putLength(b->bytes, 0, (uint32_t)(b->bytes.size() - FRAME_HEADER_SIZE));
+    classify(b, b->bytes.data() + FRAME_HEADER_SIZE, b->bytes.size() - FRAME_HEADER_SIZE, isPrivate);
+    return FramePtr(b);
+}
@@ -0,0 +1,204 @@
+#include "../include/HandlerPool.h"
+#include <chrono>
+#include <cstdint>
+
+static HandlerPool* handlerPool = nullptr;
+static thread_local int currentWorker = -1;    // 当前线程在池中的编号，非工作线程为 -1
+
+HandlerPool::HandlerPool(int count) {
+    for (int i = 0; i < count; i++) workers.emplace_back(new Worker());
+    for (int i = 0; i < count; i++) {
+        workers[i]->thread = std::thread(&HandlerPool::workerLoop, this, i);
+    }
+}
+
+HandlerPool::~HandlerPool() {
+    stop();
+}
+
+void HandlerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lk(idleLock);
+        running.store(false);
+    }
+    idle.notify_all();
+    for (auto& w : workers) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+}
+
+HandlerPool::Shard& HandlerPool::shardOf(const std::string& key) {
+    return shards[std::hash<std::string>()(key) % SHARD_COUNT];
+}
+
+void HandlerPool::submit(const std::shared_ptr<ConnOrder>& order, const std::string& key, Job job) {
+    submitJob(order, key, job, false);
+}
+
+bool HandlerPool::trySubmit(const std::shared_ptr<ConnOrder>& order, const std::string& key, Job& job) {
+    return submitJob(order, key, job, true);
+}
+
+// 持有连接的锁完成入队（锁顺序：连接 → 分片），strand 已满时连接的状态不变，job 原样留给调用方
+bool HandlerPool::submitJob(const std::shared_ptr<ConnOrder>& order, const std::string& key, Job& job, bool bounded) {
+    std::lock_guard<std::mutex> lk(order->lock);
+    if (bounded && order->running + order->deferred.size() >= MAX_CONN_JOBS) return false;
+    std::string k = key.empty() ? order->lastKey : key;
+    // 该连接还有任务在别的 strand 里，或者已经有任务在排队：先挂起，保证连接内的顺序
+    if (!order->deferred.empty() || (order->running > 0 && k != order->lastKey)) {
+        order->deferred.emplace_back(k, std::move(job));
+        outstanding.fetch_add(1);
+        return true;
+    }
+    Task task{std::move(job), order};
+    outstanding.fetch_add(1);
+    if (!enqueue(k, task, bounded ? MAX_STRAND_JOBS : SIZE_MAX)) {
+        outstanding.fetch_sub(1);
+        job = std::move(task.job);
+        return false;
+    }
+    order->running++;
+    order->lastKey = k;
+    return true;
+}
+
+// 连接的任务全部完成后，放行挂起的任务（连续的同一 strand 任务一次放行）
+void HandlerPool::finished(const std::shared_ptr<ConnOrder>& order) {
+    std::vector<std::pair<std::string, Job>> release;
+    {
+        std::lock_guard<std::mutex> lk(order->lock);
+        if (--order->running > 0) return;
+        while (!order->deferred.empty() &&
+               (release.empty() || order->deferred.front().first == release.front().first)) {
+            release.push_back(std::move(order->deferred.front()));
+            order->deferred.pop_front();
+        }
+        if (release.empty()) return;
+        order->running = (int)release.size();
+        order->lastKey = release.front().first;
+    }
+    for (auto& [k, job] : release) {
+        Task task{std::move(job), order};
+        enqueue(k, task, SIZE_MAX);
+    }
+}
+
+bool HandlerPool::enqueue(const std::string& key, Task& task, size_t limit) {
+    Shard& sh = shardOf(key);
+    std::shared_ptr<Strand> toSchedule;
+    {
+        std::lock_guard<std::mutex> lk(sh.lock);
+        std::shared_ptr<Strand>& s = sh.strands[key];
+        if (!s) {
+            s = std::make_shared<Strand>();
+            s->key = key;
+        }
+        if (s->jobs.size() >= limit) return false;
+        s->jobs.push_back(std::move(task));
+        if (!s->scheduled) {
+            s->scheduled = true;
+            toSchedule = s;
+        }
+    }
+    queued.fetch_add(1, std::memory_order_relaxed);
+    if (toSchedule) schedule(toSchedule);
+    return true;
+}
+
+// 工作线程自己产生的 strand 放进自己的队列，reactor 提交的轮流分给各工作线程
+void HandlerPool::schedule(const std::shared_ptr<Strand>& s) {
+    int target = currentWorker;
+    if (target < 0) target = (int)(nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size());
+    {
+        std::lock_guard<std::mutex> lk(workers[target]->lock);
+        workers[target]->ready.push_back(s);
+    }
+    {
+        std::lock_guard<std::mutex> lk(idleLock);
+        readyCount.fetch_add(1);
+    }
+    idle.notify_one();
+}
+
+bool HandlerPool::takeWork(int self, std::shared_ptr<Strand>& out) {
+    {
+        Worker& w = *workers[self];
+        std::lock_guard<std::mutex> lk(w.lock);
+        if (!w.ready.empty()) {
+            out = std::move(w.ready.front());
+            w.ready.pop_front();
+            readyCount.fetch_sub(1);
+            return true;
+        }
+    }
+    // 自己没活：从其它线程队列的尾部偷一个
+    int n = (int)workers.size();
+    for (int i = 1; i < n; i++) {
+        Worker& v = *workers[(self + i) % n];
+        std::lock_guard<std::mutex> lk(v.lock);
+        if (!v.ready.empty()) {
+            out = std::move(v.ready.back());
+            v.ready.pop_back();
+            readyCount.fetch_sub(1);
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void HandlerPool::runStrand(const std::shared_ptr<Strand>& s) {
+    Shard& sh = shardOf(s->key);
+    for (int n = 0; n < STRAND_BATCH; n++) {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lk(sh.lock);
+            if (s->jobs.empty()) {
+                // 做完了：空闲 strand 太多时从表中移除，之后同名任务会新建 strand
+                s->scheduled = false;
+                if (sh.strands.size() > MAX_IDLE_STRANDS) {
+                    auto it = sh.strands.find(s->key);
+                    if (it != sh.strands.end() && it->second == s) sh.strands.erase(it);
+                }
+                return;
+            }
+            task = std::move(s->jobs.front());
+            s->jobs.pop_front();
+        }
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        task.job();
+        if (task.order) finished(task.order);
+        executed.fetch_add(1, std::memory_order_relaxed);
+        // 停止时最后一个任务做完：叫醒空等的工作线程退出
+        if (outstanding.fetch_sub(1) == 1 && !running.load()) {
+            std::lock_guard<std::mutex> lk(idleLock);
+            idle.notify_all();
+        }
+    }
+    // 配额用完仍有任务：排到队尾，先让其它 strand 执行
+    schedule(s);
+}
+
+void HandlerPool::workerLoop(int self) {
+    currentWorker = self;
+    // 停止后继续执行，直到已提交的任务（包括各连接挂起的）全部做完
+    while (running.load() || outstanding.load() > 0) {
+        std::shared_ptr<Strand> s;
+        if (takeWork(self, s)) {
+            runStrand(s);
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(idleLock);
+        idle.wait_for(lk, std::chrono::milliseconds(100), [this]() {
+            return readyCount.load() > 0 || (!running.load() && outstanding.load() == 0);
+        });
+    }
+}
+
+void startHandlerPool(int workers) {
+    if (workers > 0 && handlerPool == nullptr) handlerPool = new HandlerPool(workers);
+}
+
+HandlerPool* getHandlerPool() {
+    return handlerPool;
+}
@@ -0,0 +1,212 @@
+#include "../include/Handoff.h"
+#include "../include/Metrics.h"
+#include "../include/Server.h"
+#include "../include/StateStore.h"
+
+#ifdef _WIN32
+
+bool takeOverFrom(const std::string&, std::vector<SOCKET>&) {
+    return false;
+}
+
+bool startHandoffListener(const std::string&) {
+    std::cout << "[WARN] Socket handoff is not supported on this platform" << std::endl;
+    return false;
+}
+
+#else
+
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <cstring>
+
+static bool makeAddr(const std::string& path, sockaddr_un& addr) {
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static bool writeAll(int s, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(s, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// 第一段：4 字节的套接字个数，套接字本身放在 SCM_RIGHTS 控制消息里
+static bool sendListeners(int s, const std::vector<SOCKET>& fds) {
+    uint32_t n = (uint32_t)fds.size();
+    iovec iov{&n, sizeof(n)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    std::vector<char> ctrl(CMSG_SPACE(sizeof(int) * (n > 0 ? n : 1)));
+    if (n > 0) {
+        msg.msg_control = ctrl.data();
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * n);
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int) * n);
+        memcpy(CMSG_DATA(c), fds.data(), sizeof(int) * n);
+    }
+    return sendmsg(s, &msg, MSG_NOSIGNAL) == (ssize_t)sizeof(n);
+}
+
+static bool recvListeners(int s, std::vector<SOCKET>& out) {
+    uint32_t n = 0;
+    iovec iov{&n, sizeof(n)};
+    std::vector<char> ctrl(CMSG_SPACE(sizeof(int) * MAX_REACTORS));
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.data();
+    msg.msg_controllen = ctrl.size();
+    if (recvmsg(s, &msg, MSG_CMSG_CLOEXEC) != (ssize_t)sizeof(n)) return false;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        size_t count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int* fds = (const int*)CMSG_DATA(c);
+        for (size_t i = 0; i < count; i++) out.push_back(fds[i]);
+    }
+    return out.size() == n;
+}
+
+// 第二段：会话表，沿用聊天协议的帧格式
+//   SESSION|<类型>|<会话名>|   之后跟若干条   MEMBER|<用户名>|<会话名>|
+//   私聊每个一条   PAIR|<用户名>|<用户名>|   最后是   END
+static bool sendState(int s, size_t& sessionCount) {
+    // 成员编号只在本进程内有效，交接时按用户名发送；编码在分批持锁期间完成
+    std::string out;
+    size_t count = 0;
+    scanInChunks(sessions, [&out, &count](const std::string& id, const ServerSession& sess) {
+        out += encodeFrame(buildMessage(Message{"SESSION", std::to_string((int)sess.type), id, ""}));
+        for (UserId member : sess.members) {
+            out += encodeFrame(buildMessage(Message{"MEMBER", users.name(member), id, ""}));
+        }
+        count++;
+    });
+    std::vector<PairKey> pairs = privateSessionKeys();
+    for (size_t start = 0; start < pairs.size(); start += SCAN_CHUNK) {
+        MeteredLock lock(clientMutex);
+        for (size_t i = start; i < pairs.size() && i < start + SCAN_CHUNK; i++) {
+            out += encodeFrame(buildMessage(Message{"PAIR", users.name(pairs[i].lo()), users.name(pairs[i].hi()), ""}));
+        }
+    }
+    count += pairs.size();
+    out += encodeFrame(buildMessage(Message{"END", "", "", ""}));
+    sessionCount = count;
+    return writeAll(s, out);
+}
+
+static bool recvState(int s, size_t& sessionCount) {
+    struct Loaded {
+        SessionType type = ST_GROUP;
+        std::vector<std::string> members;
+    };
+    std::map<std::string, Loaded> loaded;
+    std::vector<std::pair<std::string, std::string>> pairs;
+    FrameDecoder decoder;
+    std::string payload;
+    char buf[16384];
+    while (true) {
+        while (decoder.next(payload)) {
+            Message m = parseMessage(payload);
+            if (m.type == "END") {
+                MeteredLock lock(clientMutex);
+                for (auto& [id, l] : loaded) {
+                    ServerSession& sess = sessions[id];
+                    sess.id = id;
+                    sess.type = l.type;
+                    std::vector<UserId> ids;
+                    ids.reserve(l.members.size());
+                    for (const auto& name : l.members) ids.push_back(users.intern(name));
+                    sess.members.assign(std::move(ids));
+                }
+                for (const auto& [a, b] : pairs) privateSessions.insert(PairKey(users.intern(a), users.intern(b)));
+                sessionCount = loaded.size() + pairs.size();
+                return true;
+            }
+            if (m.type == "SESSION") {
+                int type = std::atoi(m.sender.c_str());
+                loaded[m.accepter].type = (type == ST_PRIVATE) ? ST_PRIVATE : ST_GROUP;
+            } else if (m.type == "MEMBER") {
+                loaded[m.accepter].members.push_back(m.sender);
+            } else if (m.type == "PAIR") {
+                pairs.emplace_back(m.sender, m.accepter);
+            }
+        }
+        if (decoder.error()) return false;
+        ssize_t n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        decoder.feed(buf, (size_t)n);
+    }
+}
+
+bool takeOverFrom(const std::string& path, std::vector<SOCKET>& listeners) {
+    sockaddr_un addr;
+    if (!makeAddr(path, addr)) return false;
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s < 0) return false;
+    // 连不上说明没有旧进程（或只是残留的套接字文件），按冷启动处理
+    if (connect(s, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(s);
+        return false;
+    }
+    size_t sessionCount = 0;
+    bool ok = recvListeners(s, listeners) && recvState(s, sessionCount);
+    close(s);
+    if (!ok) {
+        std::cout << "[WARN] Handoff from " << path << " failed, starting cold" << std::endl;
+        for (SOCKET l : listeners) closeSocket(l);
+        listeners.clear();
+        return false;
+    }
+    std::cout << "[SYS] Took over " << listeners.size() << " listeners and " << sessionCount
+              << " sessions from the previous server" << std::endl;
+    return true;
+}
+
+static void handoffLoop(int listener) {
+    while (true) {
+        int s = accept(listener, nullptr, nullptr);
+        if (s < 0) continue;
+        size_t sessionCount = 0;
+        bool ok = sendListeners(s, getListeners()) && sendState(s, sessionCount);
+        close(s);
+        if (!ok) {
+            std::cout << "[WARN] Handoff to new server failed, still serving" << std::endl;
+            continue;
+        }
+        // 路径已归新进程所有，这里只关闭自己的套接字，不删除文件
+        close(listener);
+        // 会话表以新进程为准，之后由它写快照和日志
+        stopStatePersistence();
+        std::cout << "[SYS] Handed over " << getListeners().size() << " listeners and " << sessionCount
+                  << " sessions to the new server" << std::endl;
+        drainServer(serverConfig.drainSeconds * 1000);
+        return;
+    }
+}
+
+bool startHandoffListener(const std::string& path) {
+    sockaddr_un addr;
+    if (!makeAddr(path, addr)) return false;
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s < 0) return false;
+    unlink(path.c_str());   // 上一个进程留下的文件（交接后由新进程重新创建）
+    if (bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 1) != 0) {
+        close(s);
+        return false;
+    }
+    chmod(path.c_str(), 0600);   // 拿到监听套接字就能接管服务，只允许同一用户连接
+    std::thread(handoffLoop, s).detach();
+    return true;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "../include/Histogram.h"
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() {
+    for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(int64_t value) {
+    if (value < 1) value = 1;
+    uint64_t v = (uint64_t)value;
+    int exp = 63;
+    while (exp > 0 && !(v >> exp)) exp--;
+    int sub = exp >= SUB_BITS ? (int)((v >> (exp - SUB_BITS)) & (SUB - 1)) : (int)(v & (SUB - 1));
+    counts[exp * SUB + sub].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    int64_t m = maxValue.load(std::memory_order_relaxed);
+    while (value > m && !maxValue.compare_exchange_weak(m, value, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& o) {
+    for (int i = 0; i < BUCKETS; i++) {
+        uint64_t n = o.counts[i].load(std::memory_order_relaxed);
+        if (n > 0) counts[i].fetch_add(n, std::memory_order_relaxed);
+    }
+    total.fetch_add(o.count(), std::memory_order_relaxed);
+    int64_t om = o.max();
+    int64_t m = maxValue.load(std::memory_order_relaxed);
+    while (om > m && !maxValue.compare_exchange_weak(m, om, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::percentile(double p) const {
+    // 读取期间可能有并发写入，按各桶当时的计数求和，结果是近似值
+    uint64_t sum = 0;
+    for (int i = 0; i < BUCKETS; i++) sum += counts[i].load(std::memory_order_relaxed);
+    if (sum == 0) return 0;
+    uint64_t rank = (uint64_t)std::ceil(p / 100.0 * (double)sum);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            int exp = i / SUB, sub = i % SUB;
+            if (exp < SUB_BITS) return sub;
+            double lo = (double)((uint64_t)(SUB + sub) << (exp - SUB_BITS));
+            double width = (double)(1ULL << (exp - SUB_BITS));
+            return (int64_t)(lo + width / 2);
+        }
+    }
+    return max();
+}
@@ -0,0 +1,454 @@
+#ifdef _WIN32
+#define FD_SETSIZE 1024     // Winsock 默认 select 只能容纳 64 个套接字
+#endif
+
+#include "../include/IoBackend.h"
+#include "../include/Metrics.h"
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#ifdef _WIN32
+#define SEND_FLAGS 0
+#else
+#define SEND_FLAGS MSG_NOSIGNAL     // 对端已关闭时不要触发 SIGPIPE
+#endif
+
+#ifdef MSG_MORE
+#define HEAD_FLAGS (SEND_FLAGS | MSG_MORE)   // 文件块的帧头与随后 sendfile 的内容合成一个 TCP 段
+#else
+#define HEAD_FLAGS SEND_FLAGS
+#endif
+
+// 一次可写事件里最多开始的文件块数，写够后让出，下一轮先写新到的聊天帧
+static const int FILE_BURST = 8;
+
+// 一次 writev/WSASend 最多携带的分片数
+static const int MAX_SLICES = 64;
+
+#ifdef _WIN32
+typedef WSABUF IoSlice;
+#else
+typedef iovec IoSlice;
+#endif
+
+// 轮询器中的特殊标识（真实 ConnId 的序号从 1 开始，至少为 256）
+static const uint64_t WAKE_TOKEN = 0;
+static const uint64_t LISTEN_TOKEN = 1;
+
+static void setSlice(IoSlice& s, const char* data, size_t len) {
+#ifdef _WIN32
+    s.buf = (CHAR*)data;
+    s.len = (ULONG)len;
+#else
+    s.iov_base = (void*)data;
+    s.iov_len = len;
+#endif
+}
+
+// 聚集写：一次系统调用写出多段数据，返回写出的字节数，出错返回 -1
+static long writeSlices(SOCKET s, IoSlice* slices, int count) {
+#ifdef _WIN32
+    DWORD sent = 0;
+    if (WSASend(s, slices, (DWORD)count, &sent, 0, nullptr, nullptr) == SOCKET_ERROR) return -1;
+    return (long)sent;
+#else
+    msghdr mh{};
+    mh.msg_iov = slices;
+    mh.msg_iovlen = (size_t)count;
+    return (long)sendmsg(s, &mh, SEND_FLAGS);
+#endif
+}
+
+// ========== 就绪式后端（select / epoll 共用的收发逻辑） ==========
+
+struct IoEvent {
+    uint64_t token;
+    bool readable;
+    bool writable;
+};
+
+class ReadinessBackend : public IoBackend {
+public:
+    void addListener(SOCKET l) override {
+        listener = l;
+        setNonBlocking(l);
+        watch(l, LISTEN_TOKEN);
+    }
+
+    void removeListener(SOCKET l) override {
+        unwatch(l);
+        listener = INVALID_SOCKET;
+    }
+
+    void addConn(Connection& c) override {
+        setNonBlocking(c.sock);
+        setNoDelay(c.sock);
+        watch(c.sock, c.id);
+    }
+
+    void removeConn(Connection& c) override {
+        unwatch(c.sock);
+    }
+
+    bool sendsFiles() const override { return sendFileSupported(); }
+
+    void flush(Connection& c) override {
+        // 正在等可写时不写，届时按通道优先级一起写出（写了一半的帧总是先写完）
+        if (c.writeBlocked) return;
+        if (writeQueued(c)) {
+            c.writeBlocked = true;
+            rewatch(c.sock, c.id, true);
+        }
+    }
+
+    void poll(int64_t timeoutUs) override {
+        wait(events, timeoutUs);
+        countSyscall();
+        for (const IoEvent& ev : events) {
+            if (ev.token == WAKE_TOKEN) {
+                drainWake();
+                continue;
+            }
+            if (ev.token == LISTEN_TOKEN) {
+                acceptReady();
+                continue;
+            }
+            Connection* c = reactor.findConn(ev.token);
+            if (c == nullptr) continue;
+            if (ev.writable) flushPending(*c);
+            if (ev.readable && !c->closing) readReady(*c);
+        }
+    }
+
+protected:
+    explicit ReadinessBackend(Reactor& owner) : IoBackend(owner) {}
+
+    virtual void watch(SOCKET s, uint64_t token) = 0;
+    virtual void rewatch(SOCKET s, uint64_t token, bool writable) = 0;
+    virtual void unwatch(SOCKET s) = 0;
+    virtual void drainWake() = 0;
+    virtual void wait(std::vector<IoEvent>& out, int64_t timeoutUs) = 0;
+
+private:
+    void acceptReady() {
+        // 每轮最多接入一批，避免连接风暴饿死已有连接
+        for (int i = 0; i < 64 && listener != INVALID_SOCKET; i++) {
+            SOCKET s = accept(listener, nullptr, nullptr);
+            countSyscall();
+            if (s == INVALID_SOCKET) break;
+            reactor.onAccept(s);
+        }
+    }
+
+    void readReady(Connection& c) {
+        char buffer[16384];
+        int bytes = recv(c.sock, buffer, sizeof(buffer), 0);
+        countSyscall();
+        if (bytes == 0 || (bytes < 0 && !socketWouldBlock())) {
+            reactor.markClosing(c);
+            return;
+        }
+        if (bytes > 0) reactor.onData(c, buffer, (size_t)bytes);
+    }
+
+    void flushPending(Connection& c) {
+        if (!writeQueued(c) && c.writeBlocked) {
+            c.writeBlocked = false;
+            rewatch(c.sock, c.id, false);
+        }
+    }
+
+    // 写了一半的帧在前，之后按通道优先级逐帧取出聚集写出。
+    // 写不完的帧放回各自通道（而不是拼进 pending），下次可写时新到的控制帧仍能排到它们前面。
+    // 通道都写空后才写文件块（零拷贝），每次最多 FILE_BURST 块。
+    // 返回是否还有没写完的数据（需要等可写）
+    bool writeQueued(Connection& c) {
+        if (c.files.midChunk() && writeFileChunk(c)) return true;
+        if (writeLanes(c)) return true;
+        if (!sendsFiles()) return false;
+        for (int i = 0; i < FILE_BURST; i++) {
+            // 没有文件时 startChunk 顺便关闭上一个发完的文件
+            if (!c.files.startChunk()) return false;
+            metrics().framesOut[MT_FILE_DATA].add();
+            metrics().bytesOut.add(c.files.head.size() + c.files.bodyLeft);
+            if (writeFileChunk(c)) return true;
+        }
+        return true;   // 还有块没发：等下一次可写，期间到达的聊天帧先写
+    }
+
+    // 写完当前文件块：帧头用 send，内容用 sendfile 直接从页缓存发出，不经过用户态。返回是否需要等可写
+    bool writeFileChunk(Connection& c) {
+        FileLane& f = c.files;
+        while (f.headSent < f.head.size()) {
+            long n = (long)send(c.sock, f.head.data() + f.headSent, (int)(f.head.size() - f.headSent), HEAD_FLAGS);
+            countWrite();
+            if (n < 0) return socketWouldBlock() || !failWrite(c);
+            f.headSent += (size_t)n;
+        }
+        while (f.bodyLeft > 0) {
+            long n = sendFileAt(c.sock, f.bodyFd, f.bodyOffset, f.bodyLeft);
+            countWrite();
+            if (n < 0 && socketWouldBlock()) return true;
+            // 文件在发送途中被截断：这一帧已经无法补齐，只能断开
+            if (n <= 0) return !failWrite(c);
+            f.bodyOffset += (uint64_t)n;
+            f.bodyLeft -= (size_t)n;
+        }
+        return false;
+    }
+
+    // 写出错：关闭连接并丢弃所有待写数据，返回 true
+    bool failWrite(Connection& c) {
+        metrics().sendErrors.add();
+        reactor.markClosing(c);
+        c.lanes.clear();
+        c.pending.clear();
+        c.files.clear();
+        return true;
+    }
+
+    bool writeLanes(Connection& c) {
+        FramePtr batch[MAX_SLICES];
+        while (!c.pending.empty() || !c.lanes.empty()) {
+            IoSlice slices[MAX_SLICES];
+            int count = 0;
+            int taken = 0;
+            size_t total = 0;
+            if (!c.pending.empty()) {
+                setSlice(slices[count++], c.pending.data(), c.pending.size());
+                total += c.pending.size();
+            }
+            while (count < MAX_SLICES) {
+                FramePtr f = c.lanes.pop();
+                if (!f) break;
+                setSlice(slices[count++], f->data(), f->size());
+                total += f->size();
+                batch[taken++] = std::move(f);
+            }
+            long n = writeSlices(c.sock, slices, count);
+            countWrite();
+            if (n < 0) {
+                if (!socketWouldBlock()) return !failWrite(c);
+                n = 0;
+            }
+            size_t left = (size_t)n;
+            if (!c.pending.empty()) {
+                size_t k = left < c.pending.size() ? left : c.pending.size();
+                c.pending.erase(0, k);
+                left -= k;
+            }
+            int done = 0;
+            while (done < taken && left >= batch[done]->size()) {
+                left -= batch[done]->size();
+                batch[done++].reset();
+            }
+            if (done < taken && left > 0) {
+                c.pending.assign(*batch[done], left, std::string::npos);   // 写了一半的帧
+                batch[done++].reset();
+            }
+            for (int i = taken - 1; i >= done; i--) c.lanes.unpop(std::move(batch[i]));
+            if ((size_t)n < total) return true;   // 内核发送缓冲已满
+        }
+        return false;
+    }
+
+    SOCKET listener = INVALID_SOCKET;
+    std::vector<IoEvent> events;
+};
+
+// ========== select 后端（全平台） ==========
+// 唤醒靠一个连接到自身的回环 UDP 套接字
+class SelectBackend : public ReadinessBackend {
+public:
+    explicit SelectBackend(Reactor& owner) : ReadinessBackend(owner) {}
+
+    ~SelectBackend() override {
+        if (wakeSock != INVALID_SOCKET) closeSocket(wakeSock);
+    }
+
+    const char* name() const override { return "select"; }
+
+#ifndef _WIN32
+    // fd_set 是按描述符编号索引的位图，FD_SET 超过 FD_SETSIZE 的描述符会写出界
+    bool canWatch(SOCKET s) const override { return s < FD_SETSIZE; }
+#endif
+
+    bool init() override {
+        wakeSock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (wakeSock == INVALID_SOCKET) return false;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+        if (bind(wakeSock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) return false;
+        if (getsockname(wakeSock, (sockaddr*)&addr, &len) == SOCKET_ERROR) return false;
+        if (connect(wakeSock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) return false;
+        setNonBlocking(wakeSock);
+        regs[wakeSock] = std::make_pair(WAKE_TOKEN, false);
+        return true;
+    }
+
+    void wake() override {
+        char b = 1;
+        ::send(wakeSock, &b, 1, 0);
+    }
+
+protected:
+    void watch(SOCKET s, uint64_t token) override { regs[s] = std::make_pair(token, false); }
+    void rewatch(SOCKET s, uint64_t token, bool writable) override { regs[s] = std::make_pair(token, writable); }
+    void unwatch(SOCKET s) override { regs.erase(s); }
+
+    void drainWake() override {
+        char b[64];
+        while (recv(wakeSock, b, sizeof(b), 0) > 0) {}
+    }
+
+    void wait(std::vector<IoEvent>& out, int64_t timeoutUs) override {
+        out.clear();
+        fd_set rset, wset;
+        FD_ZERO(&rset);
+        FD_ZERO(&wset);
+        SOCKET maxSock = 0;
+        for (const auto& [s, reg] : regs) {
+            FD_SET(s, &rset);
+            if (reg.second) FD_SET(s, &wset);
+            if (s > maxSock) maxSock = s;
+        }
+        timeval tv;
+        tv.tv_sec = (long)(timeoutUs / 1000000);
+        tv.tv_usec = (long)(timeoutUs % 1000000);
+        int n = select((int)(maxSock + 1), &rset, &wset, nullptr, &tv);
+        if (n <= 0) return;
+        for (const auto& [s, reg] : regs) {
+            bool r = FD_ISSET(s, &rset) != 0;
+            bool w = FD_ISSET(s, &wset) != 0;
+            if (r || w) out.push_back(IoEvent{reg.first, r, w});
+        }
+    }
+
+private:
+    SOCKET wakeSock = INVALID_SOCKET;
+    std::unordered_map<SOCKET, std::pair<uint64_t, bool>> regs;   // socket -> (标识, 是否关注可写)
+};
+
+#ifdef __linux__
+// ========== epoll 后端（Linux） ==========
+// 每个 reactor 一个 epoll 实例，用 eventfd 做跨线程唤醒
+class EpollBackend : public ReadinessBackend {
+public:
+    explicit EpollBackend(Reactor& owner) : ReadinessBackend(owner) {}
+
+    ~EpollBackend() override {
+        if (epfd >= 0) close(epfd);
+        if (wakeFd >= 0) close(wakeFd);
+    }
+
+    const char* name() const override { return "epoll"; }
+
+    bool init() override {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epfd < 0 || wakeFd < 0) return false;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = WAKE_TOKEN;
+        return epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &ev) == 0;
+    }
+
+    void wake() override {
+        uint64_t one = 1;
+        ssize_t r = write(wakeFd, &one, sizeof(one));
+        (void)r;
+    }
+
+    int wakeHandle() const override { return wakeFd; }
+
+protected:
+    void watch(SOCKET s, uint64_t token) override { ctl(EPOLL_CTL_ADD, s, token, false); }
+    void rewatch(SOCKET s, uint64_t token, bool writable) override { ctl(EPOLL_CTL_MOD, s, token, writable); }
+
+    void unwatch(SOCKET s) override {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, s, nullptr);
+        countSyscall();
+    }
+
+    void drainWake() override {
+        uint64_t v;
+        ssize_t r = read(wakeFd, &v, sizeof(v));
+        countSyscall();
+        (void)r;
+    }
+
+    void wait(std::vector<IoEvent>& out, int64_t timeoutUs) override {
+        out.clear();
+        int timeoutMs = (int)((timeoutUs + 999) / 1000);   // epoll_wait 只有毫秒精度，向上取整
+        int n = epoll_wait(epfd, buf.data(), (int)buf.size(), timeoutMs);
+        for (int i = 0; i < n; i++) {
+            IoEvent e;
+            e.token = buf[i].data.u64;
+            e.readable = (buf[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0;
+            e.writable = (buf[i].events & EPOLLOUT) != 0;
+            out.push_back(e);
+        }
+    }
+
+private:
+    void ctl(int op, SOCKET s, uint64_t token, bool writable) {
+        epoll_event ev{};
+        ev.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        ev.data.u64 = token;
+        epoll_ctl(epfd, op, s, &ev);
+        countSyscall();
+    }
+
+    int epfd = -1;
+    int wakeFd = -1;
+    std::vector<epoll_event> buf = std::vector<epoll_event>(256);
+};
+#endif
+
+// ========== 后端工厂 ==========
+
+const char* defaultIoBackend() {
+#ifdef __linux__
+    return "epoll";
+#else
+    return "select";
+#endif
+}
+
+IoBackend* createIoBackend(const std::string& name, Reactor& owner) {
+    std::string want = name.empty() ? defaultIoBackend() : name;
+    bool report = (owner.index() == 0);   // 回退提示只打印一次
+#ifdef __linux__
+    if (want == "uring") {
+        IoBackend* b = createUringBackend(owner);
+        if (b != nullptr) return b;
+        if (report) std::cout << "[WARN] io_uring unavailable, falling back to epoll" << std::endl;
+        want = "epoll";
+    }
+    if (want == "epoll") {
+        IoBackend* b = new EpollBackend(owner);
+        if (b->init()) return b;
+        delete b;
+        if (report) std::cout << "[WARN] epoll unavailable, falling back to select" << std::endl;
+        want = "select";
+    }
+#endif
+    if (want != "select" && report) {
+        std::cout << "[WARN] I/O backend '" << want << "' not supported here, using select" << std::endl;
+    }
+    IoBackend* b = new SelectBackend(owner);
+    if (b->init()) return b;
+    delete b;
+    return nullptr;
+}
@@ -0,0 +1,401 @@
+// ===================== 压测工具：无界面负载生成器 =====================
+// 功能说明：
+// 1. 一个进程模拟成千上万个在线用户，复用 Common.cpp 中的协议与帧格式。
+// 2. 可配置：用户数、上线方式（同时/匀速）、每人发送速率、消息大小、
+//    群聊与私聊的比例（ALL 为主 / 私聊为主 / 混合）。
+// 3. 每条消息内容里带上发送时刻，收到后计算端到端延迟。
+// 4. 每秒打印发送/投递速率，结束时给出总量与延迟分位数，用于评估服务器容量。
+// 5. --trace 时消息带跟踪字段，结束时额外给出“服务器->客户端”与端到端的分段统计，
+//    服务器各阶段的分布在服务器控制台输入 latency 查看。
+//
+// 用法：LoadGen.exe [--users N] [--threads T] [--duration 秒] [--rate 每人每秒条数]
+//                  [--size 字节] [--mix all|private|mixed] [--all-ratio 0~1]
+//                  [--join burst|ramp:毫秒] [--host IP] [--port 端口] [--unix 路径] [--trace]
+// ==========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/Common.h"
+#include "../include/Histogram.h"
+#include "../include/Trace.h"
+#ifdef _WIN32
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// ========== 参数 ==========
+struct LoadOptions {
+    int users = 1000;
+    int threads = 4;
+    int duration = 10;          // 压测时长（秒）
+    double rate = 1.0;          // 每个用户每秒发送的消息数
+    int size = 64;              // 消息内容字节数
+    double allRatio = 1.0;      // 发往 ALL 的消息比例，其余发给私聊对象
+    int rampMs = 0;             // 0 表示所有用户同时上线，否则在这段时间内匀速上线
+    std::string host = "127.0.0.1";
+    unsigned short port = 8888;
+    std::string unixPath;       // 非空时经 Unix 域套接字连接（与服务器同机）
+    bool trace = false;         // 消息是否带分段跟踪字段
+};
+
+static LoadOptions opt;
+
+// ========== 运行阶段（主线程推进，工作线程跟随） ==========
+enum Phase { PH_CONNECT, PH_JOIN, PH_LOAD, PH_DRAIN, PH_DONE };
+static std::atomic<int> phase{PH_CONNECT};
+
+static std::atomic<long long> connectedUsers{0};
+static std::atomic<long long> welcomed{0};
+static std::atomic<long long> joinAcks{0};
+static std::atomic<long long> sentMsgs{0};
+static std::atomic<long long> deliveredMsgs{0};
+static std::atomic<long long> failedUsers{0};
+static TraceStats traceStats;   // --trace 时各线程共同写入
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// ========== 模拟用户 ==========
+struct SimUser {
+    int index = 0;
+    std::string name;
+    std::string peer;           // 私聊对象（相邻编号的用户）
+    SOCKET sock = INVALID_SOCKET;
+    FrameDecoder decoder;
+    std::string out;            // 尚未写出的字节
+    int64_t connectAt = 0;      // 计划上线时刻
+    int64_t nextSend = 0;       // 下一条消息的计划发送时刻
+    bool joinedSessions = false;
+    bool exited = false;
+};
+
+static SOCKET connectServer() {
+    if (!opt.unixPath.empty()) {
+        SOCKET s = connectUnix(opt.unixPath);
+        if (s != INVALID_SOCKET) setNonBlocking(s);
+        return s;
+    }
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    addr.sin_addr.s_addr = inet_addr(opt.host.c_str());
+    if (connect(s, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        closeSocket(s);
+        return INVALID_SOCKET;
+    }
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+    setNonBlocking(s);
+    return s;
+}
+
+static void queueMessage(SimUser& u, const Message& m) {
+    std::string payload;
+    payload.reserve(64 + m.content.size());
+    appendMessage(payload, m);
+    u.out += encodeFrame(payload);
+}
+
+// 尽量把积压写出；连接出错返回 false
+static bool flushOut(SimUser& u) {
+    while (!u.out.empty()) {
+        int n = send(u.sock, u.out.data(), (int)u.out.size(), 0);
+        if (n < 0) return socketWouldBlock();
+        u.out.erase(0, (size_t)n);
+    }
+    return true;
+}
+
+static void closeUser(SimUser& u) {
+    if (u.sock != INVALID_SOCKET) {
+        closeSocket(u.sock);
+        u.sock = INVALID_SOCKET;
+    }
+}
+
+// 消息内容：LG<发送时刻纳秒>_ 后面用 x 补足到指定长度（不能含 |）
+static std::string makeContent(int64_t sendNs) {
+    std::string c = "LG" + std::to_string(sendNs) + "_";
+    if ((int)c.size() < opt.size) c.append((size_t)(opt.size - (int)c.size()), 'x');
+    return c;
+}
+
+static void handleFrame(SimUser& u, const Message& m, LatencyHistogram& hist) {
+    if (m.type == "MSG") {
+        deliveredMsgs.fetch_add(1, std::memory_order_relaxed);
+        if (m.content.size() > 2 && m.content[0] == 'L' && m.content[1] == 'G') {
+            int64_t sendNs = std::strtoll(m.content.c_str() + 2, nullptr, 10);
+            hist.record(nowNs() - sendNs);
+        }
+        int64_t stamps[TRACE_STAMPS];
+        if (!m.trace.empty() && parseTraceStamps(m.trace, stamps) == TRACE_STAMPS) {
+            int64_t now = traceNowUs();
+            traceStats.record(STAGE_NET_OUT, now - stamps[TRACE_ROUTE]);
+            traceStats.record(STAGE_END_TO_END, now - stamps[TRACE_SEND]);
+        }
+        return;
+    }
+    if (m.type != "SYS" || m.accepter != u.name) return;
+    // 欢迎语之后才算登录完成；之后的每条发给自己的系统消息都是加入会话的回复
+    if (m.content.find("/join") != std::string::npos) welcomed.fetch_add(1);
+    else if (u.joinedSessions) joinAcks.fetch_add(1);
+}
+
+// ========== 工作线程：负责编号 t, t+T, t+2T... 的用户 ==========
+static void worker(int t, LatencyHistogram* histOut) {
+    std::vector<SimUser> users;
+    for (int i = t; i < opt.users; i += opt.threads) {
+        SimUser u;
+        u.index = i;
+        u.name = "lg" + std::to_string(i);
+        int peer = (i % 2 == 0) ? i + 1 : i - 1;
+        if (peer >= opt.users) peer = i;   // 奇数个用户时最后一个和自己私聊
+        u.peer = "lg" + std::to_string(peer);
+        users.push_back(u);
+    }
+
+    std::mt19937 rng((unsigned)(t * 7919 + 17));
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    LatencyHistogram& hist = *histOut;
+    Message scratch;
+    std::vector<pollfd> fds;
+    std::vector<SimUser*> fdUsers;
+    char buf[16384];
+    int64_t start = nowNs();
+    for (SimUser& u : users) {
+        u.connectAt = start + (opt.rampMs > 0 ? (int64_t)u.index * opt.rampMs * 1000000LL / opt.users : 0);
+    }
+    int64_t intervalNs = opt.rate > 0 ? (int64_t)(1e9 / opt.rate) : 0;
+    bool loadStarted = false;
+    bool drainStarted = false;
+
+    while (true) {
+        int ph = phase.load();
+        int64_t now = nowNs();
+
+        // 上线：到点的用户建立连接并发送 JOIN
+        if (ph == PH_CONNECT) {
+            for (SimUser& u : users) {
+                if (u.sock != INVALID_SOCKET || u.exited || u.connectAt > now) continue;
+                u.sock = connectServer();
+                if (u.sock == INVALID_SOCKET) {
+                    u.exited = true;
+                    failedUsers.fetch_add(1);
+                    continue;
+                }
+                connectedUsers.fetch_add(1);
+                queueMessage(u, Message{"JOIN", u.name, "", ""});
+            }
+        }
+        // 加入会话：ALL 和私聊对象（此时所有用户都已登录，对方一定在线）
+        if (ph >= PH_JOIN) {
+            for (SimUser& u : users) {
+                if (u.sock == INVALID_SOCKET || u.joinedSessions) continue;
+                u.joinedSessions = true;
+                if (opt.allRatio > 0) queueMessage(u, Message{"JOIN_SESSION", u.name, "ALL", ""});
+                if (opt.allRatio < 1) queueMessage(u, Message{"JOIN_SESSION", u.name, u.peer, ""});
+            }
+        }
+        // 发送负载：每个用户按固定间隔发送，起始相位随机打散
+        if (ph == PH_LOAD) {
+            if (!loadStarted) {
+                loadStarted = true;
+                for (SimUser& u : users) u.nextSend = now + (int64_t)(uni(rng) * (double)intervalNs);
+            }
+            for (SimUser& u : users) {
+                if (u.sock == INVALID_SOCKET || intervalNs == 0) continue;
+                while (u.nextSend <= now) {
+                    bool toAll = uni(rng) < opt.allRatio;
+                    Message m{"MSG", u.name, toAll ? "ALL" : u.peer, makeContent(now)};
+                    if (opt.trace) m.trace = std::to_string(traceNowUs());
+                    queueMessage(u, m);
+                    sentMsgs.fetch_add(1, std::memory_order_relaxed);
+                    u.nextSend += intervalNs;
+                }
+            }
+        }
+        // 收尾：发送 EXIT 并关闭
+        if (ph == PH_DONE) {
+            if (!drainStarted) {
+                drainStarted = true;
+                for (SimUser& u : users) {
+                    if (u.sock == INVALID_SOCKET) continue;
+                    queueMessage(u, Message{"EXIT", u.name, "", ""});
+                    flushOut(u);
+                    closeUser(u);
+                }
+            }
+            break;
+        }
+
+        // 等待可读/可写，超时取下一个计划事件
+        fds.clear();
+        fdUsers.clear();
+        for (SimUser& u : users) {
+            if (u.sock == INVALID_SOCKET) continue;
+            pollfd p{};
+            p.fd = u.sock;
+            p.events = POLLIN;
+            if (!u.out.empty()) p.events |= POLLOUT;
+            fds.push_back(p);
+            fdUsers.push_back(&u);
+        }
+        int timeoutMs = 1;
+        if (fds.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            continue;
+        }
+        int n = poll(fds.data(), (unsigned long)fds.size(), timeoutMs);
+        if (n <= 0) continue;
+        for (size_t i = 0; i < fds.size(); i++) {
+            SimUser& u = *fdUsers[i];
+            if (fds[i].revents & POLLOUT) {
+                if (!flushOut(u)) {
+                    closeUser(u);
+                    continue;
+                }
+            }
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+                int bytes = recv(u.sock, buf, sizeof(buf), 0);
+                if (bytes == 0 || (bytes < 0 && !socketWouldBlock())) {
+                    closeUser(u);
+                    continue;
+                }
+                if (bytes < 0) continue;
+                u.decoder.feed(buf, (size_t)bytes);
+                const char* payload;
+                size_t len;
+                while (u.decoder.next(payload, len)) {
+                    parseMessageInto(payload, len, scratch);
+                    handleFrame(u, scratch, hist);
+                }
+            }
+        }
+        // 新排队的数据立刻尝试写出，不必等下一轮 poll
+        for (SimUser* u : fdUsers) {
+            if (u->sock != INVALID_SOCKET && !u->out.empty() && !flushOut(*u)) closeUser(*u);
+        }
+    }
+}
+
+// 等待计数达到目标，超时返回 false
+static bool waitFor(const std::atomic<long long>& counter, long long target, int timeoutMs) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (counter.load() < target) {
+        if (Clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+static void parseArgs(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--users" && hasValue) opt.users = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--duration" && hasValue) opt.duration = std::atoi(argv[++i]);
+        else if (arg == "--rate" && hasValue) opt.rate = std::atof(argv[++i]);
+        else if (arg == "--size" && hasValue) opt.size = std::atoi(argv[++i]);
+        else if (arg == "--all-ratio" && hasValue) opt.allRatio = std::atof(argv[++i]);
+        else if (arg == "--host" && hasValue) opt.host = argv[++i];
+        else if (arg == "--port" && hasValue) opt.port = (unsigned short)std::atoi(argv[++i]);
+        else if (arg == "--unix" && hasValue) opt.unixPath = argv[++i];
+        else if (arg == "--trace") opt.trace = true;
+        else if (arg == "--mix" && hasValue) {
+            std::string mix = argv[++i];
+            if (mix == "all") opt.allRatio = 1.0;
+            else if (mix == "private") opt.allRatio = 0.0;
+            else opt.allRatio = 0.5;   // mixed
+        } else if (arg == "--join" && hasValue) {
+            std::string join = argv[++i];
+            opt.rampMs = join.rfind("ramp:", 0) == 0 ? std::atoi(join.c_str() + 5) : 0;
+        } else {
+            std::cout << "[WARN] Unknown argument: " << arg << std::endl;
+        }
+    }
+    if (opt.users < 1) opt.users = 1;
+    if (opt.threads < 1) opt.threads = 1;
+    if (opt.threads > opt.users) opt.threads = opt.users;
+    if (opt.allRatio < 0) opt.allRatio = 0;
+    if (opt.allRatio > 1) opt.allRatio = 1;
+}
+
+int main(int argc, char* argv[]) {
+    setupConsole();
+    parseArgs(argc, argv);
+    if (!netStartup()) {
+        std::cout << "Load WSA failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "[LoadGen] users=" << opt.users << " threads=" << opt.threads << " duration=" << opt.duration
+              << "s rate=" << opt.rate << "/s/user size=" << opt.size << "B all-ratio=" << opt.allRatio
+              << " join=" << (opt.rampMs > 0 ? "ramp:" + std::to_string(opt.rampMs) + "ms" : std::string("burst"))
+              << std::endl;
+
+    std::unique_ptr<LatencyHistogram[]> hists(new LatencyHistogram[(size_t)opt.threads]);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < opt.threads; t++) threads.emplace_back(worker, t, &hists[(size_t)t]);
+
+    // 1. 登录：等所有用户收到欢迎语
+    auto t0 = Clock::now();
+    waitFor(welcomed, opt.users - failedUsers.load(), opt.rampMs + 30000);
+    double loginSec = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::cout << "  logged in " << welcomed.load() << "/" << opt.users << " users in " << loginSec << "s"
+              << (failedUsers.load() > 0 ? " (" + std::to_string(failedUsers.load()) + " failed to connect)" : "") << std::endl;
+
+    // 2. 加入会话：等所有加入请求的回复
+    long long perUser = (opt.allRatio > 0 ? 1 : 0) + (opt.allRatio < 1 ? 1 : 0);
+    phase.store(PH_JOIN);
+    waitFor(joinAcks, welcomed.load() * perUser, 30000);
+
+    // 3. 压测：每秒打印一次速率
+    phase.store(PH_LOAD);
+    auto loadStart = Clock::now();
+    long long lastSent = 0, lastDelivered = 0;
+    for (int s = 0; s < opt.duration; s++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        long long sent = sentMsgs.load(), delivered = deliveredMsgs.load();
+        std::cout << "  [" << (s + 1) << "s] sent=" << (sent - lastSent) << "/s delivered=" << (delivered - lastDelivered) << "/s" << std::endl;
+        lastSent = sent;
+        lastDelivered = delivered;
+    }
+    long long sentAtStop = sentMsgs.load();
+    double loadSec = std::chrono::duration<double>(Clock::now() - loadStart).count();
+
+    // 4. 停止发送，留 2 秒让在途消息送达
+    phase.store(PH_DRAIN);
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    phase.store(PH_DONE);
+    for (auto& th : threads) th.join();
+
+    LatencyHistogram all;
+    for (int t = 0; t < opt.threads; t++) all.merge(hists[(size_t)t]);
+    long long delivered = deliveredMsgs.load();
+    std::cout << "[LoadGen] result" << std::endl;
+    std::cout << "  sent      " << sentAtStop << " msgs -> " << (long long)(sentAtStop / loadSec) << " msg/s" << std::endl;
+    std::cout << "  delivered " << delivered << " frames -> " << (long long)(delivered / loadSec) << " frames/s" << std::endl;
+    std::cout << "  latency   p50=" << all.percentile(50) / 1000 << "us p90=" << all.percentile(90) / 1000
+              << "us p99=" << all.percentile(99) / 1000 << "us p999=" << all.percentile(99.9) / 1000
+              << "us max=" << all.max() / 1000 << "us (" << all.count() << " samples)" << std::endl;
+    if (opt.trace) {
+        std::cout << "  traced stages (us):" << std::endl;
+        traceStats.print(std::cout, STAGE_NET_OUT, STAGE_COUNT);
+    }
+    netCleanup();
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "../include/Metrics.h"
+#include "../include/Server.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <utility>
+
+// 导出成员数的会话上限（私聊会话可能成千上万，只导出成员最多的这些，避免标签基数爆炸）
+static const size_t MAX_EXPORTED_SESSIONS = 50;
+
+ServerMetrics& metrics() {
+    static ServerMetrics m;
+    return m;
+}
+
+MeteredLock::MeteredLock(std::mutex& m) : mu(m) {
+    ServerMetrics& mt = metrics();
+    mt.lockAcquires.add();
+    if (mu.try_lock()) return;
+    auto t0 = std::chrono::steady_clock::now();
+    mu.lock();
+    mt.lockContended.add();
+    mt.lockWaitNs.add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count());
+}
+
+// 标签值转义：反斜杠、双引号、换行
+static std::string escapeLabel(const std::string& v) {
+    std::string out;
+    out.reserve(v.size());
+    for (char ch : v) {
+        if (ch == '\\' || ch == '"') {
+            out.push_back('\\');
+            out.push_back(ch);
+        } else if (ch == '\n') {
+            out += "\\n";
+        } else {
+            out.push_back(ch);
+        }
+    }
+    return out;
+}
+
+static void header(std::ostringstream& os, const char* name, const char* type, const char* help) {
+    os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+
+static std::string renderMetrics() {
+    ServerMetrics& mt = metrics();
+    std::ostringstream os;
+
+    // 会话与在线用户：计量锁内只读计数；会话表分批扫描（每批短暂持锁），只保留成员最多的 MAX_EXPORTED_SESSIONS 个，
+    // 十万级会话时也不会一次持锁拷贝全部会话名而卡住路由
+    size_t users = 0;
+    size_t pairs = 0;
+    {
+        MeteredLock lock(clientMutex);
+        users = userSocket.size();
+        pairs = privateSessions.size();
+    }
+    size_t sessionCount = 0;
+    size_t totalMembers = 0;
+    auto larger = [](const std::pair<size_t, std::string>& a, const std::pair<size_t, std::string>& b) {
+        return a.first > b.first;
+    };
+    std::vector<std::pair<size_t, std::string>> members;   // 小顶堆：堆顶是已选中成员最少的会话
+    scanInChunks(sessions, [&](const std::string& id, const ServerSession& s) {
+        size_t n = s.members.size();
+        sessionCount++;
+        totalMembers += n;
+        if (members.size() < MAX_EXPORTED_SESSIONS) {
+            members.emplace_back(n, id);
+            std::push_heap(members.begin(), members.end(), larger);
+        } else if (n > members.front().first) {
+            std::pop_heap(members.begin(), members.end(), larger);
+            members.back() = {n, id};
+            std::push_heap(members.begin(), members.end(), larger);
+        }
+    });
+    std::sort(members.begin(), members.end(), larger);
+
+    header(os, "chat_connections", "gauge", "Open client connections.");
+    os << "chat_connections " << (mt.connOpened.value() - mt.connClosed.value()) << "\n";
+    header(os, "chat_connections_accepted_total", "counter", "Accepted client connections.");
+    os << "chat_connections_accepted_total " << mt.connOpened.value() << "\n";
+    header(os, "chat_users_online", "gauge", "Logged-in users.");
+    os << "chat_users_online " << users << "\n";
+    header(os, "chat_sessions", "gauge", "Sessions known to the server.");
+    os << "chat_sessions " << sessionCount << "\n";
+    header(os, "chat_private_sessions", "gauge", "Private sessions (user pairs) known to the server.");
+    os << "chat_private_sessions " << pairs << "\n";
+
+    header(os, "chat_session_members_total", "gauge", "Members summed over all sessions.");
+    os << "chat_session_members_total " << totalMembers << "\n";
+    header(os, "chat_session_members", "gauge", "Members per session (largest sessions only).");
+    for (const auto& [n, id] : members) {
+        os << "chat_session_members{session=\"" << escapeLabel(id) << "\"} " << n << "\n";
+    }
+
+    header(os, "chat_frames_in_total", "counter", "Frames received, by message type.");
+    for (int t = 0; t < MT_TYPE_COUNT; t++) {
+        os << "chat_frames_in_total{type=\"" << messageTypeName(t) << "\"} " << mt.framesIn[t].value() << "\n";
+    }
+    header(os, "chat_frames_out_total", "counter", "Frames queued for delivery, by message type.");
+    for (int t = 0; t < MT_TYPE_COUNT; t++) {
+        os << "chat_frames_out_total{type=\"" << messageTypeName(t) << "\"} " << mt.framesOut[t].value() << "\n";
+    }
+    header(os, "chat_bytes_in_total", "counter", "Bytes read from client sockets.");
+    os << "chat_bytes_in_total " << mt.bytesIn.value() << "\n";
+    header(os, "chat_bytes_out_total", "counter", "Bytes handed to client sockets.");
+    os << "chat_bytes_out_total " << mt.bytesOut.value() << "\n";
+    header(os, "chat_send_errors_total", "counter", "Connections closed because a send failed.");
+    os << "chat_send_errors_total " << mt.sendErrors.value() << "\n";
+    header(os, "chat_slow_consumer_disconnects_total", "counter", "Connections closed for exceeding the send backlog.");
+    os << "chat_slow_consumer_disconnects_total " << mt.slowConsumers.value() << "\n";
+    header(os, "chat_throttled_total", "counter", "Messages over a rate limit, by limit.");
+    os << "chat_throttled_total{limit=\"user\"} " << mt.throttledUser.value() << "\n";
+    os << "chat_throttled_total{limit=\"session\"} " << mt.throttledSession.value() << "\n";
+    header(os, "chat_throttle_actions_total", "counter", "Throttled messages, by action taken.");
+    os << "chat_throttle_actions_total{action=\"drop\"} " << mt.throttleDropped.value() << "\n";
+    os << "chat_throttle_actions_total{action=\"delay\"} " << mt.throttleDelayed.value() << "\n";
+    header(os, "chat_flood_disconnects_total", "counter", "Connections closed for flooding while paused.");
+    os << "chat_flood_disconnects_total " << mt.floodDisconnects.value() << "\n";
+    header(os, "chat_pool_paused_total", "counter", "Messages held back because the handler pool backlog was full.");
+    os << "chat_pool_paused_total " << mt.poolPaused.value() << "\n";
+    header(os, "chat_compress_frames_total", "counter", "Chat frames merged into compressed ZIP frames.");
+    os << "chat_compress_frames_total " << mt.compressFrames.value() << "\n";
+    header(os, "chat_compress_bytes_total", "counter", "Bytes before and after per-connection compression.");
+    os << "chat_compress_bytes_total{stage=\"in\"} " << mt.compressBytesIn.value() << "\n";
+    os << "chat_compress_bytes_total{stage=\"out\"} " << mt.compressBytesOut.value() << "\n";
+    header(os, "chat_compress_seconds_total", "counter", "Time spent compressing send backlogs.");
+    os << "chat_compress_seconds_total " << (double)mt.compressNs.value() / 1e9 << "\n";
+    header(os, "chat_batch_frames_total", "counter", "BATCH frames accepted from clients and frames expanded for legacy receivers.");
+    os << "chat_batch_frames_total{stage=\"in\"} " << mt.batchIn.value() << "\n";
+    os << "chat_batch_frames_total{stage=\"expanded\"} " << mt.batchExpanded.value() << "\n";
+    header(os, "chat_batch_messages_total", "counter", "Messages carried inside accepted BATCH frames.");
+    os << "chat_batch_messages_total " << mt.batchItems.value() << "\n";
+
+    header(os, "chat_reactor_mailbox_depth", "gauge", "Tasks waiting in each reactor mailbox.");
+    for (int i = 0; i < getReactorCount(); i++) {
+        Reactor* r = getReactor(i);
+        uint64_t posted = r->mailboxPosted.load(std::memory_order_relaxed);
+        uint64_t drained = r->mailboxDrained.load(std::memory_order_relaxed);
+        os << "chat_reactor_mailbox_depth{reactor=\"" << i << "\"} " << (posted > drained ? posted - drained : 0) << "\n";
+    }
+    HandlerPool* pool = getHandlerPool();
+    header(os, "chat_handler_queue_depth", "gauge", "Messages waiting in the handler pool.");
+    os << "chat_handler_queue_depth " << (pool != nullptr ? pool->queuedJobs() : 0) << "\n";
+    header(os, "chat_handler_steals_total", "counter", "Strands stolen between handler workers.");
+    os << "chat_handler_steals_total " << (pool != nullptr ? pool->steals.load() : 0) << "\n";
+
+    header(os, "chat_lock_acquires_total", "counter", "clientMutex acquisitions.");
+    os << "chat_lock_acquires_total{lock=\"client\"} " << mt.lockAcquires.value() << "\n";
+    header(os, "chat_lock_contended_total", "counter", "clientMutex acquisitions that had to wait.");
+    os << "chat_lock_contended_total{lock=\"client\"} " << mt.lockContended.value() << "\n";
+    header(os, "chat_lock_wait_seconds_total", "counter", "Time spent waiting for clientMutex.");
+    os << "chat_lock_wait_seconds_total{lock=\"client\"} " << (double)mt.lockWaitNs.value() / 1e9 << "\n";
+    return os.str();
+}
+
+static bool sendAll(SOCKET s, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = send(s, data.data() + sent, (int)(data.size() - sent), 0);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// 一次只服务一个抓取请求：读到请求头结束（最多等 2 秒），回复后关闭连接
+static void serveOne(SOCKET s) {
+    std::string req;
+    char buf[1024];
+    while (req.find("\r\n\r\n") == std::string::npos && req.size() < 8192) {
+        fd_set rs;
+        FD_ZERO(&rs);
+        FD_SET(s, &rs);
+        timeval tv{2, 0};
+        if (select((int)s + 1, &rs, nullptr, nullptr, &tv) <= 0) return;
+        int n = recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        req.append(buf, (size_t)n);
+    }
+    std::string body;
+    std::string status = "200 OK";
+    if (req.compare(0, 13, "GET /metrics ") == 0 || req.compare(0, 6, "GET / ") == 0) {
+        body = renderMetrics();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+    std::string resp = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                       std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    sendAll(s, resp);
+}
+
+static void metricsLoop(SOCKET listener) {
+    while (true) {
+        SOCKET s = accept(listener, nullptr, nullptr);
+        if (s == INVALID_SOCKET) continue;
+        serveOne(s);
+        closeSocket(s);
+    }
+}
+
+bool startMetricsServer(unsigned short port) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return false;
+#ifndef _WIN32
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+#endif
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   // 只对本机开放，由本机的采集端转发
+    addr.sin_port = htons(port);
+    if (bind(s, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(s, 16) == SOCKET_ERROR) {
+        closeSocket(s);
+        return false;
+    }
+    std::thread(metricsLoop, s).detach();
+    return true;
+}
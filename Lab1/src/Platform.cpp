@@ -0,0 +1,198 @@
+#include "../include/Platform.h"
+#include <fcntl.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <csignal>
+#include <cstring>
+#include <sys/un.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+bool netStartup() {
+#ifdef _WIN32
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#else
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
+}
+
+void netCleanup() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void closeSocket(SOCKET s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+void setNonBlocking(SOCKET s) {
+#ifdef _WIN32
+    u_long mode = 1;
+    ioctlsocket(s, FIONBIO, &mode);
+#else
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+void setNoDelay(SOCKET s) {
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+}
+
+void setSendLowWater(SOCKET s, int bytes) {
+#ifdef TCP_NOTSENT_LOWAT
+    setsockopt(s, IPPROTO_TCP, TCP_NOTSENT_LOWAT, (const char*)&bytes, sizeof(bytes));
+#else
+    (void)s;
+    (void)bytes;
+#endif
+}
+
+int socketError() {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+bool socketWouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+SOCKET connectTcp(unsigned short port, int rcvBuf) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    if (rcvBuf > 0) setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvBuf, sizeof(rcvBuf));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (connect(s, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        closeSocket(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+#ifndef _WIN32
+static bool makeUnixAddr(const std::string& path, sockaddr_un& addr) {
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+#endif
+
+SOCKET listenUnix(const std::string& path, int backlog) {
+#ifdef _WIN32
+    (void)path;
+    (void)backlog;
+    return INVALID_SOCKET;
+#else
+    sockaddr_un addr;
+    if (!makeUnixAddr(path, addr)) return INVALID_SOCKET;
+    SOCKET s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    unlink(path.c_str());
+    if (bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, backlog) != 0) {
+        close(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+#endif
+}
+
+SOCKET connectUnix(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return INVALID_SOCKET;
+#else
+    sockaddr_un addr;
+    if (!makeUnixAddr(path, addr)) return INVALID_SOCKET;
+    SOCKET s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    if (connect(s, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+#endif
+}
+
+int openFileRead(const std::string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+void closeFile(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+bool seekFile(FILE* f, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(f, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+long readFileAt(int fd, char* buf, size_t len, uint64_t offset) {
+#ifdef _WIN32
+    if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0) return -1;
+    return (long)_read(fd, buf, (unsigned)len);
+#else
+    return (long)pread(fd, buf, len, (off_t)offset);
+#endif
+}
+
+bool sendFileSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+long sendFileAt(SOCKET s, int fd, uint64_t offset, size_t len) {
+#ifdef __linux__
+    off_t off = (off_t)offset;
+    return (long)sendfile(s, fd, &off, len);
+#else
+    (void)s;
+    (void)fd;
+    (void)offset;
+    (void)len;
+    return -1;
+#endif
+}
+
+void setupConsole() {
+#ifdef _WIN32
+    SetConsoleOutputCP(65001);
+    SetConsoleCP(65001);
+#endif
+}
@@ -0,0 +1,284 @@
+#include "../include/Presence.h"
+#include "../include/Cluster.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// gossip 消息：1 字节标志 + 4 字节节点数 n + n 组（纪元、发送方已有版本、本条覆盖的 (from, to]）各 8 字节
+// + 若干条记录（4 字节来源节点、8 字节版本号、8 字节连接、1 字节是否在线、4 字节名字长度、名字）
+static const uint8_t GOSSIP_RESYNC = 1;                 // 收到的增量有缺口，请对方从确认过的版本重发
+static const size_t GOSSIP_MAX_BYTES = 512 * 1024;      // 一条 gossip 的记录部分上限，剩下的下一轮再发
+static const int RELAY_DELAY_TICKS = 3;                 // 转发别的来源的记录前等几轮：直连链路正常时对端早已确认，不重复发
+
+struct PresenceEntry {
+    ConnId conn = INVALID_CONN;     // 在来源节点上的本地连接
+    bool online = false;
+    uint64_t seq = 0;
+};
+
+// 一个来源节点的记录
+struct OriginLog {
+    uint64_t epoch = 0;                                     // 来源节点本次运行的纪元，0 表示还没听说过
+    uint64_t version = 0;                                   // 已完整收到的最大版本号（版本向量的一项）
+    std::unordered_map<std::string, PresenceEntry> entries;
+    std::map<uint64_t, std::string> bySeq;                  // 版本号 -> 用户名，每个用户只留最新一条
+};
+
+static std::mutex presenceLock;
+static std::vector<OriginLog> origins;
+static std::vector<std::vector<uint64_t>> peerAck;      // [对端][来源]：对端报来的已有版本
+static std::vector<std::vector<uint64_t>> peerSent;     // [对端][来源]：已经发给对端的版本
+static std::vector<uint8_t> resyncWanted;               // [对端]：下一条 gossip 请对端重发
+static std::vector<std::vector<uint64_t>> haveSent;     // [对端]：上次发给对端的版本向量
+static std::vector<std::vector<uint64_t>> horizons;     // 最近几轮开始时的版本向量，horizons[0] 最旧
+static std::atomic<int> presenceSelf{-1};
+
+static std::atomic<uint64_t> localChanges{0};
+static std::atomic<uint64_t> gossipsOut{0};
+static std::atomic<uint64_t> gossipBytesOut{0};
+static std::atomic<uint64_t> entriesOut{0};
+static std::atomic<uint64_t> gossipsIn{0};
+static std::atomic<uint64_t> entriesApplied{0};
+static std::atomic<uint64_t> resyncs{0};
+
+static void putU32(std::string& out, uint32_t v) {
+    char b[4] = {(char)(v >> 24), (char)(v >> 16), (char)(v >> 8), (char)v};
+    out.append(b, 4);
+}
+
+static void putU64(std::string& out, uint64_t v) {
+    putU32(out, (uint32_t)(v >> 32));
+    putU32(out, (uint32_t)v);
+}
+
+static uint32_t getU32(const char* p) {
+    const unsigned char* u = (const unsigned char*)p;
+    return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | (uint32_t)u[3];
+}
+
+static uint64_t getU64(const char* p) {
+    return ((uint64_t)getU32(p) << 32) | getU32(p + 4);
+}
+
+// 写入一条记录（调用方持有 presenceLock）：旧版本从 bySeq 中摘掉
+static void storeEntry(OriginLog& log, const std::string& name, ConnId conn, bool online, uint64_t seq) {
+    PresenceEntry& e = log.entries[name];
+    if (e.seq != 0) log.bySeq.erase(e.seq);
+    e.conn = conn;
+    e.online = online;
+    e.seq = seq;
+    log.bySeq[seq] = name;
+}
+
+void startPresence(int nodes, int self) {
+    std::lock_guard<std::mutex> lk(presenceLock);
+    origins.assign(nodes, OriginLog());
+    peerAck.assign(nodes, std::vector<uint64_t>(nodes, 0));
+    peerSent.assign(nodes, std::vector<uint64_t>(nodes, 0));
+    haveSent.assign(nodes, std::vector<uint64_t>(nodes, 0));
+    resyncWanted.assign(nodes, 0);
+    horizons.assign(RELAY_DELAY_TICKS, std::vector<uint64_t>(nodes, 0));
+    origins[self].epoch = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    presenceSelf = self;
+}
+
+bool presenceEnabled() {
+    return presenceSelf >= 0;
+}
+
+void presenceLocal(const std::string& name, ConnId conn, bool online) {
+    if (presenceSelf < 0) return;
+    std::lock_guard<std::mutex> lk(presenceLock);
+    OriginLog& log = origins[presenceSelf];
+    storeEntry(log, name, conn, online, ++log.version);
+    localChanges.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool presenceFind(const std::string& name, ConnId& conn) {
+    conn = INVALID_CONN;
+    if (presenceSelf < 0) return false;
+    std::lock_guard<std::mutex> lk(presenceLock);
+    bool known = false;
+    // 先看本节点，同名用户同时连在多个节点上时优先本地连接
+    for (int i = 0; i < (int)origins.size(); i++) {
+        int o = (presenceSelf + i) % (int)origins.size();
+        auto it = origins[o].entries.find(name);
+        if (it == origins[o].entries.end()) continue;
+        known = true;
+        if (it->second.online) {
+            conn = o == presenceSelf ? it->second.conn : makeRemoteConn(o, it->second.conn);
+            return true;
+        }
+    }
+    return known;
+}
+
+void presenceTick() {
+    std::lock_guard<std::mutex> lk(presenceLock);
+    if (horizons.empty()) return;
+    horizons.erase(horizons.begin());
+    std::vector<uint64_t> now(origins.size());
+    for (size_t o = 0; o < origins.size(); o++) now[o] = origins[o].version;
+    horizons.push_back(now);
+}
+
+bool buildGossip(int peer, std::string& out, bool force) {
+    out.clear();
+    std::lock_guard<std::mutex> lk(presenceLock);
+    int n = (int)origins.size();
+    uint8_t flags = resyncWanted[peer] ? GOSSIP_RESYNC : 0;
+    bool changed = force || flags != 0 || haveSent[peer].size() != (size_t)n;
+    for (int o = 0; o < n && !changed; o++) changed = haveSent[peer][o] != origins[o].version;
+
+    out.push_back((char)flags);
+    putU32(out, (uint32_t)n);
+    size_t headerAt = out.size();
+    out.resize(headerAt + (size_t)n * 32);
+    std::string entries;
+    uint32_t count = 0;
+    for (int o = 0; o < n; o++) {
+        OriginLog& log = origins[o];
+        uint64_t from = std::max(peerSent[peer][o], peerAck[peer][o]);
+        uint64_t to = from;
+        // 本节点的记录立即发；别的来源的记录只转发几轮前就有、对端至今没确认的（两者之间的链路可能断了）
+        uint64_t limit = o == presenceSelf ? log.version : std::min(log.version, horizons[0][o]);
+        // 对端自己的记录不用发回去；没听说过的来源也没什么可发
+        if (o != peer && log.epoch != 0 && from < limit) {
+            auto it = log.bySeq.upper_bound(from);
+            for (; it != log.bySeq.end() && it->first <= limit && entries.size() < GOSSIP_MAX_BYTES; ++it) {
+                const PresenceEntry& e = log.entries[it->second];
+                putU32(entries, (uint32_t)o);
+                putU64(entries, e.seq);
+                putU64(entries, e.conn);
+                entries.push_back(e.online ? 1 : 0);
+                putU32(entries, (uint32_t)it->second.size());
+                entries += it->second;
+                to = it->first;
+                count++;
+            }
+            if (it == log.bySeq.end() || it->first > limit) to = limit;
+            peerSent[peer][o] = to;
+        }
+        if (to > from) changed = true;
+        std::string slot;
+        putU64(slot, log.epoch);
+        putU64(slot, log.version);
+        putU64(slot, from);
+        putU64(slot, to);
+        out.replace(headerAt + (size_t)o * 32, 32, slot);
+    }
+    if (!changed) {
+        out.clear();
+        return false;
+    }
+    out += entries;
+    resyncWanted[peer] = 0;
+    haveSent[peer].resize(n);
+    for (int o = 0; o < n; o++) haveSent[peer][o] = origins[o].version;
+    gossipsOut.fetch_add(1, std::memory_order_relaxed);
+    gossipBytesOut.fetch_add(out.size(), std::memory_order_relaxed);
+    entriesOut.fetch_add(count, std::memory_order_relaxed);
+    return true;
+}
+
+void applyGossip(int from, const char* data, size_t len) {
+    if (len < 5) return;
+    uint8_t flags = (uint8_t)data[0];
+    size_t n = getU32(data + 1);
+    std::lock_guard<std::mutex> lk(presenceLock);
+    if (n != origins.size() || len < 5 + n * 32) return;
+    gossipsIn.fetch_add(1, std::memory_order_relaxed);
+    const char* header = data + 5;
+    std::vector<uint8_t> accept(n, 0);
+    for (size_t o = 0; o < n; o++) {
+        const char* h = header + o * 32;
+        uint64_t epoch = getU64(h);
+        uint64_t have = getU64(h + 8);
+        if (epoch == 0 || (int)o == presenceSelf) {
+            // 本节点的纪元只有自己能改；对端报来的已有版本仍然记下
+            if ((int)o == presenceSelf && epoch == origins[o].epoch) peerAck[from][o] = std::max(peerAck[from][o], have);
+            continue;
+        }
+        OriginLog& log = origins[o];
+        if (epoch < log.epoch) continue;   // 来源节点上一次运行的记录
+        if (epoch > log.epoch) {
+            // 来源节点重启过：清掉旧记录，各对端的进度从头算
+            log.entries.clear();
+            log.bySeq.clear();
+            log.version = 0;
+            log.epoch = epoch;
+            for (size_t p = 0; p < n; p++) {
+                peerAck[p][o] = 0;
+                peerSent[p][o] = 0;
+            }
+        }
+        accept[o] = 1;
+        peerAck[from][o] = std::max(peerAck[from][o], have);
+    }
+    if (flags & GOSSIP_RESYNC) {
+        // 对端发现缺口：从它确认过的版本重发
+        peerSent[from] = peerAck[from];
+        resyncs.fetch_add(1, std::memory_order_relaxed);
+    }
+    size_t pos = 5 + n * 32;
+    while (pos + 25 <= len) {
+        uint32_t o = getU32(data + pos);
+        uint64_t seq = getU64(data + pos + 4);
+        ConnId conn = getU64(data + pos + 12);
+        bool online = data[pos + 20] != 0;
+        size_t nameLen = getU32(data + pos + 21);
+        if (pos + 25 + nameLen > len) break;
+        std::string name(data + pos + 25, nameLen);
+        pos += 25 + nameLen;
+        if (o >= n || !accept[o]) continue;
+        OriginLog& log = origins[o];
+        auto it = log.entries.find(name);
+        if (it != log.entries.end() && it->second.seq >= seq) continue;
+        storeEntry(log, name, conn, online, seq);
+        entriesApplied.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 覆盖区间与已有的版本相接才推进版本向量，否则说明中间丢了一段，请对端重发
+    for (size_t o = 0; o < n; o++) {
+        if (!accept[o]) continue;
+        const char* h = header + o * 32;
+        uint64_t lo = getU64(h + 16);
+        uint64_t hi = getU64(h + 24);
+        if (hi <= lo) continue;
+        if (lo <= origins[o].version) {
+            origins[o].version = std::max(origins[o].version, hi);
+        } else {
+            resyncWanted[from] = 1;
+        }
+    }
+}
+
+void presenceLinkUp(int peer) {
+    std::lock_guard<std::mutex> lk(presenceLock);
+    if (peer < (int)peerSent.size()) {
+        peerSent[peer] = peerAck[peer];
+        haveSent[peer].clear();   // 立即发一次版本向量
+    }
+}
+
+void describePresence(std::ostream& os) {
+    if (presenceSelf < 0) return;
+    size_t online = 0, total = 0;
+    std::string vv;
+    {
+        std::lock_guard<std::mutex> lk(presenceLock);
+        for (const OriginLog& log : origins) {
+            total += log.entries.size();
+            for (const auto& kv : log.entries) online += kv.second.online ? 1 : 0;
+            vv += (vv.empty() ? "" : ",") + std::to_string(log.version);
+        }
+    }
+    os << "presence: " << online << " online / " << total << " known, version vector [" << vv << "]\n"
+       << "  local changes " << localChanges.load() << ", gossip out " << gossipsOut.load() << " msgs / "
+       << entriesOut.load() << " entries / " << gossipBytesOut.load() << " B, in " << gossipsIn.load()
+       << " msgs / " << entriesApplied.load() << " entries applied, resyncs " << resyncs.load() << "\n";
+}
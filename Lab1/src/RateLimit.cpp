@@ -0,0 +1,124 @@
+#include "../include/RateLimit.h"
+#include <atomic>
+
+// 会话桶的个数：会话键哈希到固定的槽位，不随会话增删分配内存。
+// 两个会话落在同一槽位时共用限额（只会更严格），槽位足够多时很少发生
+static const size_t SESSION_SLOTS = 16384;
+// 用户桶的个数：用户编号连续分配，直接取模；超过这么多用户后才会有两人共用一个桶
+static const size_t USER_SLOTS = 65536;
+
+static RateLimitConfig config;
+static int64_t userInterval = 0;      // 每个令牌的间隔（微秒）
+static int64_t userCapacity = 0;      // 间隔 × 突发条数
+static int64_t sessionInterval = 0;
+static int64_t sessionCapacity = 0;
+static std::atomic<int64_t> sessionTat[SESSION_SLOTS];
+static std::atomic<int64_t> userTat[USER_SLOTS];
+
+bool rateLimitActive = false;
+
+static int64_t intervalOf(double rate) {
+    if (rate <= 0) return 0;
+    int64_t us = (int64_t)(1000000.0 / rate);
+    return us > 0 ? us : 1;
+}
+
+void configureRateLimit(const RateLimitConfig& cfg) {
+    config = cfg;
+    if (config.userBurst < 1) config.userBurst = 1;
+    if (config.sessionBurst < 1) config.sessionBurst = 1;
+    userInterval = intervalOf(config.userRate);
+    userCapacity = userInterval * config.userBurst;
+    sessionInterval = intervalOf(config.sessionRate);
+    sessionCapacity = sessionInterval * config.sessionBurst;
+    rateLimitActive = userInterval > 0 || sessionInterval > 0;
+}
+
+const RateLimitConfig& rateLimitConfig() {
+    return config;
+}
+
+// GCRA：放行后桶的新 tat 写入 next，返回还需等待的微秒数（0 表示放行）
+static inline int64_t gcra(int64_t tat, int64_t now, int64_t interval, int64_t capacity, int64_t& next) {
+    next = (tat > now ? tat : now) + interval;
+    int64_t over = next - now - capacity;
+    return over > 0 ? over : 0;
+}
+
+// 最高位区分两类会话键
+static const uint64_t PRIVATE_KEY_BIT = 1ULL << 63;
+
+uint64_t groupRateKey(const std::string& group) {
+    uint64_t h = 1469598103934665603ULL;   // FNV-1a
+    for (unsigned char ch : group) {
+        h ^= ch;
+        h *= 1099511628211ULL;
+    }
+    return (h & ~PRIVATE_KEY_BIT) | 1;
+}
+
+uint64_t privateRateKey(uint64_t pair) {
+    // 编号对是两个连续分配的小整数，先打散
+    pair ^= pair >> 33;
+    pair *= 0xff51afd7ed558ccdULL;
+    pair ^= pair >> 33;
+    return pair | PRIVATE_KEY_BIT;
+}
+
+static size_t slotOf(uint64_t key) {
+    return (size_t)(key ^ (key >> 32)) & (SESSION_SLOTS - 1);
+}
+
+int64_t rateLimitCheck(TokenBucket& conn, uint32_t user, uint64_t session, int64_t nowUs, bool& bySession, int cost) {
+    bySession = false;
+    std::atomic<int64_t>* userSlot = user != RATE_ANON ? &userTat[user & (USER_SLOTS - 1)] : nullptr;
+    int64_t userNeed = userInterval * cost;
+    int64_t userNext = conn.tat;
+    if (userInterval > 0) {
+        // 超过桶容量的一帧要等桶满才放行，之后按全部条数补足间隔，长期速率不变
+        int64_t tat = userSlot != nullptr ? userSlot->load(std::memory_order_relaxed) : conn.tat;
+        int64_t wait = gcra(tat, nowUs, userNeed, userNeed > userCapacity ? userNeed : userCapacity, userNext);
+        if (wait > 0) return wait;
+    }
+    if (sessionInterval > 0 && session != 0) {
+        int64_t need = sessionInterval * cost;
+        int64_t capacity = need > sessionCapacity ? need : sessionCapacity;
+        std::atomic<int64_t>& slot = sessionTat[slotOf(session)];
+        int64_t cur = slot.load(std::memory_order_relaxed);
+        int64_t next;
+        while (true) {
+            int64_t wait = gcra(cur, nowUs, need, capacity, next);
+            if (wait > 0) {
+                // 会话限额没过，用户的令牌不扣
+                bySession = true;
+                return wait;
+            }
+            if (slot.compare_exchange_weak(cur, next, std::memory_order_relaxed)) break;
+        }
+    }
+    if (userSlot == nullptr) {
+        conn.tat = userNext;
+    } else if (userInterval > 0) {
+        // 同一用户的其它连接可能同时扣过令牌：在最新的 tat 上累加，不再重新检查（至多多放行并发的那几条）
+        int64_t cur = userSlot->load(std::memory_order_relaxed);
+        while (!userSlot->compare_exchange_weak(cur, (cur > nowUs ? cur : nowUs) + userNeed, std::memory_order_relaxed)) {
+        }
+    }
+    return 0;
+}
+
+bool parseThrottleAction(const std::string& name, ThrottleAction& out) {
+    if (name == "warn") out = THROTTLE_WARN;
+    else if (name == "drop") out = THROTTLE_DROP;
+    else if (name == "delay") out = THROTTLE_DELAY;
+    else return false;
+    return true;
+}
+
+const char* throttleActionName(ThrottleAction action) {
+    switch (action) {
+    case THROTTLE_DROP: return "drop";
+    case THROTTLE_DELAY: return "delay";
+    default: return "warn";
+    }
+}
@@ -0,0 +1,969 @@
+#include "../include/Reactor.h"
+#include "../include/Cluster.h"
+#include "../include/IoBackend.h"
+#include "../include/Metrics.h"
+#include "../include/ObjectPool.h"
+#include "../include/Server.h"
+#include "../include/ShmRing.h"
+#include "../include/Trace.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+static Reactor* reactors[MAX_REACTORS];
+static int reactorCount = 0;
+static thread_local Reactor* currentReactor = nullptr;
+static std::atomic<SOCKET> sharedListener{INVALID_SOCKET};   // 不支持 SO_REUSEPORT 时的共享监听
+static std::vector<SOCKET> listenerSockets;                   // 启动时创建或接管的全部监听套接字
+
+// Unix 域套接字监听（--unix 的普通连接与 --shm 的控制连接）
+struct UnixListener {
+    std::atomic<SOCKET> sock{INVALID_SOCKET};
+    std::string path;
+#ifndef _WIN32
+    ino_t inode = 0;            // 绑定时套接字文件的 inode，关闭时只删除自己创建的文件
+#endif
+};
+static UnixListener unixListener;
+static UnixListener shmListener;
+
+// 共享内存连接每轮最多从一个环里读这么多字节，避免一个灌消息的客户端饿死其它连接
+static const size_t SHM_READ_BUDGET = 256 * 1024;
+// 处理池积压时，暂缓的消息隔这么久再尝试提交
+static const int64_t POOL_RETRY_US = 1000;
+// 每个连接最多缓存这么多个目标的限流会话键，超过就整体清空（只影响查私聊表的次数）
+static const size_t MAX_RATE_KEYS = 64;
+
+// ========== Reactor ==========
+
+Reactor::Reactor(int index) : idx(index) {}
+
+Reactor::~Reactor() {
+    stop();
+    join();
+    for (auto& [id, c] : conns) closeSocket(c.sock);
+    if (listenSock != INVALID_SOCKET) closeSocket(listenSock);
+}
+
+bool Reactor::init(const std::string& ioBackend) {
+    backend.reset(createIoBackend(ioBackend, *this));
+    return backend != nullptr;
+}
+
+bool Reactor::listenOn(SOCKET listener) {
+    listenSock = listener;
+    backend->addListener(listener);
+    return true;
+}
+
+void Reactor::start() {
+    running.store(true);
+    worker = std::thread(&Reactor::run, this);
+}
+
+void Reactor::stop() {
+    running.store(false);
+    if (backend) backend->wake();
+}
+
+void Reactor::join() {
+    if (worker.joinable()) worker.join();
+}
+
+const char* Reactor::backendName() const {
+    return backend ? backend->name() : "none";
+}
+
+uint64_t Reactor::syscallCount() const {
+    return backend ? backend->syscalls.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t Reactor::writeCount() const {
+    return backend ? backend->writes.load(std::memory_order_relaxed) : 0;
+}
+
+int Reactor::wakeHandle() const {
+    return backend ? backend->wakeHandle() : -1;
+}
+
+void Reactor::post(ReactorTask task) {
+    mailbox.push(std::move(task));
+    mailboxPosted.fetch_add(1, std::memory_order_relaxed);
+    // 合并唤醒：只有邮箱从“已处理”变为“有新任务”时才真正写唤醒句柄
+    if (!wakePending.exchange(true, std::memory_order_acq_rel)) {
+        backend->wake();
+    }
+}
+
+void Reactor::run() {
+    currentReactor = this;
+    while (running.load(std::memory_order_acquire)) {
+        // 先给空闲的下载连接排下一块，再决定 poll 等多久（排了就不等）
+        if (!fileConns.empty()) pumpFiles();
+        int64_t timeoutUs = pollTimeoutUs();
+        if (!throttled.empty()) {
+            int64_t untilResume = nextResumeUs - rateNowUs();
+            timeoutUs = std::max<int64_t>(0, std::min(timeoutUs, untilResume));
+        }
+        // 共享内存客户端只在服务器登记了等待时才写 eventfd，所以阻塞前先登记；环里已有数据就不阻塞
+        if (!shmConns.empty() && timeoutUs > 0 && !armShm()) timeoutUs = 0;
+        backend->poll(timeoutUs);
+        drainMailbox();
+        if (!shmConns.empty()) pollShm();
+        if (!throttled.empty()) resumeThrottled();
+        if (pollTimeoutUs() == 0) flushOutput();
+        closeMarked();
+    }
+    for (auto& [id, c] : conns) closeSocket(c.sock);
+    conns.clear();
+}
+
+void Reactor::onAccept(SOCKET sock, std::shared_ptr<ShmLink> shm) {
+    if (!backend->canWatch(sock)) {
+        //连接数超过了后端的上限：直接关闭，不进入连接表
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) {
+            std::cout << "[WARN] " << backend->name() << " backend cannot watch socket " << sock
+                      << ", refusing connections beyond this limit (use --io epoll for more clients)" << std::endl;
+        } else if (serverConfig.verbose) {
+            std::cout << "[SYS] Reactor " << idx << " refused socket " << sock << std::endl;
+        }
+        closeSocket(sock);
+        return;
+    }
+    ConnId id = (nextSeq++ << 8) | (ConnId)idx;
+    Connection& c = conns[id];
+    c.id = id;
+    c.sock = sock;
+    if (shm) {
+        c.shm = std::move(shm);
+        shmConns.push_back(id);
+    }
+    if (getHandlerPool() != nullptr) {
+        c.order = std::make_shared<ConnOrder>();
+        c.order->lastKey = "#" + std::to_string(id);   // 跟随连接的任务默认所在的 strand
+    }
+    backend->addConn(c);
+    acceptedCount.fetch_add(1, std::memory_order_relaxed);
+    metrics().connOpened.add();
+    if (serverConfig.verbose) {
+        std::cout << "[SYS] Reactor " << idx << " accepted connection " << id << std::endl;
+    }
+}
+
+Connection* Reactor::findConn(ConnId conn) {
+    auto it = conns.find(conn);
+    return it == conns.end() ? nullptr : &it->second;
+}
+
+void Reactor::collectConnStats(std::vector<ConnStat>& out) const {
+    for (const auto& [id, c] : conns) {
+        ConnStat st;
+        st.id = id;
+        st.msgsIn = c.msgsIn;
+        st.bytesIn = c.bytesIn;
+        st.queuedBytes = c.lanes.bytes() + c.pending.size() + c.inflight.size();
+        st.queuedFrames = c.lanes.size();
+        out.push_back(st);
+    }
+}
+
+void Reactor::onData(Connection& c, const char* data, size_t len) {
+    /*recv() 取出的是 TCP 字节流，可能被拆包/粘包，由 FrameDecoder 按长度头重新切分出完整的消息。*/
+    int64_t recvUs = traceNowUs();   // 收到本批数据的时刻（被跟踪的消息以此为服务器收到时刻）
+    metrics().bytesIn.add(len);
+    c.decoder.feed(data, len);
+    if (c.held != nullptr) {
+        // 限流或处理池积压而暂缓中：数据先留在 decoder 里；积压超过上限说明客户端在持续灌消息，断开
+        if (c.decoder.buffered() > MAX_PENDING_BYTES) {
+            std::cout << "[WARN] Connection " << c.id << " keeps flooding while paused, closing" << std::endl;
+            metrics().floodDisconnects.add();
+            markClosing(c);
+        }
+        return;
+    }
+    processInput(c, recvUs);
+}
+
+void Reactor::processInput(Connection& c, int64_t recvUs) {
+    const char* payload;
+    size_t payloadLen;
+    while (!c.closing && c.held == nullptr && c.decoder.next(payload, payloadLen)) {
+        framesIn.fetch_add(1, std::memory_order_relaxed);
+        // 解析结果放进复用的 Message（交给处理池时取自对象池），稳定负载下不分配内存
+        Message* m = c.order ? ObjectPool<Message>::acquire() : &scratch;
+        parseMessageInto(payload, payloadLen, *m);
+        metrics().framesIn[messageTypeOf(m->type.data(), m->type.size())].add();
+        c.msgsIn++;
+        c.bytesIn += FRAME_HEADER_SIZE + payloadLen;
+        if (!m->trace.empty()) {
+            int64_t stamps[TRACE_STAMPS];
+            m->recvUs = recvUs;
+            m->parseUs = traceNowUs();
+            if (parseTraceStamps(m->trace, stamps) > TRACE_SEND) {
+                serverTraceStats().record(STAGE_NET_IN, recvUs - stamps[TRACE_SEND]);
+            }
+            serverTraceStats().record(STAGE_PARSE, m->parseUs - recvUs);
+        }
+        // 限流在加锁和扇出之前：被拦下的消息不会进入处理池
+        if (rateLimitEnabled() && throttle(c, m)) continue;
+        dispatch(c, m);
+    }
+    if (c.decoder.error()) {
+        std::cout << "[WARN] Oversized frame from connection " << c.id << ", closing" << std::endl;
+        markClosing(c);
+    }
+}
+
+void Reactor::dispatch(Connection& c, Message* m) {
+    if (serverConfig.verbose && m->type != FILE_DATA_TYPE) {
+        std::cout << "[SYS] Parsed - Type:[" << m->type << "] Sender:[" << m->sender << "] Accepter:[" << m->accepter << "] Content:[" << m->content << "]" << std::endl;
+    }
+    bool isExit = (m->type == "EXIT");
+    if (c.order) {
+        // 交给处理池：本线程只负责收发，热点会话不会拖慢其它连接的 I/O
+        ConnId id = c.id;
+        Job job = [m, id]() {
+            handleMessage(*m, id);
+            ObjectPool<Message>::release(m);
+        };
+        if (!getHandlerPool()->trySubmit(c.order, messageOrderKey(*m), job)) {
+            // 该连接或目标会话积压过多：暂缓这条消息，连接后面的帧留在 decoder 里，积压回落后再提交
+            metrics().poolPaused.add();
+            hold(c, m, rateNowUs() + POOL_RETRY_US, true);
+            return;
+        }
+    } else {
+        handleMessage(*m, c.id);
+        if (m != &scratch) ObjectPool<Message>::release(m);   // 限流暂缓过的消息取自对象池
+    }
+    if (isExit) {
+        markClosing(c);  // onExit 由 handleMessage 处理（可能在处理池中稍后执行）
+    }
+}
+
+bool Reactor::throttle(Connection& c, Message* m) {
+    // EXIT 总是放行，文件块按块计数会把上传限成每秒几十块，也不计；会话限额只计聊天消息
+    if (m->type == "EXIT" || m->type == FILE_DATA_TYPE) return false;
+    bool isBatch = m->type == BATCH_TYPE;
+    uint64_t session = 0;
+    if (m->type == "MSG" || isBatch) {
+        // 会话键要查私聊表（加锁），按目标缓存在连接里
+        auto it = c.rateKeys.find(m->accepter);
+        if (it == c.rateKeys.end()) {
+            if (c.rateKeys.size() >= MAX_RATE_KEYS) c.rateKeys.clear();
+            it = c.rateKeys.emplace(m->accepter, rateSessionKey(c.rateUser, m->accepter)).first;
+        }
+        session = it->second;
+    }
+    // 批量帧按其中的消息条数计，不能借批量绕过限额
+    int cost = 1;
+    if (isBatch) {
+        thread_local std::vector<std::pair<size_t, size_t>> items;
+        int64_t ts;
+        if (parseBatch(m->content, ts, items)) cost = (int)items.size();
+    }
+    int64_t now = rateNowUs();
+    bool bySession = false;
+    int64_t wait = rateLimitCheck(c.bucket, c.rateUser, session, now, bySession, cost);
+    if (wait == 0) return false;
+
+    (bySession ? metrics().throttledSession : metrics().throttledUser).add();
+    const RateLimitConfig& cfg = rateLimitConfig();
+    if (cfg.action == THROTTLE_DELAY) {
+        // 暂缓这条消息，连接后面的帧留在 decoder 里，保持先后顺序
+        if (m == &scratch) {
+            m = ObjectPool<Message>::acquire();
+            *m = scratch;
+        }
+        metrics().throttleDelayed.add();
+        hold(c, m, now + wait, false);
+        return true;
+    }
+    metrics().throttleDropped.add();
+    if (cfg.action == THROTTLE_WARN && now - c.warnedAtUs >= 1000000) {
+        c.warnedAtUs = now;
+        std::string reason = bySession ? "会话 " + m->accepter + " 消息过多" : "你发送消息过快";
+        Message warn{"SYS", "Server", m->sender, reason + "，消息已被丢弃，请稍后再发"};
+        sendLocal(c.id, makeFrame(buildMessage(warn)));
+    }
+    if (m != &scratch) ObjectPool<Message>::release(m);
+    return true;
+}
+
+void Reactor::hold(Connection& c, Message* m, int64_t resumeAtUs, bool byPool) {
+    c.held = m;
+    c.heldByPool = byPool;
+    c.resumeAtUs = resumeAtUs;
+    if (throttled.empty() || resumeAtUs < nextResumeUs) nextResumeUs = resumeAtUs;
+    throttled.push_back(c.id);
+}
+
+void Reactor::resumeThrottled() {
+    int64_t now = rateNowUs();
+    if (now < nextResumeUs) return;
+    std::vector<ConnId> waiting;
+    waiting.swap(throttled);
+    for (ConnId id : waiting) {
+        Connection* c = findConn(id);
+        if (c == nullptr || c->held == nullptr) continue;
+        if (c->resumeAtUs <= now) {
+            // 到期后重新检查（同一会话的其他人可能已用掉令牌），放行后接着处理积压的帧；
+            // 因处理池积压暂缓的消息已经计过限额，直接再提交一次
+            Message* m = c->held;
+            c->held = nullptr;
+            if (c->heldByPool || !throttle(*c, m)) {
+                dispatch(*c, m);
+                processInput(*c, traceNowUs());
+            }
+            if (c->held != nullptr) continue;   // 又被暂缓，throttle 已重新登记
+        } else {
+            if (throttled.empty() || c->resumeAtUs < nextResumeUs) nextResumeUs = c->resumeAtUs;
+            throttled.push_back(id);
+        }
+    }
+}
+
+void Reactor::sendLocal(ConnId conn, const FramePtr& frame) {
+    Connection* c = findConn(conn);
+    if (c == nullptr || c->closing) return;
+    if (c->eventsOff && frame.type() == MT_EVENTS) return;
+    if (frame.type() == MT_BATCH && !c->batchOk) {
+        expandBatch(conn, frame);
+        return;
+    }
+    if (c->pending.size() + c->inflight.size() + c->lanes.bytes() + frame->size() > MAX_PENDING_BYTES) {
+        std::cout << "[WARN] Connection " << c->id << " is too slow, closing" << std::endl;
+        metrics().slowConsumers.add();
+        markClosing(*c);
+        return;
+    }
+    framesOut.fetch_add(1, std::memory_order_relaxed);
+    metrics().framesOut[frame.type()].add();
+    // 只排队不写：本轮所有发给该连接的帧在 flushOutput 中合并成一次写
+    c->lanes.push(frame);
+    metrics().bytesOut.add(frame->size());
+    if (frame.traceUs() != 0) {
+        int64_t now = traceNowUs();
+        serverTraceStats().record(STAGE_FANOUT, now - frame.traceUs());
+        c->tracedAt.push_back(now);
+    }
+    queueFlush(*c);
+}
+
+// 连接没有声明支持批量帧：拆回逐条 MSG 依次入队，与发送者逐条发送时收到的完全一样
+void Reactor::expandBatch(ConnId conn, const FramePtr& frame) {
+    thread_local Message batch;
+    thread_local Message one;
+    thread_local std::vector<std::pair<size_t, size_t>> items;
+    parseMessageInto(frame->data() + FRAME_HEADER_SIZE, frame->size() - FRAME_HEADER_SIZE, batch);
+    if (!parseBatch(batch.content, one.timestamp, items)) return;
+    metrics().batchExpanded.add();
+    one.type = "MSG";
+    one.sender = batch.sender;
+    one.accepter = batch.accepter;
+    one.trace.clear();
+    for (const auto& item : items) {
+        one.content.assign(batch.content, item.first, item.second);
+        sendLocal(conn, makeMessageFrame(one, frame.isPrivate()));
+    }
+}
+
+void Reactor::queueFlush(Connection& c) {
+    if (!c.queued) {
+        c.queued = true;
+        if (toFlush.empty()) corkStart = std::chrono::steady_clock::now();
+        toFlush.push_back(c.id);
+    }
+}
+
+void Reactor::sendFileLocal(ConnId conn, int fd, const std::string& hash, uint64_t offset, uint64_t end) {
+    Connection* c = findConn(conn);
+    if (c == nullptr || c->closing) {
+        closeFile(fd);
+        return;
+    }
+    if (c->files.empty()) {
+        fileConns.push_back(conn);
+        // 文件块会填满内核发送缓冲，之后的聊天帧要在它后面排几 MB；限制未发出的字节数，让插队在内核里也成立
+        if (!c->shm) setSendLowWater(c->sock, FILE_LOW_WATER);
+    }
+    c->files.push(fd, hash, offset, end);
+}
+
+// 文件通道：能零拷贝的后端在 flush 里自己按块写（写满或写够一批后等可写），这里只需在它空闲时排一次 flush；
+// 其它后端在连接完全空闲时读出一块作为普通帧排队，写完后下一轮再读下一块
+void Reactor::pumpFiles() {
+    for (size_t i = 0; i < fileConns.size();) {
+        Connection* c = findConn(fileConns[i]);
+        if (c == nullptr || c->closing || c->files.empty()) {
+            fileConns[i] = fileConns.back();
+            fileConns.pop_back();
+            continue;
+        }
+        i++;
+        if (c->writeBlocked || c->queued) continue;
+        if (backend->sendsFiles() && !c->shm) {
+            queueFlush(*c);
+        } else if (c->lanes.empty() && c->pending.empty() && c->inflight.empty()) {
+            FramePtr f = c->files.readChunk();
+            if (f) sendLocal(c->id, f);
+        }
+    }
+}
+
+// 有帧排队时：不开 cork 立即写；开了 cork 则最多等 corkUs 微秒再写，换取更大的合并批次
+int64_t Reactor::pollTimeoutUs() const {
+    if (toFlush.empty()) return 1000000;
+    if (serverConfig.corkUs <= 0) return 0;
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - corkStart).count();
+    return waited >= serverConfig.corkUs ? 0 : serverConfig.corkUs - waited;
+}
+
+void Reactor::flushOutput() {
+    std::vector<ConnId> batch;
+    batch.swap(toFlush);
+    for (ConnId id : batch) {
+        Connection* c = findConn(id);
+        if (c == nullptr) continue;
+        c->queued = false;
+        if (!c->tracedAt.empty()) {
+            int64_t now = traceNowUs();
+            for (int64_t at : c->tracedAt) serverTraceStats().record(STAGE_FLUSH, now - at);
+            c->tracedAt.clear();
+        }
+        if (c->compress && !c->shm && !c->closing && serverConfig.compressMinBytes > 0 &&
+            c->lanes.bulkBytes() >= (size_t)serverConfig.compressMinBytes) compressBulk(*c);
+        // 即将关闭的连接也写出，保证 EXIT 等回复能送达
+        if (c->shm) flushShm(*c);
+        else backend->flush(*c);
+    }
+}
+
+// 压缩只用在积压上：少量帧立即写出，不值得压缩；写不动（慢消费者、刚上线的一大批历史、扇出突发）时
+// 各会话流里的帧越攒越多，每到阈值就按轮转顺序取出一批（原文不超过 ZIP_MAX_INPUT）压成一帧 ZIP。
+// ZIP 帧放进控制通道：它在剩下的聊天帧之前写出，同一会话内的先后不变；文件块和单个超大的帧不压缩。
+void Reactor::compressBulk(Connection& c) {
+    if (!c.zip) c.zip.reset(new ZipEncoder(chatDictionary()));
+    size_t minBytes = (size_t)serverConfig.compressMinBytes;
+    std::string raw;
+    std::string payload;
+    while (c.lanes.bulkBytes() >= minBytes) {
+        raw.clear();
+        int frames = 0;
+        while (FramePtr f = c.lanes.popBulk()) {
+            if ((f.type() != MT_MSG && f.type() != MT_BATCH) || raw.size() + f->size() > ZIP_MAX_INPUT) {
+                c.lanes.unpop(std::move(f));
+                break;
+            }
+            raw += *f;
+            frames++;
+        }
+        if (frames == 0) return;
+        auto start = std::chrono::steady_clock::now();
+        payload.assign(ZIP_TYPE).append(1, '|');
+        c.zip->compress(raw.data(), raw.size(), payload);
+        FramePtr zipped = makeFrame(payload);
+        metrics().compressNs.add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start).count());
+        metrics().compressFrames.add((uint64_t)frames);
+        metrics().compressBlocks.add();
+        metrics().compressBytesIn.add(raw.size());
+        metrics().compressBytesOut.add(zipped->size());
+        metrics().framesOut[MT_ZIP].add();
+        c.lanes.push(zipped);
+        if (raw.size() < minBytes) return;   // 剩下的是文件块或超大帧
+    }
+}
+
+// ========== 共享内存连接 ==========
+
+bool Reactor::armShm() {
+    bool idle = true;
+    for (ConnId id : shmConns) {
+        Connection* c = findConn(id);
+        if (c == nullptr || c->closing) continue;
+        ShmLink& link = *c->shm;
+        if (!link.up.prepareWait()) idle = false;
+        if (c->writeBlocked && !link.down.prepareWaitSpace(link.blockedTail)) idle = false;
+    }
+    return idle;
+}
+
+void Reactor::pollShm() {
+    for (size_t i = 0; i < shmConns.size(); i++) {
+        Connection* c = findConn(shmConns[i]);
+        if (c == nullptr || c->closing) continue;
+        std::shared_ptr<ShmLink> link = c->shm;   // onData 里可能标记关闭，但连接要到 closeMarked 才释放
+        link->up.endWait();
+        size_t budget = SHM_READ_BUDGET;
+        const char* p1;
+        const char* p2;
+        size_t n1, n2;
+        while (budget > 0 && !c->closing && link->up.peek(p1, n1, p2, n2) > 0) {
+            // 直接把环里的字节交给 decoder，与 recv 到的 TCP 字节流一样处理
+            size_t take1 = std::min(n1, budget);
+            size_t take2 = std::min(n2, budget - take1);
+            onData(*c, p1, take1);
+            if (take2 > 0) onData(*c, p2, take2);
+            budget -= take1 + take2;
+            if (link->up.consume(take1 + take2)) notifyEvent(link->clientEvent);
+        }
+        if (c->writeBlocked && link->down.consumed() != link->blockedTail) {
+            link->down.endWaitSpace();
+            c->writeBlocked = false;
+            flushShm(*c);
+        }
+    }
+}
+
+void Reactor::flushShm(Connection& c) {
+    // 环满时等客户端读走一部分（pollShm 里重试），期间新帧留在 lanes 里，慢消费者同样按积压上限断开
+    if (c.writeBlocked) return;
+    ShmLink& link = *c.shm;
+    bool wrote = false;
+    while (FramePtr f = c.lanes.pop()) {
+        if (!link.down.append(f->data(), f->size())) {
+            c.lanes.unpop(std::move(f));
+            c.writeBlocked = true;
+            link.blockedTail = link.down.consumed();
+            break;
+        }
+        wrote = true;
+    }
+    if (wrote && link.down.publish()) notifyEvent(link.clientEvent);
+}
+
+void Reactor::drainMailbox() {
+    wakePending.exchange(false, std::memory_order_acq_rel);
+    ReactorTask task;
+    while (mailbox.pop(task)) {
+        mailboxDrained.fetch_add(1, std::memory_order_relaxed);
+        switch (task.kind) {
+        case ReactorTask::TASK_ADOPT:
+            onAccept(task.sock, std::move(task.shm));
+            break;
+        case ReactorTask::TASK_SEND:
+            sendLocal(task.conn, task.frame);
+            break;
+        case ReactorTask::TASK_FANOUT:
+            for (ConnId id : task.targets) sendLocal(id, task.frame);
+            break;
+        case ReactorTask::TASK_CLOSE: {
+            Connection* c = findConn(task.conn);
+            if (c != nullptr) markClosing(*c);
+            break;
+        }
+        case ReactorTask::TASK_CALL:
+            if (task.call) task.call();
+            task.call = nullptr;
+            break;
+        case ReactorTask::TASK_STOP_LISTEN:
+            if (listenSock != INVALID_SOCKET) {
+                backend->removeListener(listenSock);
+                closeSocket(listenSock);
+                listenSock = INVALID_SOCKET;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void Reactor::markClosing(Connection& c) {
+    if (!c.closing) {
+        c.closing = true;
+        toClose.push_back(c.id);
+    }
+}
+
+void Reactor::closeMarked() {
+    // onDisconnect 可能再次广播并标记新的待关闭连接，所以循环处理
+    while (!toClose.empty()) {
+        std::vector<ConnId> batch;
+        batch.swap(toClose);
+        for (ConnId id : batch) {
+            auto it = conns.find(id);
+            if (it == conns.end()) continue;
+            if (!toFlush.empty()) flushOutput();   // 先把已排队的帧（如 EXIT 的回复）写出去
+            if (it->second.held != nullptr) ObjectPool<Message>::release(it->second.held);
+            backend->removeConn(it->second);
+            closeSocket(it->second.sock);
+            if (it->second.shm) shmConns.erase(std::find(shmConns.begin(), shmConns.end(), id));
+            metrics().connClosed.add();
+            std::shared_ptr<ConnOrder> order = std::move(it->second.order);
+            conns.erase(it);
+            if (order) {
+                // 排在该连接所有未处理消息之后
+                getHandlerPool()->submit(order, "", [id]() { onDisconnect(id); });
+            } else {
+                onDisconnect(id);
+            }
+        }
+    }
+}
+
+// ========== reactor 组 ==========
+
+static SOCKET openListener(unsigned short port, bool reusePort) {
+    SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+    int one = 1;
+#ifndef _WIN32
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+#endif
+#ifdef SO_REUSEPORT
+    if (reusePort) {
+        setsockopt(s, SOL_SOCKET, SO_REUSEPORT, (const char*)&one, sizeof(one));
+    }
+#else
+    (void)reusePort;
+    (void)one;
+#endif
+    sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;//地址簇为ipv4
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    serverAddr.sin_port = htons(port);
+    /*该调用与 TCP 四元组中的“源地址与源端口”关联，确立服务器的传输层标识符(源IP, 源Port, ANY目标IP, ANY目标Port)。
+      开启 SO_REUSEPORT 后多个监听套接字绑定同一端口，内核按四元组哈希把新连接分给它们。*/
+    if (bind(s, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR ||
+        listen(s, SOMAXCONN) == SOCKET_ERROR) {
+        closeSocket(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+// 接入线程：阻塞 accept，轮流把新连接交给各 reactor。
+// 用于不支持 SO_REUSEPORT 时的共享 TCP 监听，以及 Unix 域套接字监听；
+// 接入之后的收发、会话表和扇出与 TCP 连接完全相同。
+// shm 为 true 时先在控制连接上完成共享内存握手，之后收发走共享内存环
+static void acceptLoop(std::atomic<SOCKET>* listenerRef, bool shm) {
+    int next = 0;
+    while (true) {
+        SOCKET listener = listenerRef->load();
+        if (listener == INVALID_SOCKET) break;
+        SOCKET s = accept(listener, nullptr, nullptr);
+        if (s == INVALID_SOCKET) {
+            if (listenerRef->load() == INVALID_SOCKET) break;   // closeListeners 已关闭监听
+            std::cout << "Accept failed" << std::endl;
+            continue;
+        }
+        Reactor* r = reactors[next];
+        next = (next + 1) % reactorCount;
+        ReactorTask task;
+        task.kind = ReactorTask::TASK_ADOPT;
+        task.sock = s;
+        if (shm) {
+            int wake = r->wakeHandle();
+            if (wake >= 0) task.shm = acceptShmLink(s, wake);
+            if (!task.shm) {
+                std::cout << "[WARN] Shared-memory handshake failed" << (wake < 0 ? " (needs epoll or uring backend)" : "")
+                          << std::endl;
+                closeSocket(s);
+                continue;
+            }
+        }
+        r->post(std::move(task));
+    }
+}
+
+bool startReactors(int count, unsigned short port, const std::string& ioBackend, const std::vector<SOCKET>& inherited) {
+    if (count <= 0) count = (int)std::thread::hardware_concurrency();
+    if (count <= 0) count = 1;
+    // 接管的监听套接字每个都要有 reactor 接收，否则内核分给它的新连接无人处理
+    if (count < (int)inherited.size()) count = (int)inherited.size();
+    if (count > MAX_REACTORS) count = MAX_REACTORS;
+
+    for (int i = 0; i < count; i++) {
+        reactors[i] = new Reactor(i);
+        if (!reactors[i]->init(ioBackend)) {
+            std::cout << "[ERROR] Reactor " << i << " init failed" << std::endl;
+            return false;
+        }
+    }
+    reactorCount = count;
+
+#ifdef SO_REUSEPORT
+    // 每个 reactor 一个独立的监听套接字，由内核在它们之间分摊新连接
+    for (int i = 0; i < count; i++) {
+        SOCKET s = i < (int)inherited.size() ? inherited[i] : openListener(port, true);
+        if (s == INVALID_SOCKET) {
+            std::cout << "[ERROR] Bind/listen on port " << port << " failed" << std::endl;
+            return false;
+        }
+        reactors[i]->listenOn(s);
+        listenerSockets.push_back(s);
+    }
+#else
+    // 平台不支持 SO_REUSEPORT：退化为单一监听 + 轮询分发
+    SOCKET s = openListener(port, false);
+    if (s == INVALID_SOCKET) {
+        std::cout << "[ERROR] Bind/listen on port " << port << " failed" << std::endl;
+        return false;
+    }
+    sharedListener.store(s);
+    listenerSockets.push_back(s);
+    std::thread(acceptLoop, &sharedListener, false).detach();
+#endif
+
+    for (int i = 0; i < count; i++) reactors[i]->start();
+    return true;
+}
+
+void stopReactors() {
+    for (int i = 0; i < reactorCount; i++) reactors[i]->stop();
+}
+
+void joinReactors() {
+    for (int i = 0; i < reactorCount; i++) reactors[i]->join();
+}
+
+int getReactorCount() {
+    return reactorCount;
+}
+
+Reactor* getReactor(int index) {
+    return (index >= 0 && index < reactorCount) ? reactors[index] : nullptr;
+}
+
+static bool openUnixListener(UnixListener& l, const std::string& path, bool shm) {
+    SOCKET s = listenUnix(path, SOMAXCONN);
+    if (s == INVALID_SOCKET) return false;
+#ifndef _WIN32
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) l.inode = st.st_ino;
+#endif
+    l.path = path;
+    l.sock.store(s);
+    std::thread(acceptLoop, &l.sock, shm).detach();
+    return true;
+}
+
+static void closeUnixListener(UnixListener& l) {
+    SOCKET s = l.sock.exchange(INVALID_SOCKET);
+    if (s == INVALID_SOCKET) return;
+    shutdown(s, SD_BOTH);   // 让阻塞中的 accept 返回
+    closeSocket(s);
+#ifndef _WIN32
+    // 热重启时接班进程已在同一路径上重新绑定，那个文件不属于本进程
+    struct stat st;
+    if (stat(l.path.c_str(), &st) == 0 && st.st_ino == l.inode) unlink(l.path.c_str());
+#endif
+}
+
+bool startUnixListener(const std::string& path) {
+    return openUnixListener(unixListener, path, false);
+}
+
+bool startShmListener(const std::string& path) {
+#ifdef __linux__
+    return openUnixListener(shmListener, path, true);
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+std::vector<SOCKET> getListeners() {
+    return listenerSockets;
+}
+
+void closeListeners() {
+    SOCKET s = sharedListener.exchange(INVALID_SOCKET);
+    if (s != INVALID_SOCKET) {
+        shutdown(s, SD_BOTH);   // 让阻塞中的 accept 返回
+        closeSocket(s);
+    }
+    closeUnixListener(unixListener);
+    closeUnixListener(shmListener);
+    for (int i = 0; i < reactorCount; i++) {
+        ReactorTask task;
+        task.kind = ReactorTask::TASK_STOP_LISTEN;
+        reactors[i]->post(std::move(task));
+    }
+}
+
+void sendFrameTo(ConnId conn, const FramePtr& frame) {
+    if (isRemoteConn(conn)) {
+        clusterSend(conn, frame);   // 连在其它节点上的用户：经节点链路转过去
+        return;
+    }
+    int r = reactorOf(conn);
+    if (conn == INVALID_CONN || r >= reactorCount) return;
+    if (reactors[r] == currentReactor) {
+        reactors[r]->sendLocal(conn, frame);
+        return;
+    }
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_SEND;
+    task.conn = conn;
+    task.frame = frame;
+    reactors[r]->post(std::move(task));
+}
+
+void sendTo(ConnId conn, const std::string& payload) {
+    sendFrameTo(conn, makeFrame(payload));
+}
+
+void fanOut(const std::vector<ConnId>& targets, const FramePtr& frame) {
+    if (targets.empty()) return;
+    thread_local std::vector<std::vector<ConnId>> groups;   // 复用的分组缓冲
+    thread_local std::vector<ConnId> remotes;               // 连在其它节点上的接收者
+    groups.resize(reactorCount);
+    for (auto& g : groups) g.clear();
+    remotes.clear();
+    for (ConnId id : targets) {
+        if (isRemoteConn(id)) {
+            remotes.push_back(id);
+            continue;
+        }
+        int r = reactorOf(id);
+        if (id != INVALID_CONN && r < reactorCount) groups[r].push_back(id);
+    }
+    if (!remotes.empty()) clusterDeliver(remotes, frame);
+    // 先投递给其它 reactor 让它们并行发送，最后再处理本线程自己的连接
+    int self = -1;
+    for (int r = 0; r < reactorCount; r++) {
+        if (groups[r].empty()) continue;
+        if (reactors[r] == currentReactor) {
+            self = r;
+            continue;
+        }
+        ReactorTask task;
+        task.kind = ReactorTask::TASK_FANOUT;
+        task.frame = frame;
+        task.targets = std::move(groups[r]);
+        reactors[r]->post(std::move(task));
+    }
+    if (self >= 0) {
+        for (ConnId id : groups[self]) reactors[self]->sendLocal(id, frame);
+    }
+}
+
+void closeConnection(ConnId conn) {
+    int r = reactorOf(conn);
+    if (conn == INVALID_CONN || isRemoteConn(conn) || r >= reactorCount) return;
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_CLOSE;
+    task.conn = conn;
+    reactors[r]->post(std::move(task));
+}
+
+void sendFileTo(ConnId conn, int fd, const std::string& hash, uint64_t offset, uint64_t end) {
+    int r = reactorOf(conn);
+    if (conn == INVALID_CONN || isRemoteConn(conn) || r >= reactorCount) {
+        closeFile(fd);
+        return;
+    }
+    Reactor* reactor = reactors[r];
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_CALL;
+    task.call = [reactor, conn, fd, hash, offset, end]() { reactor->sendFileLocal(conn, fd, hash, offset, end); };
+    reactor->post(std::move(task));
+}
+
+void setConnEvents(ConnId conn, bool wanted) {
+    int r = reactorOf(conn);
+    if (conn == INVALID_CONN || isRemoteConn(conn) || r >= reactorCount) return;
+    Reactor* reactor = reactors[r];
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_CALL;
+    task.call = [reactor, conn, wanted]() {
+        Connection* c = reactor->findConn(conn);
+        if (c != nullptr) c->eventsOff = !wanted;
+    };
+    reactor->post(std::move(task));
+}
+
+void setConnBatch(ConnId conn) {
+    int r = reactorOf(conn);
+    if (conn == INVALID_CONN || isRemoteConn(conn) || r >= reactorCount) return;
+    Reactor* reactor = reactors[r];
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_CALL;
+    task.call = [reactor, conn]() {
+        Connection* c = reactor->findConn(conn);
+        if (c != nullptr) c->batchOk = true;
+    };
+    reactor->post(std::move(task));
+}
+
+void setConnUser(ConnId conn, uint32_t user) {
+    int r = reactorOf(conn);
+    if (conn == INVALID_CONN || isRemoteConn(conn) || r >= reactorCount) return;
+    Reactor* reactor = reactors[r];
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_CALL;
+    task.call = [reactor, conn, user]() {
+        Connection* c = reactor->findConn(conn);
+        if (c == nullptr) return;
+        c->rateUser = user;
+        c->rateKeys.clear();
+    };
+    reactor->post(std::move(task));
+}
+
+void resetConnRateKey(ConnId conn) {
+    // 未开启限流时连接不缓存会话键，不用投递
+    int r = reactorOf(conn);
+    if (!rateLimitEnabled() || conn == INVALID_CONN || isRemoteConn(conn) || r >= reactorCount) return;
+    Reactor* reactor = reactors[r];
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_CALL;
+    task.call = [reactor, conn]() {
+        Connection* c = reactor->findConn(conn);
+        if (c != nullptr) c->rateKeys.clear();
+    };
+    reactor->post(std::move(task));
+}
+
+void setConnCompress(ConnId conn) {
+    int r = reactorOf(conn);
+    if (conn == INVALID_CONN || isRemoteConn(conn) || r >= reactorCount) return;
+    Reactor* reactor = reactors[r];
+    ReactorTask task;
+    task.kind = ReactorTask::TASK_CALL;
+    task.call = [reactor, conn]() {
+        Connection* c = reactor->findConn(conn);
+        if (c != nullptr && !c->compress) {
+            c->compress = true;
+            metrics().compressConns.add();
+        }
+    };
+    reactor->post(std::move(task));
+}
+
+std::vector<ConnStat> snapshotConnections(int timeoutMs) {
+    // 每个 reactor 在自己的线程里拷贝连接统计，不加任何锁，也不打断它的 I/O
+    struct Collector {
+        std::mutex lock;
+        std::condition_variable done;
+        std::vector<ConnStat> stats;
+        int pending = 0;
+    };
+    auto col = std::make_shared<Collector>();
+    col->pending = reactorCount;
+    for (int i = 0; i < reactorCount; i++) {
+        Reactor* r = reactors[i];
+        ReactorTask task;
+        task.kind = ReactorTask::TASK_CALL;
+        task.call = [col, r]() {
+            std::vector<ConnStat> part;
+            r->collectConnStats(part);
+            std::lock_guard<std::mutex> lk(col->lock);
+            col->stats.insert(col->stats.end(), part.begin(), part.end());
+            col->pending--;
+            col->done.notify_all();
+        };
+        r->post(std::move(task));
+    }
+    std::unique_lock<std::mutex> lk(col->lock);
+    col->done.wait_for(lk, std::chrono::milliseconds(timeoutMs), [&col]() { return col->pending == 0; });
+    return col->stats;
+}
@@ -0,0 +1,200 @@
+#include "../include/SendLanes.h"
+#include "../include/Platform.h"
+
+// 每轮轮转给一个流的基本额度（字节），乘以流的权重
+static const long long QUANTUM_BYTES = 4096;
+// 通道全部写空时，流超过这个数就整体丢弃（用户同时收到的会话通常不多，留着复用容量）
+static const size_t KEEP_FLOWS = 8;
+
+FramePtr FrameQueue::pop_front() {
+    FramePtr f = std::move(items[head++]);
+    if (head == items.size()) clear();
+    return f;
+}
+
+void FrameQueue::push_front(FramePtr f) {
+    if (head > 0) items[--head] = std::move(f);
+    else items.insert(items.begin(), std::move(f));
+}
+
+void FrameQueue::clear() {
+    items.clear();
+    head = 0;
+}
+
+SendLanes::Flow& SendLanes::flowOf(uint32_t key, int weight) {
+    for (Flow& f : flows) {
+        if (f.key == key) return f;
+    }
+    // 复用一个已经空了的流
+    for (Flow& f : flows) {
+        if (f.q.empty()) {
+            f.key = key;
+            f.weight = weight;
+            f.deficit = 0;
+            return f;
+        }
+    }
+    flows.emplace_back();
+    flows.back().key = key;
+    flows.back().weight = weight;
+    return flows.back();
+}
+
+void SendLanes::push(const FramePtr& f) {
+    count++;
+    queuedBytes += f->size();
+    if (f.flow() == 0) {
+        control.push_back(f);
+        return;
+    }
+    bulkCount++;
+    bulkQueued += f->size();
+    flowOf(f.flow(), f.weight()).q.push_back(f);
+}
+
+FramePtr SendLanes::pop() {
+    if (count == 0) return FramePtr();
+    if (!control.empty()) {
+        count--;
+        FramePtr f = control.pop_front();
+        queuedBytes -= f->size();
+        return f;
+    }
+    return popBulk();
+}
+
+FramePtr SendLanes::popBulk() {
+    if (bulkCount == 0) return FramePtr();
+    count--;
+    bulkCount--;
+    while (true) {
+        Flow& flow = flows[cursor];
+        if (!flow.q.empty() && flow.deficit >= (long long)flow.q.front()->size()) {
+            FramePtr f = flow.q.pop_front();
+            flow.deficit -= (long long)f->size();
+            queuedBytes -= f->size();
+            bulkQueued -= f->size();
+            if (flow.q.empty()) flow.deficit = 0;
+            if (bulkCount == 0 && flows.size() > KEEP_FLOWS) {
+                flows.clear();
+                cursor = 0;
+            }
+            return f;
+        }
+        // 本流额度不够（或已空）：轮到下一个流，并给它这一轮的额度
+        if (flow.q.empty()) flow.deficit = 0;
+        cursor = (cursor + 1) % flows.size();
+        Flow& next = flows[cursor];
+        if (!next.q.empty()) next.deficit += QUANTUM_BYTES * next.weight;
+    }
+}
+
+void SendLanes::unpop(FramePtr f) {
+    count++;
+    queuedBytes += f->size();
+    if (f.flow() == 0) {
+        control.push_front(std::move(f));
+        return;
+    }
+    bulkCount++;
+    bulkQueued += f->size();
+    Flow& flow = flowOf(f.flow(), f.weight());
+    flow.deficit += (long long)f->size();   // 退还 pop 时扣掉的额度
+    flow.q.push_front(std::move(f));
+}
+
+void SendLanes::clear() {
+    control.clear();
+    flows.clear();
+    cursor = 0;
+    bulkCount = 0;
+    bulkQueued = 0;
+    count = 0;
+    queuedBytes = 0;
+}
+
+// ========== 文件通道 ==========
+
+void FileLane::push(int fd, const std::string& hash, uint64_t offset, uint64_t end) {
+    files.push_back(FileSend{fd, hash, offset, end});
+}
+
+uint64_t FileLane::bytes() const {
+    uint64_t n = bodyLeft;
+    for (const FileSend& f : files) n += f.end - f.offset;
+    return n;
+}
+
+void FileLane::closeDone() {
+    if (doneFd >= 0) closeFile(doneFd);
+    doneFd = -1;
+}
+
+void FileLane::clear() {
+    for (FileSend& f : files) closeFile(f.fd);
+    files.clear();
+    closeDone();
+    head.clear();
+    headSent = 0;
+    bodyFd = -1;
+    bodyLeft = 0;
+}
+
+size_t FileLane::chunkOf(FileSend& f) {
+    uint64_t left = f.end - f.offset;
+    return (size_t)(left < FILE_CHUNK_SIZE ? left : FILE_CHUNK_SIZE);
+}
+
+static void putFrameLength(std::string& out, size_t at, uint32_t len) {
+    out[at] = (char)((len >> 24) & 0xFF);
+    out[at + 1] = (char)((len >> 16) & 0xFF);
+    out[at + 2] = (char)((len >> 8) & 0xFF);
+    out[at + 3] = (char)(len & 0xFF);
+}
+
+bool FileLane::startChunk() {
+    closeDone();
+    if (files.empty()) return false;
+    FileSend& f = files.front();
+    size_t n = chunkOf(f);
+    head.assign(FRAME_HEADER_SIZE, '\0');
+    appendFileChunkHeader(head, "Server", f.hash, f.offset);
+    putFrameLength(head, 0, (uint32_t)(head.size() - FRAME_HEADER_SIZE + n));
+    headSent = 0;
+    bodyFd = f.fd;
+    bodyOffset = f.offset;
+    bodyLeft = n;
+    f.offset += n;
+    if (f.offset == f.end) {
+        doneFd = f.fd;
+        files.pop_front();
+    }
+    return true;
+}
+
+FramePtr FileLane::readChunk() {
+    closeDone();
+    while (!files.empty()) {
+        FileSend& f = files.front();
+        size_t n = chunkOf(f);
+        std::string payload;
+        appendFileChunkHeader(payload, "Server", f.hash, f.offset);
+        size_t at = payload.size();
+        payload.resize(at + n);
+        long got = n > 0 ? readFileAt(f.fd, &payload[at], n, f.offset) : 0;
+        if (got != (long)n || n == 0) {
+            // 文件被截断或读出错：丢掉它，客户端校验摘要时会发现并续传
+            closeFile(f.fd);
+            files.pop_front();
+            continue;
+        }
+        f.offset += n;
+        if (f.offset == f.end) {
+            closeFile(f.fd);
+            files.pop_front();
+        }
+        return makeFrame(payload);
+    }
+    return FramePtr();
+}
@@ -4,136 +4,263 @@
 #include <vector>
 #include <thread>
 #include <algorithm>
-#include<winsock2.h>
+#include <chrono>
+#include <cstdlib>
+#include <random>
 #include"../include/Server.h"
-//更新退逻辑,分离退出线程 ,防止推出命令阻塞
-void exitThread(SOCKET serverSocket){
-    std::string command;
-    while(std::cin>>command){
-        if(command=="exit"){
-            closesocket(serverSocket);
-            WSACleanup();
-            exit(0);
-        }
+#include"../include/Trace.h"
+#include"../include/Metrics.h"
+#include"../include/Admin.h"
+#include"../include/Handoff.h"
+#include"../include/StateStore.h"
+#include"../include/Cluster.h"
+#include"../include/Presence.h"
+#include"../include/BlobStore.h"
+#include"../include/Compress.h"
+
+//全局状态定义（声明见 Server.h）
+std::map<ConnId,std::string> socketUser;
+std::map<std::string, ConnId> userSocket;
+std::mutex clientMutex;
+std::map<std::string, ServerSession> sessions;
+UserDirectory users;
+std::unordered_set<PairKey, PairKeyHash> privateSessions;
+ServerConfig serverConfig;
+
+//排空窗口结束后再等这么久，仍未断开的连接随进程退出一起关闭
+static const int DRAIN_GRACE_MS = 5000;
+
+//控制台线程：stdin 上的管理命令（与管理端口共用一套命令，见 Admin.h）
+void consoleThread(){
+    std::string line;
+    bool quit = false;
+    while(!quit && std::getline(std::cin,line)){
+        std::cout<<runAdminCommand(line, quit)<<std::flush;
     }
+    if(quit) shutdownServer();
+}
 
+//排空：客户端按各自的随机延迟重连，重连被分散在整个窗口内，不会同时涌向新进程
+void drainServer(int windowMs){
+    static std::atomic<bool> draining{false};
+    if(draining.exchange(true)) return;
+    closeListeners();
+    std::vector<std::pair<ConnId,std::string>> online;
+    {
+        MeteredLock lock(clientMutex);
+        online.assign(socketUser.begin(), socketUser.end());
+    }
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_int_distribution<int> jitter(0, windowMs > 0 ? windowMs - 1 : 0);
+    for(const auto &[conn,name]:online){
+        //RECONNECT 的内容是建议的重连延迟（毫秒）
+        Message notice{"RECONNECT","Server",name,std::to_string(jitter(rng))};
+        sendTo(conn, buildMessage(notice));
+    }
+    std::cout<<"[SYS] Draining: "<<online.size()<<" users asked to reconnect within "<<windowMs<<"ms"<<std::endl;
+    //等客户端自行断开；超过窗口仍未断开的（如不认识 RECONNECT 的旧客户端）到时直接关闭
+    std::thread([windowMs](){
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(windowMs + DRAIN_GRACE_MS);
+        while(std::chrono::steady_clock::now() < deadline){
+            uint64_t open = metrics().connOpened.value() - metrics().connClosed.value();
+            if(open == 0) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        std::cout<<"[SYS] Drain finished"<<std::endl;
+        shutdownServer();
+    }).detach();
 }
 
+//关闭：停止接入并让 reactor 退出事件循环；其余收尾在 main 里 joinReactors 返回之后按顺序进行，
+//保证 netCleanup 和进程退出时不再有线程在用套接字
+void shutdownServer(){
+    static std::atomic<bool> stopping{false};
+    if(stopping.exchange(true)) return;
+    closeListeners();
+    stopReactors();
+}
+
+//构造回复：复用本线程的协议字符串缓冲（结果会立刻被 makeFrame 拷进帧，下一次调用前必须用完）
+static const std::string& buildReply(const Message& m){
+    thread_local std::string buf;
+    buf.clear();
+    appendMessage(buf, m);
+    return buf;
+}
+
+//带跟踪字段的消息：转发时在 TRACE 后追加服务器收到、解析完成、路由完成三个时刻
+static const std::string& buildTracedReply(const Message& m, int64_t routeUs){
+    thread_local std::string buf;
+    buf.clear();
+    appendMessage(buf, m);
+    appendTraceStamp(buf, m.recvUs);
+    appendTraceStamp(buf, m.parseUs);
+    appendTraceStamp(buf, routeUs);
+    return buf;
+}
 
+//用户当前的连接（调用方持有 clientMutex）：连在本节点上直接返回；集群模式下其它节点上的用户查在线目录，
+//目录还没有该用户时退回本节点记下的远端连接
+static ConnId onlineConnOf(const std::string &name){
+    ConnId conn=users.connOf(users.find(name));
+    if(conn!=INVALID_CONN && !isRemoteConn(conn)) return conn;
+    ConnId found;
+    if(presenceFind(name, found)) return found;
+    return conn;
+}
 
 //完善session相关的函数
 //创建群聊session函数
-void createGroupSession(const std::string & groupName){
-    std::lock_guard<std::mutex> lock(clientMutex);
+bool createGroupSession(const std::string & groupName, const std::string & creator){
+    MeteredLock lock(clientMutex);
     //C++ 的安全锁操作语句，它让多个线程在访问共享资源时保证互斥。
-    if(sessions.find(groupName)==sessions.end()){
-        ServerSession newSession;
-        newSession.id=groupName;
-        sessions[groupName]=newSession;//将新建的会话添加到会话表中
-    }
+    if(sessions.find(groupName)!=sessions.end()) return false;
+    ServerSession &newSession=sessions[groupName];//将新建的会话添加到会话表中
+    newSession.id=groupName;
+    newSession.type=ST_GROUP;
+    newSession.members.insert(users.intern(creator));
+    journalSessionCreate(groupName, ST_GROUP);
+    journalMemberAdd(groupName, creator);
+    return true;
 }
              
-//创建私聊session
-void createPrivateSession(const std::string &user1, const std::string &user2){
-    std::lock_guard<std::mutex> lock(clientMutex);
-    std::string sessionID =user1< user2 ? user1+user2:user2+user1;
-    if(sessions.find(sessionID)==sessions.end()){
-        ServerSession newSession;
-        newSession.members.insert(user1);
-        newSession.members.insert(user2);
-        newSession.id=sessionID;
-        sessions[sessionID]=newSession;
-    }
+//创建私聊session：键是两人编号的有序对，与谁先发起无关（调用方持有 clientMutex）
+bool createPrivateSession(const std::string &user1, const std::string &user2){
+    UserId a=users.intern(user1), b=users.intern(user2);
+    if(!privateSessions.insert(PairKey(a,b)).second) return false;
+    journalPrivateCreate(user1, user2);
+    //两人之间的消息从此按私聊计会话限额，连接缓存的会话键作废
+    resetConnRateKey(users.connOf(a));
+    resetConnRateKey(users.connOf(b));
+    return true;
+}
+
+//删除私聊session（调用方持有 clientMutex）
+bool dropPrivateSession(const std::string &user1, const std::string &user2){
+    UserId a=users.find(user1), b=users.find(user2);
+    if(a==NO_USER || b==NO_USER || privateSessions.erase(PairKey(a,b))==0) return false;
+    journalPrivateDrop(user1, user2);
+    resetConnRateKey(users.connOf(a));
+    resetConnRateKey(users.connOf(b));
+    return true;
+}
 
+std::vector<PairKey> privateSessionKeys(){
+    MeteredLock lock(clientMutex);
+    return std::vector<PairKey>(privateSessions.begin(), privateSessions.end());
 }
 
 //向session中添加用户
 void addUserToSession(const std::string & sessionId ,const std::string &userName){
-    std::lock_guard<std::mutex> lock(clientMutex);
+    MeteredLock lock(clientMutex);
     auto iter=sessions.find(sessionId);
     if(iter!=sessions.end()){
         //iter->second 取的是 map 项的值部分，也就是那个 Session 对象；
-        iter->second.members.insert(userName);
+        if(iter->second.members.insert(users.intern(userName))){
+            journalMemberAdd(sessionId, userName);
+        }
     }
 }
 
 void removeUserFromSession(const std::string & sessionId,const std::string &userName){
-    std::lock_guard<std::mutex> lock(clientMutex);
+    MeteredLock lock(clientMutex);
     auto iter=sessions.find(sessionId); //通过名字进行查找对应的session
     if(iter!=sessions.end()){
-        iter->second.members.erase(userName);//删除session中的用户
+        if(iter->second.members.erase(users.find(userName))){//删除session中的用户
+            journalMemberDel(sessionId, userName);
+        }
     }
 }
 
 //向session内所有成员广播消息
-void broadcastToSession(const std::string & sessionId, const std::string & msg, SOCKET excludeSocket){
-    std::lock_guard<std::mutex> lock(clientMutex);
-    auto iter =sessions.find(sessionId);
-    
-    //处理特殊的群组广播:all
-    if(sessionId=="ALL"){
-        for(const auto &[name,socket]:userSocket){
-            if(socket!=excludeSocket){
-                send(socket,msg.c_str(),msg.size(),0);
+void broadcastToSession(const std::string & sessionId, const std::string & msg, ConnId excludeConn, int64_t traceUs){
+    thread_local std::vector<ConnId> targets;   // 复用的接收者缓冲
+    thread_local std::vector<ConnId> remotes;   // 连在其它节点上的成员（集群模式）
+    targets.clear();
+    remotes.clear();
+    {
+        MeteredLock lock(clientMutex);
+        //处理特殊的群组广播:all
+        if(sessionId=="ALL"){
+            for(const auto &[name,conn]:userSocket){
+                if(conn!=excludeConn){
+                    targets.push_back(conn);
+                }
             }
         }
-        return ;//直接返回，不再进行后续操作
-    }
-
-    if(iter!=sessions.end()){
-        for(const auto &member:iter->second.members){
-            auto iter2=userSocket.find(member);
-            if(iter2!=userSocket.end()){
-                send(iter2->second,msg.c_str(),msg.size(),0);
+        else{
+            auto iter =sessions.find(sessionId);
+            if(iter!=sessions.end()){
+                //成员是编号数组，在线连接按编号直接取，不再逐个查用户名
+                for(UserId member:iter->second.members){
+                    ConnId conn=users.connOf(member);
+                    if(conn==INVALID_CONN) continue;
+                    //其它节点上的成员不逐个转发，按节点发布一份（排除者由该节点处理，名单保持稳定）
+                    if(isRemoteConn(conn)) remotes.push_back(conn);
+                    else if(conn!=excludeConn) targets.push_back(conn);
+                }
             }
         }
     }
-
+    //锁外扇出：只编码一次，按 reactor 分组投递，不在持锁期间做任何发送
+    FramePtr frame = makeFrame(msg, traceUs);
+    fanOut(targets, frame);
+    if(!remotes.empty()) clusterPublish(sessionId, remotes, excludeConn, frame);
+    //ALL 是所有在线用户：其它节点上的用户不在本节点的 userSocket 里，每个节点转一份由它自己广播
+    if(sessionId=="ALL") clusterBroadcast(msg, excludeConn);
 }
 
-//广播函数实现
-void broadcast(const std::string & data, SOCKET excludeSocket){
-    std::lock_guard<std::mutex> lock(clientMutex);//加锁保护映射表
-    for(const auto &[name,socket]:userSocket){
-        if(socket!=excludeSocket){
-            int result = send(socket,data.c_str(),data.size(),0);
-            if (result == SOCKET_ERROR) {
-                std::cout << "[ERROR] broadcast send failed for user " << name << ", error: " << WSAGetLastError() << std::endl;
-            } else {
-                std::cout << "[SYS] broadcast sent " << result << " bytes to " << name << std::endl;
+//广播函数实现：本节点的在线用户，集群模式下再请其它节点各自广播一次
+void broadcast(const std::string & data, ConnId excludeConn){
+    broadcastLocal(data, excludeConn);
+    clusterBroadcast(data, excludeConn);
+}
+//只发给连在本节点上的在线用户
+void broadcastLocal(const std::string & data, ConnId excludeConn){
+    thread_local std::vector<ConnId> targets;   // 复用的接收者缓冲
+    targets.clear();
+    {
+        MeteredLock lock(clientMutex);//加锁保护映射表
+        for(const auto &[name,conn]:userSocket){
+            if(conn!=excludeConn){
+                targets.push_back(conn);
             }
         }
     }
+    fanOut(targets, makeFrame(data));
 }
 //处理用户连接（不自动加入任何session）
-void onJoin(const Message & m, SOCKET clientSocket){
+void onJoin(const Message & m, ConnId clientConn){
     std::cout << "[SYS] User " << m.sender << " connected (not joined any session)" << std::endl;
     
+    UserId id;
     {
-        std::lock_guard<std::mutex> lock(clientMutex);
-        userSocket[m.sender] = clientSocket;
-        socketUser[clientSocket] = m.sender;
+        MeteredLock lock(clientMutex);
+        userSocket[m.sender] = clientConn;
+        socketUser[clientConn] = m.sender;
+        id = users.intern(m.sender);
+        users.setConn(id, clientConn);
+        presenceLocal(m.sender, clientConn, true);
     }
+    //之后按用户计限额：同一用户的多个连接、重连前后共用一个桶
+    setConnUser(clientConn, id);
+    //JOIN 的内容是客户端支持的扩展：batch 表示能直接解析批量帧
+    if (m.content == BATCH_FEATURE) setConnBatch(clientConn);
     
     // 仅给该用户发送欢迎消息（不广播）
     Message welcomeMsg{"SYS", "Server", m.sender, 
         "欢迎！请使用 /join ALL 加入聊天室，或 /join <用户名> 开始私聊"};
-    std::string welcomeStr = buildMessage(welcomeMsg);
-    int result = send(clientSocket, welcomeStr.c_str(), welcomeStr.size(), 0);
-    if (result == SOCKET_ERROR) {
-        std::cout << "[ERROR] Failed to send welcome message, error: " << WSAGetLastError() << std::endl;
-    } else {
-        std::cout << "[SYS] Sent welcome message, " << result << " bytes" << std::endl;
-    }
+    sendTo(clientConn, buildReply(welcomeMsg));
     
     // 检查是否是第一个用户，如果是则创建 ALL 群
     {
-        std::lock_guard<std::mutex> lock(clientMutex);
+        MeteredLock lock(clientMutex);
         if (sessions.find("ALL") == sessions.end()) {
             ServerSession allSession;
             allSession.id = "ALL";
             allSession.type = ST_GROUP;
             sessions["ALL"] = allSession;
+            journalSessionCreate("ALL", ST_GROUP);
             std::cout << "[SYS] Created default group session: ALL" << std::endl;
         }
     }
@@ -142,247 +269,606 @@ void onJoin(const Message & m, SOCKET clientSocket){
 }
 
 // 处理加入会话
-void onJoinSession(const Message &m, SOCKET clientSocket) {
+void onJoinSession(const Message &m, ConnId clientConn) {
     std::string sessionId = m.accepter;
     std::string userName = m.sender;
     
     std::cout << "[SYS] " << userName << " trying to join session: " << sessionId << std::endl;
     
+    ConnId peerConn = INVALID_CONN;   // 私聊时对方的连接
     {
-        std::lock_guard<std::mutex> lock(clientMutex);
+        MeteredLock lock(clientMutex);
         
         // 检查 session 是否存在
         auto it = sessions.find(sessionId);
         
-        // 如果是私聊（不是 ALL）且 session 不存在，自动创建
+        // 不是已有的群：按私聊处理，会话键是两人的编号对
         if (it == sessions.end() && sessionId != "ALL") {
+            std::string err;
+            peerConn = onlineConnOf(sessionId);
             // 检查目标用户是否在线（私聊需要对方存在）
-            if (userSocket.find(sessionId) != userSocket.end()) {
-                // 创建私聊 session
-                ServerSession privateSession;
-                privateSession.id = sessionId;  // 使用对方用户名作为 sessionId
-                privateSession.type = ST_PRIVATE;
-                privateSession.members.insert(userName);
-                privateSession.members.insert(sessionId);
-                sessions[sessionId] = privateSession;
-                std::cout << "[SYS] Auto-created private session: " << sessionId << std::endl;
-                it = sessions.find(sessionId);
-            } else {
-                // 对方不在线
+            if (sessionId == userName) {
+                err = "不能和自己私聊";
+            } else if (peerConn == INVALID_CONN) {
+                err = "用户 " + sessionId + " 不在线";
+            } else if (clusterEnabled() && privateOwnerOf(userName, sessionId) != clusterSelf()) {
+                // 请求方节点的在线目录还不认识对方，按群名转到了这里；私聊只能建在两人的归属节点上
+                err = "用户 " + sessionId + " 不在线";
+            } else if (!createPrivateSession(userName, sessionId)) {
+                err = "你已在会话 " + sessionId + " 中";
+            }
+            if (!err.empty()) {
+                Message errMsg{"SYS", "Server", userName, err};
+                sendTo(clientConn, buildReply(errMsg));
+                std::cout << "[WARN] Private session " << userName << " <-> " << sessionId << ": " << err << std::endl;
+                return;
+            }
+            std::cout << "[SYS] Created private session: " << userName << " <-> " << sessionId << std::endl;
+        } else {
+            if (it == sessions.end()) {
+                // Session 不存在（ALL 群不存在，不应该发生）
                 Message errMsg{"SYS", "Server", userName, 
-                    "用户 " + sessionId + " 不在线"};
-                std::string errStr = buildMessage(errMsg);
-                send(clientSocket, errStr.c_str(), errStr.size(), 0);
-                std::cout << "[WARN] User " << sessionId << " not online" << std::endl;
+                    "会话 " + sessionId + " 不存在"};
+                const std::string& errStr = buildReply(errMsg);
+                sendTo(clientConn, errStr);
+                std::cout << "[WARN] Session " << sessionId << " not found" << std::endl;
                 return;
             }
+            
+            // 检查是否已在该 session 中
+            if (it->second.members.contains(users.find(userName))) {
+                Message warnMsg{"SYS", "Server", userName, 
+                    "你已在会话 " + sessionId + " 中"};
+                const std::string& warnStr = buildReply(warnMsg);
+                sendTo(clientConn, warnStr);
+                return;
+            }
+            
+            // 加入 session
+            it->second.members.insert(users.intern(userName));
+            journalMemberAdd(sessionId, userName);
+            std::cout << "[SYS] " << userName << " joined session " << sessionId << std::endl;
         }
-        
-        if (it == sessions.end()) {
-            // Session 不存在（ALL 群不存在，不应该发生）
-            Message errMsg{"SYS", "Server", userName, 
-                "会话 " + sessionId + " 不存在"};
-            std::string errStr = buildMessage(errMsg);
-            send(clientSocket, errStr.c_str(), errStr.size(), 0);
-            std::cout << "[WARN] Session " << sessionId << " not found" << std::endl;
-            return;
-        }
-        
-        // 检查是否已在该 session 中
-        if (it->second.members.count(userName)) {
-            Message warnMsg{"SYS", "Server", userName, 
-                "你已在会话 " + sessionId + " 中"};
-            std::string warnStr = buildMessage(warnMsg);
-            send(clientSocket, warnStr.c_str(), warnStr.size(), 0);
-            return;
-        }
-        
-        // 加入 session
-        it->second.members.insert(userName);
-        std::cout << "[SYS] " << userName << " joined session " << sessionId << std::endl;
     }
     
     // 通知该用户
     Message successMsg{"SYS", "Server", userName, 
         "已加入会话 " + sessionId};
-    std::string successStr = buildMessage(successMsg);
-    send(clientSocket, successStr.c_str(), successStr.size(), 0);
+    const std::string& successStr = buildReply(successMsg);
+    sendTo(clientConn, successStr);
     
-    // 通知 session 内其他成员
-    Message notifyMsg{"SYS", "Server", sessionId, 
-        userName + " 加入了会话"};
-    broadcastToSession(sessionId, buildMessage(notifyMsg), clientSocket);
+    // 私聊只有对方一人，直接通知；群里的加入事件合并到下一轮，和同一轮的其它变化一起发给全体成员
+    if (peerConn != INVALID_CONN) {
+        Message notifyMsg{"SYS", "Server", sessionId, 
+            userName + " 加入了会话"};
+        sendTo(peerConn, buildReply(notifyMsg));
+    } else {
+        postSessionEvent(sessionId, userName, EV_JOIN);
+    }
 }
 
 // 处理离开会话
-void onLeaveSession(const Message &m, SOCKET clientSocket) {
+void onLeaveSession(const Message &m, ConnId clientConn) {
     std::string sessionId = m.accepter;
     std::string userName = m.sender;
     
-    removeUserFromSession(sessionId, userName);
+    // 私聊：删除两人的会话，只需通知对方
+    ConnId peerConn = INVALID_CONN;
+    bool wasPrivate = false;
+    {
+        MeteredLock lock(clientMutex);
+        if (dropPrivateSession(userName, sessionId)) {
+            wasPrivate = true;
+            peerConn = onlineConnOf(sessionId);
+        }
+    }
+    if (!wasPrivate) removeUserFromSession(sessionId, userName);
     
     // 通知该用户
     Message successMsg{"SYS", "Server", userName, 
         "已离开会话 " + sessionId};
-    std::string successStr = buildMessage(successMsg);
-    send(clientSocket, successStr.c_str(), successStr.size(), 0);
+    const std::string& successStr = buildReply(successMsg);
+    sendTo(clientConn, successStr);
     
-    // 通知 session 内其他成员
-    Message notifyMsg{"SYS", "Server", sessionId, 
-        userName + " 离开了会话"};
-    broadcastToSession(sessionId, buildMessage(notifyMsg), INVALID_SOCKET);
+    // 通知 session 内其他成员（群里的离开事件按轮合并）
+    if (wasPrivate) {
+        Message notifyMsg{"SYS", "Server", sessionId, 
+            userName + " 离开了会话"};
+        if (peerConn != INVALID_CONN) sendTo(peerConn, buildReply(notifyMsg));
+    } else {
+        postSessionEvent(sessionId, userName, EV_LEAVE);
+    }
+}
+
+//创建命名群聊：创建者自动成为成员，其他人用 JOIN_SESSION 加入、LEAVE_SESSION 离开
+void onCreateGroup(const Message &m, ConnId clientConn){
+    const std::string &groupName = m.accepter;
+    std::string reply;
+    bool isUser;
+    {
+        MeteredLock lock(clientMutex);
+        ConnId conn;
+        isUser = users.find(groupName) != NO_USER || presenceFind(groupName, conn);
+    }
+    if (groupName.empty()) {
+        reply = "群名不能为空";
+    } else if (isUser) {
+        // 发往用户名的消息按私聊路由，群名不能与用户名相同
+        reply = groupName + " 是用户名，不能用作群名";
+    } else if (createGroupSession(groupName, m.sender)) {
+        reply = "已创建群聊 " + groupName;
+        std::cout << "[SYS] " << m.sender << " created group " << groupName << std::endl;
+    } else {
+        reply = "会话 " + groupName + " 已存在，请直接 /join " + groupName;
+    }
+    Message replyMsg{"SYS", "Server", m.sender, reply};
+    sendTo(clientConn, buildReply(replyMsg));
 }
 
-void onExit(const Message&m ,SOCKET clientSocket){
+void onExit(const Message&m ,ConnId clientConn){
     {
-        std::lock_guard<std::mutex>lock(clientMutex);//加锁保护映射表
+        MeteredLock lock(clientMutex);//加锁保护映射表
         //删除对应的映射表
         userSocket.erase(m.sender);
-        socketUser.erase(clientSocket);
+        socketUser.erase(clientConn);
+        UserId id = users.find(m.sender);
+        if (id != NO_USER && users.connOf(id) == clientConn) {
+            users.setConn(id, INVALID_CONN);
+            presenceLocal(m.sender, clientConn, false);
+        }
     } // 锁在这里释放
 
-    Message exitMsg{"SYS","Server","ALL",m.sender + " has left the chat."};
-    std::string strMsg=buildMessage(exitMsg);
-    broadcast(strMsg,clientSocket);
+    clusterUserGone(m.sender, clientConn);
+
+    //下线事件记在 ALL 上：一轮里的全部下线合成一帧发给所有在线用户
+    postSessionEvent("ALL", m.sender, EV_OFFLINE);
     //在终端(服务器处输出提示)
     std::cout<<std::string ("[EXIT]"+m.sender)<<std::endl;
 }
 
-void onMsg(const Message & m, SOCKET clientSocket){
-    std::string sessionId = m.accepter;
-    std::string sender = m.sender;
-    
-    // 验证 sender 是否在该 session 中
-    {
-        std::lock_guard<std::mutex> lock(clientMutex);
-        auto it = sessions.find(sessionId);
-        
-        if (it == sessions.end()) {
-            // Session 不存在
-            Message errMsg{"SYS", "Server", sender, 
-                "会话 " + sessionId + " 不存在，请先 /join " + sessionId};
-            std::string errStr = buildMessage(errMsg);
-            send(clientSocket, errStr.c_str(), errStr.size(), 0);
-            std::cout << "[WARN] Session " << sessionId << " not found for " << sender << std::endl;
+//MSG 与 BATCH 共用：批量帧只做一次成员检查、一次扇出，帧原样转发（发送者与会话只写一次）
+void onMsg(const Message & m, ConnId clientConn){
+    const std::string &sessionId = m.accepter;
+    const std::string &sender = m.sender;
+    thread_local std::vector<ConnId> pairTargets;   // 私聊的接收者：双方各自的连接
+    pairTargets.clear();
+    bool isPrivate = false;
+    bool peerOffline = false;
+    bool isBatch = m.type == BATCH_TYPE;
+    size_t batchItems = 0;
+    if (isBatch) {
+        thread_local std::vector<std::pair<size_t, size_t>> items;
+        int64_t ts;
+        if (!parseBatch(m.content, ts, items)) {
+            Message errMsg{"SYS", "Server", sender, "批量消息格式错误，已丢弃"};
+            sendTo(clientConn, buildReply(errMsg));
+            std::cout << "[WARN] Malformed BATCH from " << sender << std::endl;
             return;
         }
-        
-        if (!it->second.members.count(sender)) {
-            // 发送者不在该 session 中
-            Message errMsg{"SYS", "Server", sender, 
-                "你未加入会话 " + sessionId + "，请先 /join " + sessionId};
-            std::string errStr = buildMessage(errMsg);
-            send(clientSocket, errStr.c_str(), errStr.size(), 0);
-            std::cout << "[WARN] " << sender << " not in session " << sessionId << std::endl;
-            return;
+        batchItems = items.size();
+        metrics().batchIn.add();
+        metrics().batchItems.add(batchItems);
+    }
+    
+    // 先按私聊查（两次用户名哈希 + 一次编号对哈希），不是私聊再验证 sender 是否在群中
+    {
+        MeteredLock lock(clientMutex);
+        UserId self = users.find(sender);
+        UserId peer = users.find(sessionId);
+        if (self != NO_USER && peer != NO_USER && privateSessions.count(PairKey(self, peer)) != 0) {
+            isPrivate = true;
+            ConnId selfConn = users.connOf(self);
+            ConnId peerConn = onlineConnOf(sessionId);
+            if (selfConn != INVALID_CONN) pairTargets.push_back(selfConn);
+            if (peerConn != INVALID_CONN) pairTargets.push_back(peerConn);
+            peerOffline = (peerConn == INVALID_CONN);
+        } else {
+            auto it = sessions.find(sessionId);
+            
+            if (it == sessions.end()) {
+                // Session 不存在
+                Message errMsg{"SYS", "Server", sender, 
+                    "会话 " + sessionId + " 不存在，请先 /join " + sessionId};
+                const std::string& errStr = buildReply(errMsg);
+                sendTo(clientConn, errStr);
+                std::cout << "[WARN] Session " << sessionId << " not found for " << sender << std::endl;
+                return;
+            }
+            
+            if (!it->second.members.contains(self)) {
+                // 发送者不在该 session 中
+                Message errMsg{"SYS", "Server", sender, 
+                    "你未加入会话 " + sessionId + "，请先 /join " + sessionId};
+                const std::string& errStr = buildReply(errMsg);
+                sendTo(clientConn, errStr);
+                std::cout << "[WARN] " << sender << " not in session " << sessionId << std::endl;
+                return;
+            }
         }
     }
     
     // 如果是私聊且对方不在线，提示（但仍然发送）
-    if (sessionId != "ALL") {
-        std::lock_guard<std::mutex> lock(clientMutex);
-        if (userSocket.find(sessionId) == userSocket.end()) {
-            Message warnMsg{"SYS", "Server", sender, 
-                "用户 " + sessionId + " 当前离线，消息已发送"};
-            std::string warnStr = buildMessage(warnMsg);
-            send(clientSocket, warnStr.c_str(), warnStr.size(), 0);
-        }
+    if (peerOffline) {
+        Message warnMsg{"SYS", "Server", sender, 
+            "用户 " + sessionId + " 当前离线，消息已发送"};
+        const std::string& warnStr = buildReply(warnMsg);
+        sendTo(clientConn, warnStr);
     }
     
-    // 转发消息到 session（包括发送者自己，用于回显）
-    broadcastToSession(sessionId, buildMessage(m), INVALID_SOCKET);
+    // 转发消息到 session（包括发送者自己，用于回显）；私聊的接收者已在上面取好，不再查会话表
+    int64_t routeUs = 0;
+    if (!m.trace.empty()) {
+        routeUs = traceNowUs();
+        serverTraceStats().record(STAGE_HANDLE, routeUs - m.parseUs);
+    }
+    const std::string &out = routeUs != 0 ? buildTracedReply(m, routeUs) : buildReply(m);
+    if (isPrivate) {
+        fanOut(pairTargets, makePrivateFrame(out, routeUs));
+    } else {
+        broadcastToSession(sessionId, out, INVALID_CONN, routeUs);
+    }
     
-    std::cout << "[MSG] " << sender << " -> " << sessionId << ": " << m.content << std::endl;
+    if (serverConfig.verbose) {
+        if (isBatch) std::cout << "[BATCH] " << sender << " -> " << sessionId << ": " << batchItems << " messages" << std::endl;
+        else std::cout << "[MSG] " << sender << " -> " << sessionId << ": " << m.content << std::endl;
+    }
+}
+//正在输入：群里记一个事件按轮合并，私聊发给对方；不是成员或没有私聊时直接忽略（不回错误，避免来回刷帧）
+void onTyping(const Message &m, ConnId clientConn){
+    (void)clientConn;
+    const std::string &sessionId = m.accepter;
+    ConnId peerConn = INVALID_CONN;
+    bool member = false;
+    {
+        MeteredLock lock(clientMutex);
+        UserId self = users.find(m.sender);
+        UserId peer = users.find(sessionId);
+        if (self != NO_USER && peer != NO_USER && privateSessions.count(PairKey(self, peer)) != 0) {
+            peerConn = onlineConnOf(sessionId);
+        } else {
+            auto it = sessions.find(sessionId);
+            member = it != sessions.end() && it->second.members.contains(self);
+        }
+    }
+    if (peerConn != INVALID_CONN) postPrivateTyping(peerConn, m.sender);
+    else if (member) postSessionEvent(sessionId, m.sender, EV_TYPING);
 }
+
+//开关本连接的会话事件推送：内容为 off 时关闭，on 时打开
+void onEvents(const Message &m, ConnId clientConn){
+    bool wanted = m.content != "off";
+    setConnEvents(clientConn, wanted);
+    Message reply{"SYS", "Server", m.sender, wanted ? "已开启会话事件推送" : "已关闭会话事件推送"};
+    sendTo(clientConn, buildReply(reply));
+}
+
+//文件传输的回复：FILE_ACK / FILE_INFO 的内容是字节数，SYS 是出错原因
+static void replyFile(ConnId clientConn, const char* type, const std::string &hash, uint64_t n){
+    Message reply{type, "Server", hash, std::to_string(n)};
+    sendTo(clientConn, buildReply(reply));
+}
+static void replyFileError(ConnId clientConn, const std::string &user, const std::string &error){
+    Message reply{"SYS", "Server", user, error};
+    sendTo(clientConn, buildReply(reply));
+}
+//上传开始或续传：回复服务器已有的字节数，已存好（同一内容传过）时直接等于大小
+void onFilePut(const Message &m, ConnId clientConn){
+    std::string error;
+    int64_t have = blobPut(m.accepter, std::strtoull(m.content.c_str(), nullptr, 10), clientConn, error);
+    if (have < 0) replyFileError(clientConn, m.sender, error);
+    else replyFile(clientConn, "FILE_ACK", m.accepter, (uint64_t)have);
+}
+//文件块：内容为 偏移|原始字节。正常写入不回复，偏移不符或收齐时回复已有字节数
+void onFileData(const Message &m, ConnId clientConn){
+    size_t bar = m.content.find('|');
+    if (bar == std::string::npos) return;
+    uint64_t offset = std::strtoull(m.content.c_str(), nullptr, 10);
+    uint64_t have = 0;
+    BlobWrite r = blobWrite(m.accepter, offset, m.content.data() + bar + 1, m.content.size() - bar - 1, have);
+    if (r == BLOB_OK) return;
+    if (r == BLOB_DONE || r == BLOB_MISMATCH) {
+        replyFile(clientConn, "FILE_ACK", m.accepter, have);
+    } else if (r == BLOB_BAD_HASH) {
+        replyFileError(clientConn, m.sender, "文件校验失败，请重新上传");
+        replyFile(clientConn, "FILE_ACK", m.accepter, 0);
+    } else {
+        replyFileError(clientConn, m.sender, "文件块写入失败，请重新声明上传");
+    }
+}
+//下载：先回复大小，再把 [偏移, 大小) 交给连接的文件通道，由 reactor 在聊天帧的空隙里分块发出
+void onFileGet(const Message &m, ConnId clientConn){
+    std::string path;
+    int64_t size = blobFind(m.accepter, path);
+    int fd = size >= 0 ? openFileRead(path) : -1;
+    if (fd < 0) {
+        replyFileError(clientConn, m.sender, blobStoreEnabled() ? "文件不存在" : "服务器未开启文件存储");
+        return;
+    }
+    uint64_t offset = std::strtoull(m.content.c_str(), nullptr, 10);
+    replyFile(clientConn, "FILE_INFO", m.accepter, (uint64_t)size);
+    if (offset >= (uint64_t)size) {
+        closeFile(fd);
+        return;
+    }
+    blobServed((uint64_t)size - offset);
+    sendFileTo(clientConn, fd, m.accepter, offset, (uint64_t)size);
+}
+
+//协商压缩：客户端的字典标识与本端相同且开启了压缩时启用，回复同一标识；否则回复 none，连接照常不压缩
+void onCompress(const Message &m, ConnId clientConn){
+    bool on = serverConfig.compressMinBytes > 0 && m.content == chatDictionaryId();
+    if (on) setConnCompress(clientConn);
+    Message reply{"COMPRESS", "Server", m.sender, on ? chatDictionaryId() : "none"};
+    sendTo(clientConn, buildReply(reply));
+}
+
 //处理Client消息的函数
-void handleMessage(const Message &m, SOCKET clientSocket){
-    if (m.type == "JOIN")           onJoin(m, clientSocket);
-    else if (m.type == "JOIN_SESSION") onJoinSession(m, clientSocket);
-    else if (m.type == "LEAVE_SESSION") onLeaveSession(m, clientSocket);
-    else if (m.type == "MSG")       onMsg(m, clientSocket);
-    else if (m.type == "EXIT")      onExit(m, clientSocket);
+void handleMessage(const Message &m, ConnId clientConn){
+    //集群模式：会话不归本节点时整条转给归属节点
+    if (clusterRoute(m, clientConn)) return;
+    if (m.type == "JOIN")           onJoin(m, clientConn);
+    else if (m.type == "JOIN_SESSION") onJoinSession(m, clientConn);
+    else if (m.type == "LEAVE_SESSION") onLeaveSession(m, clientConn);
+    else if (m.type == "MSG")       onMsg(m, clientConn);
+    else if (m.type == BATCH_TYPE)  onMsg(m, clientConn);
+    else if (m.type == "EXIT")      onExit(m, clientConn);
+    else if (m.type == "CREATE_GROUP") onCreateGroup(m, clientConn);
+    else if (m.type == "TYPING")    onTyping(m, clientConn);
+    else if (m.type == "EVENTS")    onEvents(m, clientConn);
+    else if (m.type == FILE_DATA_TYPE) onFileData(m, clientConn);
+    else if (m.type == "FILE_PUT")  onFilePut(m, clientConn);
+    else if (m.type == "FILE_GET")  onFileGet(m, clientConn);
+    else if (m.type == "COMPRESS")  onCompress(m, clientConn);
     else {
         std::cout << "[WARN] Unknown message type: " << m.type << std::endl;
     }
 }
-//定义处理Client消息的函数
-void handleClient(SOCKET clientSocket){
-    std::cout << "[SYS] handleClient thread started for socket " << clientSocket << std::endl;
-    char buffer[4096];
-    //修改接受信息逻辑,实现多次通信
+//会话类消息按会话排队（同一会话内所有人看到的顺序一致），其余消息跟随所在连接
+const std::string& messageOrderKey(const Message &m){
+    static const std::string followConn;
+    if (m.type == "MSG" || m.type == BATCH_TYPE || m.type == "JOIN_SESSION" || m.type == "LEAVE_SESSION" ||
+        m.type == "CREATE_GROUP" || m.type == "TYPING") return m.accepter;
+    return followConn;
+}
+uint64_t rateSessionKey(uint32_t user, const std::string &target){
+    if(user != NO_USER){
+        MeteredLock lock(clientMutex);
+        UserId peer=users.find(target);
+        if(peer != NO_USER && privateSessions.count(PairKey(user, peer)) != 0) return privateRateKey(PairKey(user, peer).v);
+    }
+    return groupRateKey(target);
+}
+//连接断开（未发送 EXIT 直接断线）时清理映射表
+void onDisconnect(ConnId clientConn){
+    blobConnClosed(clientConn);   // 未完成的上传关闭 .part，重连后从它的长度续传
+    std::string name;
+    {
+        MeteredLock lock(clientMutex);
+        auto it = socketUser.find(clientConn);
+        if (it == socketUser.end()) return;   // 已通过 EXIT 正常退出
+        name = it->second;
+        socketUser.erase(it);
+        auto it2 = userSocket.find(name);
+        if (it2 != userSocket.end() && it2->second == clientConn) {
+            userSocket.erase(it2);
+        }
+        UserId id = users.find(name);
+        if (id != NO_USER && users.connOf(id) == clientConn) {
+            users.setConn(id, INVALID_CONN);
+            presenceLocal(name, clientConn, false);
+        }
+    }
+    clusterUserGone(name, clientConn);
+    std::cout << "[SYS] " << name << " disconnected" << std::endl;
+}
+
+//每秒汇总各 reactor 的计数，便于比较不同 I/O 后端的吞吐与系统调用次数
+void statsThread(){
+    uint64_t lastIn = 0, lastOut = 0, lastSys = 0, lastWrites = 0;
     while (true) {
-        std::cout << "[SYS] Waiting for data..." << std::endl;
-        int bytes = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
-        std::cout << "[SYS] recv returned " << bytes << std::endl;
-        if (bytes <= 0) {
-            std::cout << "[SYS] recv returned " << bytes << ", closing connection" << std::endl;
-            break;
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        uint64_t in = 0, out = 0, sys = 0, writes = 0;
+        for (int i = 0; i < getReactorCount(); i++) {
+            Reactor* r = getReactor(i);
+            in += r->framesIn.load();
+            out += r->framesOut.load();
+            sys += r->syscallCount();
+            writes += r->writeCount();
         }
-        buffer[bytes] = '\0';
-        /*recv() 是应用层与传输层的边界操作，取出 TCP 接收窗口内的数据段。数据可能被拆包/粘包，因此应用层需自行定义消息边界（后续协议设计要考虑）。*/
-        std::string msg(buffer);
-        std::cout << "[SYS] Received raw message: [" << msg << "]" << std::endl;
-        Message m = parseMessage(msg);
-        std::cout << "[SYS] Parsed - Type:[" << m.type << "] Sender:[" << m.sender << "] Accepter:[" << m.accepter << "] Content:[" << m.content << "]" << std::endl;
-        std::cout << "[SYS] Calling handleMessage..." << std::endl;
-        handleMessage(m,clientSocket);
-        std::cout << "[SYS] handleMessage returned" << std::endl;
-        if (m.type == "EXIT") {
-            break;  // onExit 已在 handleMessage 中调用，无需重复
+        HandlerPool* pool = getHandlerPool();
+        uint64_t dIn = in - lastIn, dOut = out - lastOut, dSys = sys - lastSys, dWrites = writes - lastWrites;
+        if (dIn + dOut > 0) {
+            //writes/msg：每条送达消息平均花费的发送类系统调用次数
+            std::cout << "[STATS] in=" << dIn << "/s out=" << dOut << "/s syscalls=" << dSys
+                      << "/s syscalls/frame=" << (double)dSys / (double)(dIn + dOut)
+                      << " writes/msg=" << (dOut > 0 ? (double)dWrites / (double)dOut : 0.0);
+            if (pool != nullptr) std::cout << " queued=" << pool->queuedJobs() << " steals=" << pool->steals.load();
+            std::cout << std::endl;
         }
+        lastIn = in;
+        lastOut = out;
+        lastSys = sys;
+        lastWrites = writes;
     }
-    std::cout << "[SYS] Exiting handleClient, closing socket " << clientSocket << std::endl;
-    closesocket(clientSocket);//先关闭客户端套接字
-    std::cout << "[SYS] handleClient thread ended" << std::endl;
 }
 
-int main(){
+//解析启动参数：Server.exe [-r 线程数] [-w 处理线程数] [-p 端口] [--io 后端] [--cork-us 微秒] [--metrics-port 端口] [--admin-port 端口]
+//                [--unix 路径] [--shm 路径] [--handoff 路径] [--drain-seconds 秒] [--state-dir 目录] [--snapshot-seconds 秒]
+//                [--cluster host:port,... --node 编号] [--event-tick-ms 毫秒] [--blob-dir 目录] [--compress-min 字节]
+//                [--rate-user 条/秒] [--burst-user 条] [--rate-session 条/秒] [--burst-session 条] [--throttle warn|drop|delay] [--stats] [-q]
+static void parseArgs(int argc, char* argv[]){
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-r" || arg == "--reactors") && i + 1 < argc) {
+            serverConfig.reactors = std::atoi(argv[++i]);
+        } else if ((arg == "-w" || arg == "--workers") && i + 1 < argc) {
+            serverConfig.workers = std::atoi(argv[++i]);
+        } else if ((arg == "-p" || arg == "--port") && i + 1 < argc) {
+            serverConfig.port = (unsigned short)std::atoi(argv[++i]);
+        } else if (arg == "--io" && i + 1 < argc) {
+            serverConfig.ioBackend = argv[++i];
+        } else if (arg == "--cork-us" && i + 1 < argc) {
+            serverConfig.corkUs = std::atoi(argv[++i]);
+        } else if (arg == "--metrics-port" && i + 1 < argc) {
+            serverConfig.metricsPort = (unsigned short)std::atoi(argv[++i]);
+        } else if (arg == "--admin-port" && i + 1 < argc) {
+            serverConfig.adminPort = (unsigned short)std::atoi(argv[++i]);
+        } else if (arg == "--unix" && i + 1 < argc) {
+            serverConfig.unixPath = argv[++i];
+        } else if (arg == "--shm" && i + 1 < argc) {
+            serverConfig.shmPath = argv[++i];
+        } else if (arg == "--cluster" && i + 1 < argc) {
+            serverConfig.clusterNodes = argv[++i];
+        } else if (arg == "--node" && i + 1 < argc) {
+            serverConfig.nodeIndex = std::atoi(argv[++i]);
+        } else if (arg == "--event-tick-ms" && i + 1 < argc) {
+            serverConfig.eventTickMs = std::atoi(argv[++i]);
+        } else if (arg == "--blob-dir" && i + 1 < argc) {
+            serverConfig.blobDir = argv[++i];
+        } else if (arg == "--compress-min" && i + 1 < argc) {
+            serverConfig.compressMinBytes = std::atoi(argv[++i]);
+        } else if (arg == "--handoff" && i + 1 < argc) {
+            serverConfig.handoffPath = argv[++i];
+        } else if (arg == "--drain-seconds" && i + 1 < argc) {
+            serverConfig.drainSeconds = std::atoi(argv[++i]);
+        } else if (arg == "--state-dir" && i + 1 < argc) {
+            serverConfig.stateDir = argv[++i];
+        } else if (arg == "--snapshot-seconds" && i + 1 < argc) {
+            serverConfig.snapshotSeconds = std::atoi(argv[++i]);
+        } else if (arg == "--rate-user" && i + 1 < argc) {
+            serverConfig.rateLimit.userRate = std::atof(argv[++i]);
+        } else if (arg == "--burst-user" && i + 1 < argc) {
+            serverConfig.rateLimit.userBurst = std::atoi(argv[++i]);
+        } else if (arg == "--rate-session" && i + 1 < argc) {
+            serverConfig.rateLimit.sessionRate = std::atof(argv[++i]);
+        } else if (arg == "--burst-session" && i + 1 < argc) {
+            serverConfig.rateLimit.sessionBurst = std::atoi(argv[++i]);
+        } else if (arg == "--throttle" && i + 1 < argc) {
+            std::string action = argv[++i];
+            if (!parseThrottleAction(action, serverConfig.rateLimit.action)) {
+                std::cout << "[WARN] Unknown throttle action: " << action << " (warn|drop|delay)" << std::endl;
+            }
+        } else if (arg == "--stats") {
+            serverConfig.stats = true;
+        } else if (arg == "-q" || arg == "--quiet") {
+            serverConfig.verbose = false;
+        } else {
+            std::cout << "[WARN] Unknown argument: " << arg << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]){
     //设置控制台支持中文
-    SetConsoleOutputCP(65001); // 设置控制台输出为 UTF-8 编码
+    setupConsole(); // 控制台使用 UTF-8 编码
+    parseArgs(argc, argv);
     //初始化阶段属于 Socket API 的系统级准备
-    WSADATA wsaData;
-    int res=WSAStartup(MAKEWORD(2,2),&wsaData);
-    if(res!=0){
+    if(!netStartup()){
         std::cout<<"Load WSA failed"<<std::endl;
         return 1;
     }
-    SOCKET serverSocket=socket(AF_INET,SOCK_STREAM,0);
-    //创建退出线程
-    std::thread exitThread(exitThread,serverSocket);
-    exitThread.detach(); //分离退出线程
-    if(serverSocket==INVALID_SOCKET){
-        std::cout<<"Create Socket failed"<<std::endl;
+    /*每个 reactor 线程拥有独立的监听套接字（SO_REUSEPORT）、独立的 epoll/select 和连接集合，
+      取代原先“一个 accept 循环 + 每个客户端一个线程”的模型。*/
+    //消息处理与 I/O 分离：reactor 拆帧后把消息交给处理池，按会话串行执行
+    int workers = serverConfig.workers;
+    if (workers < 0) {
+        workers = (int)std::thread::hardware_concurrency();
+        if (workers <= 0) workers = 1;
+    }
+    startHandlerPool(workers);
+    //加入、离开、下线、正在输入按会话每轮合并成一帧
+    startSessionEvents(serverConfig.eventTickMs);
+    //入口限流：在 reactor 拆帧后立即检查，未配置时不生效
+    configureRateLimit(serverConfig.rateLimit);
+    if(rateLimitEnabled()){
+        const RateLimitConfig &rl = rateLimitConfig();
+        std::cout<<"[SYS] Rate limit: user "<<rl.userRate<<"/s (burst "<<rl.userBurst<<"), session "<<rl.sessionRate
+                 <<"/s (burst "<<rl.sessionBurst<<"), over limit: "<<throttleActionName(rl.action)<<std::endl;
+    }
+    //热重启：有旧进程在交接路径上等待时，接管它的监听套接字和会话表
+    std::vector<SOCKET> inherited;
+    bool tookOver = false;
+    if(!serverConfig.handoffPath.empty()){
+        tookOver = takeOverFrom(serverConfig.handoffPath, inherited);
+    }
+    //冷启动：从快照和变更日志恢复会话表；接管时会话表已由旧进程传来，不再读磁盘
+    if(!serverConfig.stateDir.empty()){
+        size_t restored = 0;
+        if(!tookOver && !loadServerState(serverConfig.stateDir, restored)){
+            std::cout<<"[SYS] No saved state in "<<serverConfig.stateDir<<", starting empty"<<std::endl;
+        }
+        if(!startStatePersistence(serverConfig.stateDir, serverConfig.snapshotSeconds)){
+            std::cout<<"[WARN] State directory "<<serverConfig.stateDir<<" unavailable, sessions will not be saved"<<std::endl;
+        }
+    }
+    //大文件：按摘要存放在 blobDir，分块上传、去重、续传，下载走连接的文件通道
+    if(!serverConfig.blobDir.empty()){
+        if(startBlobStore(serverConfig.blobDir)) std::cout<<"[SYS] File store: "<<serverConfig.blobDir<<std::endl;
+        else std::cout<<"[WARN] File store directory "<<serverConfig.blobDir<<" unavailable, file transfer disabled"<<std::endl;
+    }
+    if(!startReactors(serverConfig.reactors, serverConfig.port, serverConfig.ioBackend, inherited)){
+        std::cout<<"Start reactors failed"<<std::endl;
+        netCleanup();
         return 1;
-        //验证套接字是否创建成功
-    }
-    //绑定套接字
-    sockaddr_in serverAddr{};
-    serverAddr.sin_family=AF_INET;//地址簇为ipv4
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(8888);
-    bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr));
-    /*该调用与 TCP 四元组中的“源地址与源端口”关联，确立服务器的传输层标识符(源IP, 源Port, ANY目标IP, ANY目标Port)。系统随后能根据目的端口匹配到此监器。*/
-    //监听
-    listen(serverSocket,SOMAXCONN); //开始监听传入连接请求
-    std::cout<<"Server is listening on port 8888..."<<std::endl;
-    //接受Client的链接
-    std::cout<<"Waiting for client connection..."<<std::endl;
-    //接受消息
-    while(true){
-
-        sockaddr_in clientAddr{};
-        int clientAddrLen=sizeof(clientAddr);
-        SOCKET clientSocket=accept(serverSocket,(sockaddr*)&clientAddr,&clientAddrLen);
-        if(clientSocket==INVALID_SOCKET){
-            std::cout<<"Accept failed"<<std::endl;
+    }
+    std::cout<<"Server is listening on port "<<serverConfig.port<<" with "<<getReactorCount()<<" reactors ("<<getReactor(0)->backendName()<<"), "<<workers<<" handler workers..."<<std::endl;
+    //同机的机器人、网关走 Unix 域套接字，与 TCP 连接共用 reactor、会话表和扇出路径
+    if(!serverConfig.unixPath.empty()){
+        if(startUnixListener(serverConfig.unixPath)){
+            std::cout<<"Also listening on unix socket "<<serverConfig.unixPath<<std::endl;
+        }else{
+            std::cout<<"[WARN] Unix socket "<<serverConfig.unixPath<<" unavailable"<<std::endl;
+        }
+    }
+    //同机的机器人进程还可以走共享内存环，稳定负载下收发不进内核
+    if(!serverConfig.shmPath.empty()){
+        if(startShmListener(serverConfig.shmPath)){
+            std::cout<<"Shared-memory transport on "<<serverConfig.shmPath<<std::endl;
+        }else{
+            std::cout<<"[WARN] Shared-memory socket "<<serverConfig.shmPath<<" unavailable"<<std::endl;
+        }
+    }
+    //多节点：会话按一致性哈希归属到唯一节点，其它节点把请求转过去
+    if(!serverConfig.clusterNodes.empty()){
+        if(startCluster(serverConfig.clusterNodes, serverConfig.nodeIndex)){
+            std::cout<<"Cluster node "<<clusterSelf()<<" of "<<clusterSize()<<std::endl;
+        }else{
+            std::cout<<"[WARN] Cluster disabled, running standalone"<<std::endl;
         }
-        //建立连接后多线程处理消息
-        std::thread clientThread(handleClient, clientSocket);
-        clientThread.detach();  // 分离线程
     }
-    exitThread.join();
+    if(serverConfig.stats){
+        std::thread(statsThread).detach();
+    }
+    //指标单独走本机 HTTP 端口，不占用聊天端口
+    if(serverConfig.metricsPort != 0){
+        if(startMetricsServer(serverConfig.metricsPort)){
+            std::cout<<"Metrics at http://127.0.0.1:"<<serverConfig.metricsPort<<"/metrics"<<std::endl;
+        }else{
+            std::cout<<"[WARN] Metrics port "<<serverConfig.metricsPort<<" unavailable"<<std::endl;
+        }
+    }
+    //之后的升级：等待下一个进程来接班
+    if(!serverConfig.handoffPath.empty()){
+        if(startHandoffListener(serverConfig.handoffPath)){
+            std::cout<<"Handoff socket at "<<serverConfig.handoffPath<<std::endl;
+        }else{
+            std::cout<<"[WARN] Handoff socket "<<serverConfig.handoffPath<<" unavailable"<<std::endl;
+        }
+    }
+    if(serverConfig.adminPort != 0){
+        if(startAdminServer(serverConfig.adminPort)){
+            std::cout<<"Admin console on 127.0.0.1:"<<serverConfig.adminPort<<std::endl;
+        }else{
+            std::cout<<"[WARN] Admin port "<<serverConfig.adminPort<<" unavailable"<<std::endl;
+        }
+    }
+    //控制台线程：读取 stdin 上的管理命令（输入 help 查看）
+    std::thread console(consoleThread);
+    console.detach();
+    joinReactors();
+    //reactor 已全部退出，不会再有新的客户端任务；处理池把排队和挂起的任务全部做完后再清理网络库
+    if(HandlerPool* pool = getHandlerPool()) pool->stop();
     std::cout<<"server has been closed"<<std::endl;
-    // closesocket(serverSocket);//后关闭服务器套接字
-    // WSACleanup();//关闭windows socket环境
+    netCleanup();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,142 @@
+#include "../include/SessionEvents.h"
+#include "../include/Server.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+static const size_t EVENTS_MAX_CONTENT = 8 * 1024;   // 一帧里事件部分的上限，超出的拆成多帧
+
+// 一个用户在本轮里的变化
+struct UserEvents {
+    char first = 0;         // 本轮第一次成员变化（j / l / o），0 表示没有
+    char last = 0;          // 本轮最后一次成员变化
+    bool typing = false;
+};
+
+// 一个会话本轮的待发事件
+struct PendingSession {
+    std::vector<std::string> order;                     // 用户第一次出现的顺序
+    std::unordered_map<std::string, UserEvents> users;
+};
+
+static std::mutex eventsLock;
+static std::map<std::string, PendingSession> pending;
+static std::set<std::pair<ConnId, std::string>> pendingTyping;   // 私聊：(对方的连接, 正在输入的人)
+static std::atomic<int> eventTickMs{0};
+
+static std::atomic<uint64_t> eventsPosted{0};
+static std::atomic<uint64_t> eventsSent{0};
+static std::atomic<uint64_t> eventsCancelled{0};
+static std::atomic<uint64_t> eventFrames{0};
+
+static void sendSessionEvents(const std::string& sessionId, const std::string& content) {
+    Message m{"EVENTS", "Server", sessionId, content};
+    broadcastToSession(sessionId, buildMessage(m), INVALID_CONN);
+    eventFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void appendEvent(const std::string& sessionId, std::string& content, char kind, const std::string& user) {
+    if (!content.empty() && content.size() + user.size() + 3 > EVENTS_MAX_CONTENT) {
+        sendSessionEvents(sessionId, content);
+        content.clear();
+    }
+    if (!content.empty()) content += ',';
+    content += kind;
+    content += ':';
+    content += user;
+    eventsSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void flushSession(const std::string& sessionId, PendingSession& ps) {
+    std::string content;
+    for (const std::string& name : ps.order) {
+        const UserEvents& u = ps.users[name];
+        bool present = true;
+        if (u.last != 0) {
+            // 本轮之前和之后的成员状态相同（加入又离开、离开又加入）：别人看不出变化，不发
+            if ((u.first == EV_JOIN) != (u.last == EV_JOIN)) eventsCancelled.fetch_add(1, std::memory_order_relaxed);
+            else appendEvent(sessionId, content, u.last, name);
+            present = u.last == EV_JOIN;
+        }
+        if (u.typing && present) appendEvent(sessionId, content, EV_TYPING, name);
+    }
+    if (!content.empty()) sendSessionEvents(sessionId, content);
+}
+
+static void sendPrivateTyping(ConnId peerConn, const std::string& from) {
+    Message m{"EVENTS", "Server", from, std::string(1, (char)EV_TYPING) + ":" + from};
+    sendTo(peerConn, buildMessage(m));
+    eventsSent.fetch_add(1, std::memory_order_relaxed);
+    eventFrames.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 取走本轮的全部事件，锁外逐个会话发出
+static void flushEvents() {
+    std::map<std::string, PendingSession> sessionsNow;
+    std::set<std::pair<ConnId, std::string>> typingNow;
+    {
+        std::lock_guard<std::mutex> lk(eventsLock);
+        sessionsNow.swap(pending);
+        typingNow.swap(pendingTyping);
+    }
+    for (auto& [id, ps] : sessionsNow) flushSession(id, ps);
+    for (const auto& [conn, from] : typingNow) sendPrivateTyping(conn, from);
+}
+
+static void eventsLoop() {
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(eventTickMs.load()));
+        flushEvents();
+    }
+}
+
+void startSessionEvents(int tickMs) {
+    eventTickMs = tickMs > 0 ? tickMs : 0;
+    if (eventTickMs > 0) std::thread(eventsLoop).detach();
+}
+
+void postSessionEvent(const std::string& sessionId, const std::string& user, SessionEventKind kind) {
+    eventsPosted.fetch_add(1, std::memory_order_relaxed);
+    if (eventTickMs == 0) {
+        std::string content;
+        appendEvent(sessionId, content, (char)kind, user);
+        sendSessionEvents(sessionId, content);
+        return;
+    }
+    std::lock_guard<std::mutex> lk(eventsLock);
+    PendingSession& ps = pending[sessionId];
+    auto it = ps.users.find(user);
+    if (it == ps.users.end()) {
+        ps.order.push_back(user);
+        it = ps.users.emplace(user, UserEvents()).first;
+    }
+    UserEvents& u = it->second;
+    if (kind == EV_TYPING) {
+        u.typing = true;
+    } else {
+        if (u.first == 0) u.first = (char)kind;
+        u.last = (char)kind;
+        u.typing = false;   // 加入、离开之前的输入状态作废
+    }
+}
+
+void postPrivateTyping(ConnId peerConn, const std::string& from) {
+    eventsPosted.fetch_add(1, std::memory_order_relaxed);
+    if (eventTickMs == 0) {
+        sendPrivateTyping(peerConn, from);
+        return;
+    }
+    std::lock_guard<std::mutex> lk(eventsLock);
+    pendingTyping.emplace(peerConn, from);
+}
+
+void describeSessionEvents(std::ostream& os) {
+    os << "events: tick " << eventTickMs.load() << "ms, posted " << eventsPosted.load() << ", sent " << eventsSent.load()
+       << " (cancelled " << eventsCancelled.load() << ") in " << eventFrames.load() << " frames\n";
+}
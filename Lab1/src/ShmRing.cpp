@@ -0,0 +1,238 @@
+#include "../include/ShmRing.h"
+#include "../include/Common.h"
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <new>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static size_t regionBytes(size_t ringBytes) {
+    return sizeof(ShmRegion) + 2 * ringBytes;
+}
+
+static char* ringData(ShmRegion* r, int which) {
+    return (char*)r + sizeof(ShmRegion) + (size_t)which * r->ringBytes;
+}
+
+void notifyEvent(int fd) {
+    uint64_t one = 1;
+    ssize_t r = write(fd, &one, sizeof(one));
+    (void)r;
+}
+
+ShmLink::~ShmLink() {
+    if (region != nullptr) munmap(region, regionSize);
+    if (clientEvent >= 0) close(clientEvent);
+}
+
+// 一次 sendmsg 传出一个字节和 count 个描述符
+static bool sendFds(int s, const int* fds, int count) {
+    char byte = 'S';
+    iovec iov{&byte, 1};
+    char ctrl[CMSG_SPACE(sizeof(int) * 4)];
+    memset(ctrl, 0, sizeof(ctrl));
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cm), fds, sizeof(int) * count);
+    return sendmsg(s, &msg, MSG_NOSIGNAL) == 1;
+}
+
+static bool recvFds(int s, int* fds, int count) {
+    char byte;
+    iovec iov{&byte, 1};
+    char ctrl[CMSG_SPACE(sizeof(int) * 4)];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    if (recvmsg(s, &msg, MSG_CMSG_CLOEXEC) != 1) return false;
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    if (cm == nullptr || cm->cmsg_type != SCM_RIGHTS || cm->cmsg_len != CMSG_LEN(sizeof(int) * count)) return false;
+    memcpy(fds, CMSG_DATA(cm), sizeof(int) * count);
+    return true;
+}
+
+std::shared_ptr<ShmLink> acceptShmLink(SOCKET ctl, int serverWake) {
+    std::shared_ptr<ShmLink> link = std::make_shared<ShmLink>();
+    size_t size = regionBytes(SHM_RING_BYTES);
+    int memfd = memfd_create("chat-shm", MFD_CLOEXEC);
+    if (memfd < 0) return nullptr;
+    if (ftruncate(memfd, (off_t)size) != 0) {
+        close(memfd);
+        return nullptr;
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (p == MAP_FAILED) {
+        close(memfd);
+        return nullptr;
+    }
+    ShmRegion* region = new (p) ShmRegion();   // 新建的 memfd 全为 0，原子量的初值即为 0
+    region->magic = SHM_MAGIC;
+    region->ringBytes = (uint32_t)SHM_RING_BYTES;
+    link->region = region;
+    link->regionSize = size;
+    link->up = ShmRing(&region->up, ringData(region, 0), SHM_RING_BYTES);
+    link->down = ShmRing(&region->down, ringData(region, 1), SHM_RING_BYTES);
+    link->clientEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (link->clientEvent < 0) {
+        close(memfd);
+        return nullptr;
+    }
+    int fds[3] = {memfd, link->clientEvent, serverWake};
+    bool ok = sendFds(ctl, fds, 3);
+    close(memfd);   // 映射保留，描述符已经交给客户端
+    return ok ? link : nullptr;
+}
+
+// ========== 客户端 ==========
+
+ShmClient::~ShmClient() {
+    close();
+}
+
+bool ShmClient::connect(const std::string& path) {
+    ctl = connectUnix(path);
+    if (ctl < 0) return false;
+    int fds[3];
+    if (!recvFds(ctl, fds, 3)) {
+        close();
+        return false;
+    }
+    event = fds[1];
+    serverWake = fds[2];
+    struct stat st;
+    if (fstat(fds[0], &st) != 0 || (size_t)st.st_size < sizeof(ShmRegion)) {
+        ::close(fds[0]);
+        close();
+        return false;
+    }
+    regionSize = (size_t)st.st_size;
+    void* p = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    ::close(fds[0]);
+    if (p == MAP_FAILED) {
+        close();
+        return false;
+    }
+    region = (ShmRegion*)p;
+    if (region->magic != SHM_MAGIC || regionBytes(region->ringBytes) != regionSize) {
+        close();
+        return false;
+    }
+    up = ShmRing(&region->up, ringData(region, 0), region->ringBytes);
+    down = ShmRing(&region->down, ringData(region, 1), region->ringBytes);
+    int flags = fcntl(event, F_GETFL, 0);
+    fcntl(event, F_SETFL, flags | O_NONBLOCK);
+    return true;
+}
+
+void ShmClient::close() {
+    if (region != nullptr) munmap(region, regionSize);
+    region = nullptr;
+    if (ctl >= 0) ::close(ctl);
+    if (event >= 0) ::close(event);
+    if (serverWake >= 0) ::close(serverWake);
+    ctl = event = serverWake = -1;
+}
+
+bool ShmClient::waitEvent(int timeoutMs) {
+    pollfd pfd[2] = {{event, POLLIN, 0}, {ctl, POLLIN, 0}};
+    int n = ::poll(pfd, 2, timeoutMs);
+    if (n > 0 && (pfd[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+        char b;
+        if (::recv(ctl, &b, 1, MSG_DONTWAIT) <= 0) return false;   // 服务器已关闭连接
+    }
+    if (n > 0 && (pfd[0].revents & POLLIN)) {
+        uint64_t v;
+        ssize_t r = read(event, &v, sizeof(v));
+        (void)r;
+    }
+    return true;
+}
+
+bool ShmClient::send(const char* payload, size_t len) {
+    if (region == nullptr || FRAME_HEADER_SIZE + len > region->ringBytes) return false;
+    while (!up.appendFrame(payload, len)) {
+        // 环满：登记等空间，服务器读走数据后会写 eventfd
+        uint64_t since = up.consumed();
+        if (up.prepareWaitSpace(since) && !waitEvent(100)) return false;
+        up.endWaitSpace();
+    }
+    if (up.publish()) {
+        notifyEvent(serverWake);
+        notifies++;
+    }
+    return true;
+}
+
+long ShmClient::recv(char* out, size_t cap, int timeoutMs) {
+    if (region == nullptr) return -1;
+    while (true) {
+        const char* p1;
+        const char* p2;
+        size_t n1, n2;
+        size_t avail = down.peek(p1, n1, p2, n2);
+        if (avail > 0) {
+            size_t take1 = n1 < cap ? n1 : cap;
+            size_t take2 = n2 < cap - take1 ? n2 : cap - take1;
+            memcpy(out, p1, take1);
+            memcpy(out + take1, p2, take2);
+            if (down.consume(take1 + take2)) {
+                notifyEvent(serverWake);   // 服务器在等空间
+                notifies++;
+            }
+            return (long)(take1 + take2);
+        }
+        if (timeoutMs == 0) return 0;
+        if (down.prepareWait()) {
+            bool alive = waitEvent(timeoutMs);
+            down.endWait();
+            if (!alive) return -1;
+            timeoutMs = 0;   // 醒来后再看一次，仍然没有就算超时
+        }
+    }
+}
+
+#else
+
+void notifyEvent(int) {}
+
+ShmLink::~ShmLink() {}
+
+std::shared_ptr<ShmLink> acceptShmLink(SOCKET, int) {
+    return nullptr;
+}
+
+ShmClient::~ShmClient() {}
+
+bool ShmClient::connect(const std::string&) {
+    return false;
+}
+
+void ShmClient::close() {}
+
+bool ShmClient::waitEvent(int) {
+    return false;
+}
+
+bool ShmClient::send(const char*, size_t) {
+    return false;
+}
+
+long ShmClient::recv(char*, size_t, int) {
+    return -1;
+}
+
+#endif // __linux__
@@ -0,0 +1,521 @@
+#include "../include/StateStore.h"
+#include "../include/Metrics.h"
+#include "../include/Server.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+static const char SNAP_MAGIC[4] = {'C', 'S', 'N', 'P'};
+static const char SNAP_END[4] = {'C', 'E', 'N', 'D'};   // 缺少结尾标记说明快照没写完整
+static const uint32_t SNAP_VERSION = 3;
+static const char* SNAP_NAME = "sessions.snap";
+static const char* JOURNAL_PREFIX = "journal.";
+static const int FLUSH_INTERVAL_MS = 100;   // 日志缓冲落盘间隔：进程崩溃最多丢失这么久的变更
+
+// 日志记录：1 字节操作码，之后是会话名与参数
+enum JournalOp : uint8_t {
+    J_CREATE = 1,   // 会话名 + 1 字节类型（成员清空）
+    J_DROP = 2,     // 会话名
+    J_ADD = 3,      // 会话名 + 用户名
+    J_DEL = 4,      // 会话名 + 用户名
+    J_PAIR_ADD = 5, // 用户名 + 用户名（建立私聊）
+    J_PAIR_DEL = 6, // 用户名 + 用户名（删除私聊）
+};
+
+static std::string stateDir;
+static std::atomic<bool> persisting{false};
+static std::mutex journalMutex;              // 保护 journalBuf、journalGen（在 clientMutex 内获取）
+static std::string journalBuf;               // 尚未落盘的日志记录
+static uint64_t journalGen = 1;              // 新记录所属的日志代号
+static std::atomic<uint64_t> changes{0};     // 上次快照以来的变更数
+static std::mutex ioMutex;                   // 日志与快照的文件操作串行执行
+static FILE* journalFile = nullptr;
+static uint64_t journalFileGen = 0;
+
+// ========== 编码 ==========
+
+static void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+static void putString(std::string& out, const std::string& s) {
+    putVarint(out, s.size());
+    out.append(s);
+}
+
+static void putFixed(std::string& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back((char)(v >> (8 * i)));   // 小端
+}
+
+// 顺序读取；越界时 ok 置 false，之后的读取都失败
+struct Reader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    bool more() const { return ok && p < end; }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) break;
+            uint8_t b = (uint8_t)*p++;
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    uint64_t fixed(int bytes) {
+        if (end - p < bytes) {
+            ok = false;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v |= (uint64_t)(uint8_t)p[i] << (8 * i);
+        p += bytes;
+        return v;
+    }
+
+    void string(std::string& s) {
+        uint64_t n = varint();
+        if (!ok || (uint64_t)(end - p) < n) {
+            ok = false;
+            return;
+        }
+        s.assign(p, (size_t)n);
+        p += n;
+    }
+};
+
+// ========== 文件 ==========
+
+static std::string pathOf(const std::string& name) {
+    return (fs::path(stateDir) / name).string();
+}
+
+static std::string journalName(uint64_t gen) {
+    return JOURNAL_PREFIX + std::to_string(gen);
+}
+
+static bool readFile(const std::string& path, std::string& data) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) return false;
+    char buf[1 << 16];
+    size_t n;
+    data.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+// 目录中已有的日志代号（升序）
+static std::vector<uint64_t> listJournals() {
+    std::vector<uint64_t> gens;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(stateDir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, strlen(JOURNAL_PREFIX), JOURNAL_PREFIX) != 0) continue;
+        char* endp = nullptr;
+        uint64_t gen = std::strtoull(name.c_str() + strlen(JOURNAL_PREFIX), &endp, 10);
+        if (endp != nullptr && *endp == '\0' && gen > 0) gens.push_back(gen);
+    }
+    std::sort(gens.begin(), gens.end());
+    return gens;
+}
+
+// ========== 加载 ==========
+
+// 加载中的状态：群会话按会话名，私聊按两人的编号对
+struct LoadedState {
+    std::map<std::string, ServerSession> sessions;
+    std::unordered_set<PairKey, PairKeyHash> pairs;
+};
+
+// 调用方持有 clientMutex（用户名要登记到 users）
+static bool parseSnapshot(const std::string& data, LoadedState& out, uint64_t& firstGen) {
+    Reader r{data.data(), data.data() + data.size()};
+    if (data.size() < 4 || memcmp(data.data(), SNAP_MAGIC, 4) != 0) return false;
+    r.p += 4;
+    uint32_t version = (uint32_t)r.fixed(4);
+    if (version < 1 || version > SNAP_VERSION) return false;
+    firstGen = r.fixed(8);
+    // 版本 2：先是用户表，成员用表中的下标（升序、差值编码）；版本 1：成员直接写用户名
+    std::vector<UserId> userMap;
+    std::string id, name;
+    if (version >= 2) {
+        uint64_t userCount = r.fixed(8);
+        userMap.reserve((size_t)std::min<uint64_t>(userCount, data.size()));
+        for (uint64_t i = 0; i < userCount && r.ok; i++) {
+            r.string(name);
+            userMap.push_back(users.intern(name));
+        }
+    }
+    uint64_t count = r.fixed(8);
+    std::vector<UserId> ids;
+    for (uint64_t i = 0; i < count && r.ok; i++) {
+        int type = (int)r.fixed(1);
+        r.string(id);
+        uint64_t members = r.varint();
+        ids.clear();
+        uint64_t index = 0;
+        for (uint64_t k = 0; k < members && r.ok; k++) {
+            if (version >= 2) {
+                index += r.varint();
+                if (index >= userMap.size()) r.ok = false;
+                else ids.push_back(userMap[index]);
+            } else {
+                r.string(name);
+                ids.push_back(users.intern(name));
+            }
+        }
+        // 快照按会话名升序写出，插入时带提示，加载是线性的
+        auto it = out.sessions.emplace_hint(out.sessions.end(), id, ServerSession{});
+        ServerSession& sess = it->second;
+        sess.id = id;
+        sess.type = (type == ST_PRIVATE) ? ST_PRIVATE : ST_GROUP;
+        sess.members.assign(std::move(ids));
+        ids = std::vector<UserId>();
+    }
+    // 版本 3：私聊单独一段，编号对升序排列，按差值写 varint
+    if (version >= 3) {
+        uint64_t pairCount = r.fixed(8);
+        uint64_t key = 0;
+        out.pairs.reserve((size_t)std::min<uint64_t>(pairCount, data.size()));
+        for (uint64_t i = 0; i < pairCount && r.ok; i++) {
+            key += r.varint();
+            PairKey pair;
+            pair.v = key;
+            // 写入时总是 lo <= hi；损坏或截断的快照两者都要检查，不能只看 hi
+            if (pair.lo() > pair.hi() || pair.hi() >= userMap.size()) r.ok = false;
+            else out.pairs.insert(PairKey(userMap[pair.lo()], userMap[pair.hi()]));
+        }
+    }
+    return r.ok && r.end - r.p == 4 && memcmp(r.p, SNAP_END, 4) == 0;
+}
+
+// 重放一个日志文件；末尾不完整的记录（写到一半时崩溃）直接忽略。调用方持有 clientMutex
+static size_t replayJournal(const std::string& data, LoadedState& state) {
+    std::map<std::string, ServerSession>& out = state.sessions;
+    Reader r{data.data(), data.data() + data.size()};
+    std::string id, user;
+    size_t applied = 0;
+    while (r.more()) {
+        uint8_t op = (uint8_t)r.fixed(1);
+        r.string(id);
+        if (op == J_CREATE) {
+            int type = (int)r.fixed(1);
+            if (!r.ok) break;
+            ServerSession& sess = out[id];
+            sess.id = id;
+            sess.type = (type == ST_PRIVATE) ? ST_PRIVATE : ST_GROUP;
+            sess.members.clear();
+        } else if (op == J_DROP) {
+            if (!r.ok) break;
+            out.erase(id);
+        } else if (op == J_ADD || op == J_DEL) {
+            r.string(user);
+            if (!r.ok) break;
+            if (op == J_ADD) {
+                ServerSession& sess = out[id];
+                sess.id = id;
+                sess.members.insert(users.intern(user));
+            } else {
+                auto it = out.find(id);
+                if (it != out.end()) it->second.members.erase(users.find(user));
+            }
+        } else if (op == J_PAIR_ADD || op == J_PAIR_DEL) {
+            r.string(user);
+            if (!r.ok) break;
+            if (op == J_PAIR_ADD) {
+                state.pairs.insert(PairKey(users.intern(id), users.intern(user)));
+            } else {
+                UserId a = users.find(id), b = users.find(user);
+                if (a != NO_USER && b != NO_USER) state.pairs.erase(PairKey(a, b));
+            }
+        } else {
+            break;   // 无法识别的记录，后面的内容不可信
+        }
+        applied++;
+    }
+    return applied;
+}
+
+// 旧格式的私聊以对方用户名为会话名，成员里除对方以外的每个人都与对方构成一个私聊
+static void upgradeLegacyPrivate(LoadedState& state) {
+    for (auto it = state.sessions.begin(); it != state.sessions.end();) {
+        if (it->second.type != ST_PRIVATE) {
+            ++it;
+            continue;
+        }
+        UserId peer = users.intern(it->first);
+        for (UserId member : it->second.members) {
+            if (member != peer) state.pairs.insert(PairKey(peer, member));
+        }
+        it = state.sessions.erase(it);
+    }
+}
+
+bool loadServerState(const std::string& dir, size_t& sessionCount) {
+    auto t0 = std::chrono::steady_clock::now();
+    stateDir = dir;
+    // 启动时加载，还没开始服务，整个过程持锁即可
+    MeteredLock lock(clientMutex);
+    LoadedState loaded;
+    uint64_t firstGen = 0;
+    bool found = false;
+    std::string data;
+    if (readFile(pathOf(SNAP_NAME), data)) {
+        if (parseSnapshot(data, loaded, firstGen)) {
+            found = true;
+        } else {
+            std::cout << "[WARN] Snapshot " << pathOf(SNAP_NAME) << " is damaged, ignoring it" << std::endl;
+            loaded = LoadedState();
+            firstGen = 0;
+        }
+    }
+    size_t records = 0;
+    for (uint64_t gen : listJournals()) {
+        if (gen < firstGen || !readFile(pathOf(journalName(gen)), data)) continue;
+        records += replayJournal(data, loaded);
+        found = true;
+    }
+    if (!found) return false;
+    upgradeLegacyPrivate(loaded);
+
+    sessionCount = loaded.sessions.size() + loaded.pairs.size();
+    if (sessions.empty()) {
+        sessions.swap(loaded.sessions);
+    } else {
+        for (auto& [id, sess] : loaded.sessions) sessions[id] = std::move(sess);
+    }
+    if (privateSessions.empty()) {
+        privateSessions.swap(loaded.pairs);
+    } else {
+        privateSessions.insert(loaded.pairs.begin(), loaded.pairs.end());
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "[SYS] Restored " << sessionCount << " sessions from " << dir << " (" << records
+              << " journal records) in " << ms << "ms" << std::endl;
+    return true;
+}
+
+// ========== 日志 ==========
+
+static void journalRecord(uint8_t op, const std::string& id, const std::string* user, int type) {
+    if (!persisting.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> lk(journalMutex);
+    journalBuf.push_back((char)op);
+    putString(journalBuf, id);
+    if (user != nullptr) putString(journalBuf, *user);
+    if (type >= 0) journalBuf.push_back((char)type);
+    changes.fetch_add(1, std::memory_order_relaxed);
+}
+
+void journalSessionCreate(const std::string& id, SessionType type) {
+    journalRecord(J_CREATE, id, nullptr, (int)type);
+}
+
+void journalSessionDrop(const std::string& id) {
+    journalRecord(J_DROP, id, nullptr, -1);
+}
+
+void journalMemberAdd(const std::string& id, const std::string& user) {
+    journalRecord(J_ADD, id, &user, -1);
+}
+
+void journalMemberDel(const std::string& id, const std::string& user) {
+    journalRecord(J_DEL, id, &user, -1);
+}
+
+void journalPrivateCreate(const std::string& user1, const std::string& user2) {
+    journalRecord(J_PAIR_ADD, user1, &user2, -1);
+}
+
+void journalPrivateDrop(const std::string& user1, const std::string& user2) {
+    journalRecord(J_PAIR_DEL, user1, &user2, -1);
+}
+
+// 把一段记录追加到第 gen 代日志（调用方持有 ioMutex）
+static void writeJournal(uint64_t gen, const std::string& buf) {
+    if (journalFile == nullptr || journalFileGen != gen) {
+        if (journalFile != nullptr) fclose(journalFile);
+        journalFile = fopen(pathOf(journalName(gen)).c_str(), "ab");
+        journalFileGen = gen;
+        if (journalFile == nullptr) {
+            std::cout << "[WARN] Cannot open journal " << pathOf(journalName(gen)) << std::endl;
+        }
+    }
+    if (journalFile != nullptr && !buf.empty()) {
+        fwrite(buf.data(), 1, buf.size(), journalFile);
+        fflush(journalFile);
+    }
+}
+
+static void flushJournal() {
+    std::string buf;
+    uint64_t gen;
+    {
+        std::lock_guard<std::mutex> lk(journalMutex);
+        buf.swap(journalBuf);
+        gen = journalGen;
+    }
+    writeJournal(gen, buf);
+}
+
+// ========== 快照 ==========
+
+// 调用方持有 ioMutex
+static bool writeSnapshot() {
+    auto t0 = std::chrono::steady_clock::now();
+    // 1. 切换到新一代日志：此后的变更都记在新日志里，快照加载后从这一代开始重放
+    std::string buf;
+    uint64_t gen;
+    {
+        std::lock_guard<std::mutex> lk(journalMutex);
+        buf.swap(journalBuf);
+        gen = journalGen++;
+        changes.store(0, std::memory_order_relaxed);
+    }
+    writeJournal(gen, buf);
+    writeJournal(gen + 1, std::string());
+
+    // 2. 分批持锁编码会话表：成员是升序的用户编号，按差值写 varint
+    std::string body;
+    uint64_t count = 0;
+    scanInChunks(sessions, [&body, &count](const std::string& id, const ServerSession& sess) {
+        putFixed(body, (uint64_t)sess.type, 1);
+        putString(body, id);
+        putVarint(body, sess.members.size());
+        UserId prev = 0;
+        for (UserId member : sess.members) {
+            putVarint(body, member - prev);
+            prev = member;
+        }
+        count++;
+    });
+    // 私聊只有两个编号：排序后整段按差值编码
+    std::vector<PairKey> pairs = privateSessionKeys();
+    std::sort(pairs.begin(), pairs.end());
+    std::string pairBody;
+    uint64_t prevKey = 0;
+    for (const PairKey& pair : pairs) {
+        putVarint(pairBody, pair.v - prevKey);
+        prevKey = pair.v;
+    }
+    // 用户表在会话之后取：编号只增不减，会话里出现过的编号都小于此时的用户数
+    std::string table;
+    uint64_t userCount = 0;
+    {
+        MeteredLock lock(clientMutex);
+        userCount = users.size();
+    }
+    for (uint64_t start = 0; start < userCount; start += SCAN_CHUNK * 16) {
+        MeteredLock lock(clientMutex);
+        for (uint64_t i = start; i < userCount && i < start + SCAN_CHUNK * 16; i++) putString(table, users.name((UserId)i));
+    }
+    std::string out;
+    out.reserve(40 + table.size() + body.size() + pairBody.size());
+    out.append(SNAP_MAGIC, 4);
+    putFixed(out, SNAP_VERSION, 4);
+    putFixed(out, gen + 1, 8);
+    putFixed(out, userCount, 8);
+    out += table;
+    putFixed(out, count, 8);
+    out += body;
+    putFixed(out, pairs.size(), 8);
+    out += pairBody;
+    out.append(SNAP_END, 4);
+
+    // 3. 先写临时文件再改名，任何时刻磁盘上都有一份完整的快照
+    std::string tmp = pathOf(std::string(SNAP_NAME) + ".tmp");
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (f == nullptr) {
+        std::cout << "[WARN] Cannot write snapshot " << tmp << std::endl;
+        return false;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = (fclose(f) == 0) && ok;
+    std::error_code ec;
+    if (ok) fs::rename(tmp, pathOf(SNAP_NAME), ec);
+    if (!ok || ec) {
+        std::cout << "[WARN] Cannot write snapshot " << pathOf(SNAP_NAME) << std::endl;
+        return false;
+    }
+
+    // 4. 已被快照覆盖的旧日志不再需要
+    for (uint64_t old : listJournals()) {
+        if (old <= gen) fs::remove(pathOf(journalName(old)), ec);
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    if (serverConfig.verbose) {
+        std::cout << "[SYS] Snapshot: " << count << " sessions, " << pairs.size() << " private, " << out.size() << " bytes, " << ms << "ms" << std::endl;
+    }
+    return true;
+}
+
+bool writeSnapshotNow() {
+    std::lock_guard<std::mutex> lk(ioMutex);
+    if (!persisting.load()) return false;
+    return writeSnapshot();
+}
+
+static void persistLoop(int intervalSec) {
+    auto nextSnapshot = std::chrono::steady_clock::now();   // 启动后先写一次，合并之前的日志
+    bool first = true;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lk(ioMutex);
+            if (!persisting.load()) return;
+            auto now = std::chrono::steady_clock::now();
+            if (now >= nextSnapshot && (first || changes.load(std::memory_order_relaxed) > 0)) {
+                writeSnapshot();
+                first = false;
+                nextSnapshot = now + std::chrono::seconds(intervalSec);
+            } else {
+                flushJournal();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+    }
+}
+
+bool startStatePersistence(const std::string& dir, int intervalSec) {
+    stateDir = dir;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (!fs::is_directory(dir, ec)) return false;
+    if (intervalSec <= 0) intervalSec = 1;
+    // 新日志接在目录中已有的日志之后，不覆盖还没被快照合并的记录
+    std::vector<uint64_t> gens = listJournals();
+    {
+        std::lock_guard<std::mutex> lk(journalMutex);
+        journalGen = gens.empty() ? 1 : gens.back() + 1;
+    }
+    persisting.store(true);
+    std::thread(persistLoop, intervalSec).detach();
+    return true;
+}
+
+void stopStatePersistence() {
+    std::lock_guard<std::mutex> lk(ioMutex);
+    if (!persisting.exchange(false)) return;
+    flushJournal();
+    if (journalFile != nullptr) {
+        fclose(journalFile);
+        journalFile = nullptr;
+    }
+}
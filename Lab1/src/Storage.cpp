@@ -1,14 +1,16 @@
 #include "../include/Storage.h"
 #include "sqlite3.h"
 #include <iostream>
+#include <cstring>
 #include <ctime>
 #include <algorithm>
+#include <filesystem>
 
 // ========== 构造函数和析构函数 ==========
 
 Storage::Storage(const std::string& userName) {
     // 每个用户独立的数据库文件（存储在 data 目录）
-    dbPath = "data\\" + userName + "_chat.db";
+    dbPath = "data/" + userName + "_chat.db";
     db = nullptr;
 }
 
@@ -20,7 +22,8 @@ Storage::~Storage() {
 
 bool Storage::init() {
     // 确保 data 目录存在
-    system("if not exist data mkdir data");
+    std::error_code ec;
+    std::filesystem::create_directories("data", ec);
     
     // 打开数据库（如果不存在会自动创建）
     if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
@@ -0,0 +1,61 @@
+#include "../include/Trace.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+const char* traceStageName(int stage) {
+    static const char* names[STAGE_COUNT] = {
+        "client->server", "recv->parse", "parse->route", "route->enqueue", "enqueue->write",
+        "route->client", "recv->display", "end-to-end"};
+    return (stage >= 0 && stage < STAGE_COUNT) ? names[stage] : "?";
+}
+
+int64_t traceNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void appendTraceStamp(std::string& out, int64_t us) {
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), ",%lld", (long long)us);
+    out.append(buf, (size_t)n);
+}
+
+int parseTraceStamps(const std::string& trace, int64_t stamps[TRACE_STAMPS]) {
+    int n = 0;
+    const char* p = trace.c_str();
+    while (n < TRACE_STAMPS && *p != '\0') {
+        char* end = nullptr;
+        long long v = std::strtoll(p, &end, 10);
+        if (end == p) break;   // 非法内容：只取前面能解析的部分
+        stamps[n++] = v;
+        if (*end != ',') break;
+        p = end + 1;
+    }
+    return n;
+}
+
+void TraceStats::reset() {
+    for (auto& h : stages) h.reset();
+}
+
+void TraceStats::print(std::ostream& os, int first, int last) const {
+    os << std::left << std::setw(16) << "stage" << std::right << std::setw(10) << "count"
+       << std::setw(10) << "p50(us)" << std::setw(10) << "p99(us)" << std::setw(10) << "p999(us)"
+       << std::setw(10) << "max(us)" << "\n";
+    for (int s = first; s < last; s++) {
+        const LatencyHistogram& h = stages[s];
+        if (h.count() == 0) continue;
+        os << std::left << std::setw(16) << traceStageName(s) << std::right << std::setw(10) << h.count()
+           << std::setw(10) << h.percentile(50) << std::setw(10) << h.percentile(99)
+           << std::setw(10) << h.percentile(99.9) << std::setw(10) << h.max() << "\n";
+    }
+    os.flush();
+}
+
+TraceStats& serverTraceStats() {
+    static TraceStats stats;
+    return stats;
+}
@@ -0,0 +1,149 @@
+// ===================== 压缩字典训练工具 =====================
+// 从客户端的本地聊天记录（data/*_chat.db）还原出服务器下发时的帧（长度头 + MSG|发送者|接收者|内容|时间戳），
+// 统计其中反复出现的片段，按“出现次数 × 能省下的字节”从高到低挑选，拼成不超过 DICT_MAX 字节的字典，
+// 以 C++ 源文件的形式输出到标准输出（make dict 用它重新生成 src/ChatDict.cpp）。
+// 字典变化后标识随之变化，新旧版本的客户端与服务器之间自动不启用压缩。
+//
+// 用法：TrainDict [数据库文件...]        不给参数时读取 data 目录下所有 .db
+// ==========================================================================
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "sqlite3.h"
+
+static const size_t DICT_MAX = 1024;
+static const size_t MIN_PIECE = 4;
+static const size_t MAX_PIECE = 32;
+static const long MATCH_COST = 3;     // 令牌 + 2 字节偏移
+
+static void appendFrame(std::string& corpus, const std::string& payload) {
+    uint32_t len = (uint32_t)payload.size();
+    for (int shift = 24; shift >= 0; shift -= 8) corpus.push_back((char)((len >> shift) & 0xFF));
+    corpus += payload;
+}
+
+// 读取一个数据库里的全部消息；群聊的接收者字段是群名，私聊是对方的用户名
+static int loadMessages(const std::string& path, std::string& corpus) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "无法打开 " << path << std::endl;
+        sqlite3_close(db);
+        return 0;
+    }
+    const char* sql = "SELECT session_id, session_type, sender, receiver, content, timestamp FROM messages "
+                      "WHERE message_type = 'MSG' ORDER BY id";
+    sqlite3_stmt* stmt = nullptr;
+    int count = 0;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            auto text = [stmt](int col) {
+                const unsigned char* s = sqlite3_column_text(stmt, col);
+                return std::string(s != nullptr ? (const char*)s : "");
+            };
+            std::string accepter = text(1) == "GROUP" ? text(0) : text(3);
+            appendFrame(corpus, "MSG|" + text(2) + "|" + accepter + "|" + text(4) + "|" +
+                                    std::to_string(sqlite3_column_int64(stmt, 5)));
+            count++;
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return count;
+}
+
+// 片段的价值：每处出现中尚未被已选片段覆盖的字节换成一次引用（约 MATCH_COST 字节）能省下的量之和，
+// 减去放进字典本身的长度
+static long gain(const std::string& corpus, const std::vector<bool>& covered, const std::string& piece) {
+    long total = -(long)piece.size();
+    for (size_t at = corpus.find(piece); at != std::string::npos; at = corpus.find(piece, at + 1)) {
+        long fresh = 0;
+        for (size_t k = at; k < at + piece.size(); k++) fresh += covered[k] ? 0 : 1;
+        if (fresh > MATCH_COST) total += fresh - MATCH_COST;
+    }
+    return total;
+}
+
+// 贪心选片段：每次取价值最高的，再把它在语料中的各处出现标记为已覆盖，
+// 与它重叠的片段价值随之下降（惰性重算：出队时价值变了就按新值放回去）
+static std::string train(const std::string& corpus) {
+    std::unordered_map<std::string, int> counts;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        for (size_t n = MIN_PIECE; n <= MAX_PIECE && i + n <= corpus.size(); n++) counts[corpus.substr(i, n)]++;
+    }
+    std::vector<bool> covered(corpus.size(), false);
+    std::priority_queue<std::pair<long, std::string>> queue;
+    for (auto& [text, count] : counts) {
+        if (count >= 2) queue.push({gain(corpus, covered, text), text});
+    }
+    std::vector<std::string> chosen;
+    size_t size = 0;
+    while (!queue.empty() && size < DICT_MAX) {
+        auto [score, text] = queue.top();
+        queue.pop();
+        if (score <= 0 || size + text.size() > DICT_MAX) continue;
+        long now = gain(corpus, covered, text);
+        if (now != score) {
+            if (now > 0) queue.push({now, text});
+            continue;
+        }
+        for (size_t at = corpus.find(text); at != std::string::npos; at = corpus.find(text, at + 1)) {
+            std::fill(covered.begin() + (long)at, covered.begin() + (long)(at + text.size()), true);
+        }
+        chosen.push_back(text);
+        size += text.size();
+    }
+    // 最有价值的片段放在最后，离后续数据最近
+    std::string out;
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) out += *it;
+    return out;
+}
+
+static void writeSource(const std::string& dict, int messages, int files) {
+    std::cout << "// 由 TrainDict 根据 " << files << " 个聊天记录数据库（" << messages
+              << " 条消息）生成，请勿手工修改；重新生成：make dict\n"
+              << "#include \"../include/Compress.h\"\n\n"
+              << "const char CHAT_DICT[] =";
+    for (size_t i = 0; i < dict.size(); i++) {
+        if (i % 32 == 0) std::cout << "\n    \"";
+        unsigned char c = (unsigned char)dict[i];
+        if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\' && c != '?') {
+            std::cout << (char)c;
+        } else {
+            char esc[5];
+            snprintf(esc, sizeof(esc), "\\%03o", c);
+            std::cout << esc;
+        }
+        if (i % 32 == 31 || i + 1 == dict.size()) std::cout << "\"";
+    }
+    if (dict.empty()) std::cout << " \"\"";
+    std::cout << ";\n\nconst size_t CHAT_DICT_SIZE = sizeof(CHAT_DICT) - 1;\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) paths.push_back(argv[i]);
+    if (paths.empty()) {
+        std::error_code ec;
+        for (auto& entry : std::filesystem::directory_iterator("data", ec)) {
+            if (entry.path().extension() == ".db") paths.push_back(entry.path().string());
+        }
+        std::sort(paths.begin(), paths.end());
+    }
+    std::string corpus;
+    int messages = 0;
+    for (const std::string& path : paths) messages += loadMessages(path, corpus);
+    if (messages == 0) {
+        std::cerr << "没有可用的聊天记录" << std::endl;
+        return 1;
+    }
+    std::string dict = train(corpus);
+    std::cerr << "语料 " << corpus.size() << " 字节，字典 " << dict.size() << " 字节" << std::endl;
+    writeSource(dict, messages, (int)paths.size());
+    return 0;
+}
@@ -0,0 +1,473 @@
+// ===================== io_uring 后端（仅 Linux） =====================
+// 1. 多次接收：每个连接挂一个 IORING_RECV_MULTISHOT，数据写进预先交给内核的缓冲池；
+// 2. 多次接入：监听套接字挂一个 IORING_ACCEPT_MULTISHOT，一个 SQE 接入所有新连接；
+// 3. 批量提交：一轮内 broadcastToSession 扇出产生的所有发送只在下一次
+//    io_uring_enter 中一次性提交，同一次系统调用里顺便等待完成事件。
+// 直接使用系统调用，不依赖 liburing。
+// ==========================================================================
+
+#ifdef __linux__
+
+#include "../include/IoBackend.h"
+#include "../include/Metrics.h"
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// user_data 低 8 位为操作类型，高位为 ConnId
+enum UringOp : uint64_t { OP_IGNORE = 0, OP_ACCEPT = 1, OP_RECV = 2, OP_SEND = 3, OP_WAKE = 4, OP_PROBE = 5 };
+
+static inline uint64_t makeTag(uint64_t id, uint64_t op) { return (id << 8) | op; }
+
+static const unsigned RING_ENTRIES = 4096;
+static const unsigned BUF_COUNT = 1024;       // 交给内核的接收缓冲个数
+static const unsigned BUF_SIZE = 16384;
+static const uint16_t BUF_GROUP = 1;
+static const size_t MAX_SEND_BATCH = 256 * 1024;   // 一次发送最多携带的字节数
+
+class UringBackend : public IoBackend {
+public:
+    explicit UringBackend(Reactor& owner) : IoBackend(owner) {}
+    ~UringBackend() override;
+
+    const char* name() const override { return "uring"; }
+    bool init() override;
+
+    void addListener(SOCKET l) override {
+        listener = l;
+        armAccept();
+    }
+
+    void removeListener(SOCKET) override {
+        listener = INVALID_SOCKET;
+        io_uring_sqe* sqe = getSqe();
+        if (sqe == nullptr) return;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = makeTag(0, OP_ACCEPT);
+        sqe->user_data = makeTag(0, OP_IGNORE);
+    }
+
+    void addConn(Connection& c) override {
+        setNoDelay(c.sock);
+        armRecv(c);
+    }
+
+    void removeConn(Connection& c) override {
+        // 关闭读方向让挂着的多次接收立即结束；尚未完成的发送缓冲要留到完成事件到达再释放
+        shutdown(c.sock, SHUT_RD);
+        if (!c.inflight.empty()) orphanSends[c.id].swap(c.inflight);
+    }
+
+    void flush(Connection& c) override {
+        // 每个连接同时只有一个发送在途；在途期间排队的帧留在 lanes，完成后合并成下一次发送
+        if (!c.inflight.empty()) return;
+        takeQueued(c);
+        if (!c.inflight.empty()) submitSend(c);
+    }
+
+    void wake() override {
+        uint64_t one = 1;
+        ssize_t r = write(wakeFd, &one, sizeof(one));
+        (void)r;
+    }
+
+    int wakeHandle() const override { return wakeFd; }
+
+    void poll(int64_t timeoutUs) override;
+
+private:
+    io_uring_sqe* getSqe();
+    int enter(unsigned minComplete, int64_t timeoutUs);
+    bool probeOpcodes();
+    bool probeMultishotRecv();
+    bool unsupported(const char* what);
+    void armAccept();
+    void armRecv(Connection& c);
+    void armWake();
+    void submitSend(Connection& c);
+    void takeQueued(Connection& c);
+    void provideBuffers(uint16_t firstBid, unsigned count);
+    void handleCqe(const io_uring_cqe& cqe);
+
+    int ringFd = -1;
+    void* sqRingPtr = nullptr;
+    void* cqRingPtr = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqEntries = 0;
+    unsigned sqLocalTail = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    char* bufBase = nullptr;
+
+    int wakeFd = -1;
+    uint64_t wakeValue = 0;
+    SOCKET listener = INVALID_SOCKET;
+    bool failed = false;                                   // io_uring_enter 出现不可恢复的错误
+    std::unordered_map<ConnId, std::string> orphanSends;   // 连接已关闭但发送仍在途的缓冲
+};
+
+UringBackend::~UringBackend() {
+    if (ringFd >= 0) close(ringFd);
+    if (sqes != nullptr) munmap(sqes, sqesSize);
+    if (cqRingPtr != nullptr && cqRingPtr != sqRingPtr) munmap(cqRingPtr, cqRingSize);
+    if (sqRingPtr != nullptr) munmap(sqRingPtr, sqRingSize);
+    delete[] bufBase;
+    if (wakeFd >= 0) close(wakeFd);
+}
+
+bool UringBackend::init() {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = RING_ENTRIES * 4;
+    ringFd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &p);
+    if (ringFd < 0) return false;
+    // 有 io_uring 不代表有这里用到的功能：带超时的等待（5.11+）和各操作码都要先探测，缺一个就退回 epoll
+    if (!(p.features & IORING_FEAT_EXT_ARG)) return unsupported("IORING_FEAT_EXT_ARG");
+    if (!probeOpcodes()) return false;
+
+    // 映射提交队列、完成队列和 SQE 数组
+    sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        if (cqRingSize > sqRingSize) sqRingSize = cqRingSize;
+        cqRingSize = sqRingSize;
+    }
+    sqRingPtr = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRingPtr == MAP_FAILED) {
+        sqRingPtr = nullptr;
+        return false;
+    }
+    if (single) {
+        cqRingPtr = sqRingPtr;
+    } else {
+        cqRingPtr = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRingPtr == MAP_FAILED) {
+            cqRingPtr = nullptr;
+            return false;
+        }
+    }
+    sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqesPtr == MAP_FAILED) return false;
+    sqes = (io_uring_sqe*)sqesPtr;
+
+    char* sq = (char*)sqRingPtr;
+    sqHead = (unsigned*)(sq + p.sq_off.head);
+    sqTail = (unsigned*)(sq + p.sq_off.tail);
+    sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+    sqArray = (unsigned*)(sq + p.sq_off.array);
+    sqEntries = p.sq_entries;
+    sqLocalTail = *sqTail;
+    char* cq = (char*)cqRingPtr;
+    cqHead = (unsigned*)(cq + p.cq_off.head);
+    cqTail = (unsigned*)(cq + p.cq_off.tail);
+    cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    // 把接收缓冲池交给内核（IORING_OP_PROVIDE_BUFFERS），多次接收从中挑选，用完再归还
+    bufBase = new char[(size_t)BUF_COUNT * BUF_SIZE];
+    provideBuffers(0, BUF_COUNT);
+    if (!probeMultishotRecv()) return false;
+
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0) return false;
+    armWake();
+    return true;
+}
+
+bool UringBackend::unsupported(const char* what) {
+    if (reactor.index() == 0) std::cout << "[WARN] io_uring: kernel lacks " << what << std::endl;
+    return false;
+}
+
+// IORING_REGISTER_PROBE（5.6+）列出内核支持的操作码
+bool UringBackend::probeOpcodes() {
+    const unsigned slots = 256;
+    std::vector<uint64_t> buf((sizeof(io_uring_probe) + slots * sizeof(io_uring_probe_op)) / sizeof(uint64_t) + 1, 0);
+    io_uring_probe* probe = (io_uring_probe*)buf.data();
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, slots) < 0) {
+        return unsupported("IORING_REGISTER_PROBE");
+    }
+    static const struct { int op; const char* name; } needed[] = {
+        {IORING_OP_ACCEPT, "IORING_OP_ACCEPT"}, {IORING_OP_RECV, "IORING_OP_RECV"},
+        {IORING_OP_SEND, "IORING_OP_SEND"}, {IORING_OP_READ, "IORING_OP_READ"},
+        {IORING_OP_PROVIDE_BUFFERS, "IORING_OP_PROVIDE_BUFFERS"}, {IORING_OP_ASYNC_CANCEL, "IORING_OP_ASYNC_CANCEL"},
+    };
+    for (const auto& n : needed) {
+        if (n.op > probe->last_op || !(probe->ops[n.op].flags & IO_URING_OP_SUPPORTED)) return unsupported(n.name);
+    }
+    return true;
+}
+
+// 多次接收（6.0+）没有特性位可查，旧内核对带 IORING_RECV_MULTISHOT 的 RECV 直接回 -EINVAL：
+// 在一对本地套接字上实际挂一次，收到数据且仍带 IORING_CQE_F_MORE 才算支持。
+// 多次接入（5.19+）比它早，一并由这次探测覆盖
+bool UringBackend::probeMultishotRecv() {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return unsupported("socketpair for probing");
+    io_uring_sqe* sqe = getSqe();
+    bool ok = false;
+    bool seen = false;
+    if (sqe != nullptr) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = sv[0];
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUF_GROUP;
+        sqe->user_data = makeTag(0, OP_PROBE);
+        ssize_t w = write(sv[1], "x", 1);
+        (void)w;
+        // 先完成的可能是前面归还缓冲的 SQE，最多等几轮
+        for (int round = 0; round < 4 && !seen; round++) {
+            if (enter(1, 200000) < 0) break;
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            while (head != tail) {
+                io_uring_cqe cqe = cqes[head & *cqMask];
+                head++;
+                if ((cqe.user_data & 0xFF) != OP_PROBE) continue;
+                seen = true;
+                ok = cqe.res == 1 && (cqe.flags & IORING_CQE_F_MORE) != 0;
+                if (cqe.flags & IORING_CQE_F_BUFFER) provideBuffers((uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT), 1);
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+    }
+    // 关闭后挂着的接收以 0 结束，那个完成事件按 OP_PROBE 在 handleCqe 中忽略
+    close(sv[0]);
+    close(sv[1]);
+    return ok ? true : unsupported("multishot recv (IORING_RECV_MULTISHOT)");
+}
+
+io_uring_sqe* UringBackend::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqLocalTail - head >= sqEntries) {
+        // 提交队列满：先把已经准备好的提交给内核
+        enter(0, 0);
+        head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqLocalTail - head >= sqEntries) {
+            std::cout << "[ERROR] io_uring submission queue full" << std::endl;
+            return nullptr;
+        }
+    }
+    unsigned index = sqLocalTail & *sqMask;
+    io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    sqLocalTail++;
+    return sqe;
+}
+
+// 提交所有未提交的 SQE，并（可选）等待至少 minComplete 个完成事件
+int UringBackend::enter(unsigned minComplete, int64_t timeoutUs) {
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    unsigned flags = 0;
+    void* arg = nullptr;
+    size_t argSize = 0;
+    __kernel_timespec ts;
+    io_uring_getevents_arg ext;
+    if (minComplete > 0) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        ts.tv_sec = timeoutUs / 1000000;
+        ts.tv_nsec = (long long)(timeoutUs % 1000000) * 1000;
+        memset(&ext, 0, sizeof(ext));
+        ext.sigmask_sz = _NSIG / 8;
+        ext.ts = (uint64_t)(uintptr_t)&ts;
+        arg = &ext;
+        argSize = sizeof(ext);
+    }
+    if (toSubmit == 0 && minComplete == 0) return 0;
+    while (true) {
+        countSyscall();
+        int r = (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize);
+        if (r >= 0) return r;
+        if (errno == ETIME) return 0;   // 等待超时（带超时的等待在没有完成事件时返回 -ETIME）
+        if (errno == EINTR) {
+            toSubmit = sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            continue;
+        }
+        // 完成队列溢出积压 / 内核暂时分配不到资源：先处理已有的完成事件，下一轮再提交
+        if (errno == EAGAIN || errno == EBUSY) return 0;
+        if (!failed) {
+            failed = true;
+            std::cout << "[ERROR] io_uring_enter failed: " << strerror(errno) << ", stopping reactor " << reactor.index()
+                      << std::endl;
+            reactor.stop();
+        }
+        return -1;
+    }
+}
+
+void UringBackend::armAccept() {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listener;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = makeTag(0, OP_ACCEPT);
+}
+
+void UringBackend::armRecv(Connection& c) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) {
+        reactor.markClosing(c);
+        return;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = c.sock;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = makeTag(c.id, OP_RECV);
+}
+
+void UringBackend::armWake() {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeFd;
+    sqe->addr = (uint64_t)(uintptr_t)&wakeValue;
+    sqe->len = sizeof(wakeValue);
+    sqe->user_data = makeTag(0, OP_WAKE);
+}
+
+void UringBackend::submitSend(Connection& c) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) {
+        reactor.markClosing(c);
+        return;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = c.sock;
+    sqe->addr = (uint64_t)(uintptr_t)c.inflight.data();
+    sqe->len = (unsigned)c.inflight.size();
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = makeTag(c.id, OP_SEND);
+}
+
+// 按通道优先级取出排队的帧，拼成一段连续缓冲作为一次 IORING_OP_SEND 提交。
+// 每次最多取 MAX_SEND_BATCH 字节：积压很多时，在途期间到达的控制帧可以排到剩余聊天消息前面
+void UringBackend::takeQueued(Connection& c) {
+    c.inflight.reserve(c.lanes.bytes() < MAX_SEND_BATCH ? c.lanes.bytes() : MAX_SEND_BATCH);
+    while (c.inflight.size() < MAX_SEND_BATCH) {
+        FramePtr f = c.lanes.pop();
+        if (!f) break;
+        c.inflight.append(*f);
+    }
+}
+
+// 归还缓冲的 SQE 与本轮的发送一起提交，不额外产生系统调用
+void UringBackend::provideBuffers(uint16_t firstBid, unsigned count) {
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return;
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = (int)count;
+    sqe->addr = (uint64_t)(uintptr_t)(bufBase + (size_t)firstBid * BUF_SIZE);
+    sqe->len = BUF_SIZE;
+    sqe->off = firstBid;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = makeTag(0, OP_IGNORE);
+}
+
+void UringBackend::poll(int64_t timeoutUs) {
+    // 完成队列里还有未处理的事件时不等待，只提交
+    unsigned head = *cqHead;
+    bool ready = head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    if (failed) return;
+    if (enter(ready ? 0 : 1, timeoutUs) < 0 && !ready) return;   // 不可恢复：reactor 已在停止
+
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        io_uring_cqe cqe = cqes[head & *cqMask];
+        head++;
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        handleCqe(cqe);
+    }
+}
+
+void UringBackend::handleCqe(const io_uring_cqe& cqe) {
+    uint64_t op = cqe.user_data & 0xFF;
+    ConnId id = cqe.user_data >> 8;
+    switch (op) {
+    case OP_WAKE:
+        armWake();
+        break;
+    case OP_ACCEPT:
+        if (cqe.res >= 0) reactor.onAccept((SOCKET)cqe.res);
+        if (!(cqe.flags & IORING_CQE_F_MORE) && listener != INVALID_SOCKET) armAccept();
+        break;
+    case OP_RECV: {
+        Connection* c = reactor.findConn(id);
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            uint16_t bid = (uint16_t)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (c != nullptr && !c->closing && cqe.res > 0) {
+                reactor.onData(*c, bufBase + (size_t)bid * BUF_SIZE, (size_t)cqe.res);
+            }
+            provideBuffers(bid, 1);
+        }
+        if (c == nullptr || c->closing) break;
+        if (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS)) {
+            reactor.markClosing(*c);
+            break;
+        }
+        // 多次接收被内核终止（例如缓冲暂时耗尽），重新挂上
+        if (!(cqe.flags & IORING_CQE_F_MORE)) armRecv(*c);
+        break;
+    }
+    case OP_SEND: {
+        Connection* c = reactor.findConn(id);
+        if (c == nullptr) {
+            orphanSends.erase(id);
+            break;
+        }
+        if (cqe.res < 0) {
+            metrics().sendErrors.add();
+            c->inflight.clear();
+            reactor.markClosing(*c);
+            break;
+        }
+        c->inflight.erase(0, (size_t)cqe.res);
+        if (c->closing) {
+            c->inflight.clear();
+            break;
+        }
+        if (c->inflight.empty()) takeQueued(*c);
+        if (!c->inflight.empty()) submitSend(*c);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+IoBackend* createUringBackend(Reactor& owner) {
+    UringBackend* b = new UringBackend(owner);
+    if (b->init()) return b;
+    delete b;
+    return nullptr;
+}
+
+#endif // __linux__